@@ -1,4 +1,9 @@
 -- Tabellen löschen falls Neustart gewünscht
+DROP TABLE IF EXISTS inbox_leases;
+DROP TABLE IF EXISTS worker_nodes;
+DROP TABLE IF EXISTS picture_near_duplicates;
+DROP TABLE IF EXISTS picture_derivatives;
+DROP TABLE IF EXISTS picture_links;
 DROP TABLE IF EXISTS picture_keywords;
 DROP TABLE IF EXISTS keywords;
 DROP TABLE IF EXISTS meta_xmp;
@@ -19,9 +24,15 @@ CREATE TABLE pictures (
     file_datetime TIMESTAMP,
     imported_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     upload_user TEXT,
-    access_group TEXT DEFAULT 'public'
+    access_group TEXT DEFAULT 'public',
+    content_hash TEXT,             -- XXH3-128 (hex) für Duplikat-Erkennung
+    blurhash TEXT,                 -- Platzhalter für die Galerie (Derivate-Stufe)
+    phash BIGINT                   -- 64-Bit Perceptual Hash (WORKER_PHASH=on), Index im Speicher
 );
 
+CREATE INDEX idx_pictures_content_hash ON pictures (content_hash);
+CREATE INDEX idx_pictures_full_path ON pictures (full_path);      -- --reindex: Upsert per Pfad
+
 -- 2. Location
 CREATE TABLE meta_location (
     id SERIAL PRIMARY KEY,
@@ -80,4 +91,55 @@ CREATE TABLE picture_keywords (
     picture_id INTEGER NOT NULL REFERENCES pictures(id) ON DELETE CASCADE,
     keyword_id INTEGER NOT NULL REFERENCES keywords(id) ON DELETE CASCADE,
     PRIMARY KEY (picture_id, keyword_id)
-);
\ No newline at end of file
+);
+
+-- 8. Duplikate (WORKER_DUPLICATE_POLICY=link): Upload verweist auf vorhandenes Foto
+CREATE TABLE picture_links (
+    id SERIAL PRIMARY KEY,
+    ref_picture INTEGER NOT NULL REFERENCES pictures(id) ON DELETE CASCADE,
+    upload_user TEXT,
+    file_name TEXT NOT NULL,
+    file_path TEXT NOT NULL,       -- Relativer Pfad des Uploads
+    linked_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
+-- 9. Derivate (WORKER_DERIVATIVE_THREADS > 0): Thumbnails / Previews
+CREATE TABLE picture_derivatives (
+    id SERIAL PRIMARY KEY,
+    ref_picture INTEGER NOT NULL REFERENCES pictures(id) ON DELETE CASCADE,
+    kind TEXT NOT NULL,            -- Längste Kante in px, z.B. "256"
+    format TEXT NOT NULL,          -- "jpeg" oder "webp"
+    width INTEGER,
+    height INTEGER,
+    file_path TEXT NOT NULL,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    UNIQUE (ref_picture, kind)
+);
+
+-- 10. Beinahe-Duplikate (WORKER_PHASH=on): neues Foto ähnelt einem älteren
+CREATE TABLE picture_near_duplicates (
+    picture_id INTEGER NOT NULL REFERENCES pictures(id) ON DELETE CASCADE,
+    candidate_id INTEGER NOT NULL REFERENCES pictures(id) ON DELETE CASCADE,
+    distance INTEGER NOT NULL,     -- Hamming-Abstand der pHashes (0..64)
+    detected_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    PRIMARY KEY (picture_id, candidate_id)
+);
+CREATE INDEX idx_near_duplicates_candidate ON picture_near_duplicates (candidate_id);
+
+-- 11. Mehrere Worker-Knoten an einer Inbox (WORKER_CLUSTER=lease)
+CREATE TABLE worker_nodes (
+    node TEXT PRIMARY KEY,         -- WORKER_NODE_ID
+    started_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    heartbeat_at TIMESTAMPTZ NOT NULL DEFAULT now()
+);
+
+-- Wer bearbeitet gerade welche Inbox-Datei; abgelaufene Zeilen darf ein anderer Knoten übernehmen
+CREATE TABLE inbox_leases (
+    path TEXT PRIMARY KEY,         -- Relativ zur Inbox
+    node TEXT NOT NULL,
+    claimed_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    expires_at TIMESTAMPTZ NOT NULL,
+    takeovers INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX idx_inbox_leases_node ON inbox_leases (node);
+CREATE INDEX idx_inbox_leases_expires ON inbox_leases (expires_at);
@@ -0,0 +1,57 @@
+#include "AllocCounter.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> g_allocations{0};
+static std::atomic<uint64_t> g_bytes{0};
+
+static void* countedAlloc(std::size_t size, std::size_t align = 0) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (size == 0) size = 1;
+    void* p = nullptr;
+    if (align > alignof(std::max_align_t)) {
+        if (posix_memalign(&p, align, size) != 0) p = nullptr;
+    } else {
+        p = std::malloc(size);
+    }
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t a) { return countedAlloc(size, static_cast<std::size_t>(a)); }
+void* operator new[](std::size_t size, std::align_val_t a) { return countedAlloc(size, static_cast<std::size_t>(a)); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAlloc(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+uint64_t AllocCounter::totalAllocations() { return g_allocations.load(std::memory_order_relaxed); }
+uint64_t AllocCounter::totalBytes() { return g_bytes.load(std::memory_order_relaxed); }
+
+AllocCounter::AllocCounter() : startAllocations_(totalAllocations()), startBytes_(totalBytes()) {}
+
+uint64_t AllocCounter::allocations() const { return totalAllocations() - startAllocations_; }
+uint64_t AllocCounter::bytes() const { return totalBytes() - startBytes_; }
+
+void AllocCounter::report(benchmark::State& state) const {
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations()), benchmark::Counter::kAvgIterations);
+    state.counters["alloc_bytes"] = benchmark::Counter(static_cast<double>(bytes()), benchmark::Counter::kAvgIterations);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+namespace benchmark { class State; }
+
+// Zählt Heap-Allokationen (globales operator new wird in AllocCounter.cpp ersetzt).
+// Anlegen vor der Benchmark-Schleife, report() danach:
+//
+//     AllocCounter allocs;
+//     for (auto _ : state) { ... }
+//     allocs.report(state);
+class AllocCounter {
+public:
+    AllocCounter();
+
+    uint64_t allocations() const;
+    uint64_t bytes() const;
+
+    // Setzt die Counter "allocs" und "alloc_bytes" (pro Iteration)
+    void report(benchmark::State& state) const;
+
+    static uint64_t totalAllocations();
+    static uint64_t totalBytes();
+
+private:
+    uint64_t startAllocations_;
+    uint64_t startBytes_;
+};
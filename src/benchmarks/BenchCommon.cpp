@@ -0,0 +1,56 @@
+#include "BenchCommon.h"
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include "DbPool.h"
+
+namespace fs = std::filesystem;
+
+const BenchCorpus& BenchCorpus::instance() {
+    static BenchCorpus corpus = [] {
+        BenchCorpus c;
+        CorpusOptions opts = CorpusOptions::fromEnvironment();
+        c.files = SyntheticCorpus::generate(opts);
+        c.dir = fs::temp_directory_path() / ("worker-bench-corpus-" + std::to_string(opts.seed));
+        c.paths = SyntheticCorpus::writeTo(c.dir, c.files);
+        for (const auto& f : c.files) c.totalBytes += f.bytes.size();
+
+        std::mt19937 rng(opts.seed);
+        for (size_t i = 0; i < 2000; ++i) c.filenames.push_back(SyntheticCorpus::makeFilename(rng, i));
+
+        std::cerr << "Corpus: " << c.files.size() << " files, " << c.totalBytes / 1024 << " KiB in "
+                  << c.dir.string() << "\n";
+        return c;
+    }();
+    return corpus;
+}
+
+BenchCorpus::~BenchCorpus() {
+    if (dir.empty()) return;
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+}
+
+static std::unique_ptr<TempPostgres>& postgresHolder() {
+    static std::unique_ptr<TempPostgres> pg;
+    return pg;
+}
+
+TempPostgres* benchPostgres() {
+    static bool tried = false;
+    auto& pg = postgresHolder();
+    if (!tried) {
+        tried = true;
+        const char* schema = std::getenv("BENCH_SCHEMA_FILE");
+        pg = std::make_unique<TempPostgres>(schema ? schema : WORKER_SCHEMA_FILE);
+    }
+    return pg && pg->isRunning() ? pg.get() : nullptr;
+}
+
+void shutdownBenchPostgres() {
+    auto& pg = postgresHolder();
+    if (!pg) return;
+    if (pg->isRunning()) DbPool::instance().releaseThread();
+    pg.reset();
+}
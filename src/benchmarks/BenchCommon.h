@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "SyntheticCorpus.h"
+#include "TempPostgres.h"
+
+// Gemeinsamer Corpus für alle Benchmarks, einmal pro Prozess erzeugt
+// (BENCH_CORPUS_SIZE / BENCH_CORPUS_SEED) und in einen Temp-Ordner geschrieben.
+struct BenchCorpus {
+    std::filesystem::path dir;
+    std::vector<CorpusFile> files;
+    std::vector<std::filesystem::path> paths;
+    std::vector<std::string> filenames;   // nur Namen, für die Parser-Benchmarks
+    uint64_t totalBytes = 0;
+
+    static const BenchCorpus& instance();
+    ~BenchCorpus();
+};
+
+// Wegwerf-PostgreSQL, beim ersten Aufruf gestartet. nullptr, wenn nicht verfügbar.
+TempPostgres* benchPostgres();
+
+// Verbindungen schließen und die Instanz stoppen (am Ende von main)
+void shutdownBenchPostgres();
@@ -0,0 +1,92 @@
+// DB-Schreibpfad gegen eine Wegwerf-PostgreSQL-Instanz
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include "AllocCounter.h"
+#include "BenchCommon.h"
+#include "DbManager.h"
+#include "MetadataExtractor.h"
+
+// Payloads mit den Metadaten des Corpus (einmal extrahiert)
+static const std::vector<WorkerPayload>& corpusPayloads() {
+    static std::vector<WorkerPayload> payloads = [] {
+        const BenchCorpus& c = BenchCorpus::instance();
+        std::vector<WorkerPayload> out;
+        out.reserve(c.files.size());
+        for (size_t i = 0; i < c.files.size(); ++i) {
+            WorkerPayload p;
+            p.filename = c.files[i].name;
+            p.relPath  = "bench";
+            p.user     = "bench";
+            p.fileSize = static_cast<long long>(c.files[i].bytes.size());
+            p.meta     = MetadataExtractor::extractWithExiv2(c.paths[i].string());
+            p.fileDate = p.meta.takenAt.isValid() ? p.meta.takenAt : QDateTime::currentDateTime();
+            out.push_back(std::move(p));
+        }
+        return out;
+    }();
+    return payloads;
+}
+
+// full_path muss pro Zeile eindeutig sein (RETURNING-Zuordnung)
+static WorkerPayload nextPayload(size_t& i) {
+    static std::atomic<uint64_t> seq{0};
+    const auto& all = corpusPayloads();
+    WorkerPayload p = all[i];
+    if (++i == all.size()) i = 0;
+    p.fullPath = "/bench/" + std::to_string(seq++) + "/" + p.filename;
+    return p;
+}
+
+static bool setUpDb(benchmark::State& state) {
+    TempPostgres* pg = benchPostgres();
+    if (!pg) {
+        state.SkipWithError("no throwaway PostgreSQL (initdb/pg_ctl not found, see PG_BIN_DIR)");
+        return false;
+    }
+    pg->truncateAll();
+    return true;
+}
+
+static void BM_DbInsertPhoto(benchmark::State& state) {
+    if (!setUpDb(state)) return;
+    size_t i = 0;
+
+    AllocCounter allocs;
+    for (auto _ : state) {
+        state.PauseTiming();
+        WorkerPayload p = nextPayload(i);
+        state.ResumeTiming();
+        if (!DbManager::insertPhoto(p)) {
+            state.SkipWithError("insertPhoto failed");
+            break;
+        }
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DbInsertPhoto)->Unit(benchmark::kMicrosecond);
+
+// Group Commit mit unterschiedlichen Batch-Größen (WORKER_DB_BATCH_SIZE)
+static void BM_DbInsertBatch(benchmark::State& state) {
+    if (!setUpDb(state)) return;
+    const auto batchSize = static_cast<size_t>(state.range(0));
+    size_t i = 0;
+
+    AllocCounter allocs;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<WorkerPayload> batch;
+        batch.reserve(batchSize);
+        for (size_t n = 0; n < batchSize; ++n) batch.push_back(nextPayload(i));
+        state.ResumeTiming();
+
+        auto ids = DbManager::insertBatch(batch, BatchFailureMode::Isolate);
+        if (ids.empty() || ids.front() <= 0) {
+            state.SkipWithError("insertBatch failed");
+            break;
+        }
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batchSize));
+}
+BENCHMARK(BM_DbInsertBatch)->Arg(1)->Arg(16)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,93 @@
+// Metadaten-Extraktion und Inhalts-Hash über den synthetischen Corpus
+#include <benchmark/benchmark.h>
+#include <iostream>
+#include "AllocCounter.h"
+#include "BenchCommon.h"
+#include "ContentHash.h"
+#include "FastMetadataReader.h"
+#include "MetadataExtractor.h"
+
+// Jede Iteration = eine Datei (reihum über den Corpus)
+template <typename Fn>
+static void overCorpus(benchmark::State& state, Fn&& fn) {
+    const BenchCorpus& c = BenchCorpus::instance();
+    size_t i = 0;
+    int64_t bytes = 0;
+
+    AllocCounter allocs;
+    for (auto _ : state) {
+        fn(c, i);
+        bytes += static_cast<int64_t>(c.files[i].bytes.size());
+        if (++i == c.files.size()) i = 0;
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+
+static void BM_Extract_Exiv2(benchmark::State& state) {
+    overCorpus(state, [](const BenchCorpus& c, size_t i) {
+        benchmark::DoNotOptimize(MetadataExtractor::extractWithExiv2(c.paths[i].string()));
+    });
+}
+BENCHMARK(BM_Extract_Exiv2);
+
+static void BM_Extract_Fast(benchmark::State& state) {
+    overCorpus(state, [](const BenchCorpus& c, size_t i) {
+        benchmark::DoNotOptimize(MetadataExtractor::extractFast(c.paths[i].string()));
+    });
+}
+BENCHMARK(BM_Extract_Fast);
+
+// Wie im Worker: WORKER_FAST_METADATA entscheidet
+static void BM_Extract_Default(benchmark::State& state) {
+    overCorpus(state, [](const BenchCorpus& c, size_t i) {
+        benchmark::DoNotOptimize(MetadataExtractor::extract(c.paths[i].string()));
+    });
+}
+BENCHMARK(BM_Extract_Default);
+
+// Nur der Parser, ohne open/mmap und ohne Umwandlung in PhotoData
+static void BM_FastParse_Buffer(benchmark::State& state) {
+    overCorpus(state, [](const BenchCorpus& c, size_t i) {
+        FastMetadata meta;
+        benchmark::DoNotOptimize(FastMetadataReader::parse(c.files[i].bytes, meta));
+    });
+}
+BENCHMARK(BM_FastParse_Buffer);
+
+static void BM_ContentHash_File(benchmark::State& state) {
+    overCorpus(state, [](const BenchCorpus& c, size_t i) {
+        benchmark::DoNotOptimize(ContentHash::ofFile(c.paths[i]));
+    });
+}
+BENCHMARK(BM_ContentHash_File);
+
+// Differenz-Check: Fast Path gegen Exiv2 über den ganzen Corpus.
+// Kein Zeitmaß, sondern die Counter "mismatches" und "unsupported"; Abweichungen
+// markieren den Lauf als Fehler. Für CI mit Exit-Code: worker_check_metadata.
+static void BM_FastVsExiv2(benchmark::State& state) {
+    const BenchCorpus& c = BenchCorpus::instance();
+    int64_t mismatches = 0, unsupported = 0;
+
+    for (auto _ : state) {
+        mismatches = unsupported = 0;
+        for (const auto& p : c.paths) {
+            auto fast = MetadataExtractor::extractFast(p.string());
+            if (!fast) {
+                unsupported++;
+                continue;
+            }
+            QStringList diffs = MetadataExtractor::differences(*fast, MetadataExtractor::extractWithExiv2(p.string()));
+            if (!diffs.isEmpty()) {
+                mismatches++;
+                std::cerr << "mismatch " << p.filename().string() << ": " << diffs.join(", ").toStdString() << "\n";
+            }
+        }
+    }
+    state.counters["files"] = static_cast<double>(c.paths.size());
+    state.counters["mismatches"] = static_cast<double>(mismatches);
+    state.counters["unsupported"] = static_cast<double>(unsupported);
+    if (mismatches > 0) state.SkipWithError(std::to_string(mismatches) + " files differ from Exiv2");
+}
+BENCHMARK(BM_FastVsExiv2)->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,65 @@
+// Dateinamen-Helfer aus FileHelpers
+#include <benchmark/benchmark.h>
+#include "AllocCounter.h"
+#include "BenchCommon.h"
+#include "FileHelpers.h"
+#include <QRegularExpression>
+
+template <typename Fn>
+static void overFilenames(benchmark::State& state, Fn&& fn) {
+    const auto& names = BenchCorpus::instance().filenames;
+    size_t i = 0;
+
+    AllocCounter allocs;
+    for (auto _ : state) {
+        fn(names[i]);
+        if (++i == names.size()) i = 0;
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ParseFilename(benchmark::State& state) {
+    overFilenames(state, [](const std::string& n) { benchmark::DoNotOptimize(parseFilename(n)); });
+}
+BENCHMARK(BM_ParseFilename);
+
+static void BM_ExtractDateFromFilename(benchmark::State& state) {
+    overFilenames(state, [](const std::string& n) { benchmark::DoNotOptimize(extractDateFromFilename(n)); });
+}
+BENCHMARK(BM_ExtractDateFromFilename);
+
+// Ohne QDateTime: nur das Muster-Matching auf dem string_view
+static void BM_MatchFilenameDate(benchmark::State& state) {
+    overFilenames(state, [](const std::string& n) { benchmark::DoNotOptimize(matchFilenameDate(n)); });
+}
+BENCHMARK(BM_MatchFilenameDate);
+
+// Vorherige Implementierung als Vergleich: ein Regex, nur "YYYY-MM-DD_HHMMSS"
+static QDateTime extractDateFromFilenameRegex(const std::string& filename) {
+    static QRegularExpression re(R"((\d{4})-(\d{2})-(\d{2})_(\d{2})(\d{2})(\d{2}))");
+    auto match = re.match(QString::fromStdString(filename));
+    if (!match.hasMatch()) return QDateTime();
+    QDate date(match.captured(1).toInt(), match.captured(2).toInt(), match.captured(3).toInt());
+    QTime time(match.captured(4).toInt(), match.captured(5).toInt(), match.captured(6).toInt());
+    return date.isValid() && time.isValid() ? QDateTime(date, time) : QDateTime();
+}
+
+static void BM_ExtractDateFromFilenameRegex(benchmark::State& state) {
+    overFilenames(state, [](const std::string& n) { benchmark::DoNotOptimize(extractDateFromFilenameRegex(n)); });
+}
+BENCHMARK(BM_ExtractDateFromFilenameRegex);
+
+static void BM_Sanitize(benchmark::State& state) {
+    overFilenames(state, [](const std::string& n) { benchmark::DoNotOptimize(sanitize(n)); });
+}
+BENCHMARK(BM_Sanitize);
+
+// Kompletter Namens-Schritt wie in extractWorker()
+static void BM_FilenamePipeline(benchmark::State& state) {
+    overFilenames(state, [](const std::string& n) {
+        FileInfo info = parseFilename(n);
+        benchmark::DoNotOptimize(extractDateFromFilename(info.cleanName));
+    });
+}
+BENCHMARK(BM_FilenamePipeline);
@@ -0,0 +1,29 @@
+// Micro-Benchmarks des Workers.
+//
+//   ./worker_bench --benchmark_out=bench.json --benchmark_out_format=json
+//
+// Umgebungsvariablen: BENCH_CORPUS_SIZE, BENCH_CORPUS_SEED, PG_BIN_DIR,
+// BENCH_SCHEMA_FILE, WORKER_FAST_METADATA (für BM_Extract_Default).
+#include <benchmark/benchmark.h>
+#include <QCoreApplication>
+#include <QtGlobal>
+#include "BenchCommon.h"
+
+int main(int argc, char** argv) {
+    // qDebug() aus DbManager & Co. würde die Messung verfälschen
+    qputenv("QT_LOGGING_RULES", "*.debug=false");
+    QCoreApplication app(argc, argv);
+
+    // Für den Vergleich von JSON-Ergebnissen über Commits hinweg
+    benchmark::AddCustomContext("worker_git_commit", WORKER_GIT_COMMIT);
+    benchmark::AddCustomContext("corpus_size", std::to_string(CorpusOptions::fromEnvironment().count));
+    benchmark::AddCustomContext("corpus_seed", std::to_string(CorpusOptions::fromEnvironment().seed));
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    shutdownBenchPostgres();
+    return 0;
+}
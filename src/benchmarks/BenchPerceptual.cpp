@@ -0,0 +1,57 @@
+// Beinahe-Duplikate: pHash berechnen und im Index suchen
+#include <benchmark/benchmark.h>
+#include <random>
+#include "AllocCounter.h"
+#include "PerceptualHash.h"
+
+// Etwa das, was die 1/8-Dekodierung eines 12-MP-Fotos liefert
+static RgbImage sampleImage() {
+    RgbImage img;
+    img.width = 500;
+    img.height = 375;
+    img.pixels.resize(static_cast<size_t>(img.width) * img.height * 3);
+    std::mt19937 rng(42);
+    for (int y = 0; y < img.height; ++y) {
+        for (int x = 0; x < img.width; ++x) {
+            uint8_t* p = &img.pixels[(static_cast<size_t>(y) * img.width + x) * 3];
+            p[0] = static_cast<uint8_t>(x / 2 + rng() % 16);
+            p[1] = static_cast<uint8_t>(y / 2 + rng() % 16);
+            p[2] = static_cast<uint8_t>((x + y) / 4);
+        }
+    }
+    return img;
+}
+
+static void BM_PerceptualHash(benchmark::State& state) {
+    const RgbImage img = sampleImage();
+
+    AllocCounter allocs;
+    for (auto _ : state) benchmark::DoNotOptimize(PerceptualHash::compute(img));
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PerceptualHash);
+
+// Index einmalig mit 1 Mio. zufälligen Hashes füllen (Singleton wie im Worker)
+static PerceptualIndex& filledIndex() {
+    static PerceptualIndex& index = [&]() -> PerceptualIndex& {
+        PerceptualIndex& ix = PerceptualIndex::instance();
+        std::mt19937_64 rng(7);
+        for (qint64 id = 1; id <= 1000000; ++id) ix.insert(rng(), id);
+        return ix;
+    }();
+    return index;
+}
+
+// range(0) = maximaler Hamming-Abstand
+static void BM_PhashSearch(benchmark::State& state) {
+    PerceptualIndex& index = filledIndex();
+    const int maxDistance = static_cast<int>(state.range(0));
+    std::mt19937_64 rng(99);
+
+    AllocCounter allocs;
+    for (auto _ : state) benchmark::DoNotOptimize(index.search(rng(), maxDistance, 20));
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PhashSearch)->Arg(4)->Arg(8)->Arg(12);
@@ -0,0 +1,76 @@
+// PhotoData: Keywords deduplizieren und Texte ablegen, alt (QStringList) gegen neu (Arena)
+#include <benchmark/benchmark.h>
+#include <QString>
+#include <QStringList>
+#include <string>
+#include <vector>
+#include "AllocCounter.h"
+#include "PhotoData.h"
+
+// Stock-Foto: n Tags, jedes vierte doppelt (IPTC und XMP liefern dieselben)
+static std::vector<std::string> makeTags(int n) {
+    std::vector<std::string> tags;
+    tags.reserve(n);
+    for (int i = 0; i < n; ++i) tags.push_back("keyword-" + std::to_string(i % 4 == 3 ? i - 1 : i));
+    return tags;
+}
+
+// Bisheriger Weg: toQt() pro Tag, QStringList::contains -> O(n²)
+static void BM_KeywordsQStringList(benchmark::State& state) {
+    const auto tags = makeTags(static_cast<int>(state.range(0)));
+
+    AllocCounter allocs;
+    for (auto _ : state) {
+        QStringList keywords;
+        for (const auto& t : tags) {
+            QString val = QString::fromStdString(t);
+            if (!keywords.contains(val)) keywords.append(val);
+        }
+        benchmark::DoNotOptimize(keywords);
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_KeywordsQStringList)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_KeywordsPhotoData(benchmark::State& state) {
+    const auto tags = makeTags(static_cast<int>(state.range(0)));
+
+    AllocCounter allocs;
+    for (auto _ : state) {
+        PhotoData data;
+        for (const auto& t : tags) data.addKeyword(t);
+        benchmark::DoNotOptimize(data.keywords.data());
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_KeywordsPhotoData)->Arg(10)->Arg(100)->Arg(1000);
+
+// Typisches Foto ohne Keywords: 12 Textfelder ablegen
+static void BM_PhotoDataFields(benchmark::State& state) {
+    const std::string make = "Canon", model = "Canon EOS R5", iso = "400", aperture = "28/10", exposure = "1/250";
+    const std::string title = "Sommer am See", caption = "Abendlicht über dem Wasser", copyright = "(c) 2023";
+    const std::string city = "Konstanz", province = "Baden-Württemberg", country = "Germany", code = "DE";
+
+    AllocCounter allocs;
+    for (auto _ : state) {
+        PhotoData data;
+        data.make = data.store(make);
+        data.model = data.store(model);
+        data.iso = data.store(iso);
+        data.aperture = data.store(aperture);
+        data.exposure = data.store(exposure);
+        data.title = data.store(title);
+        data.caption = data.store(caption);
+        data.copyright = data.store(copyright);
+        data.city = data.store(city);
+        data.province = data.store(province);
+        data.country = data.store(country);
+        data.countryCode = data.store(code);
+        benchmark::DoNotOptimize(data.countryCode.data());
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PhotoDataFields);
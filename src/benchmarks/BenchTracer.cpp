@@ -0,0 +1,31 @@
+// Span-Tracing: Kosten pro Span aus- und eingeschaltet
+#include <benchmark/benchmark.h>
+#include "AllocCounter.h"
+#include "Tracer.h"
+
+static void BM_TraceSpanDisabled(benchmark::State& state) {
+    Tracer::instance().setEnabled(false);
+    AllocCounter allocs;
+    for (auto _ : state) {
+        TraceFileScope file("IMG_20230815_142233.jpg", "alice", 4 << 20);
+        TraceSpan span("hash", "extract");
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceSpanDisabled);
+
+// Ringpuffer läuft nach WORKER_TRACE_EVENTS Spans über -> Dauerzustand
+static void BM_TraceSpanEnabled(benchmark::State& state) {
+    Tracer::instance().setEnabled(true);
+    AllocCounter allocs;
+    for (auto _ : state) {
+        TraceFileScope file("IMG_20230815_142233.jpg", "alice", 4 << 20);
+        TraceSpan span("hash", "extract");
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+    Tracer::instance().setEnabled(false);
+    Tracer::instance().clear();
+}
+BENCHMARK(BM_TraceSpanEnabled);
@@ -0,0 +1,95 @@
+// Differenz-Check: Fast Path (FastMetadataReader) gegen Exiv2, Feld für Feld.
+//
+//   ./worker_check_metadata                  synthetischer Corpus (BENCH_CORPUS_SIZE/_SEED)
+//   ./worker_check_metadata <ordner>...      echte Stichprobe, rekursiv
+//   ./worker_check_metadata --synthetic <ordner>...   beides
+//
+// Exit-Code: 0 alle Felder gleich, 1 mindestens eine Abweichung, 2 nichts geprüft
+// bzw. Aufruf-/Lesefehler. Dateien, die der Fast Path nicht unterstützt, sind kein
+// Fehler (dort übernimmt im Worker Exiv2), werden aber mitgezählt.
+#include <QCoreApplication>
+#include <QStringList>
+#include <QtGlobal>
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "MetadataExtractor.h"
+#include "SyntheticCorpus.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    qputenv("QT_LOGGING_RULES", "*.debug=false");
+    QCoreApplication app(argc, argv);
+
+    bool synthetic = argc < 2;
+    std::vector<fs::path> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--synthetic") {
+            synthetic = true;
+            continue;
+        }
+        if (arg.starts_with("-")) {
+            std::cerr << "usage: " << argv[0] << " [--synthetic] [dir...]\n";
+            return 2;
+        }
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(arg, fs::directory_options::skip_permission_denied, ec), end;
+             !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file() && !it->path().filename().string().starts_with(".")) paths.push_back(it->path());
+        }
+        if (ec) {
+            std::cerr << "cannot read " << arg << ": " << ec.message() << "\n";
+            return 2;
+        }
+    }
+
+    fs::path corpusDir;
+    if (synthetic) {
+        CorpusOptions opts = CorpusOptions::fromEnvironment();
+        corpusDir = fs::temp_directory_path() / ("worker-check-corpus-" + std::to_string(opts.seed));
+        auto generated = SyntheticCorpus::writeTo(corpusDir, SyntheticCorpus::generate(opts));
+        paths.insert(paths.end(), generated.begin(), generated.end());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    size_t compared = 0, mismatches = 0, unsupported = 0, unreadable = 0;
+    for (const fs::path& p : paths) {
+        PhotoData reference;
+        try {
+            reference = MetadataExtractor::extractWithExiv2(p.string());
+        } catch (const std::exception&) {
+            // Auch im Worker nicht verarbeitbar -> kein Vergleich möglich
+            unreadable++;
+            continue;
+        }
+        auto fast = MetadataExtractor::extractFast(p.string());
+        if (!fast) {
+            unsupported++;
+            continue;
+        }
+        compared++;
+        QStringList diffs = MetadataExtractor::differences(*fast, reference);
+        if (!diffs.isEmpty()) {
+            mismatches++;
+            std::cout << "MISMATCH " << p.string() << ": " << diffs.join(", ").toStdString() << "\n";
+        }
+    }
+
+    if (!corpusDir.empty()) {
+        std::error_code ec;
+        fs::remove_all(corpusDir, ec);
+    }
+
+    std::cout << paths.size() << " files: " << compared << " compared, " << mismatches << " mismatches, "
+              << unsupported << " unsupported by the fast path, " << unreadable << " unreadable\n";
+    if (compared == 0) {
+        std::cerr << "nothing compared\n";
+        return 2;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+// Synthetischen Corpus auf Platte schreiben, z.B. um ihn in die Inbox zu kopieren:
+//
+//   ./worker_make_corpus <zielordner> [anzahl] [seed]
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include "SyntheticCorpus.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <dir> [count] [seed]\n";
+        return 1;
+    }
+
+    CorpusOptions opts;
+    if (argc > 2) opts.count = static_cast<size_t>(std::max(1L, std::atol(argv[2])));
+    if (argc > 3) opts.seed = static_cast<uint32_t>(std::atol(argv[3]));
+
+    auto files = SyntheticCorpus::generate(opts);
+    auto paths = SyntheticCorpus::writeTo(argv[1], files);
+    std::cout << "Wrote " << paths.size() << " files to " << argv[1] << "\n";
+    return 0;
+}
@@ -0,0 +1,624 @@
+// End-to-End Last- und Dauertest gegen einen echten Worker-Prozess:
+//
+//   ./worker_soak --mode steady --rate 50 --duration 3600 --out soak.json
+//   ./worker_soak --mode burst --burst-size 500 --burst-period 60
+//   ./worker_soak --mode users --users 200 --rate 100
+//
+// Startet ein Wegwerf-PostgreSQL und den Worker (--worker, Default: der mitgebaute
+// CrowWorker) in einem Temp-Ordner und legt synthetische JPEGs in dessen uploads/.
+// Gemessen wird vom rename in uploads/ bis die Zeile in pictures sichtbar ist.
+// Dazu RSS, offene Dateien, Threads und DB-Verbindungen des Workers über die Zeit.
+//
+// Exit-Code: 0 ok, 1 Setup fehlgeschlagen, 2 SLO verletzt / Dateien verloren /
+// Verdacht auf ein Leck. Der JSON-Report enthält alle Werte und die Zeitreihe.
+#include <QCoreApplication>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <QtGlobal>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "DbPool.h"
+#include "SyntheticCorpus.h"
+#include "TempPostgres.h"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+enum class SoakMode { Steady, Burst, Users };
+
+struct SoakOptions {
+    SoakMode mode = SoakMode::Steady;
+    double rate = 20.0;              // Dateien/s (steady, users)
+    int duration = 60;               // Sekunden Last
+    int burstSize = 200;
+    int burstPeriod = 30;            // Sekunden zwischen zwei Bursts
+    int users = 1;                   // users: Default 200
+    int minKb = 0;                   // Dateigröße durch Auffüllen streuen
+    int maxKb = 0;
+    int drainTimeout = 120;          // nach der Last: so lange auf offene Dateien warten
+    int sampleInterval = 5;
+    int warmup = -1;                 // Sekunden ohne Leck-Auswertung, -1 = 10 % der Dauer
+    double sloP99Ms = 0.0;           // 0 = nicht prüfen
+    double rssSlopeMbPerHour = 64.0; // darüber gilt RSS als Leck
+    int fdTolerance = 16;
+    CorpusOptions corpus;
+    fs::path worker = WORKER_BINARY;
+    fs::path out = "soak-report.json";
+    bool keep = false;
+};
+
+static const char* modeName(SoakMode m) {
+    switch (m) {
+        case SoakMode::Burst: return "burst";
+        case SoakMode::Users: return "users";
+        default:              return "steady";
+    }
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [options]\n"
+              << "  --mode steady|burst|users   --rate N (files/s)   --duration S\n"
+              << "  --burst-size N   --burst-period S   --users N\n"
+              << "  --min-kb N --max-kb N   --max-keywords N   --gps-share F   --seed N\n"
+              << "  --drain-timeout S   --sample-interval S   --warmup S\n"
+              << "  --slo-p99-ms MS   --rss-slope-mb-h MB   --fd-tolerance N\n"
+              << "  --worker PATH   --out FILE   --keep\n";
+}
+
+static std::optional<SoakOptions> parseArgs(int argc, char** argv) {
+    SoakOptions o;
+    bool usersSet = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + a);
+            return argv[++i];
+        };
+        try {
+            if (a == "--mode") {
+                std::string m = next();
+                if (m == "steady") o.mode = SoakMode::Steady;
+                else if (m == "burst") o.mode = SoakMode::Burst;
+                else if (m == "users") o.mode = SoakMode::Users;
+                else throw std::invalid_argument("unknown mode " + m);
+            }
+            else if (a == "--rate") o.rate = std::stod(next());
+            else if (a == "--duration") o.duration = std::stoi(next());
+            else if (a == "--burst-size") o.burstSize = std::stoi(next());
+            else if (a == "--burst-period") o.burstPeriod = std::stoi(next());
+            else if (a == "--users") { o.users = std::stoi(next()); usersSet = true; }
+            else if (a == "--min-kb") o.minKb = std::stoi(next());
+            else if (a == "--max-kb") o.maxKb = std::stoi(next());
+            else if (a == "--max-keywords") o.corpus.maxKeywords = std::stoi(next());
+            else if (a == "--gps-share") o.corpus.gpsShare = std::stod(next());
+            else if (a == "--seed") o.corpus.seed = static_cast<uint32_t>(std::stoul(next()));
+            else if (a == "--drain-timeout") o.drainTimeout = std::stoi(next());
+            else if (a == "--sample-interval") o.sampleInterval = std::stoi(next());
+            else if (a == "--warmup") o.warmup = std::stoi(next());
+            else if (a == "--slo-p99-ms") o.sloP99Ms = std::stod(next());
+            else if (a == "--rss-slope-mb-h") o.rssSlopeMbPerHour = std::stod(next());
+            else if (a == "--fd-tolerance") o.fdTolerance = std::stoi(next());
+            else if (a == "--worker") o.worker = next();
+            else if (a == "--out") o.out = next();
+            else if (a == "--keep") o.keep = true;
+            else throw std::invalid_argument("unknown option " + a);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            usage(argv[0]);
+            return std::nullopt;
+        }
+    }
+    if (o.mode == SoakMode::Users && !usersSet) o.users = 200;
+    o.users = std::max(1, o.users);
+    o.rate = std::max(0.1, o.rate);
+    o.duration = std::max(1, o.duration);
+    o.sampleInterval = std::max(1, o.sampleInterval);
+    o.maxKb = std::max(o.minKb, o.maxKb);
+    if (o.warmup < 0) o.warmup = o.duration / 10;
+    return o;
+}
+
+// --- Worker-Prozess ---
+
+struct ProcessStats {
+    long rssKb = -1;
+    long threads = -1;
+    long fds = -1;
+};
+
+static ProcessStats processStats(pid_t pid) {
+    ProcessStats s;
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.starts_with("VmRSS:")) s.rssKb = std::atol(line.c_str() + 6);
+        else if (line.starts_with("Threads:")) s.threads = std::atol(line.c_str() + 8);
+    }
+    std::error_code ec;
+    long fds = 0;
+    for (fs::directory_iterator it("/proc/" + std::to_string(pid) + "/fd", ec), end; !ec && it != end; it.increment(ec)) {
+        ++fds;
+    }
+    if (!ec) s.fds = fds;
+    return s;
+}
+
+// Worker im Arbeitsordner starten (uploads/ und Photos/ sind dort relativ),
+// Ausgabe nach worker.log. PG_* hat TempPostgres schon gesetzt.
+static pid_t startWorker(const fs::path& binary, const fs::path& workDir) {
+    pid_t pid = ::fork();
+    if (pid != 0) return pid;
+
+    if (::chdir(workDir.c_str()) != 0) ::_exit(127);
+    int log = ::open("worker.log", O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (log >= 0) {
+        ::dup2(log, STDOUT_FILENO);
+        ::dup2(log, STDERR_FILENO);
+    }
+    ::setenv("QT_LOGGING_RULES", "*.debug=false", 0);
+    ::execl(binary.c_str(), binary.c_str(), static_cast<char*>(nullptr));
+    ::_exit(127);
+}
+
+// SIGTERM -> Worker fährt die Pipeline herunter; nach timeout SIGKILL
+static int stopWorker(pid_t pid, std::chrono::seconds timeout) {
+    ::kill(pid, SIGTERM);
+    auto deadline = Clock::now() + timeout;
+    int status = 0;
+    while (Clock::now() < deadline) {
+        pid_t r = ::waitpid(pid, &status, WNOHANG);
+        if (r == pid) return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::cerr << "Worker did not stop within " << timeout.count() << "s, killing it\n";
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, &status, 0);
+    return 128 + SIGKILL;
+}
+
+static bool workerAlive(pid_t pid) {
+    int status = 0;
+    return ::waitpid(pid, &status, WNOHANG) == 0;
+}
+
+// --- Last erzeugen ---
+
+struct Sample {
+    double t = 0.0;           // Sekunden seit Lastbeginn
+    ProcessStats proc;
+    long dbConnections = -1;
+    size_t written = 0;
+    size_t committed = 0;
+    size_t pending = 0;
+};
+
+class Soak {
+public:
+    Soak(SoakOptions opts, fs::path workDir) : opts_(std::move(opts)), inbox_(workDir / "uploads") {}
+
+    // Datei neben dem Ziel schreiben und per rename "erscheinen" lassen
+    // (Punkt-Dateien ignoriert der Worker)
+    bool drop(const std::string& user, size_t seq, std::mt19937& rng) {
+        CorpusFile f = SyntheticCorpus::makeFile(rng, opts_.corpus, seq);
+
+        // Inhalt eindeutig machen (COM-Segment), sonst greift die Duplikat-Erkennung
+        std::string tag = "soak " + std::to_string(seq);
+        std::vector<unsigned char> com = {0xFF, 0xFE, static_cast<unsigned char>((tag.size() + 2) >> 8),
+                                          static_cast<unsigned char>((tag.size() + 2) & 0xFF)};
+        com.insert(com.end(), tag.begin(), tag.end());
+        f.bytes.insert(f.bytes.begin() + 2, com.begin(), com.end());
+        if (opts_.maxKb > 0) {
+            size_t target = 1024 * std::uniform_int_distribution<size_t>(opts_.minKb, opts_.maxKb)(rng);
+            if (target > f.bytes.size()) f.bytes.resize(target, 0);   // hinter EOI, wird nicht dekodiert
+        }
+
+        // Muster aus dem Corpus, aber ohne dessen "user___"-Präfix
+        std::string name = SyntheticCorpus::makeFilename(rng, seq);
+        if (size_t sep = name.rfind("___"); sep != std::string::npos) name = name.substr(sep + 3);
+        const std::string cleanName = "s" + std::to_string(seq) + "_" + name;
+
+        const fs::path part = inbox_ / ("." + cleanName + ".part");
+        {
+            std::ofstream out(part, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(f.bytes.data()), static_cast<std::streamsize>(f.bytes.size()));
+            if (!out) return false;
+        }
+        const auto appeared = Clock::now();
+        {
+            std::lock_guard lock(mutex_);
+            pending_.emplace(cleanName, appeared);
+        }
+        std::error_code ec;
+        fs::rename(part, inbox_ / (user + "___" + cleanName), ec);
+        if (ec) {
+            std::lock_guard lock(mutex_);
+            pending_.erase(cleanName);
+            return false;
+        }
+        written_++;
+        bytes_ += f.bytes.size();
+        return true;
+    }
+
+    // Lastprofil abspielen; stop -> vorzeitig beenden
+    void produce(const std::atomic<bool>& stop) {
+        std::mt19937 rng(opts_.corpus.seed);
+        // users: wenige Vielnutzer, viele Gelegenheitsnutzer (Gewicht ~ 1/Rang)
+        std::vector<double> weights;
+        for (int u = 0; u < opts_.users; ++u) weights.push_back(opts_.mode == SoakMode::Users ? 1.0 / (u + 1) : 1.0);
+        std::discrete_distribution<int> pickUser(weights.begin(), weights.end());
+        auto user = [&] { return opts_.users == 1 ? std::string("soak") : "user" + std::to_string(pickUser(rng)); };
+
+        const auto end = start_ + std::chrono::seconds(opts_.duration);
+        size_t seq = 1;
+        if (opts_.mode == SoakMode::Burst) {
+            for (auto next = start_; next < end && !stop; next += std::chrono::seconds(opts_.burstPeriod)) {
+                std::this_thread::sleep_until(next);
+                for (int i = 0; i < opts_.burstSize && !stop; ++i) {
+                    if (!drop(user(), seq++, rng)) failedWrites_++;
+                }
+            }
+            return;
+        }
+        const auto gap = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opts_.rate));
+        // Fester Takt: ein langsames drop() holt die Verspätung wieder auf
+        for (auto next = start_; next < end && !stop; next += gap) {
+            std::this_thread::sleep_until(next);
+            if (!drop(user(), seq++, rng)) failedWrites_++;
+        }
+    }
+
+    // Neue Zeilen in pictures abholen. IDs werden vor dem Commit vergeben, parallele
+    // DB-Threads committen also nicht in ID-Reihenfolge -> alles über floor_ lesen,
+    // floor_ nur über lückenlos gesehene IDs (oder seit 30 s offene Lücken) schieben.
+    bool poll(QSqlDatabase& db) {
+        QSqlQuery q(db);
+        q.prepare("SELECT id, file_name FROM pictures WHERE id > ? ORDER BY id");
+        q.addBindValue(floor_);
+        if (!q.exec()) {
+            std::cerr << "Polling pictures failed: " << q.lastError().text().toStdString() << "\n";
+            return false;
+        }
+        const auto now = Clock::now();
+        while (q.next()) {
+            qint64 id = q.value(0).toLongLong();
+            if (!seen_.insert(id).second) continue;
+            std::string name = q.value(1).toString().toStdString();
+            std::lock_guard lock(mutex_);
+            auto it = pending_.find(name);
+            if (it == pending_.end()) continue;   // Canary oder fremde Datei
+            latenciesMs_.push_back(std::chrono::duration<double, std::milli>(now - it->second).count());
+            pending_.erase(it);
+            committed_++;
+        }
+
+        while (!seen_.empty() && *seen_.begin() == floor_ + 1) {
+            floor_ = *seen_.begin();
+            seen_.erase(seen_.begin());
+            gapSince_.reset();
+        }
+        if (!seen_.empty()) {
+            if (!gapSince_) gapSince_ = now;
+            else if (now - *gapSince_ > std::chrono::seconds(30)) {
+                floor_ = *seen_.begin() - 1;   // zurückgerollte ID, kommt nie mehr
+                gapSince_.reset();
+            }
+        }
+        return true;
+    }
+
+    static long dbConnections(QSqlDatabase& db) {
+        QSqlQuery q(db);
+        if (!q.exec("SELECT count(*) FROM pg_stat_activity WHERE datname = current_database() "
+                    "AND backend_type = 'client backend' AND pid <> pg_backend_pid()") || !q.next()) {
+            return -1;
+        }
+        return q.value(0).toLongLong();
+    }
+
+    Sample sample(QSqlDatabase& db, pid_t worker) {
+        Sample s;
+        s.t = std::chrono::duration<double>(Clock::now() - start_).count();
+        s.proc = processStats(worker);
+        s.dbConnections = dbConnections(db);
+        s.written = written_;
+        std::lock_guard lock(mutex_);
+        s.committed = committed_;
+        s.pending = pending_.size();
+        return s;
+    }
+
+    void begin() { start_ = Clock::now(); }
+    size_t pending() {
+        std::lock_guard lock(mutex_);
+        return pending_.size();
+    }
+
+    const SoakOptions& options() const { return opts_; }
+    std::vector<double> latencies() {
+        std::lock_guard lock(mutex_);
+        return latenciesMs_;
+    }
+    size_t written() const { return written_; }
+    size_t committed() const { return committed_; }
+    uint64_t bytes() const { return bytes_; }
+    size_t failedWrites() const { return failedWrites_; }
+    Clock::time_point started() const { return start_; }
+
+private:
+    SoakOptions opts_;
+    fs::path inbox_;
+    Clock::time_point start_;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Clock::time_point> pending_;   // file_name -> erschienen
+    std::vector<double> latenciesMs_;
+    size_t committed_ = 0;
+
+    std::atomic<size_t> written_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<size_t> failedWrites_{0};
+
+    qint64 floor_ = 0;
+    std::set<qint64> seen_;
+    std::optional<Clock::time_point> gapSince_;
+};
+
+// --- Auswertung ---
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(std::ceil(p * sorted.size())) - 1;
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+// Steigung per kleinster Quadrate, Einheit pro Sekunde
+static double slope(const std::vector<Sample>& s, auto value) {
+    if (s.size() < 2) return 0.0;
+    double n = static_cast<double>(s.size()), sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const Sample& x : s) {
+        double v = static_cast<double>(value(x));
+        sx += x.t;
+        sy += v;
+        sxx += x.t * x.t;
+        sxy += x.t * v;
+    }
+    double den = n * sxx - sx * sx;
+    return den == 0.0 ? 0.0 : (n * sxy - sx * sy) / den;
+}
+
+// Wächst ein Zähler dauerhaft? Minimum im letzten Viertel gegen Maximum im ersten
+// Viertel nach dem Warmup -> normale Schwankungen durch offene Dateien zählen nicht.
+struct Growth {
+    long start = -1;
+    long end = -1;
+    bool leak = false;
+};
+
+static Growth growth(const std::vector<Sample>& s, auto value, long tolerance) {
+    Growth g;
+    if (s.size() < 4) return g;
+    const size_t quarter = std::max<size_t>(1, s.size() / 4);
+    g.start = value(s[0]);
+    for (size_t i = 0; i < quarter; ++i) g.start = std::max(g.start, value(s[i]));
+    g.end = value(s.back());
+    for (size_t i = s.size() - quarter; i < s.size(); ++i) g.end = std::min(g.end, value(s[i]));
+    g.leak = g.start >= 0 && g.end > g.start + tolerance;
+    return g;
+}
+
+static std::string num(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", v);
+    return buf;
+}
+
+static std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+int main(int argc, char** argv) {
+    qputenv("QT_LOGGING_RULES", "*.debug=false");
+    QCoreApplication app(argc, argv);
+
+    auto parsed = parseArgs(argc, argv);
+    if (!parsed) return 1;
+    const SoakOptions opts = *parsed;
+    if (!fs::exists(opts.worker)) {
+        std::cerr << "Worker binary not found: " << opts.worker << "\n";
+        return 1;
+    }
+
+    const char* schema = std::getenv("BENCH_SCHEMA_FILE");
+    TempPostgres pg(schema ? schema : WORKER_SCHEMA_FILE);
+    if (!pg.isRunning()) {
+        std::cerr << "PostgreSQL not available: " << pg.error() << "\n";
+        return 1;
+    }
+
+    std::string templ = (fs::temp_directory_path() / "worker-soak-XXXXXX").string();
+    if (!::mkdtemp(templ.data())) {
+        std::cerr << "mkdtemp failed\n";
+        return 1;
+    }
+    const fs::path workDir = templ;
+    fs::create_directories(workDir / "uploads");
+
+    const pid_t worker = startWorker(opts.worker, workDir);
+    if (worker < 0) {
+        std::cerr << "fork failed: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cerr << "Worker pid " << worker << " in " << workDir.string() << "\n";
+
+    int rc = 0;
+    std::vector<Sample> samples;
+    double loadSeconds = 0.0;
+    int workerExit = -1;
+    {
+        DbPool::Lease lease = DbPool::instance().acquire();
+        if (!lease.isValid()) {
+            stopWorker(worker, std::chrono::seconds(30));
+            return 1;
+        }
+        QSqlDatabase& db = lease.db();
+
+        // Bereit, sobald eine Testdatei durch die ganze Pipeline gelaufen ist
+        Soak canary(opts, workDir);
+        std::mt19937 canaryRng(1);
+        canary.begin();
+        canary.drop("soak", 0, canaryRng);
+        auto readyBy = Clock::now() + std::chrono::seconds(120);
+        while (canary.pending() > 0 && Clock::now() < readyBy && workerAlive(worker)) {
+            canary.poll(db);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (canary.pending() > 0) {
+            std::cerr << "Worker did not become ready, see " << (workDir / "worker.log").string() << "\n";
+            if (workerAlive(worker)) stopWorker(worker, std::chrono::seconds(30));
+            return 1;
+        }
+        Soak measured(opts, workDir);
+        std::cerr << "Worker ready, running " << modeName(opts.mode) << " load for " << opts.duration << "s\n";
+
+        std::atomic<bool> stop{false};
+        measured.begin();
+        std::thread producer([&] { measured.produce(stop); });
+
+        // Abholen alle 20 ms, Stichprobe alle sampleInterval Sekunden
+        const auto loadEnd = measured.started() + std::chrono::seconds(opts.duration);
+        auto nextSample = measured.started();
+        auto drainDeadline = loadEnd + std::chrono::seconds(opts.drainTimeout);
+        bool producing = true;
+        while (true) {
+            if (!workerAlive(worker)) {
+                std::cerr << "Worker exited during the run\n";
+                stop = true;
+                rc = 2;
+                break;
+            }
+            measured.poll(db);
+            auto now = Clock::now();
+            if (now >= nextSample) {
+                samples.push_back(measured.sample(db, worker));
+                const Sample& s = samples.back();
+                std::cerr << "t=" << static_cast<int>(s.t) << "s written=" << s.written << " committed=" << s.committed
+                          << " pending=" << s.pending << " rss=" << s.proc.rssKb / 1024 << "MiB fds=" << s.proc.fds
+                          << " conns=" << s.dbConnections << "\n";
+                nextSample += std::chrono::seconds(opts.sampleInterval);
+            }
+            if (producing && now >= loadEnd) producing = false;
+            if (!producing && measured.pending() == 0 && measured.written() > 0) break;
+            if (now >= drainDeadline) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        stop = true;
+        producer.join();
+        samples.push_back(measured.sample(db, worker));
+        loadSeconds = std::chrono::duration<double>(Clock::now() - measured.started()).count();
+
+        // --- Report ---
+        std::vector<double> lat = measured.latencies();
+        std::sort(lat.begin(), lat.end());
+        double mean = 0.0;
+        for (double v : lat) mean += v;
+        if (!lat.empty()) mean /= static_cast<double>(lat.size());
+        const double p99 = percentile(lat, 0.99);
+        const size_t lost = measured.written() - measured.committed();
+
+        std::vector<Sample> steady;
+        for (const Sample& s : samples) {
+            if (s.t >= opts.warmup) steady.push_back(s);
+        }
+        const double rssSlope = slope(steady, [](const Sample& s) { return s.proc.rssKb; }) * 3600.0 / 1024.0;
+        const bool rssLeak = steady.size() >= 4 && rssSlope > opts.rssSlopeMbPerHour;
+        Growth fds = growth(steady, [](const Sample& s) { return s.proc.fds; }, opts.fdTolerance);
+        Growth threads = growth(steady, [](const Sample& s) { return s.proc.threads; }, 0);
+        Growth conns = growth(steady, [](const Sample& s) { return s.dbConnections; }, 0);
+        const bool sloOk = opts.sloP99Ms <= 0.0 || p99 <= opts.sloP99Ms;
+
+        if (!sloOk || lost > 0 || rssLeak || fds.leak || threads.leak || conns.leak) rc = 2;
+
+        std::ostringstream j;
+        j << "{\n";
+        j << "  \"worker_git_commit\": " << jsonString(WORKER_GIT_COMMIT) << ",\n";
+        j << "  \"config\": {\"mode\": " << jsonString(modeName(opts.mode)) << ", \"rate\": " << num(opts.rate)
+          << ", \"duration_s\": " << opts.duration << ", \"burst_size\": " << opts.burstSize
+          << ", \"burst_period_s\": " << opts.burstPeriod << ", \"users\": " << opts.users
+          << ", \"min_kb\": " << opts.minKb << ", \"max_kb\": " << opts.maxKb
+          << ", \"max_keywords\": " << opts.corpus.maxKeywords << ", \"gps_share\": " << num(opts.corpus.gpsShare)
+          << ", \"seed\": " << opts.corpus.seed << ", \"warmup_s\": " << opts.warmup << "},\n";
+        j << "  \"files\": {\"written\": " << measured.written() << ", \"committed\": " << measured.committed()
+          << ", \"lost\": " << lost << ", \"write_errors\": " << measured.failedWrites()
+          << ", \"bytes\": " << measured.bytes() << "},\n";
+        j << "  \"latency_ms\": {\"p50\": " << num(percentile(lat, 0.5)) << ", \"p90\": " << num(percentile(lat, 0.9))
+          << ", \"p99\": " << num(p99) << ", \"p999\": " << num(percentile(lat, 0.999))
+          << ", \"max\": " << num(lat.empty() ? 0.0 : lat.back()) << ", \"mean\": " << num(mean)
+          << ", \"poll_resolution_ms\": 20},\n";
+        j << "  \"throughput\": {\"seconds\": " << num(loadSeconds)
+          << ", \"files_per_s\": " << num(measured.committed() / loadSeconds)
+          << ", \"mib_per_s\": " << num(measured.bytes() / loadSeconds / (1024.0 * 1024.0)) << "},\n";
+        j << "  \"resources\": {\"rss_kb_start\": " << (steady.empty() ? -1 : steady.front().proc.rssKb)
+          << ", \"rss_kb_end\": " << samples.back().proc.rssKb << ", \"rss_slope_mb_per_h\": " << num(rssSlope)
+          << ", \"fds_start\": " << fds.start << ", \"fds_end\": " << fds.end
+          << ", \"threads_start\": " << threads.start << ", \"threads_end\": " << threads.end
+          << ", \"db_connections_start\": " << conns.start << ", \"db_connections_end\": " << conns.end << "},\n";
+        j << "  \"leaks\": {\"rss\": " << (rssLeak ? "true" : "false") << ", \"fds\": " << (fds.leak ? "true" : "false")
+          << ", \"threads\": " << (threads.leak ? "true" : "false")
+          << ", \"db_connections\": " << (conns.leak ? "true" : "false") << "},\n";
+        j << "  \"slo\": {\"p99_ms\": " << num(opts.sloP99Ms) << ", \"ok\": " << (sloOk ? "true" : "false") << "},\n";
+        j << "  \"samples\": [";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const Sample& s = samples[i];
+            j << (i ? ",\n    " : "\n    ") << "{\"t\": " << num(s.t) << ", \"rss_kb\": " << s.proc.rssKb
+              << ", \"fds\": " << s.proc.fds << ", \"threads\": " << s.proc.threads
+              << ", \"db_connections\": " << s.dbConnections << ", \"written\": " << s.written
+              << ", \"committed\": " << s.committed << ", \"pending\": " << s.pending << "}";
+        }
+        j << "\n  ],\n";
+
+        if (workerAlive(worker)) workerExit = stopWorker(worker, std::chrono::seconds(60));
+        j << "  \"worker_exit\": " << workerExit << ",\n";
+        j << "  \"result\": " << jsonString(rc == 0 ? "pass" : "fail") << "\n}\n";
+
+        std::ofstream(opts.out) << j.str();
+        std::cerr << "p50=" << num(percentile(lat, 0.5)) << "ms p99=" << num(p99)
+                  << "ms p999=" << num(percentile(lat, 0.999)) << "ms lost=" << lost
+                  << " -> " << opts.out.string() << "\n";
+    }
+    DbPool::instance().releaseThread();
+
+    if (!opts.keep) {
+        std::error_code ec;
+        fs::remove_all(workDir, ec);
+    } else {
+        std::cerr << "Keeping " << workDir.string() << "\n";
+    }
+    return rc;
+}
@@ -0,0 +1,422 @@
+#include "SyntheticCorpus.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+using Bytes = std::vector<unsigned char>;
+
+CorpusOptions CorpusOptions::fromEnvironment() {
+    CorpusOptions opts;
+    if (const char* v = std::getenv("BENCH_CORPUS_SIZE")) opts.count = std::max(1L, std::atol(v));
+    if (const char* v = std::getenv("BENCH_CORPUS_SEED")) opts.seed = static_cast<uint32_t>(std::atol(v));
+    return opts;
+}
+
+// --- Bausteine ---
+
+static void put16be(Bytes& b, uint16_t v) {
+    b.push_back(static_cast<unsigned char>(v >> 8));
+    b.push_back(static_cast<unsigned char>(v));
+}
+
+static void put32be(Bytes& b, uint32_t v) {
+    put16be(b, static_cast<uint16_t>(v >> 16));
+    put16be(b, static_cast<uint16_t>(v));
+}
+
+static void append(Bytes& b, std::string_view s) {
+    b.insert(b.end(), s.begin(), s.end());
+}
+
+static void segment(Bytes& out, unsigned char marker, const Bytes& payload) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    put16be(out, static_cast<uint16_t>(payload.size() + 2));
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+template <typename T>
+static const T& pick(std::mt19937& rng, const std::vector<T>& v) {
+    return v[std::uniform_int_distribution<size_t>(0, v.size() - 1)(rng)];
+}
+
+static bool chance(std::mt19937& rng, double p) {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+}
+
+static int randInt(std::mt19937& rng, int lo, int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+// --- TIFF / Exif ---
+
+// Schreibt IFD0 -> ExifIFD -> GPS-IFD hintereinander, in wählbarer Byte-Order
+class TiffBuilder {
+public:
+    struct Entry {
+        uint16_t tag;
+        uint16_t type;
+        uint32_t count;
+        Bytes data;
+    };
+
+    explicit TiffBuilder(bool littleEndian) : le_(littleEndian) {}
+
+    Entry ascii(uint16_t tag, const std::string& s) const {
+        Bytes d(s.begin(), s.end());
+        d.push_back(0);
+        return {tag, 2, static_cast<uint32_t>(d.size()), d};
+    }
+    Entry shortValue(uint16_t tag, uint16_t v) const {
+        Bytes d;
+        put16(d, v);
+        return {tag, 3, 1, d};
+    }
+    Entry byteValue(uint16_t tag, unsigned char v) const {
+        return {tag, 1, 1, Bytes{v}};
+    }
+    Entry rationals(uint16_t tag, const std::vector<std::pair<uint32_t, uint32_t>>& values) const {
+        Bytes d;
+        for (auto [num, den] : values) {
+            put32(d, num);
+            put32(d, den);
+        }
+        return {tag, 5, static_cast<uint32_t>(values.size()), d};
+    }
+
+    Bytes build(std::vector<Entry> ifd0, const std::vector<Entry>& exif, const std::vector<Entry>& gps) const {
+        // Offsets vorab berechnen: Pointer-Einträge sind LONG und liegen inline
+        if (!exif.empty()) ifd0.push_back({0x8769, 4, 1, Bytes(4)});
+        if (!gps.empty()) ifd0.push_back({0x8825, 4, 1, Bytes(4)});
+
+        uint32_t off0 = 8;
+        uint32_t offExif = off0 + ifdSize(ifd0) + dataSize(ifd0);
+        uint32_t offGps = offExif + (exif.empty() ? 0 : ifdSize(exif) + dataSize(exif));
+
+        for (auto& e : ifd0) {
+            if (e.tag == 0x8769) { e.data.clear(); put32(e.data, offExif); }
+            if (e.tag == 0x8825) { e.data.clear(); put32(e.data, offGps); }
+        }
+
+        Bytes out;
+        append(out, le_ ? "II" : "MM");
+        put16(out, 42);
+        put32(out, off0);
+        writeIfd(out, ifd0, off0);
+        if (!exif.empty()) writeIfd(out, exif, offExif);
+        if (!gps.empty()) writeIfd(out, gps, offGps);
+        return out;
+    }
+
+private:
+    void put16(Bytes& b, uint16_t v) const {
+        if (le_) {
+            b.push_back(static_cast<unsigned char>(v));
+            b.push_back(static_cast<unsigned char>(v >> 8));
+        } else {
+            put16be(b, v);
+        }
+    }
+    void put32(Bytes& b, uint32_t v) const {
+        if (le_) {
+            put16(b, static_cast<uint16_t>(v));
+            put16(b, static_cast<uint16_t>(v >> 16));
+        } else {
+            put32be(b, v);
+        }
+    }
+
+    static uint32_t ifdSize(const std::vector<Entry>& entries) {
+        return static_cast<uint32_t>(2 + entries.size() * 12 + 4);
+    }
+    static uint32_t dataSize(const std::vector<Entry>& entries) {
+        uint32_t size = 0;
+        for (const auto& e : entries) {
+            if (e.data.size() > 4) size += static_cast<uint32_t>(e.data.size() + (e.data.size() & 1));
+        }
+        return size;
+    }
+
+    void writeIfd(Bytes& out, std::vector<Entry> entries, uint32_t offset) const {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+        uint32_t dataOff = offset + ifdSize(entries);
+        Bytes data;
+
+        put16(out, static_cast<uint16_t>(entries.size()));
+        for (const auto& e : entries) {
+            put16(out, e.tag);
+            put16(out, e.type);
+            put32(out, e.count);
+            if (e.data.size() <= 4) {
+                Bytes inline4 = e.data;
+                inline4.resize(4, 0);
+                out.insert(out.end(), inline4.begin(), inline4.end());
+            } else {
+                put32(out, dataOff + static_cast<uint32_t>(data.size()));
+                data.insert(data.end(), e.data.begin(), e.data.end());
+                if (data.size() & 1) data.push_back(0);
+            }
+        }
+        put32(out, 0);   // kein weiteres IFD
+        out.insert(out.end(), data.begin(), data.end());
+    }
+
+    bool le_;
+};
+
+// --- Wortlisten ---
+
+static const std::vector<std::string> MAKES = {"Canon", "NIKON CORPORATION", "SONY", "FUJIFILM", "Apple", "Google", "samsung"};
+static const std::vector<std::string> MODELS = {"EOS R5", "NIKON Z 6_2", "ILCE-7M3", "X-T4", "iPhone 14 Pro", "Pixel 7", "SM-S911B"};
+static const std::vector<std::string> CITIES = {"Berlin", "München", "Shanghai", "Beijing", "Paris", "Lisboa", "New York", "Zürich"};
+static const std::vector<std::string> PROVINCES = {"Berlin", "Bayern", "Shanghai", "Île-de-France", "Lisboa", "NY", "ZH"};
+static const std::vector<std::string> COUNTRIES = {"Deutschland", "China", "France", "Portugal", "USA", "Schweiz"};
+static const std::vector<std::string> COUNTRY_CODES = {"DEU", "CHN", "FRA", "PRT", "USA", "CHE"};
+static const std::vector<std::string> WORDS = {
+    "Urlaub", "Familie", "Sommer", "Winter", "Strand", "Berge", "Stadt", "Nacht", "Essen", "Hochzeit",
+    "Geburtstag", "Hund", "Katze", "Architektur", "Sonnenuntergang", "Wald", "See", "Schnee", "Konzert", "Museum",
+    "Markt", "Brücke", "Fluss", "Park", "Kinder", "Freunde", "Reise", "Zug", "Flughafen", "Garten"};
+
+static std::string keyword(std::mt19937& rng) {
+    // Gemischt: häufige Wörter und eine lange Liste seltener Tags
+    if (chance(rng, 0.7)) return pick(rng, WORDS);
+    return "tag" + std::to_string(randInt(rng, 1, 5000));
+}
+
+static std::string xmlEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+// --- Segmente ---
+
+static Bytes exifSegment(std::mt19937& rng, bool withGps, const std::string& dateTime) {
+    TiffBuilder t(chance(rng, 0.5));
+    size_t cam = std::uniform_int_distribution<size_t>(0, MAKES.size() - 1)(rng);
+
+    std::vector<TiffBuilder::Entry> ifd0 = {
+        t.ascii(0x010F, MAKES[cam]),
+        t.ascii(0x0110, MODELS[cam]),
+        t.ascii(0x0131, "SyntheticCorpus 1.0"),   // Software, nur Ballast
+    };
+    std::vector<TiffBuilder::Entry> exif = {
+        t.rationals(0x829A, {{1, static_cast<uint32_t>(pick(rng, std::vector<int>{30, 60, 125, 250, 1000}))}}),
+        t.rationals(0x829D, {{static_cast<uint32_t>(randInt(rng, 14, 160)), 10}}),
+        t.shortValue(0x8827, static_cast<uint16_t>(pick(rng, std::vector<int>{100, 200, 400, 800, 3200}))),
+        t.ascii(0x9003, dateTime),
+        t.ascii(0x9004, dateTime),
+    };
+    std::vector<TiffBuilder::Entry> gps;
+    if (withGps) {
+        auto dms = [&](int maxDeg) {
+            return std::vector<std::pair<uint32_t, uint32_t>>{
+                {static_cast<uint32_t>(randInt(rng, 0, maxDeg)), 1},
+                {static_cast<uint32_t>(randInt(rng, 0, 59)), 1},
+                {static_cast<uint32_t>(randInt(rng, 0, 5999)), 100}};
+        };
+        gps = {
+            t.ascii(1, chance(rng, 0.8) ? "N" : "S"),
+            t.rationals(2, dms(89)),
+            t.ascii(3, chance(rng, 0.7) ? "E" : "W"),
+            t.rationals(4, dms(179)),
+            t.byteValue(5, chance(rng, 0.95) ? 0 : 1),
+            t.rationals(6, {{static_cast<uint32_t>(randInt(rng, 0, 40000)), 10}}),
+        };
+    }
+
+    Bytes seg;
+    append(seg, std::string_view("Exif\0\0", 6));
+    Bytes tiff = t.build(ifd0, exif, gps);
+    seg.insert(seg.end(), tiff.begin(), tiff.end());
+    return seg;
+}
+
+static void iptcDataset(Bytes& out, unsigned char dataset, const std::string& value) {
+    out.push_back(0x1C);
+    out.push_back(2);
+    out.push_back(dataset);
+    put16be(out, static_cast<uint16_t>(value.size()));
+    append(out, value);
+}
+
+static Bytes iptcSegment(std::mt19937& rng, const std::vector<std::string>& keywords, size_t place) {
+    Bytes iptc;
+    iptcDataset(iptc, 0, std::string("\x00\x04", 2));   // RecordVersion
+    iptcDataset(iptc, 5, "Bild " + std::to_string(randInt(rng, 1, 99999)));
+    for (const auto& k : keywords) iptcDataset(iptc, 25, k);
+    iptcDataset(iptc, 90, CITIES[place % CITIES.size()]);
+    iptcDataset(iptc, 95, PROVINCES[place % PROVINCES.size()]);
+    iptcDataset(iptc, 100, COUNTRY_CODES[place % COUNTRY_CODES.size()]);
+    iptcDataset(iptc, 101, COUNTRIES[place % COUNTRIES.size()]);
+    iptcDataset(iptc, 116, "(c) Synthetic");
+    if (chance(rng, 0.5)) iptcDataset(iptc, 120, "Beschreibung mit Umlauten: äöü ß");
+
+    Bytes seg;
+    append(seg, std::string_view("Photoshop 3.0\0", 14));
+    append(seg, "8BIM");
+    put16be(seg, 0x0404);
+    put16be(seg, 0);   // leerer Pascal-Name, auf gerade Länge aufgefüllt
+    put32be(seg, static_cast<uint32_t>(iptc.size()));
+    seg.insert(seg.end(), iptc.begin(), iptc.end());
+    if (iptc.size() & 1) seg.push_back(0);
+    return seg;
+}
+
+static Bytes xmpSegment(std::mt19937& rng, const std::vector<std::string>& keywords, size_t place) {
+    std::string xml =
+        "<?xpacket begin=\"\xEF\xBB\xBF\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?>\n"
+        "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">\n"
+        " <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+        "  <rdf:Description rdf:about=\"\"\n"
+        "    xmlns:dc=\"http://purl.org/dc/elements/1.1/\"\n"
+        "    xmlns:photoshop=\"http://ns.adobe.com/photoshop/1.0/\"\n"
+        "    xmlns:Iptc4xmpCore=\"http://iptc.org/std/Iptc4xmpCore/1.0/xmlns/\"\n"
+        "    photoshop:City=\"" + xmlEscape(CITIES[place % CITIES.size()]) + "\"\n"
+        "    photoshop:Country=\"" + xmlEscape(COUNTRIES[place % COUNTRIES.size()]) + "\">\n"
+        "   <Iptc4xmpCore:CountryCode>" + COUNTRY_CODES[place % COUNTRY_CODES.size()] + "</Iptc4xmpCore:CountryCode>\n";
+    if (!keywords.empty()) {
+        xml += "   <dc:subject>\n    <rdf:Bag>\n";
+        for (const auto& k : keywords) xml += "     <rdf:li>" + xmlEscape(k) + "</rdf:li>\n";
+        xml += "    </rdf:Bag>\n   </dc:subject>\n";
+    }
+    xml += "   <dc:title>\n    <rdf:Alt>\n     <rdf:li xml:lang=\"x-default\">Titel &amp; " +
+           std::to_string(randInt(rng, 1, 999)) + "</rdf:li>\n    </rdf:Alt>\n   </dc:title>\n";
+    xml += "  </rdf:Description>\n </rdf:RDF>\n</x:xmpmeta>\n";
+    xml += std::string(static_cast<size_t>(randInt(rng, 0, 2048)), ' ');   // Padding wie bei echten Dateien
+    xml += "<?xpacket end=\"w\"?>";
+
+    Bytes seg;
+    append(seg, std::string_view("http://ns.adobe.com/xap/1.0/\0", 29));
+    append(seg, xml);
+    return seg;
+}
+
+// --- Öffentliche Funktionen ---
+
+std::vector<unsigned char> SyntheticCorpus::plainJpeg(int width, int height) {
+    Bytes body;
+
+    // DQT: eine Tabelle, alle Faktoren 1
+    Bytes dqt{0x00};
+    dqt.insert(dqt.end(), 64, 1);
+    segment(body, 0xDB, dqt);
+
+    // SOF0: 8 Bit, eine Komponente, 1x1 Sampling, Tabelle 0
+    Bytes sof{8};
+    put16be(sof, static_cast<uint16_t>(height));
+    put16be(sof, static_cast<uint16_t>(width));
+    sof.insert(sof.end(), {1, 1, 0x11, 0});
+    segment(body, 0xC0, sof);
+
+    // DHT: DC und AC jeweils genau ein Code der Länge 1 ("0")
+    // DC-Symbol 0 (keine Differenz), AC-Symbol 0x00 (EOB)
+    for (unsigned char tableClass : {0x00, 0x10}) {
+        Bytes dht{tableClass};
+        dht.push_back(1);
+        dht.insert(dht.end(), 15, 0);
+        dht.push_back(0x00);
+        segment(body, 0xC4, dht);
+    }
+
+    segment(body, 0xDA, Bytes{1, 1, 0x00, 0, 63, 0});
+
+    // Pro 8x8-Block zwei 0-Bits, Rest mit 1 auffüllen
+    size_t blocks = static_cast<size_t>((width + 7) / 8) * static_cast<size_t>((height + 7) / 8);
+    size_t bits = blocks * 2;
+    body.insert(body.end(), bits / 8, 0x00);
+    if (bits % 8) body.push_back(static_cast<unsigned char>(0xFF >> (bits % 8)));
+
+    body.push_back(0xFF);
+    body.push_back(0xD9);
+    return body;
+}
+
+std::string SyntheticCorpus::makeFilename(std::mt19937& rng, size_t index) {
+    int y = randInt(rng, 2005, 2025), mo = randInt(rng, 1, 12), d = randInt(rng, 1, 28);
+    int h = randInt(rng, 0, 23), mi = randInt(rng, 0, 59), s = randInt(rng, 0, 59);
+    char buf[128];
+
+    switch (randInt(rng, 0, 7)) {
+        case 0: std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d_%02d%02d%02d.jpg", y, mo, d, h, mi, s); break;
+        case 1: std::snprintf(buf, sizeof(buf), "IMG_%04d%02d%02d_%02d%02d%02d.jpg", y, mo, d, h, mi, s); break;
+        case 2: std::snprintf(buf, sizeof(buf), "PXL_%04d%02d%02d_%02d%02d%02d%03d.jpg", y, mo, d, h, mi, s, randInt(rng, 0, 999)); break;
+        case 3: std::snprintf(buf, sizeof(buf), "WhatsApp Image %04d-%02d-%02d at %02d.%02d.%02d.jpeg", y, mo, d, h, mi, s); break;
+        case 4: std::snprintf(buf, sizeof(buf), "DSC_%04zu.JPG", index % 10000); break;
+        case 5: std::snprintf(buf, sizeof(buf), "user%d___%04d___%04d-%02d-%02d_%02d%02d%02d.jpg", randInt(rng, 1, 50), y, y, mo, d, h, mi, s); break;
+        case 6: std::snprintf(buf, sizeof(buf), "user%d___Urlaub %04d %zu.jpg", randInt(rng, 1, 50), y, index); break;
+        default: std::snprintf(buf, sizeof(buf), "photo_%zu.jpg", index); break;
+    }
+    return buf;
+}
+
+CorpusFile SyntheticCorpus::makeFile(std::mt19937& rng, const CorpusOptions& opts, size_t index) {
+    static const std::vector<std::pair<int, int>> SIZES = {{640, 480}, {1024, 768}, {1600, 1200}, {4000, 3000}, {3024, 4032}};
+
+    CorpusFile f;
+    auto [w, h] = pick(rng, SIZES);
+    f.width = w;
+    f.height = h;
+    f.hasExif = chance(rng, opts.exifShare);
+    f.hasGps = f.hasExif && chance(rng, opts.gpsShare);
+    f.hasIptc = chance(rng, opts.iptcShare);
+    f.hasXmp = chance(rng, opts.xmpShare);
+    f.keywordCount = randInt(rng, 0, opts.maxKeywords);
+
+    std::vector<std::string> keywords;
+    for (int i = 0; i < f.keywordCount; ++i) keywords.push_back(keyword(rng));
+    size_t place = std::uniform_int_distribution<size_t>(0, 100)(rng);
+
+    char date[32];
+    std::snprintf(date, sizeof(date), "%04d:%02d:%02d %02d:%02d:%02d", randInt(rng, 2005, 2025), randInt(rng, 1, 12),
+                  randInt(rng, 1, 28), randInt(rng, 0, 23), randInt(rng, 0, 59), randInt(rng, 0, 59));
+
+    Bytes out{0xFF, 0xD8};
+    segment(out, 0xE0, Bytes{'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0});
+    if (f.hasExif) segment(out, 0xE1, exifSegment(rng, f.hasGps, date));
+    if (f.hasXmp) segment(out, 0xE1, xmpSegment(rng, keywords, place));
+    if (f.hasIptc) segment(out, 0xED, iptcSegment(rng, keywords, place));
+
+    Bytes frame = plainJpeg(w, h);
+    out.insert(out.end(), frame.begin(), frame.end());
+    f.bytes = std::move(out);
+
+    // Eindeutiger Name, damit sich Dateien im Corpus-Ordner nicht überschreiben
+    f.name = std::to_string(index) + "_" + makeFilename(rng, index);
+    return f;
+}
+
+std::vector<CorpusFile> SyntheticCorpus::generate(const CorpusOptions& opts) {
+    std::mt19937 rng(opts.seed);
+    std::vector<CorpusFile> files;
+    files.reserve(opts.count);
+    for (size_t i = 0; i < opts.count; ++i) files.push_back(makeFile(rng, opts, i));
+    return files;
+}
+
+std::vector<fs::path> SyntheticCorpus::writeTo(const fs::path& dir, const std::vector<CorpusFile>& files) {
+    fs::create_directories(dir);
+    std::vector<fs::path> paths;
+    paths.reserve(files.size());
+    for (const auto& f : files) {
+        fs::path p = dir / f.name;
+        std::ofstream out(p, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(f.bytes.data()), static_cast<std::streamsize>(f.bytes.size()));
+        paths.push_back(p);
+    }
+    return paths;
+}
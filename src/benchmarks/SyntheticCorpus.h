@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// Erzeugt synthetische JPEGs mit unterschiedlich großen Exif/IPTC/XMP-Blöcken.
+// Die Bilddaten sind ein gültiger, einfarbiger Baseline-Scan (1 Komponente),
+// d.h. Exiv2 und libjpeg können die Dateien normal lesen.
+struct CorpusOptions {
+    size_t count = 200;
+    uint32_t seed = 42;
+    int maxKeywords = 24;
+    double exifShare = 0.9;    // Anteil Dateien mit Exif
+    double gpsShare = 0.6;     // davon mit GPS
+    double iptcShare = 0.6;
+    double xmpShare = 0.5;
+
+    // BENCH_CORPUS_SIZE, BENCH_CORPUS_SEED
+    static CorpusOptions fromEnvironment();
+};
+
+struct CorpusFile {
+    std::string name;
+    std::vector<unsigned char> bytes;
+    int width = 0;
+    int height = 0;
+    int keywordCount = 0;
+    bool hasExif = false;
+    bool hasGps = false;
+    bool hasIptc = false;
+    bool hasXmp = false;
+};
+
+class SyntheticCorpus {
+public:
+    static std::vector<CorpusFile> generate(const CorpusOptions& opts);
+    static CorpusFile makeFile(std::mt19937& rng, const CorpusOptions& opts, size_t index);
+
+    // Dateinamen in den Varianten, die im Upload-Ordner vorkommen
+    // (user___..., IMG_/PXL_/WhatsApp/DSC, YYYY-MM-DD_HHMMSS, ...)
+    static std::string makeFilename(std::mt19937& rng, size_t index);
+
+    // Nur den einfarbigen JPEG-Rahmen (ohne Metadaten)
+    static std::vector<unsigned char> plainJpeg(int width, int height);
+
+    // Alle Dateien nach dir schreiben, liefert die Pfade
+    static std::vector<std::filesystem::path> writeTo(const std::filesystem::path& dir,
+                                                      const std::vector<CorpusFile>& files);
+};
@@ -0,0 +1,105 @@
+#include "TempPostgres.h"
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Ausgabe eines Kommandos (erste Zeile), leer bei Fehler
+static std::string firstLineOf(const std::string& cmd) {
+    std::string out;
+    if (FILE* p = ::popen(cmd.c_str(), "r")) {
+        std::array<char, 512> buf{};
+        if (std::fgets(buf.data(), static_cast<int>(buf.size()), p)) out = buf.data();
+        ::pclose(p);
+    }
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) out.pop_back();
+    return out;
+}
+
+static std::string quote(const std::string& s) {
+    std::string out = "'";
+    for (char c : s) {
+        if (c == '\'') out += "'\\''";
+        else out += c;
+    }
+    return out + "'";
+}
+
+TempPostgres::TempPostgres(const fs::path& schemaFile) {
+    if (const char* v = std::getenv("PG_BIN_DIR")) binDir_ = v;
+    else binDir_ = firstLineOf("pg_config --bindir 2>/dev/null");
+
+    // Unix-Socket-Pfade sind auf ~100 Zeichen begrenzt -> kurzer Ordnername
+    std::string templ = (fs::temp_directory_path() / "wgbench-XXXXXX").string();
+    if (!::mkdtemp(templ.data())) {
+        error_ = "mkdtemp failed";
+        return;
+    }
+    dir_ = templ;
+    port_ = 50000 + static_cast<int>(::getpid() % 10000);
+
+    std::string data = (dir_ / "data").string();
+    std::string log = (dir_ / "postgres.log").string();
+
+    if (!run(bin("initdb") + " -D " + quote(data) + " -U worker -A trust -E UTF8 --no-sync >/dev/null", "initdb")) return;
+
+    std::string opts = "-p " + std::to_string(port_) + " -k " + dir_.string() + " -c listen_addresses=''";
+    if (!run(bin("pg_ctl") + " -D " + quote(data) + " -o " + quote(opts) + " -l " + quote(log) + " -w start >/dev/null",
+             "pg_ctl start")) {
+        return;
+    }
+    running_ = true;
+
+    if (!run(psql("postgres") + " -c 'CREATE DATABASE \"Photos\"' >/dev/null", "create database") ||
+        !run(psql("Photos") + " -f " + quote(schemaFile.string()) + " >/dev/null", "load schema")) {
+        return;
+    }
+
+    // DbPool liest diese Variablen beim ersten instance()
+    ::setenv("PG_HOST", dir_.c_str(), 1);
+    ::setenv("PG_PORT", std::to_string(port_).c_str(), 1);
+    ::setenv("PG_DB", "Photos", 1);
+    ::setenv("PG_USER", "worker", 1);
+    ::setenv("PG_PASS", "unused", 1);
+}
+
+TempPostgres::~TempPostgres() {
+    if (running_) {
+        std::string data = (dir_ / "data").string();
+        std::system((bin("pg_ctl") + " -D " + quote(data) + " -m immediate -w stop >/dev/null 2>&1").c_str());
+    }
+    if (!dir_.empty()) {
+        std::error_code ec;
+        fs::remove_all(dir_, ec);
+    }
+}
+
+bool TempPostgres::truncateAll() const {
+    if (!running_) return false;
+    std::string sql = "TRUNCATE pictures, keywords RESTART IDENTITY CASCADE";
+    return std::system((psql("Photos") + " -c " + quote(sql) + " >/dev/null").c_str()) == 0;
+}
+
+bool TempPostgres::run(const std::string& cmd, const std::string& what) {
+    if (std::system(cmd.c_str()) == 0) return true;
+    error_ = what + " failed (" + cmd + ")";
+    std::cerr << "TempPostgres: " << error_ << "\n";
+    if (running_) {
+        std::string data = (dir_ / "data").string();
+        std::system((bin("pg_ctl") + " -D " + quote(data) + " -m immediate -w stop >/dev/null 2>&1").c_str());
+        running_ = false;
+    }
+    return false;
+}
+
+std::string TempPostgres::bin(const std::string& tool) const {
+    return binDir_.empty() ? tool : quote((fs::path(binDir_) / tool).string());
+}
+
+std::string TempPostgres::psql(const std::string& db) const {
+    return bin("psql") + " -X -q -v ON_ERROR_STOP=1 -h " + quote(dir_.string()) + " -p " + std::to_string(port_) +
+           " -U worker -d " + quote(db);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <filesystem>
+#include <string>
+
+// Wegwerf-PostgreSQL für Benchmarks: initdb in einen Temp-Ordner, Start über
+// pg_ctl (nur Unix-Socket, kein TCP), schema.sql laden, PG_* Umgebungs-
+// variablen für DbPool setzen. Der Destruktor stoppt die Instanz und löscht
+// den Ordner.
+//
+// Die Binaries werden über PG_BIN_DIR, sonst "pg_config --bindir", sonst PATH
+// gesucht. Fehlen sie, ist isRunning() false und die DB-Benchmarks werden
+// übersprungen.
+class TempPostgres {
+public:
+    explicit TempPostgres(const std::filesystem::path& schemaFile);
+    ~TempPostgres();
+
+    TempPostgres(const TempPostgres&) = delete;
+    TempPostgres& operator=(const TempPostgres&) = delete;
+
+    bool isRunning() const { return running_; }
+    const std::string& error() const { return error_; }
+
+    const std::filesystem::path& socketDir() const { return dir_; }
+    int port() const { return port_; }
+
+    // Alle Tabellen leeren (zwischen Benchmark-Läufen)
+    bool truncateAll() const;
+
+private:
+    bool run(const std::string& cmd, const std::string& what);
+    std::string bin(const std::string& tool) const;
+    std::string psql(const std::string& db) const;
+
+    std::filesystem::path dir_;
+    std::string binDir_;
+    int port_ = 0;
+    bool running_ = false;
+    std::string error_;
+};
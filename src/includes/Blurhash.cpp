@@ -0,0 +1,92 @@
+#include "Blurhash.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+static constexpr char BASE83[] =
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz#$%*+,-.:;=?@[]^_{|}~";
+
+static void appendBase83(std::string& out, int value, int length) {
+    for (int i = 1; i <= length; ++i) {
+        int divisor = 1;
+        for (int k = 0; k < length - i; ++k) divisor *= 83;
+        out += BASE83[(value / divisor) % 83];
+    }
+}
+
+static float srgbToLinear(uint8_t v) {
+    float x = v / 255.0f;
+    return x <= 0.04045f ? x / 12.92f : std::pow((x + 0.055f) / 1.055f, 2.4f);
+}
+
+static int linearToSrgb(float v) {
+    v = std::clamp(v, 0.0f, 1.0f);
+    if (v <= 0.0031308f) return static_cast<int>(v * 12.92f * 255.0f + 0.5f);
+    return static_cast<int>((1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f) * 255.0f + 0.5f);
+}
+
+static float signPow(float v, float exp) {
+    return std::copysign(std::pow(std::abs(v), exp), v);
+}
+
+std::string encodeBlurhash(const RgbImage& img, int componentsX, int componentsY) {
+    if (!img.isValid() || componentsX < 1 || componentsX > 9 || componentsY < 1 || componentsY > 9) return {};
+
+    const int w = img.width, h = img.height;
+
+    // Lineare Farben und Kosinus-Tabellen einmal vorberechnen
+    std::vector<float> linear(img.pixels.size());
+    for (size_t i = 0; i < img.pixels.size(); ++i) linear[i] = srgbToLinear(img.pixels[i]);
+
+    std::vector<float> cosX(static_cast<size_t>(componentsX) * w), cosY(static_cast<size_t>(componentsY) * h);
+    for (int i = 0; i < componentsX; ++i)
+        for (int x = 0; x < w; ++x) cosX[static_cast<size_t>(i) * w + x] = std::cos(std::numbers::pi_v<float> * i * x / w);
+    for (int j = 0; j < componentsY; ++j)
+        for (int y = 0; y < h; ++y) cosY[static_cast<size_t>(j) * h + y] = std::cos(std::numbers::pi_v<float> * j * y / h);
+
+    std::vector<std::array<float, 3>> factors;
+    for (int j = 0; j < componentsY; ++j) {
+        for (int i = 0; i < componentsX; ++i) {
+            float r = 0, g = 0, b = 0;
+            for (int y = 0; y < h; ++y) {
+                const float* row = &linear[static_cast<size_t>(y) * w * 3];
+                const float cy = cosY[static_cast<size_t>(j) * h + y];
+                for (int x = 0; x < w; ++x) {
+                    float basis = cosX[static_cast<size_t>(i) * w + x] * cy;
+                    r += basis * row[x * 3];
+                    g += basis * row[x * 3 + 1];
+                    b += basis * row[x * 3 + 2];
+                }
+            }
+            float scale = ((i == 0 && j == 0) ? 1.0f : 2.0f) / (w * h);
+            factors.push_back({r * scale, g * scale, b * scale});
+        }
+    }
+
+    std::string hash;
+    appendBase83(hash, (componentsX - 1) + (componentsY - 1) * 9, 1);
+
+    float maximumValue = 1.0f;
+    if (factors.size() > 1) {
+        float actualMax = 0.0f;
+        for (size_t k = 1; k < factors.size(); ++k)
+            for (float v : factors[k]) actualMax = std::max(actualMax, std::abs(v));
+        int quantisedMax = std::clamp(static_cast<int>(std::floor(actualMax * 166.0f - 0.5f)), 0, 82);
+        maximumValue = (quantisedMax + 1) / 166.0f;
+        appendBase83(hash, quantisedMax, 1);
+    } else {
+        appendBase83(hash, 0, 1);
+    }
+
+    const auto& dc = factors[0];
+    appendBase83(hash, (linearToSrgb(dc[0]) << 16) + (linearToSrgb(dc[1]) << 8) + linearToSrgb(dc[2]), 4);
+
+    for (size_t k = 1; k < factors.size(); ++k) {
+        auto quant = [&](float v) {
+            return std::clamp(static_cast<int>(std::floor(signPow(v / maximumValue, 0.5f) * 9.0f + 9.5f)), 0, 18);
+        };
+        appendBase83(hash, quant(factors[k][0]) * 19 * 19 + quant(factors[k][1]) * 19 + quant(factors[k][2]), 2);
+    }
+    return hash;
+}
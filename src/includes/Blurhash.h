@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+#include "ImageResize.h"
+
+// BlurHash (https://blurha.sh) als Platzhalter, bis die Galerie das Thumbnail geladen hat.
+// Das Bild sollte schon klein sein (z.B. 32 px), der Aufwand ist O(Pixel * Komponenten).
+std::string encodeBlurhash(const RgbImage& img, int componentsX = 4, int componentsY = 3);
@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Blockierende Queue mit fester Kapazität zwischen zwei Pipeline-Stufen.
+// Ist sie voll, blockiert push() -> langsame Stufen bremsen die vorherigen aus.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+    // false, wenn die Queue geschlossen wurde
+    bool push(T item) {
+        std::unique_lock lock(mutex_);
+        notFull_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool tryPush(T item) {
+        std::lock_guard lock(mutex_);
+        if (closed_ || items_.size() >= capacity_) return false;
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // nullopt erst, wenn geschlossen UND leer
+    std::optional<T> pop() {
+        std::unique_lock lock(mutex_);
+        notEmpty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        return takeFront();
+    }
+
+    // nullopt bei Timeout oder wenn geschlossen und leer
+    template <typename Rep, typename Period>
+    std::optional<T> popFor(std::chrono::duration<Rep, Period> timeout) {
+        std::unique_lock lock(mutex_);
+        notEmpty_.wait_for(lock, timeout, [&] { return closed_ || !items_.empty(); });
+        return takeFront();
+    }
+
+    void close() {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    // Wartende Einträge verwerfen (z.B. beim Herunterfahren)
+    void clear() {
+        std::lock_guard lock(mutex_);
+        items_.clear();
+        notFull_.notify_all();
+    }
+
+    bool isClosed() const {
+        std::lock_guard lock(mutex_);
+        return closed_;
+    }
+
+    size_t size() const {
+        std::lock_guard lock(mutex_);
+        return items_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    std::optional<T> takeFront() {
+        if (items_.empty()) return std::nullopt;
+        std::optional<T> item(std::move(items_.front()));
+        items_.pop_front();
+        notFull_.notify_one();
+        return item;
+    }
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
@@ -0,0 +1,96 @@
+#include "ContentHash.h"
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <vector>
+
+static ContentHash fromXxh(XXH128_hash_t h) {
+    ContentHash out;
+    out.high = h.high64;
+    out.low = h.low64;
+    out.valid = true;
+    return out;
+}
+
+ContentHash ContentHash::ofBuffer(const void* data, size_t len) {
+    return fromXxh(XXH3_128bits(data, len));
+}
+
+ContentHash ContentHash::ofFile(const std::filesystem::path& p) {
+    int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return {};
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return {};
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return ofBuffer(nullptr, 0);
+    }
+
+    // Normalfall: ganze Datei mappen, der Kernel liest sequenziell voraus
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+        ::madvise(map, size, MADV_SEQUENTIAL);
+        ContentHash h = ofBuffer(map, size);
+        ::munmap(map, size);
+        ::close(fd);
+        return h;
+    }
+
+    // Fallback (z.B. Dateisysteme ohne mmap): streamend lesen
+    ContentHasher hasher;
+    std::vector<char> buf(1 << 20);
+    ssize_t n;
+    bool ok = true;
+    while ((n = ::read(fd, buf.data(), buf.size())) != 0) {
+        if (n < 0) { ok = false; break; }
+        hasher.update(buf.data(), static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return ok ? hasher.digest() : ContentHash{};
+}
+
+ContentHasher::ContentHasher() : state_(XXH3_createState()) {
+    XXH3_128bits_reset(static_cast<XXH3_state_t*>(state_));
+}
+
+ContentHasher::~ContentHasher() {
+    XXH3_freeState(static_cast<XXH3_state_t*>(state_));
+}
+
+void ContentHasher::update(const void* data, size_t len) {
+    XXH3_128bits_update(static_cast<XXH3_state_t*>(state_), data, len);
+}
+
+ContentHash ContentHasher::digest() const {
+    return fromXxh(XXH3_128bits_digest(static_cast<XXH3_state_t*>(state_)));
+}
+
+std::string ContentHash::toHex() const {
+    if (!valid) return {};
+    char buf[33];
+    std::snprintf(buf, sizeof(buf), "%016llx%016llx",
+                  static_cast<unsigned long long>(high), static_cast<unsigned long long>(low));
+    return std::string(buf, 32);
+}
+
+ContentHash ContentHash::fromHex(const std::string& hex) {
+    ContentHash h;
+    if (hex.size() != 32) return h;
+    try {
+        h.high = std::stoull(hex.substr(0, 16), nullptr, 16);
+        h.low = std::stoull(hex.substr(16), nullptr, 16);
+        h.valid = true;
+    } catch (...) {
+        h = {};
+    }
+    return h;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+// 128-Bit Inhalts-Hash (XXH3) einer Datei, per mmap gelesen.
+struct ContentHash {
+    uint64_t high = 0;
+    uint64_t low = 0;
+    bool valid = false;
+
+    static ContentHash ofFile(const std::filesystem::path& p);
+    static ContentHash ofBuffer(const void* data, size_t len);
+    static ContentHash fromHex(const std::string& hex);
+
+    std::string toHex() const;   // 32 Zeichen, so wie in pictures.content_hash
+
+    bool operator==(const ContentHash& o) const {
+        return valid == o.valid && high == o.high && low == o.low;
+    }
+};
+
+// Inkrementell, z.B. für Uploads, die in Stücken ankommen. Ergibt denselben
+// Hash wie ofBuffer() über alle Stücke.
+class ContentHasher {
+public:
+    ContentHasher();
+    ~ContentHasher();
+
+    ContentHasher(const ContentHasher&) = delete;
+    ContentHasher& operator=(const ContentHasher&) = delete;
+
+    void update(const void* data, size_t len);
+    ContentHash digest() const;
+
+private:
+    void* state_;   // XXH3_state_t (xxhash.h bleibt aus dem Header)
+};
+
+template <>
+struct std::hash<ContentHash> {
+    size_t operator()(const ContentHash& h) const noexcept {
+        // XXH3 ist bereits gut verteilt
+        return static_cast<size_t>(h.low ^ (h.high * 0x9E3779B97F4A7C15ull));
+    }
+};
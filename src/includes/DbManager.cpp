@@ -1,149 +1,548 @@
 #include "DbManager.h"
+#include "DbPool.h"
+#include "PerceptualHash.h"
+#include "Tracer.h"
 #include <QDebug>
-#include <QThread>
-#include <QProcessEnvironment> // Nötig für Umgebungsvariablen
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
 
-// Helper: Keyword ID holen (Code bleibt unverändert)
-int DbManager::getOrCreateKeywordId(QSqlDatabase& db, const QString& tag) {
-    QSqlQuery q(db);
-    // 1. Suche
-    q.prepare("SELECT id FROM keywords WHERE tag = :t");
-    q.bindValue(":t", tag);
-    if (q.exec() && q.next()) return q.value(0).toInt();
+// Helper: "(?,?,?),(?,?,?)" für Multi-Row INSERTs
+static QString valuesList(size_t rows, int cols) {
+    QString row = "(";
+    for (int c = 0; c < cols; ++c) row += (c ? ",?" : "?");
+    row += ")";
 
-    // 2. Insert (Thread-Safe via Conflict)
-    q.prepare("INSERT INTO keywords (tag) VALUES (:t) ON CONFLICT (tag) DO NOTHING RETURNING id");
-    q.bindValue(":t", tag);
-    if (q.exec() && q.next()) return q.value(0).toInt();
+    QString out;
+    out.reserve(static_cast<int>(rows) * (row.size() + 1));
+    for (size_t r = 0; r < rows; ++r) {
+        if (r) out += ",";
+        out += row;
+    }
+    return out;
+}
 
-    // 3. Fallback
-    q.prepare("SELECT id FROM keywords WHERE tag = :t");
-    q.bindValue(":t", tag);
-    if (q.exec() && q.next()) return q.value(0).toInt();
+// Helper: Keyword ohne Leerraum am Rand (wie QString::trimmed, ohne Kopie)
+static std::string_view trimmed(std::string_view s) {
+    constexpr std::string_view ws = " \t\n\v\f\r";
+    size_t b = s.find_first_not_of(ws);
+    if (b == std::string_view::npos) return {};
+    return s.substr(b, s.find_last_not_of(ws) - b + 1);
+}
 
-    return -1;
+// Helper: alle Keywords eines Batches (getrimmt, ohne Duplikate).
+// Erst dedupliziert, dann einmal pro Tag nach QString umgewandelt.
+static std::vector<QString> collectTags(std::span<const WorkerPayload> rows) {
+    std::vector<QString> tags;
+    std::unordered_set<std::string_view> seen;
+    for (const auto& p : rows) {
+        for (std::string_view k : p.meta.keywords) {
+            std::string_view tag = trimmed(k);
+            if (!tag.empty() && seen.insert(tag).second) tags.push_back(toQString(tag));
+        }
+    }
+    return tags;
 }
 
-bool DbManager::insertPhoto(const WorkerPayload& p) {
-    // Unique Connection Name pro Thread
-    QString connName = QString("pg_worker_%1").arg((quint64)QThread::currentThreadId());
-    
-    {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QPSQL", connName);
-
-        // --- KONFIGURATION AUS UMGEBUNGSVARIABLEN ---
-        // Syntax: qEnvironmentVariable("NAME", "DEFAULT_WERT")
-        
-        QString host = qEnvironmentVariable("PG_HOST", "localhost");
-        QString dbName = qEnvironmentVariable("PG_DB", "Photos"); // Default wie gewünscht
-        QString user = qEnvironmentVariable("PG_USER", "postgres");
-        QString pass = qEnvironmentVariable("PG_PASS");
-        QString portStr = qEnvironmentVariable("PG_PORT", "5432");
-
-        // Warnung, falls Passwort fehlt (optional)
-        if (pass.isEmpty()) {
-            qWarning() << "Warnung: Umgebungsvariable PG_PASS ist nicht gesetzt!";
+// Alle Tabellen für rows schreiben (Transaktion macht der Aufrufer).
+// Pro Tabelle genau EIN Statement, egal wie viele Fotos im Batch sind.
+bool DbManager::writeRows(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::vector<qint64>& ids,
+                          WriteContext& ctx) {
+    return insertPictures(lease, rows, ids, ctx) && writeMeta(lease, rows, ids, ctx);
+}
+
+// Zeilen in pictures anlegen (RETURNING full_path, um IDs sicher zuzuordnen)
+bool DbManager::insertPictures(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::vector<qint64>& ids,
+                               WriteContext& ctx) {
+    const size_t n = rows.size();
+    ids.assign(n, -1);
+    TraceSpan span("insert pictures", "db");
+    span.setCount(static_cast<int>(n));
+
+    QSqlQuery& q = lease.prepared(
+        "INSERT INTO pictures (file_name, file_path, full_path, file_size, width, height, file_datetime, upload_user, content_hash, phash) "
+        "VALUES " + valuesList(n, 10) + " RETURNING id, full_path");
+    int pos = 0;
+    for (const auto& p : rows) {
+        q.bindValue(pos++, QString::fromStdString(p.filename));
+        q.bindValue(pos++, QString::fromStdString(p.relPath));
+        q.bindValue(pos++, QString::fromStdString(p.fullPath));
+        q.bindValue(pos++, p.fileSize);
+        q.bindValue(pos++, p.meta.width);
+        q.bindValue(pos++, p.meta.height);
+        q.bindValue(pos++, p.fileDate);
+        q.bindValue(pos++, QString::fromStdString(p.user));
+        q.bindValue(pos++, p.contentHash.empty() ? QVariant() : QVariant(QString::fromStdString(p.contentHash)));
+        q.bindValue(pos++, p.phash ? QVariant(static_cast<qint64>(*p.phash)) : QVariant());
+    }
+    if (!q.exec()) {
+        qCritical() << "Insert Picture failed:" << q.lastError().text();
+        return false;
+    }
+
+    std::unordered_multimap<std::string, qint64> returned;
+    while (q.next()) returned.emplace(q.value(1).toString().toStdString(), q.value(0).toLongLong());
+    q.finish();
+
+    for (size_t i = 0; i < n; ++i) {
+        auto it = returned.find(rows[i].fullPath);
+        if (it == returned.end()) {
+            qCritical() << "Insert Picture: no id returned for" << QString::fromStdString(rows[i].fullPath);
+            return false;
         }
+        ids[i] = it->second;
+        returned.erase(it);
+    }
 
-        db.setHostName(host);
-        db.setDatabaseName(dbName);
-        db.setUserName(user);
-        db.setPassword(pass);
-        db.setPort(portStr.toInt());
-        // ---------------------------------------------
+    // Duplikat-Policy "replace": ältere Fotos mit gleichem Inhalt entfernen
+    for (size_t i = 0; i < n; ++i) {
+        if (!deleteReplaced(lease, rows[i], ids[i], ctx)) return false;
+    }
+    return true;
+}
 
-        if (!db.open()) {
-            qCritical() << "DB Open Error (" << host << "/" << dbName << "):" << db.lastError().text();
+// Andere Fotos mit gleichem content_hash löschen (Policy "replace"), Dateien merken
+bool DbManager::deleteReplaced(DbPool::Lease& lease, const WorkerPayload& row, qint64 id, WriteContext& ctx) {
+    if (!row.replaceExisting || row.contentHash.empty()) return true;
+    // Derivate gehen per CASCADE mit, ihre Dateien brauchen wir vorher
+    QSqlQuery& qDer = lease.prepared(
+        "DELETE FROM picture_derivatives d USING pictures p "
+        "WHERE d.ref_picture = p.id AND p.content_hash = ? AND p.id <> ? RETURNING d.file_path");
+    qDer.bindValue(0, QString::fromStdString(row.contentHash));
+    qDer.bindValue(1, id);
+    if (!qDer.exec()) {
+        qCritical() << "Delete replaced derivatives failed:" << qDer.lastError().text();
+        return false;
+    }
+    while (qDer.next()) ctx.obsoleteFiles.push_back(qDer.value(0).toString().toStdString());
+
+    QSqlQuery& qDel = lease.prepared("DELETE FROM pictures WHERE content_hash = ? AND id <> ? RETURNING id, full_path");
+    qDel.bindValue(0, QString::fromStdString(row.contentHash));
+    qDel.bindValue(1, id);
+    if (!qDel.exec()) {
+        qCritical() << "Delete replaced picture failed:" << qDel.lastError().text();
+        return false;
+    }
+    while (qDel.next()) {
+        ctx.deletedPictures.push_back(qDel.value(0).toLongLong());
+        ctx.obsoleteFiles.push_back(qDel.value(1).toString().toStdString());
+    }
+    return true;
+}
+
+// meta_* und Keyword-Links für bereits vorhandene Picture-IDs
+bool DbManager::writeMeta(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::span<const qint64> ids,
+                          WriteContext& ctx) {
+    const size_t n = rows.size();
+    int pos = 0;
+    TraceSpan span("write meta", "db");
+    span.setCount(static_cast<int>(n));
+
+    // Location
+    QSqlQuery& qLoc = lease.prepared(
+        "INSERT INTO meta_location (ref_picture, continent, country, country_code, province, city) VALUES " + valuesList(n, 6));
+    for (size_t i = 0; i < n; ++i) {
+        const PhotoData& m = rows[i].meta;
+        qLoc.bindValue(pos++, ids[i]);
+        qLoc.bindValue(pos++, toQString(m.continent));
+        qLoc.bindValue(pos++, toQString(m.country));
+        qLoc.bindValue(pos++, toQString(m.countryCode));
+        qLoc.bindValue(pos++, toQString(m.province));
+        qLoc.bindValue(pos++, toQString(m.city));
+    }
+    if (!qLoc.exec()) {
+        qCritical() << "Insert Location failed:" << qLoc.lastError().text();
+        return false;
+    }
+
+    // Exif
+    QSqlQuery& qExif = lease.prepared(
+        "INSERT INTO meta_exif (ref_picture, make, model, iso, aperture, exposure_time, gps_latitude, gps_longitude, datetime_original) "
+        "VALUES " + valuesList(n, 9));
+    pos = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const PhotoData& m = rows[i].meta;
+        qExif.bindValue(pos++, ids[i]);
+        qExif.bindValue(pos++, toQString(m.make));
+        qExif.bindValue(pos++, toQString(m.model));
+        qExif.bindValue(pos++, toQString(m.iso));
+        qExif.bindValue(pos++, toQString(m.aperture));
+        qExif.bindValue(pos++, toQString(m.exposure));
+        qExif.bindValue(pos++, m.gpsLat);
+        qExif.bindValue(pos++, m.gpsLon);
+        qExif.bindValue(pos++, m.takenAt);
+    }
+    if (!qExif.exec()) {
+        qCritical() << "Insert Exif failed:" << qExif.lastError().text();
+        return false;
+    }
+
+    // IPTC
+    QSqlQuery& qIptc = lease.prepared(
+        "INSERT INTO meta_iptc (ref_picture, object_name, caption, copyright) VALUES " + valuesList(n, 4));
+    pos = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const PhotoData& m = rows[i].meta;
+        qIptc.bindValue(pos++, ids[i]);
+        qIptc.bindValue(pos++, toQString(m.title));
+        qIptc.bindValue(pos++, toQString(m.caption));
+        qIptc.bindValue(pos++, toQString(m.copyright));
+    }
+    if (!qIptc.exec()) {
+        qCritical() << "Insert IPTC failed:" << qIptc.lastError().text();
+        return false;
+    }
+
+    // Keywords (Many-to-Many): IDs aus dem Cache, Fehltreffer per unnest()-Upsert
+    std::vector<QString> tags = collectTags(rows);
+    if (tags.empty()) return true;
+
+    std::unordered_map<QString, int> tagIds;
+    if (!KeywordCache::instance().resolve(lease, tags, tagIds, ctx.freshKeywords)) return false;
+
+    // Alle Links in EINEM Statement
+    std::vector<QString> linkPics, linkKeys;
+    for (size_t i = 0; i < n; ++i) {
+        for (std::string_view k : rows[i].meta.keywords) {
+            std::string_view tag = trimmed(k);
+            if (tag.empty()) continue;
+            auto it = tagIds.find(toQString(tag));
+            if (it == tagIds.end()) continue;
+            linkPics.push_back(QString::number(ids[i]));
+            linkKeys.push_back(QString::number(it->second));
+        }
+    }
+    if (!linkPics.empty()) {
+        QSqlQuery& qLink = lease.prepared(
+            "INSERT INTO picture_keywords (picture_id, keyword_id) "
+            "SELECT unnest(?::int[]), unnest(?::int[]) ON CONFLICT DO NOTHING");
+        qLink.bindValue(0, KeywordCache::toPgArray(linkPics));
+        qLink.bindValue(1, KeywordCache::toPgArray(linkKeys));
+        if (!qLink.exec()) {
+            qCritical() << "Insert Keywords failed:" << qLink.lastError().text();
             return false;
         }
+    }
+    return true;
+}
 
-        // Start Transaction
-        db.transaction();
-        
-        bool ok = true;
-        qint64 picId = -1;
-
-        // 1. Picture Insert
-        QSqlQuery q(db);
-        q.prepare("INSERT INTO pictures (file_name, file_path, full_path, file_size, width, height, file_datetime, upload_user) "
-                  "VALUES (:fn, :fp, :full, :sz, :w, :h, :dt, :usr) RETURNING id");
-        q.bindValue(":fn", QString::fromStdString(p.filename));
-        q.bindValue(":fp", QString::fromStdString(p.relPath));
-        q.bindValue(":full", QString::fromStdString(p.fullPath));
-        q.bindValue(":sz", p.fileSize);
-        q.bindValue(":w", p.meta.width);
-        q.bindValue(":h", p.meta.height);
-        q.bindValue(":dt", p.fileDate);
-        q.bindValue(":usr", QString::fromStdString(p.user));
-        
-        if (q.exec() && q.next()) {
-            picId = q.value(0).toLongLong();
+// Reindex: vorhandene Fotos (per full_path) behalten ihre ID, Zeile wird
+// aktualisiert und die Metadaten neu geschrieben. Unbekannte Pfade -> INSERT.
+// upload_user, imported_at und Derivate bleiben unangetastet.
+bool DbManager::upsertRows(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::vector<qint64>& ids,
+                           WriteContext& ctx) {
+    const size_t n = rows.size();
+    ids.assign(n, -1);
+    TraceSpan span("upsert pictures", "db");
+    span.setCount(static_cast<int>(n));
+
+    // 1. Vorhandene IDs auflösen (bei mehrfach gleichem Pfad: die älteste Zeile)
+    std::vector<QString> paths;
+    paths.reserve(n);
+    for (const auto& p : rows) paths.push_back(QString::fromStdString(p.fullPath));
+    QSqlQuery& qFind = lease.prepared(
+        "SELECT DISTINCT ON (full_path) full_path, id FROM pictures "
+        "WHERE full_path = ANY(?::text[]) ORDER BY full_path, id");
+    qFind.bindValue(0, KeywordCache::toPgArray(paths));
+    if (!qFind.exec()) {
+        qCritical() << "Lookup pictures failed:" << qFind.lastError().text();
+        return false;
+    }
+    std::unordered_map<std::string, qint64> existing;
+    while (qFind.next()) existing.emplace(qFind.value(0).toString().toStdString(), qFind.value(1).toLongLong());
+    qFind.finish();
+
+    std::vector<size_t> updated, added;
+    for (size_t i = 0; i < n; ++i) {
+        auto it = existing.find(rows[i].fullPath);
+        if (it != existing.end()) {
+            ids[i] = it->second;
+            updated.push_back(i);
         } else {
-            ok = false;
-            qCritical() << "Insert Picture failed:" << q.lastError().text();
+            added.push_back(i);
+        }
+    }
+
+    // 2. Vorhandene Zeilen in EINEM Statement aktualisieren, alte Metadaten weg
+    if (!updated.empty()) {
+        QString values;
+        for (size_t k = 0; k < updated.size(); ++k) {
+            if (k) values += ",";
+            values += "(?::int,?,?,?::bigint,?::int,?::int,?::timestamp,?,?::bigint)";
+        }
+        QSqlQuery& qUpd = lease.prepared(
+            "UPDATE pictures p SET file_name = v.fn, file_path = v.fp, file_size = v.sz, width = v.w, height = v.h, "
+            "file_datetime = v.dt, content_hash = v.hash, phash = COALESCE(v.ph, p.phash) "
+            "FROM (VALUES " + values + ") AS v(id, fn, fp, sz, w, h, dt, hash, ph) WHERE p.id = v.id");
+        int pos = 0;
+        std::vector<QString> idList;
+        for (size_t i : updated) {
+            const WorkerPayload& p = rows[i];
+            qUpd.bindValue(pos++, ids[i]);
+            qUpd.bindValue(pos++, QString::fromStdString(p.filename));
+            qUpd.bindValue(pos++, QString::fromStdString(p.relPath));
+            qUpd.bindValue(pos++, p.fileSize);
+            qUpd.bindValue(pos++, p.meta.width);
+            qUpd.bindValue(pos++, p.meta.height);
+            qUpd.bindValue(pos++, p.fileDate);
+            qUpd.bindValue(pos++, p.contentHash.empty() ? QVariant() : QVariant(QString::fromStdString(p.contentHash)));
+            qUpd.bindValue(pos++, p.phash ? QVariant(static_cast<qint64>(*p.phash)) : QVariant());
+            idList.push_back(QString::number(ids[i]));
+        }
+        if (!qUpd.exec()) {
+            qCritical() << "Update Picture failed:" << qUpd.lastError().text();
+            return false;
         }
 
-        if (ok) {
-            // 2. Location
-            QSqlQuery qLoc(db);
-            qLoc.prepare("INSERT INTO meta_location (ref_picture, country, country_code, province, city) VALUES (:id, :c, :cc, :p, :ci)");
-            qLoc.bindValue(":id", picId);
-            qLoc.bindValue(":c", p.meta.country);
-            qLoc.bindValue(":cc", p.meta.countryCode);
-            qLoc.bindValue(":p", p.meta.province);
-            qLoc.bindValue(":ci", p.meta.city);
-            if(!qLoc.exec()) ok = false;
-
-            // 3. Exif
-            QSqlQuery qExif(db);
-            qExif.prepare("INSERT INTO meta_exif (ref_picture, make, model, iso, aperture, exposure_time, gps_latitude, gps_longitude, datetime_original) "
-                          "VALUES (:id, :mk, :md, :iso, :ap, :exp, :lat, :lon, :dto)");
-            qExif.bindValue(":id", picId);
-            qExif.bindValue(":mk", p.meta.make);
-            qExif.bindValue(":md", p.meta.model);
-            qExif.bindValue(":iso", p.meta.iso);
-            qExif.bindValue(":ap", p.meta.aperture);
-            qExif.bindValue(":exp", p.meta.exposure);
-            qExif.bindValue(":lat", p.meta.gpsLat);
-            qExif.bindValue(":lon", p.meta.gpsLon);
-            qExif.bindValue(":dto", p.meta.takenAt);
-            if(!qExif.exec()) ok = false;
-
-            // 4. IPTC
-            QSqlQuery qIptc(db);
-            qIptc.prepare("INSERT INTO meta_iptc (ref_picture, object_name, caption, copyright) VALUES (:id, :obj, :cap, :copy)");
-            qIptc.bindValue(":id", picId);
-            qIptc.bindValue(":obj", p.meta.title);
-            qIptc.bindValue(":cap", p.meta.caption);
-            qIptc.bindValue(":copy", p.meta.copyright);
-            if(!qIptc.exec()) ok = false;
-
-            // 5. Keywords (Many-to-Many)
-            for(const auto& k : p.meta.keywords) {
-                if(k.trimmed().isEmpty()) continue;
-                int kId = getOrCreateKeywordId(db, k.trimmed());
-                if(kId > 0) {
-                    QSqlQuery qLink(db);
-                    qLink.prepare("INSERT INTO picture_keywords (picture_id, keyword_id) VALUES (:pid, :kid) ON CONFLICT DO NOTHING");
-                    qLink.bindValue(":pid", picId);
-                    qLink.bindValue(":kid", kId);
-                    qLink.exec();
-                }
+        const QString idArray = KeywordCache::toPgArray(idList);
+        for (const char* sql : {"DELETE FROM meta_location WHERE ref_picture = ANY(?::int[])",
+                                "DELETE FROM meta_exif WHERE ref_picture = ANY(?::int[])",
+                                "DELETE FROM meta_iptc WHERE ref_picture = ANY(?::int[])",
+                                "DELETE FROM picture_keywords WHERE picture_id = ANY(?::int[])"}) {
+            QSqlQuery& qDel = lease.prepared(sql);
+            qDel.bindValue(0, idArray);
+            if (!qDel.exec()) {
+                qCritical() << "Delete old metadata failed:" << qDel.lastError().text();
+                return false;
             }
         }
 
-        if (ok) {
-            db.commit();
-            qDebug() << "Successfully processed photo ID:" << picId;
+        // Policy "replace" auch bei wiederholten Zeilen (Outbox-Replay nach DB-Ausfall)
+        for (size_t i : updated) {
+            if (!deleteReplaced(lease, rows[i], ids[i], ctx)) return false;
+        }
+    }
+
+    // 3. Neue Dateien wie beim Import anlegen
+    if (!added.empty()) {
+        std::vector<WorkerPayload> fresh;
+        fresh.reserve(added.size());
+        for (size_t i : added) fresh.push_back(rows[i]);
+        std::vector<qint64> freshIds;
+        if (!insertPictures(lease, fresh, freshIds, ctx)) return false;
+        for (size_t k = 0; k < added.size(); ++k) ids[added[k]] = freshIds[k];
+    }
+
+    // 4. Metadaten für alle
+    return writeMeta(lease, rows, ids, ctx);
+}
+
+std::vector<qint64> DbManager::insertBatch(std::span<const WorkerPayload> batch, BatchFailureMode mode) {
+    return runBatch(batch, mode, &DbManager::writeRows);
+}
+
+std::vector<qint64> DbManager::upsertBatch(std::span<const WorkerPayload> batch, BatchFailureMode mode) {
+    return runBatch(batch, mode, &DbManager::upsertRows);
+}
+
+std::vector<qint64> DbManager::runBatch(std::span<const WorkerPayload> batch, BatchFailureMode mode, RowWriter write) {
+    std::vector<qint64> ids(batch.size(), -1);
+    if (batch.empty()) return ids;
+
+    // Persistente Verbindung des aktuellen Threads aus dem Pool
+    DbPool::Lease lease = DbPool::instance().acquire();
+    if (!lease.isValid()) return ids;
+
+    QSqlDatabase& db = lease.db();
+
+    // 1. Versuch: alles in einer Transaktion
+    if (!db.transaction()) {
+        qCritical() << "Begin transaction failed:" << db.lastError().text();
+        lease.markBroken();
+        return ids;
+    }
+    WriteContext ctx;
+    TraceSpan span("transaction", "db");
+    span.setCount(static_cast<int>(batch.size()));
+    if (write(lease, batch, ids, ctx) && db.commit()) {
+        afterCommit(ctx, batch);
+        qDebug() << "Batch committed:" << batch.size() << "photos";
+        return ids;
+    }
+    db.rollback();
+    lease.markBroken();
+    ids.assign(batch.size(), -1);
+    // Gecachte IDs könnten veraltet sein (Keyword extern gelöscht)
+    KeywordCache::instance().forget(collectTags(batch));
+    ctx = WriteContext();
+
+    if (mode == BatchFailureMode::Rollback || batch.size() == 1) {
+        qCritical() << "Transaction failed. Rolled back" << batch.size() << "photos.";
+        return ids;
+    }
+
+    // 2. Versuch: zeilenweise mit SAVEPOINT, damit nur fehlerhafte Fotos verloren gehen
+    qWarning() << "Batch failed, retrying" << batch.size() << "photos row by row";
+    if (!db.transaction()) {
+        qCritical() << "Begin transaction failed:" << db.lastError().text();
+        return ids;
+    }
+    QSqlQuery sp(db);
+    std::vector<qint64> rowId;
+    int failed = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        sp.exec("SAVEPOINT photo_row");
+        WriteContext rowCtx;
+        if (write(lease, batch.subspan(i, 1), rowId, rowCtx)) {
+            sp.exec("RELEASE SAVEPOINT photo_row");
+            ids[i] = rowId[0];
+            ctx.freshKeywords.insert(ctx.freshKeywords.end(), rowCtx.freshKeywords.begin(), rowCtx.freshKeywords.end());
+            ctx.obsoleteFiles.insert(ctx.obsoleteFiles.end(), rowCtx.obsoleteFiles.begin(), rowCtx.obsoleteFiles.end());
+            ctx.deletedPictures.insert(ctx.deletedPictures.end(), rowCtx.deletedPictures.begin(), rowCtx.deletedPictures.end());
         } else {
-            db.rollback();
-            qCritical() << "Transaction failed. Rolled back.";
+            sp.exec("ROLLBACK TO SAVEPOINT photo_row");
+            failed++;
+            qCritical() << "Row failed, skipped:" << QString::fromStdString(batch[i].fullPath);
         }
-        db.close();
-        return ok;
-    }
-    
-    // Aufräumen der Verbindung
-    QSqlDatabase::removeDatabase(connName);
-    return false;
-}
\ No newline at end of file
+    }
+    if (!db.commit()) {
+        qCritical() << "Commit failed:" << db.lastError().text();
+        db.rollback();
+        ids.assign(batch.size(), -1);
+        return ids;
+    }
+    afterCommit(ctx, batch);
+    qDebug() << "Batch committed row by row:" << batch.size() - failed << "ok," << failed << "failed";
+    return ids;
+}
+
+void DbManager::afterCommit(const WriteContext& ctx, std::span<const WorkerPayload> rows) {
+    KeywordCache::instance().publish(ctx.freshKeywords);
+    for (qint64 id : ctx.deletedPictures) PerceptualIndex::instance().erase(id);
+
+    // Dateien ersetzter Fotos löschen (außer sie wurden gerade überschrieben)
+    for (const auto& path : ctx.obsoleteFiles) {
+        bool reused = std::any_of(rows.begin(), rows.end(), [&](const WorkerPayload& p) { return p.fullPath == path; });
+        if (reused) continue;
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        if (ec) qWarning() << "Could not remove replaced file" << QString::fromStdString(path) << ":" << ec.message().c_str();
+    }
+}
+
+int DbManager::insertLinks(std::span<const WorkerPayload> links) {
+    if (links.empty()) return 0;
+    TraceSpan span("insert links", "db");
+    span.setCount(static_cast<int>(links.size()));
+
+    DbPool::Lease lease = DbPool::instance().acquire();
+    if (!lease.isValid()) return -1;
+
+    std::vector<QString> hashes, users, names, paths;
+    for (const auto& p : links) {
+        hashes.push_back(QString::fromStdString(p.contentHash));
+        users.push_back(QString::fromStdString(p.user));
+        names.push_back(QString::fromStdString(p.filename));
+        paths.push_back(QString::fromStdString(p.relPath));
+    }
+
+    // Ziel per Hash auflösen: funktioniert auch, wenn das Original im selben
+    // oder einem gerade committeten Batch steckt
+    QSqlQuery& q = lease.prepared(
+        "INSERT INTO picture_links (ref_picture, upload_user, file_name, file_path) "
+        "SELECT p.id, l.usr, l.fn, l.fp "
+        "FROM unnest(?::text[], ?::text[], ?::text[], ?::text[]) AS l(hash, usr, fn, fp) "
+        "JOIN LATERAL (SELECT id FROM pictures WHERE content_hash = l.hash ORDER BY id LIMIT 1) p ON true");
+    q.bindValue(0, KeywordCache::toPgArray(hashes));
+    q.bindValue(1, KeywordCache::toPgArray(users));
+    q.bindValue(2, KeywordCache::toPgArray(names));
+    q.bindValue(3, KeywordCache::toPgArray(paths));
+    if (!q.exec()) {
+        qCritical() << "Insert Links failed:" << q.lastError().text();
+        lease.markBroken();
+        return -1;
+    }
+    int written = q.numRowsAffected();
+    if (written < static_cast<int>(links.size())) {
+        qWarning() << "Links without original:" << static_cast<int>(links.size()) - written;
+    }
+    return written;
+}
+
+int DbManager::insertNearDuplicates(std::span<const NearDuplicate> pairs) {
+    if (pairs.empty()) return 0;
+
+    TraceSpan span("insert near duplicates", "db");
+    span.setCount(static_cast<int>(pairs.size()));
+    DbPool::Lease lease = DbPool::instance().acquire();
+    if (!lease.isValid()) return -1;
+
+    std::vector<QString> pics, candidates, distances;
+    for (const auto& d : pairs) {
+        pics.push_back(QString::number(d.pictureId));
+        candidates.push_back(QString::number(d.candidateId));
+        distances.push_back(QString::number(d.distance));
+    }
+
+    // Index im Speicher kennt noch IDs ersetzter Fotos -> nur vorhandene eintragen
+    QSqlQuery& q = lease.prepared(
+        "INSERT INTO picture_near_duplicates (picture_id, candidate_id, distance) "
+        "SELECT n.pic, n.cand, n.dist FROM unnest(?::int[], ?::int[], ?::int[]) AS n(pic, cand, dist) "
+        "WHERE EXISTS (SELECT 1 FROM pictures WHERE id = n.cand) "
+        "AND EXISTS (SELECT 1 FROM pictures WHERE id = n.pic) "
+        "ON CONFLICT DO NOTHING");
+    q.bindValue(0, KeywordCache::toPgArray(pics));
+    q.bindValue(1, KeywordCache::toPgArray(candidates));
+    q.bindValue(2, KeywordCache::toPgArray(distances));
+    if (!q.exec()) {
+        qCritical() << "Insert near duplicates failed:" << q.lastError().text();
+        lease.markBroken();
+        return -1;
+    }
+    return q.numRowsAffected();
+}
+
+bool DbManager::insertPhoto(const WorkerPayload& p) {
+    auto ids = insertBatch(std::span<const WorkerPayload>(&p, 1), BatchFailureMode::Rollback);
+    if (ids[0] < 0) return false;
+    qDebug() << "Successfully processed photo ID:" << ids[0];
+    return true;
+}
+
+bool DbManager::insertDerivatives(qint64 pictureId, std::span<const DerivativeRecord> derivatives,
+                                  const std::string& blurhash) {
+    TraceSpan span("insert derivatives", "db");
+    DbPool::Lease lease = DbPool::instance().acquire();
+    if (!lease.isValid()) return false;
+
+    // Ein Statement: Blurhash am Foto + alle Derivate (idempotent bei erneutem Lauf)
+    QString sql = "WITH upd AS (UPDATE pictures SET blurhash = ? WHERE id = ?) ";
+    if (derivatives.empty()) {
+        sql += "SELECT 1";
+    } else {
+        sql += "INSERT INTO picture_derivatives (ref_picture, kind, format, width, height, file_path) VALUES " +
+               valuesList(derivatives.size(), 6) +
+               " ON CONFLICT (ref_picture, kind) DO UPDATE SET format = EXCLUDED.format, width = EXCLUDED.width, "
+               "height = EXCLUDED.height, file_path = EXCLUDED.file_path, created_at = now()";
+    }
+    QSqlQuery& q = lease.prepared(sql);
+    int pos = 0;
+    q.bindValue(pos++, blurhash.empty() ? QVariant() : QVariant(QString::fromStdString(blurhash)));
+    q.bindValue(pos++, pictureId);
+    for (const auto& d : derivatives) {
+        q.bindValue(pos++, pictureId);
+        q.bindValue(pos++, QString::fromStdString(d.kind));
+        q.bindValue(pos++, QString::fromStdString(d.format));
+        q.bindValue(pos++, d.width);
+        q.bindValue(pos++, d.height);
+        q.bindValue(pos++, QString::fromStdString(d.path));
+    }
+    if (!q.exec()) {
+        qCritical() << "Insert Derivatives failed:" << q.lastError().text();
+        lease.markBroken();
+        return false;
+    }
+    return true;
+}
+
+bool DbManager::isReachable() {
+    DbPool::Lease lease = DbPool::instance().acquire();
+    if (!lease.isValid()) return false;
+    QSqlQuery& q = lease.prepared("SELECT 1");
+    if (!q.exec()) {
+        lease.markBroken();
+        return false;
+    }
+    return true;
+}
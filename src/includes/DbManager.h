@@ -4,6 +4,13 @@
 #include <QSqlError>
 #include <QVariant>
 #include <QDateTime>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+#include "DbPool.h"
+#include "KeywordCache.h"
 #include "MetadataExtractor.h"
 
 struct WorkerPayload {
@@ -14,11 +21,85 @@ struct WorkerPayload {
     long long fileSize;
     QDateTime fileDate;
     PhotoData meta;
+
+    std::string contentHash;        // XXH3-128 hex, leer wenn unbekannt
+    bool linkOnly = false;          // Duplikat: nur Verweis in picture_links
+    bool replaceExisting = false;   // Duplikat: ältere Fotos mit gleichem Hash entfernen
+    std::optional<uint64_t> phash;  // Perceptual Hash (WORKER_PHASH=on, nur JPEG)
+
+    std::function<void(qint64)> onStored;   // HTTP-Ingest: Picture-ID nach dem Commit, -1 bei Fehler
+};
+
+// Ein erzeugtes Thumbnail/Preview (picture_derivatives)
+struct DerivativeRecord {
+    std::string kind;     // z.B. "256", "1024"
+    std::string format;   // "jpeg" | "webp"
+    int width = 0;
+    int height = 0;
+    std::string path;
+};
+
+// Beinahe-Duplikat: pictureId ähnelt dem älteren candidateId (Hamming-Abstand der pHashes)
+struct NearDuplicate {
+    qint64 pictureId = 0;
+    qint64 candidateId = 0;
+    int distance = 0;
+};
+
+// Verhalten, wenn eine Zeile im Batch fehlschlägt
+enum class BatchFailureMode {
+    Rollback,   // ganzer Batch wird verworfen
+    Isolate     // Batch wird zeilenweise (SAVEPOINT) wiederholt, nur die fehlerhafte Zeile fällt raus
 };
 
 class DbManager {
 public:
     static bool insertPhoto(const WorkerPayload& p);
+
+    // Mehrere Fotos in EINER Transaktion (Multi-Row INSERT ... RETURNING).
+    // Liefert pro Payload die neue Picture-ID bzw. -1 bei Fehler.
+    static std::vector<qint64> insertBatch(std::span<const WorkerPayload> batch, BatchFailureMode mode);
+
+    // Wie insertBatch, aber vorhandene Fotos (gleicher full_path) werden
+    // aktualisiert statt doppelt angelegt (--reindex). IDs bleiben erhalten.
+    static std::vector<qint64> upsertBatch(std::span<const WorkerPayload> batch, BatchFailureMode mode);
+
+    // Duplikate (linkOnly) per content_hash auf vorhandene Fotos verweisen lassen.
+    // Liefert die Anzahl geschriebener Verweise, -1 bei Fehler.
+    static int insertLinks(std::span<const WorkerPayload> links);
+
+    // Kandidaten für Beinahe-Duplikate eintragen (inzwischen gelöschte Fotos
+    // werden übersprungen). Liefert die Anzahl geschriebener Zeilen, -1 bei Fehler.
+    static int insertNearDuplicates(std::span<const NearDuplicate> pairs);
+
+    // Derivate eines Fotos + Blurhash speichern (Upsert je kind).
+    static bool insertDerivatives(qint64 pictureId, std::span<const DerivativeRecord> derivatives,
+                                  const std::string& blurhash);
+
+    // Antwortet die DB? (SELECT 1) Unterscheidet Ausfall von fehlerhaften Zeilen.
+    static bool isReachable();
+
 private:
-    static int getOrCreateKeywordId(QSqlDatabase& db, const QString& tag);
-};
\ No newline at end of file
+    // Was erst nach erfolgreichem COMMIT passieren darf
+    struct WriteContext {
+        KeywordCache::Resolved freshKeywords;
+        std::vector<std::string> obsoleteFiles;   // Dateien ersetzter Fotos
+        std::vector<qint64> deletedPictures;      // IDs ersetzter Fotos
+    };
+
+    using RowWriter = bool (*)(DbPool::Lease&, std::span<const WorkerPayload>, std::vector<qint64>&, WriteContext&);
+
+    // Transaktion + ggf. zeilenweise Wiederholung (SAVEPOINT) um einen RowWriter
+    static std::vector<qint64> runBatch(std::span<const WorkerPayload> batch, BatchFailureMode mode, RowWriter write);
+
+    static bool writeRows(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::vector<qint64>& ids,
+                          WriteContext& ctx);
+    static bool upsertRows(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::vector<qint64>& ids,
+                           WriteContext& ctx);
+    static bool insertPictures(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::vector<qint64>& ids,
+                               WriteContext& ctx);
+    static bool deleteReplaced(DbPool::Lease& lease, const WorkerPayload& row, qint64 id, WriteContext& ctx);
+    static bool writeMeta(DbPool::Lease& lease, std::span<const WorkerPayload> rows, std::span<const qint64> ids,
+                          WriteContext& ctx);
+    static void afterCommit(const WriteContext& ctx, std::span<const WorkerPayload> rows);
+};
@@ -0,0 +1,250 @@
+#include "DbPool.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QThread>
+#include <QtGlobal>
+#include <algorithm>
+#include <utility>
+
+using Clock = std::chrono::steady_clock;
+
+DbPool& DbPool::instance() {
+    static DbPool pool;
+    return pool;
+}
+
+DbPool::DbPool() {
+    configureFromEnvironment();
+}
+
+// --- KONFIGURATION AUS UMGEBUNGSVARIABLEN (einmalig) ---
+void DbPool::configureFromEnvironment() {
+    host_   = qEnvironmentVariable("PG_HOST", "localhost");
+    dbName_ = qEnvironmentVariable("PG_DB", "Photos");
+    user_   = qEnvironmentVariable("PG_USER", "postgres");
+    pass_   = qEnvironmentVariable("PG_PASS");
+    port_   = qEnvironmentVariable("PG_PORT", "5432").toInt();
+
+    // Wird 1:1 an libpq durchgereicht (z.B. "sslmode=require;connect_timeout=5")
+    connectOptions_ = qEnvironmentVariable("PG_CONNECT_OPTIONS", "connect_timeout=5;keepalives=1;keepalives_idle=30");
+
+    bool ok = false;
+    int maxSize = qEnvironmentVariableIntValue("PG_POOL_MAX", &ok);
+    if (ok && maxSize > 0) {
+        maxSize_ = maxSize;
+        maxSizeFromEnv_ = true;
+    }
+    int check = qEnvironmentVariableIntValue("PG_POOL_HEALTHCHECK_SEC", &ok);
+    if (ok && check >= 0) healthCheckAfter_ = std::chrono::seconds(check);
+
+    // Warnung, falls Passwort fehlt (optional)
+    if (pass_.isEmpty()) {
+        qWarning() << "Warnung: Umgebungsvariable PG_PASS ist nicht gesetzt!";
+    }
+}
+
+bool DbPool::openConnection(Slot& slot) {
+    slot.db = QSqlDatabase::contains(slot.connName)
+        ? QSqlDatabase::database(slot.connName, false)
+        : QSqlDatabase::addDatabase("QPSQL", slot.connName);
+
+    slot.db.setHostName(host_);
+    slot.db.setDatabaseName(dbName_);
+    slot.db.setUserName(user_);
+    slot.db.setPassword(pass_);
+    slot.db.setPort(port_);
+    slot.db.setConnectOptions(connectOptions_);
+
+    if (!slot.db.open()) {
+        qCritical() << "DB Open Error (" << host_ << "/" << dbName_ << "):" << slot.db.lastError().text();
+        return false;
+    }
+    slot.broken = false;
+    slot.lastUsed = Clock::now();
+    return true;
+}
+
+// Leichter Health-Check für länger ungenutzte Verbindungen
+bool DbPool::isHealthy(Slot& slot) {
+    if (!slot.db.isOpen()) return false;
+    QSqlQuery q(slot.db);
+    return q.exec("SELECT 1") && q.next();
+}
+
+// Prepared Statements und Qt-Handle müssen vor removeDatabase() weg sein
+void DbPool::closeConnection(Slot& slot) {
+    slot.statements.clear();
+    slot.db.close();
+    slot.db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(slot.connName);
+}
+
+DbPool::Lease DbPool::acquire() {
+    auto t0 = Clock::now();
+    bool needOpen = false;
+    Slot* slot = nullptr;
+
+    {
+        std::unique_lock lock(mutex_);
+        auto& slotPtr = slots_[std::this_thread::get_id()];
+        if (!slotPtr) {
+            slotPtr = std::make_unique<Slot>();
+            // Unique Connection Name pro Thread
+            slotPtr->connName = QString("pg_worker_%1").arg((quint64)QThread::currentThreadId());
+        }
+        slot = slotPtr.get();
+
+        if (slot->leased) {
+            qWarning() << "DbPool: nested acquire() in the same thread";
+            return {};
+        }
+
+        if (!slot->open) {
+            // Pool voll -> warten, bis ein anderer Thread seine Verbindung freigibt
+            slotFree_.wait(lock, [&] { return openConnections_ < maxSize_; });
+            openConnections_++;
+            slot->open = true;
+            needOpen = true;
+        }
+        slot->leased = true;
+        inUse_++;
+    }
+
+    static MetricHistogram& waitSeconds = MetricsRegistry::instance().histogram(
+        "worker_db_pool_wait_seconds", "Time spent waiting for a pooled DB connection");
+    qint64 waited = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+    waitSeconds.observe(waited / 1e9);
+    acquisitions_++;
+    waitNanosTotal_ += waited;
+    qint64 prevMax = waitNanosMax_.load(std::memory_order_relaxed);
+    while (waited > prevMax && !waitNanosMax_.compare_exchange_weak(prevMax, waited)) {}
+
+    Lease lease(this, slot);
+
+    if (needOpen) {
+        if (!openConnection(*slot)) {
+            lease.release();
+            releaseThread();
+            return {};
+        }
+        return lease;
+    }
+
+    // Bestehende Verbindung: nach Fehler oder langer Pause prüfen / neu verbinden
+    bool stale = Clock::now() - slot->lastUsed > healthCheckAfter_;
+    if ((slot->broken || stale) && !isHealthy(*slot)) {
+        qWarning() << "DbPool: reconnecting" << slot->connName;
+        reconnects_++;
+        slot->statements.clear();
+        slot->db.close();
+        if (!openConnection(*slot)) {
+            slot->broken = true;
+            return {};   // Lease-Destruktor gibt den Slot zurück
+        }
+    }
+    slot->broken = false;
+    return lease;
+}
+
+void DbPool::giveBack(Slot* slot) {
+    slot->lastUsed = Clock::now();
+    std::lock_guard lock(mutex_);
+    slot->leased = false;
+    inUse_--;
+}
+
+void DbPool::releaseThread() {
+    std::unique_ptr<Slot> slot;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = slots_.find(std::this_thread::get_id());
+        if (it == slots_.end() || it->second->leased) return;
+        slot = std::move(it->second);
+        slots_.erase(it);
+    }
+
+    if (!slot->open) return;
+    closeConnection(*slot);
+
+    std::lock_guard lock(mutex_);
+    openConnections_--;
+    slotFree_.notify_one();
+}
+
+bool DbPool::reserveFor(int connections, const QString& detail) {
+    std::lock_guard lock(mutex_);
+    if (connections <= maxSize_) {
+        qDebug() << "DB pool:" << connections << "of" << maxSize_ << "connections needed -" << detail;
+        return true;
+    }
+    if (maxSizeFromEnv_) {
+        qCritical() << "PG_POOL_MAX =" << maxSize_ << "is too small," << connections
+                    << "connections needed -" << detail << "-> raise PG_POOL_MAX or lower the thread counts";
+        return false;
+    }
+    qWarning() << "DB pool: raising the default maximum from" << maxSize_ << "to" << connections << "-" << detail;
+    maxSize_ = connections;
+    slotFree_.notify_all();
+    return true;
+}
+
+DbPoolStats DbPool::stats() const {
+    DbPoolStats s;
+    {
+        std::lock_guard lock(mutex_);
+        s.maxSize = maxSize_;
+        s.openConnections = openConnections_;
+        s.inUse = inUse_;
+    }
+    s.acquisitions = acquisitions_.load();
+    s.reconnects = reconnects_.load();
+    if (s.acquisitions > 0) s.avgWaitMs = waitNanosTotal_.load() / 1e6 / s.acquisitions;
+    s.maxWaitMs = waitNanosMax_.load() / 1e6;
+    return s;
+}
+
+// --- Lease ---
+
+DbPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(std::exchange(other.pool_, nullptr)), slot_(std::exchange(other.slot_, nullptr)) {}
+
+DbPool::Lease& DbPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = std::exchange(other.pool_, nullptr);
+        slot_ = std::exchange(other.slot_, nullptr);
+    }
+    return *this;
+}
+
+DbPool::Lease::~Lease() {
+    release();
+}
+
+void DbPool::Lease::release() {
+    if (slot_) pool_->giveBack(slot_);
+    pool_ = nullptr;
+    slot_ = nullptr;
+}
+
+QSqlDatabase& DbPool::Lease::db() {
+    return slot_->db;
+}
+
+QSqlQuery& DbPool::Lease::prepared(const QString& sql) {
+    auto it = slot_->statements.find(sql);
+    if (it != slot_->statements.end()) return *it->second;
+
+    // Fehler zeigt sich spätestens bei exec(); bei Verbindungsproblemen
+    // verwirft markBroken() -> Reconnect ohnehin den ganzen Cache
+    auto q = std::make_unique<QSqlQuery>(slot_->db);
+    if (!q->prepare(sql)) {
+        qCritical() << "Prepare failed:" << q->lastError().text();
+    }
+    return *slot_->statements.emplace(sql, std::move(q)).first->second;
+}
+
+void DbPool::Lease::markBroken() {
+    if (slot_) slot_->broken = true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+struct DbPoolStats {
+    int maxSize = 0;
+    int openConnections = 0;
+    int inUse = 0;
+    qint64 acquisitions = 0;
+    qint64 reconnects = 0;
+    double avgWaitMs = 0.0;
+    double maxWaitMs = 0.0;
+};
+
+// Persistenter PostgreSQL Connection-Pool.
+// Qt erlaubt eine Verbindung nur in dem Thread, der sie geöffnet hat ->
+// jeder Worker-Thread bekommt genau eine eigene Verbindung, die offen bleibt.
+// PG_POOL_MAX begrenzt die Anzahl gleichzeitig offener Verbindungen; weitere
+// Threads warten in acquire(), bis ein Thread seine Verbindung freigibt.
+class DbPool {
+    struct Slot;
+
+public:
+    // RAII-Zugriff auf die Verbindung des aktuellen Threads
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        bool isValid() const { return slot_ != nullptr; }
+        QSqlDatabase& db();
+
+        // Einmal pro Verbindung vorbereitetes Statement (Server-seitiges PREPARE)
+        QSqlQuery& prepared(const QString& sql);
+
+        // Nach einem Fehler: beim nächsten acquire() prüfen und ggf. neu verbinden
+        void markBroken();
+
+    private:
+        friend class DbPool;
+        Lease(DbPool* pool, Slot* slot) : pool_(pool), slot_(slot) {}
+        void release();
+
+        DbPool* pool_ = nullptr;
+        Slot* slot_ = nullptr;
+    };
+
+    static DbPool& instance();
+
+    // Verbindung des aktuellen Threads holen (öffnen / prüfen / neu verbinden)
+    Lease acquire();
+
+    // Verbindung des aktuellen Threads schließen und Platz im Pool freigeben
+    void releaseThread();
+
+    // Beim Start: so viele Verbindungen werden gebraucht (Threads, die ihre bis
+    // zum Ende halten, plus Kurzzugriffe). Reicht der Pool nicht, warten die
+    // übrigen Threads in acquire() für immer. Ohne PG_POOL_MAX wird er deshalb
+    // vergrößert, ein zu kleines PG_POOL_MAX -> false (Aufrufer bricht ab).
+    bool reserveFor(int connections, const QString& detail);
+
+    DbPoolStats stats() const;
+
+private:
+    DbPool();
+    void configureFromEnvironment();
+    bool openConnection(Slot& slot);
+    bool isHealthy(Slot& slot);
+    void closeConnection(Slot& slot);
+    void giveBack(Slot* slot);
+
+    struct Slot {
+        QString connName;
+        QSqlDatabase db;
+        std::unordered_map<QString, std::unique_ptr<QSqlQuery>> statements;
+        std::chrono::steady_clock::time_point lastUsed;
+        bool open = false;
+        bool broken = false;
+        bool leased = false;
+    };
+
+    // Konfiguration (einmalig aus PG_* gelesen)
+    QString host_, dbName_, user_, pass_, connectOptions_;
+    int port_ = 5432;
+    int maxSize_ = 8;
+    bool maxSizeFromEnv_ = false;   // PG_POOL_MAX gesetzt -> nicht automatisch vergrößern
+    std::chrono::seconds healthCheckAfter_{30};
+
+    mutable std::mutex mutex_;
+    std::condition_variable slotFree_;
+    std::unordered_map<std::thread::id, std::unique_ptr<Slot>> slots_;
+    int openConnections_ = 0;
+    int inUse_ = 0;
+
+    std::atomic<qint64> acquisitions_{0};
+    std::atomic<qint64> reconnects_{0};
+    std::atomic<qint64> waitNanosTotal_{0};
+    std::atomic<qint64> waitNanosMax_{0};
+};
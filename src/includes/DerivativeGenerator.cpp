@@ -0,0 +1,263 @@
+#include "DerivativeGenerator.h"
+#include "Blurhash.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <jpeglib.h>
+#ifdef WORKER_HAVE_WEBP
+#include <webp/encode.h>
+#endif
+
+namespace fs = std::filesystem;
+
+DerivativeConfig DerivativeConfig::fromEnvironment() {
+    DerivativeConfig cfg;
+    cfg.root = qEnvironmentVariable("WORKER_DERIVATIVES_ROOT", "Derivatives").toStdString();
+
+    // "256,1024" -> aufsteigend, ohne Duplikate
+    QString sizes = qEnvironmentVariable("WORKER_DERIVATIVE_SIZES", "256,1024");
+    std::vector<int> parsed;
+    for (const QString& s : sizes.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int v = s.trimmed().toInt(&ok);
+        if (ok && v >= 16 && v <= 8192) parsed.push_back(v);
+        else qWarning() << "Ignoring derivative size" << s;
+    }
+    std::sort(parsed.begin(), parsed.end());
+    parsed.erase(std::unique(parsed.begin(), parsed.end()), parsed.end());
+    if (!parsed.empty()) cfg.sizes = std::move(parsed);
+
+    QString format = qEnvironmentVariable("WORKER_DERIVATIVE_FORMAT", "jpeg").toLower();
+    if (format == "webp") {
+#ifdef WORKER_HAVE_WEBP
+        cfg.format = DerivativeFormat::WebP;
+#else
+        qWarning() << "WORKER_DERIVATIVE_FORMAT=webp, but built without libwebp -> jpeg";
+#endif
+    }
+
+    bool ok = false;
+    int quality = qEnvironmentVariableIntValue("WORKER_DERIVATIVE_QUALITY", &ok);
+    if (ok) cfg.quality = std::clamp(quality, 1, 100);
+    cfg.blurhash = qEnvironmentVariable("WORKER_BLURHASH", "on") != "off";
+    return cfg;
+}
+
+DerivativeGenerator::DerivativeGenerator(DerivativeConfig cfg) : cfg_(std::move(cfg)) {}
+
+static const char* extensionFor(DerivativeFormat f) {
+    return f == DerivativeFormat::WebP ? ".webp" : ".jpg";
+}
+
+static const char* formatName(DerivativeFormat f) {
+    return f == DerivativeFormat::WebP ? "webp" : "jpeg";
+}
+
+fs::path DerivativeGenerator::targetPath(int size, const std::string& relPath, const std::string& filename) const {
+    // Voller Originalname: "a.jpg" und "a.png" im selben Ordner bekämen sonst beide "a.webp"
+    fs::path name = filename;
+    name += extensionFor(cfg_.format);
+    return cfg_.root / std::to_string(size) / relPath / name;
+}
+
+// --- libjpeg ---------------------------------------------------------------
+// Der Standard-Fehlerhandler ruft exit() -> per longjmp zurück in den Aufrufer.
+// Zwischen setjmp und longjmp dürfen deshalb keine C++-Objekte mit Destruktor
+// im selben Frame entstehen.
+
+namespace {
+struct JpegError {
+    jpeg_error_mgr mgr;
+    std::jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+} // namespace
+
+static void jpegErrorExit(j_common_ptr cinfo) {
+    auto* err = reinterpret_cast<JpegError*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    std::longjmp(err->jump, 1);
+}
+
+static void jpegSilent(j_common_ptr, int) {}
+
+static bool decodeInto(FILE* in, int minEdge, RgbImage* out, JpegError* err) {
+    jpeg_decompress_struct cinfo;
+    cinfo.err = jpeg_std_error(&err->mgr);
+    err->mgr.error_exit = jpegErrorExit;
+    err->mgr.emit_message = jpegSilent;   // Warnungen (z.B. korrupte Daten am Ende) nicht auf stderr
+    if (setjmp(err->jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, in);
+    jpeg_read_header(&cinfo, TRUE);
+
+    // Kleinsten Faktor n/8 wählen, bei dem die längste Kante noch >= minEdge ist
+    const unsigned longEdge = std::max(cinfo.image_width, cinfo.image_height);
+    unsigned num = 8;
+    for (unsigned n = 1; n < 8; ++n) {
+        if ((longEdge * n + 7) / 8 >= static_cast<unsigned>(minEdge)) {
+            num = n;
+            break;
+        }
+    }
+    cinfo.scale_num = num;
+    cinfo.scale_denom = 8;
+    cinfo.out_color_space = JCS_RGB;   // auch Graustufen/YCCK -> RGB
+    cinfo.dct_method = JDCT_ISLOW;
+
+    jpeg_start_decompress(&cinfo);
+    if (cinfo.output_components != 3) {
+        std::snprintf(err->message, sizeof(err->message), "unsupported color space");
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    out->width = static_cast<int>(cinfo.output_width);
+    out->height = static_cast<int>(cinfo.output_height);
+    out->pixels.resize(static_cast<size_t>(out->width) * out->height * 3);
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = &out->pixels[static_cast<size_t>(cinfo.output_scanline) * out->width * 3];
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+bool DerivativeGenerator::decodeJpegScaled(const fs::path& file, int minEdge, RgbImage& out, std::string& error) {
+    FILE* in = std::fopen(file.c_str(), "rb");
+    if (!in) {
+        error = "cannot open file";
+        return false;
+    }
+    JpegError err{};
+    bool ok = decodeInto(in, minEdge, &out, &err);
+    std::fclose(in);
+    if (!ok) {
+        error = err.message;
+        out = RgbImage();
+    }
+    return ok;
+}
+
+static bool encodeJpeg(FILE* outFile, const RgbImage& img, int quality, JpegError* err) {
+    jpeg_compress_struct cinfo;
+    cinfo.err = jpeg_std_error(&err->mgr);
+    err->mgr.error_exit = jpegErrorExit;
+    if (setjmp(err->jump)) {
+        jpeg_destroy_compress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, outFile);
+    cinfo.image_width = static_cast<JDIMENSION>(img.width);
+    cinfo.image_height = static_cast<JDIMENSION>(img.height);
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    cinfo.optimize_coding = TRUE;
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = const_cast<JSAMPROW>(&img.pixels[static_cast<size_t>(cinfo.next_scanline) * img.width * 3]);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return true;
+}
+
+// Erst in <ziel>.tmp schreiben, dann umbenennen -> die Galerie sieht nie halbe Dateien
+void DerivativeGenerator::write(const RgbImage& img, const fs::path& target) const {
+    fs::create_directories(target.parent_path());
+    fs::path tmp = target;
+    tmp += ".tmp";
+
+    if (cfg_.format == DerivativeFormat::WebP) {
+#ifdef WORKER_HAVE_WEBP
+        uint8_t* data = nullptr;
+        size_t size = WebPEncodeRGB(img.pixels.data(), img.width, img.height, img.width * 3,
+                                    static_cast<float>(cfg_.quality), &data);
+        if (size == 0) throw std::runtime_error("WebP encode failed");
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        WebPFree(data);
+        if (!out) throw std::runtime_error("cannot write " + tmp.string());
+#endif
+    } else {
+        FILE* out = std::fopen(tmp.c_str(), "wb");
+        if (!out) throw std::runtime_error("cannot write " + tmp.string());
+        JpegError err{};
+        bool ok = encodeJpeg(out, img, cfg_.quality, &err);
+        ok = (std::fclose(out) == 0) && ok;
+        if (!ok) {
+            fs::remove(tmp);
+            throw std::runtime_error("JPEG encode failed: " + std::string(err.message));
+        }
+    }
+    fs::rename(tmp, target);
+}
+
+static bool isJpeg(const fs::path& file) {
+    std::ifstream in(file, std::ios::binary);
+    unsigned char soi[3] = {};
+    in.read(reinterpret_cast<char*>(soi), 3);
+    return in && soi[0] == 0xFF && soi[1] == 0xD8 && soi[2] == 0xFF;
+}
+
+DerivativeResult DerivativeGenerator::generate(const fs::path& original, const std::string& relPath) const {
+    DerivativeResult result;
+    if (cfg_.sizes.empty() || !isJpeg(original)) {
+        result.unsupported = true;
+        return result;
+    }
+
+    // 1. Einmal dekodieren, gerade groß genug für das größte Derivat
+    RgbImage decoded;
+    std::string error;
+    if (!decodeJpegScaled(original, cfg_.sizes.back(), decoded, error)) {
+        throw std::runtime_error("JPEG decode failed: " + error);
+    }
+
+    // 2. Vom größten zum kleinsten Derivat, jeweils aus dem vorherigen (weniger Pixel pro Schritt)
+    const std::string filename = original.filename().string();
+    const RgbImage* source = &decoded;
+    RgbImage previous;
+    try {
+        for (auto it = cfg_.sizes.rbegin(); it != cfg_.sizes.rend(); ++it) {
+            int w = 0, h = 0;
+            fitInside(decoded.width, decoded.height, *it, w, h);
+            RgbImage scaled = (w == source->width && h == source->height) ? *source : resizeRgb(*source, w, h);
+
+            fs::path target = targetPath(*it, relPath, filename);
+            write(scaled, target);
+            result.records.push_back({std::to_string(*it), formatName(cfg_.format), w, h, target.string()});
+
+            previous = std::move(scaled);
+            source = &previous;
+        }
+    } catch (...) {
+        for (const auto& r : result.records) {
+            std::error_code ec;
+            fs::remove(r.path, ec);
+        }
+        throw;
+    }
+
+    // 3. Blurhash aus einer 32px-Version des kleinsten Derivats
+    if (cfg_.blurhash) {
+        int w = 0, h = 0;
+        fitInside(source->width, source->height, 32, w, h);
+        result.blurhash = encodeBlurhash(resizeRgb(*source, w, h));
+    }
+    return result;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "DbManager.h"
+#include "ImageResize.h"
+
+enum class DerivativeFormat { Jpeg, WebP };
+
+// Welche Derivate erzeugt werden (aus Umgebungsvariablen)
+struct DerivativeConfig {
+    std::filesystem::path root;          // parallel zu Photos/: <root>/<größe>/<relPath>/<name.jpg>.<ext>
+    std::vector<int> sizes{256, 1024};   // längste Kante in Pixeln, aufsteigend
+    DerivativeFormat format = DerivativeFormat::Jpeg;
+    int quality = 82;
+    bool blurhash = true;
+
+    static DerivativeConfig fromEnvironment();
+};
+
+struct DerivativeResult {
+    std::vector<DerivativeRecord> records;
+    std::string blurhash;
+    bool unsupported = false;   // kein JPEG -> nichts zu tun
+};
+
+// Thumbnails/Previews für ein Original. Dekodiert per skalierter IDCT
+// (libjpeg scale_num/8) nur so viele Pixel wie das größte Derivat braucht.
+class DerivativeGenerator {
+public:
+    explicit DerivativeGenerator(DerivativeConfig cfg);
+
+    // Wirft std::runtime_error bei Dekodier-/Schreibfehlern.
+    // Bereits geschriebene Dateien werden dann wieder entfernt.
+    DerivativeResult generate(const std::filesystem::path& original, const std::string& relPath) const;
+
+    // Zielpfad eines Derivats (auch zum Aufräumen)
+    std::filesystem::path targetPath(int size, const std::string& relPath, const std::string& filename) const;
+
+    const DerivativeConfig& config() const { return cfg_; }
+
+    // JPEG dekodieren, sodass die längste Kante >= minEdge bleibt (falls das Original so groß ist)
+    static bool decodeJpegScaled(const std::filesystem::path& file, int minEdge, RgbImage& out, std::string& error);
+
+private:
+    void write(const RgbImage& img, const std::filesystem::path& target) const;
+
+    DerivativeConfig cfg_;
+};
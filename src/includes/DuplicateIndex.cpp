@@ -0,0 +1,99 @@
+#include "DuplicateIndex.h"
+#include "DbPool.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+
+DuplicateIndex& DuplicateIndex::instance() {
+    static DuplicateIndex index;
+    return index;
+}
+
+DuplicatePolicy DuplicateIndex::policyFromEnvironment() {
+    QString policy = qEnvironmentVariable("WORKER_DUPLICATE_POLICY", "skip");
+    if (policy == "link") return DuplicatePolicy::Link;
+    if (policy == "replace") return DuplicatePolicy::Replace;
+    return DuplicatePolicy::Skip;
+}
+
+bool DuplicateIndex::load() {
+    size_t loaded = 0;
+    {
+        DbPool::Lease lease = DbPool::instance().acquire();
+        if (!lease.isValid()) return false;
+
+        QSqlQuery q(lease.db());
+        q.setForwardOnly(true);
+        if (!q.exec("SELECT content_hash, id FROM pictures WHERE content_hash IS NOT NULL")) {
+            qCritical() << "Loading content hashes failed:" << q.lastError().text();
+            return false;
+        }
+
+        std::lock_guard lock(mutex_);
+        while (q.next()) {
+            ContentHash h = ContentHash::fromHex(q.value(0).toString().toStdString());
+            if (h.valid) ids_.emplace(h, q.value(1).toLongLong());
+        }
+        loaded = ids_.size();
+    }
+    DbPool::instance().releaseThread();
+    qDebug() << "Duplicate index loaded:" << loaded << "hashes";
+    return true;
+}
+
+std::optional<qint64> DuplicateIndex::findOrReserve(const ContentHash& hash) {
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = ids_.try_emplace(hash, 0);
+    if (inserted) return std::nullopt;
+    return it->second;
+}
+
+void DuplicateIndex::commit(const ContentHash& hash, qint64 pictureId) {
+    std::unique_lock lock(mutex_);
+    ids_.insert_or_assign(hash, pictureId);
+    notify(hash, lock);
+}
+
+// Reservierung zurücknehmen (Verarbeitung fehlgeschlagen)
+void DuplicateIndex::release(const ContentHash& hash) {
+    std::unique_lock lock(mutex_);
+    auto it = ids_.find(hash);
+    if (it == ids_.end() || it->second != 0) return;
+    ids_.erase(it);
+    notify(hash, lock);
+}
+
+void DuplicateIndex::erase(const ContentHash& hash) {
+    std::unique_lock lock(mutex_);
+    ids_.erase(hash);
+    notify(hash, lock);
+}
+
+bool DuplicateIndex::whenSettled(const ContentHash& hash, const void* owner, std::function<void()> onSettled) {
+    std::lock_guard lock(mutex_);
+    auto it = ids_.find(hash);
+    if (it == ids_.end() || it->second != 0) return false;
+    waiters_[hash].push_back({owner, std::move(onSettled)});
+    return true;
+}
+
+void DuplicateIndex::cancelWaiters(const void* owner) {
+    std::lock_guard lock(mutex_);
+    for (auto it = waiters_.begin(); it != waiters_.end();) {
+        std::erase_if(it->second, [owner](const Waiter& w) { return w.owner == owner; });
+        it = it->second.empty() ? waiters_.erase(it) : std::next(it);
+    }
+}
+
+// Rückrufe ohne Lock: sie fragen den Index typischerweise gleich wieder
+void DuplicateIndex::notify(const ContentHash& hash, std::unique_lock<std::mutex>& lock) {
+    auto node = waiters_.extract(hash);
+    lock.unlock();
+    if (node.empty()) return;
+    for (Waiter& w : node.mapped()) w.onSettled();
+}
+
+size_t DuplicateIndex::size() const {
+    std::lock_guard lock(mutex_);
+    return ids_.size();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <QString>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "ContentHash.h"
+
+// Was passiert mit exakten Duplikaten (WORKER_DUPLICATE_POLICY)
+enum class DuplicatePolicy {
+    Skip,     // Upload verwerfen
+    Link,     // Upload als Verweis auf das vorhandene Foto eintragen (picture_links)
+    Replace   // Upload normal verarbeiten, altes Foto danach entfernen
+};
+
+// In-Memory Index aller bekannten Inhalts-Hashes (pictures.content_hash).
+// Beim Start aus der DB geladen; Duplikate überspringen Exiv2 und DB komplett.
+class DuplicateIndex {
+public:
+    static DuplicateIndex& instance();
+
+    bool load();
+
+    // Ist der Hash bekannt, wird die Picture-ID geliefert (0 = gerade in Arbeit).
+    // Sonst wird er für den Aufrufer reserviert und nullopt zurückgegeben.
+    std::optional<qint64> findOrReserve(const ContentHash& hash);
+
+    void commit(const ContentHash& hash, qint64 pictureId);
+    void release(const ContentHash& hash);
+    void erase(const ContentHash& hash);
+
+    // Ist der Hash gerade reserviert (ID 0), wird onSettled genau einmal nach
+    // commit(), release() oder erase() aufgerufen (ohne Lock, im Thread des
+    // Aufrufers) -> true. false -> nicht (mehr) reserviert, neu nachfragen.
+    bool whenSettled(const ContentHash& hash, const void* owner, std::function<void()> onSettled);
+    // Noch ausstehende Rückrufe von owner verwerfen (Herunterfahren)
+    void cancelWaiters(const void* owner);
+
+    size_t size() const;
+
+    static DuplicatePolicy policyFromEnvironment();
+
+private:
+    DuplicateIndex() = default;
+
+    struct Waiter {
+        const void* owner;
+        std::function<void()> onSettled;
+    };
+
+    void notify(const ContentHash& hash, std::unique_lock<std::mutex>& lock);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<ContentHash, qint64> ids_;
+    std::unordered_map<ContentHash, std::vector<Waiter>> waiters_;
+};
@@ -0,0 +1,716 @@
+#include "FastMetadataReader.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+// --- MappedHeader ---
+
+MappedHeader::MappedHeader(const std::filesystem::path& p, size_t window) {
+    int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_t len = std::min(static_cast<size_t>(st.st_size), window);
+        void* map = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            data_ = static_cast<const unsigned char*>(map);
+            size_ = len;
+        }
+    }
+    ::close(fd);
+}
+
+MappedHeader::~MappedHeader() {
+    if (data_) ::munmap(const_cast<unsigned char*>(data_), size_);
+}
+
+namespace {
+
+using Bytes = std::span<const unsigned char>;
+
+std::string_view asText(Bytes b) {
+    return {reinterpret_cast<const char*>(b.data()), b.size()};
+}
+
+bool startsWith(Bytes b, std::string_view prefix) {
+    return b.size() >= prefix.size() && std::memcmp(b.data(), prefix.data(), prefix.size()) == 0;
+}
+
+uint16_t be16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+uint32_t be32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+           static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+// ------------------------------------------------------------------------
+// TIFF / Exif
+// ------------------------------------------------------------------------
+
+enum TiffType : uint16_t {
+    T_BYTE = 1, T_ASCII = 2, T_SHORT = 3, T_LONG = 4, T_RATIONAL = 5,
+    T_SBYTE = 6, T_UNDEFINED = 7, T_SSHORT = 8, T_SLONG = 9, T_SRATIONAL = 10,
+    T_IFD = 13
+};
+
+size_t typeSize(uint16_t type) {
+    switch (type) {
+        case T_BYTE: case T_ASCII: case T_SBYTE: case T_UNDEFINED: return 1;
+        case T_SHORT: case T_SSHORT: return 2;
+        case T_LONG: case T_SLONG: case T_IFD: return 4;
+        case T_RATIONAL: case T_SRATIONAL: return 8;
+        default: return 0;
+    }
+}
+
+struct IfdEntry {
+    uint16_t tag = 0;
+    uint16_t type = 0;
+    uint32_t count = 0;
+    Bytes data;       // Wert (inline oder über Offset), bereits bereichsgeprüft
+};
+
+class TiffReader {
+public:
+    TiffReader(Bytes tiff, FastMetadata& out) : d_(tiff), out_(out) {}
+
+    bool read() {
+        if (d_.size() < 8) return false;
+        if (d_[0] == 'I' && d_[1] == 'I') le_ = true;
+        else if (d_[0] == 'M' && d_[1] == 'M') le_ = false;
+        else return false;
+        if (u16(2) != 42) return false;
+
+        uint32_t exifIfd = 0, gpsIfd = 0;
+        bool ok = readIfd(u32(4), [&](const IfdEntry& e) {
+            switch (e.tag) {
+                case 0x010F: return text(e, out_.make);
+                case 0x0110: return text(e, out_.model);
+                case 0x8769: return pointer(e, exifIfd);
+                case 0x8825: return pointer(e, gpsIfd);
+                default: return true;
+            }
+        });
+        if (!ok) return false;
+
+        if (exifIfd && !readIfd(exifIfd, [&](const IfdEntry& e) {
+                switch (e.tag) {
+                    case 0x829A: return text(e, out_.exposure);
+                    case 0x829D: return text(e, out_.aperture);
+                    case 0x8827: return text(e, out_.iso);
+                    case 0x9003: return text(e, out_.dateTimeOriginal);
+                    default: return true;
+                }
+            })) {
+            return false;
+        }
+
+        if (gpsIfd) {
+            IfdEntry lat, latRef, lon, lonRef, alt, altRef;
+            if (!readIfd(gpsIfd, [&](const IfdEntry& e) {
+                    switch (e.tag) {
+                        case 1: if (!latRef.tag) latRef = e; break;
+                        case 2: if (!lat.tag) lat = e; break;
+                        case 3: if (!lonRef.tag) lonRef = e; break;
+                        case 4: if (!lon.tag) lon = e; break;
+                        case 5: if (!altRef.tag) altRef = e; break;
+                        case 6: if (!alt.tag) alt = e; break;
+                    }
+                    return true;
+                })) {
+                return false;
+            }
+            if (!coordinate(lat, latRef, out_.gpsLat)) return false;
+            if (!coordinate(lon, lonRef, out_.gpsLon)) return false;
+            if (!altitude(alt, altRef, out_.gpsAlt)) return false;
+        }
+        return true;
+    }
+
+private:
+    uint16_t u16(size_t off) const {
+        const unsigned char* p = d_.data() + off;
+        return le_ ? static_cast<uint16_t>(p[0] | p[1] << 8) : be16(p);
+    }
+    uint32_t u32(size_t off) const {
+        const unsigned char* p = d_.data() + off;
+        return le_ ? (static_cast<uint32_t>(p[3]) << 24 | static_cast<uint32_t>(p[2]) << 16 |
+                      static_cast<uint32_t>(p[1]) << 8 | p[0])
+                   : be32(p);
+    }
+    bool inRange(size_t off, size_t len) const {
+        return off <= d_.size() && len <= d_.size() - off;
+    }
+
+    template <typename Fn>
+    bool readIfd(uint32_t offset, Fn&& onEntry) {
+        if (!inRange(offset, 2)) return false;
+        uint16_t n = u16(offset);
+        if (!inRange(offset + 2, static_cast<size_t>(n) * 12)) return false;
+
+        // Exiv2 verwendet beim Lesen per findKey() jeweils den ersten Eintrag
+        std::vector<uint16_t> seen;
+        for (uint16_t i = 0; i < n; ++i) {
+            size_t pos = offset + 2 + static_cast<size_t>(i) * 12;
+            IfdEntry e;
+            e.tag = u16(pos);
+            e.type = u16(pos + 2);
+            e.count = u32(pos + 4);
+            if (std::find(seen.begin(), seen.end(), e.tag) != seen.end()) continue;
+            seen.push_back(e.tag);
+
+            size_t sz = typeSize(e.type);
+            if (sz == 0) continue;   // unbekannter Typ, betrifft uns nur, wenn wir das Tag brauchen
+            uint64_t total = static_cast<uint64_t>(sz) * e.count;
+            if (total <= 4) {
+                e.data = d_.subspan(pos + 8, static_cast<size_t>(total));
+            } else {
+                uint32_t valueOff = u32(pos + 8);
+                if (total > d_.size() || !inRange(valueOff, static_cast<size_t>(total))) return false;
+                e.data = d_.subspan(valueOff, static_cast<size_t>(total));
+            }
+            if (!onEntry(e)) return false;
+        }
+        return true;
+    }
+
+    bool pointer(const IfdEntry& e, uint32_t& target) {
+        if ((e.type != T_LONG && e.type != T_IFD) || e.count < 1) return false;
+        target = static_cast<uint32_t>(number(e, 0));
+        return true;
+    }
+
+    int64_t number(const IfdEntry& e, size_t i) const {
+        size_t off = static_cast<size_t>(e.data.data() - d_.data());
+        switch (e.type) {
+            case T_BYTE: case T_UNDEFINED: return e.data[i];
+            case T_SBYTE: return static_cast<int8_t>(e.data[i]);
+            case T_SHORT: return u16(off + i * 2);
+            case T_SSHORT: return static_cast<int16_t>(u16(off + i * 2));
+            case T_LONG: case T_IFD: return u32(off + i * 4);
+            case T_SLONG: return static_cast<int32_t>(u32(off + i * 4));
+            default: return 0;
+        }
+    }
+
+    // Exiv2 toRational(): auch URational wird nach int32 gecastet
+    std::pair<int32_t, int32_t> rational(const IfdEntry& e, size_t i) const {
+        size_t off = static_cast<size_t>(e.data.data() - d_.data()) + i * 8;
+        return {static_cast<int32_t>(u32(off)), static_cast<int32_t>(u32(off + 4))};
+    }
+
+    // Wert so formatieren wie Exiv2 Exifdatum::toString()
+    bool text(const IfdEntry& e, std::string_view& target) {
+        if (e.type == T_ASCII) {
+            std::string_view s = asText(e.data);
+            target = s.substr(0, s.find('\0'));   // nur bis zum ersten '\0'
+            return true;
+        }
+        std::string s;
+        for (uint32_t i = 0; i < e.count; ++i) {
+            if (i) s += ' ';
+            if (e.type == T_RATIONAL) {
+                size_t off = static_cast<size_t>(e.data.data() - d_.data()) + i * 8;
+                s += std::to_string(u32(off)) + "/" + std::to_string(u32(off + 4));
+            } else if (e.type == T_SRATIONAL) {
+                auto [num, den] = rational(e, i);
+                s += std::to_string(num) + "/" + std::to_string(den);
+            } else if (e.type == T_UNDEFINED) {
+                return false;   // Exiv2 formatiert Undefined je nach Tag unterschiedlich
+            } else {
+                s += std::to_string(number(e, i));
+            }
+        }
+        target = out_.storage.emplace_back(std::move(s));
+        return true;
+    }
+
+    // Gleiche Rechnung wie getGpsCoordinate() im Exiv2-Pfad
+    bool coordinate(const IfdEntry& e, const IfdEntry& ref, double& target) {
+        if (!e.tag) return true;
+        if (e.type != T_RATIONAL && e.type != T_SRATIONAL) return false;
+        if (e.count < 3) return true;
+
+        auto [dn, dd] = rational(e, 0);
+        auto [mn, md] = rational(e, 1);
+        auto [sn, sd] = rational(e, 2);
+        double degrees = dn / (double)dd;
+        double minutes = mn / (double)md;
+        double seconds = sn / (double)sd;
+        double decimal = degrees + (minutes / 60.0) + (seconds / 3600.0);
+
+        if (ref.tag) {
+            std::string_view r;
+            if (!text(ref, r)) return false;
+            if (r == "S" || r == "W") decimal *= -1.0;
+        }
+        target = decimal;
+        return true;
+    }
+
+    bool altitude(const IfdEntry& e, const IfdEntry& ref, double& target) {
+        if (!e.tag) return true;
+        if (e.type != T_RATIONAL && e.type != T_SRATIONAL) return false;
+        if (e.count < 1) return true;
+
+        auto [num, den] = rational(e, 0);
+        double alt = num / (double)den;
+        if (ref.tag) {
+            if (ref.type == T_RATIONAL || ref.type == T_SRATIONAL || ref.type == T_ASCII || ref.count < 1) return false;
+            if (number(ref, 0) == 1) alt *= -1.0;
+        }
+        target = alt;
+        return true;
+    }
+
+    Bytes d_;
+    FastMetadata& out_;
+    bool le_ = true;
+};
+
+// ------------------------------------------------------------------------
+// IPTC (Photoshop IRB 0x0404 in APP13)
+// ------------------------------------------------------------------------
+
+bool isIrbSignature(const unsigned char* p) {
+    return std::memcmp(p, "8BIM", 4) == 0 || std::memcmp(p, "AgHg", 4) == 0 ||
+           std::memcmp(p, "DCSR", 4) == 0 || std::memcmp(p, "PHUT", 4) == 0;
+}
+
+// Alle IPTC-Blöcke (Resource 0x0404) aus den Photoshop-Daten sammeln
+void collectIptcBlocks(Bytes ps, std::vector<Bytes>& blocks) {
+    size_t pos = 0;
+    while (ps.size() >= 12 && pos <= ps.size() - 12) {
+        if (!isIrbSignature(ps.data() + pos)) return;
+        uint16_t type = be16(ps.data() + pos + 4);
+        size_t nameSize = ps[pos + 6] + 1u;
+        nameSize += nameSize & 1;   // Pascal-String auf gerade Länge aufgefüllt
+        size_t p = pos + 6 + nameSize;
+        if (p + 4 > ps.size()) return;
+        uint32_t size = be32(ps.data() + p);
+        p += 4;
+        if (size > ps.size() - p) return;
+        if (type == 0x0404 && size) blocks.push_back(ps.subspan(p, size));
+        pos = p + size + (size & 1);
+    }
+}
+
+struct IptcDataset {
+    uint8_t record;
+    uint8_t dataset;
+    std::string_view value;
+};
+
+// Wie Exiv2 IptcParser::decode(); false -> Exiv2 verwirft alle IPTC-Daten
+bool decodeIptc(Bytes blob, std::vector<IptcDataset>& out) {
+    const unsigned char* p = blob.data();
+    const unsigned char* end = p + blob.size();
+    while (p + 3 < end) {
+        while (*p != 0x1C && p + 3 < end) ++p;
+        if (p + 3 >= end) break;
+        ++p;
+        uint8_t record = *p++;
+        uint8_t dataset = *p++;
+        if (end - p < 2) return false;
+        size_t size = 0;
+        if ((*p & 0x80) == 0) {
+            size = be16(p);
+            p += 2;
+        } else {
+            size_t sizeOfSize = be16(p) & 0x7FFF;
+            if (sizeOfSize > 4) return false;
+            p += 2;
+            if (sizeOfSize > static_cast<size_t>(end - p)) return false;
+            for (; sizeOfSize > 0; --sizeOfSize) size |= static_cast<size_t>(*p++) << (8 * (sizeOfSize - 1));
+        }
+        if (size > static_cast<size_t>(end - p)) return false;
+        out.push_back({record, dataset, asText(Bytes(p, size))});
+        p += size;
+    }
+    return true;
+}
+
+void applyIptc(const std::vector<IptcDataset>& sets, FastMetadata& out) {
+    out.hasIptc = !sets.empty();
+
+    auto first = [&](uint8_t dataset) -> std::string_view {
+        for (const auto& s : sets) {
+            if (s.record == 2 && s.dataset == dataset) return s.value;
+        }
+        return {};
+    };
+    out.title       = first(5);
+    out.caption     = first(120);
+    out.city        = first(90);
+    out.province    = first(95);
+    out.country     = first(101);
+    out.countryCode = first(100);
+    out.copyright   = first(116);
+
+    // Wie der Exiv2-Pfad: ab dem ersten Keyword alle direkt folgenden
+    auto it = std::find_if(sets.begin(), sets.end(), [](const IptcDataset& s) {
+        return s.record == 2 && s.dataset == 25;
+    });
+    for (; it != sets.end() && it->record == 2 && it->dataset == 25; ++it) {
+        out.keywords.push_back(it->value);
+    }
+}
+
+// ------------------------------------------------------------------------
+// XMP (nur die wenigen Properties, die PhotoData braucht)
+// ------------------------------------------------------------------------
+
+constexpr std::string_view NS_DC = "http://purl.org/dc/elements/1.1/";
+constexpr std::string_view NS_PHOTOSHOP = "http://ns.adobe.com/photoshop/1.0/";
+constexpr std::string_view NS_IPTC_CORE = "http://iptc.org/std/Iptc4xmpCore/1.0/xmlns/";
+
+class XmpScanner {
+public:
+    XmpScanner(std::string_view xml, FastMetadata& out) : xml_(xml), out_(out) {}
+
+    bool read() {
+        // Wir suchen nach den üblichen Präfixen -> abweichende Deklarationen nicht unterstützt
+        if (!checkPrefix(NS_DC, "dc") || !checkPrefix(NS_PHOTOSHOP, "photoshop") ||
+            !checkPrefix(NS_IPTC_CORE, "Iptc4xmpCore")) {
+            return false;
+        }
+
+        std::optional<std::string_view> v;
+        if (!bag("dc:subject", v)) return false;
+        if (v) {
+            out_.hasXmpSubject = true;
+            out_.xmpSubject = *v;
+        }
+
+        return simple("photoshop:City", out_.xmpCity) &&
+               simple("photoshop:State", out_.xmpState) &&
+               simple("photoshop:Country", out_.xmpCountry) &&
+               simple("Iptc4xmpCore:CountryCode", out_.xmpCountryCode) &&
+               langAlt("dc:title", out_.xmpTitle) &&
+               langAlt("dc:description", out_.xmpDescription) &&
+               langAlt("dc:rights", out_.xmpRights);
+    }
+
+private:
+    bool checkPrefix(std::string_view uri, std::string_view expected) {
+        size_t pos = 0;
+        while ((pos = xml_.find("xmlns:", pos)) != std::string_view::npos) {
+            pos += 6;
+            size_t eq = xml_.find('=', pos);
+            if (eq == std::string_view::npos || eq + 1 >= xml_.size()) return false;
+            std::string_view prefix = trim(xml_.substr(pos, eq - pos));
+            char quote = xml_[eq + 1];
+            if (quote != '"' && quote != '\'') return false;
+            size_t close = xml_.find(quote, eq + 2);
+            if (close == std::string_view::npos) return false;
+            std::string_view value = xml_.substr(eq + 2, close - eq - 2);
+            if (value == uri && prefix != expected) return false;
+            if (prefix == expected && value != uri) return false;
+            pos = close;
+        }
+        return true;
+    }
+
+    static std::string_view trim(std::string_view s) {
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+        return s;
+    }
+
+    // Start-Tag "<qname" finden; liefert Position nach dem Namen
+    size_t findStartTag(std::string_view qname, size_t from = 0) const {
+        size_t pos = from;
+        while ((pos = xml_.find(qname, pos)) != std::string_view::npos) {
+            size_t after = pos + qname.size();
+            if (pos > 0 && xml_[pos - 1] == '<' && after < xml_.size() &&
+                (xml_[after] == '>' || xml_[after] == '/' || std::isspace(static_cast<unsigned char>(xml_[after])))) {
+                return after;
+            }
+            pos = after;
+        }
+        return std::string_view::npos;
+    }
+
+    // Attribut-Form: <rdf:Description photoshop:City="...">
+    size_t findAttribute(std::string_view qname) const {
+        size_t pos = 0;
+        while ((pos = xml_.find(qname, pos)) != std::string_view::npos) {
+            size_t after = pos + qname.size();
+            if (pos > 0 && std::isspace(static_cast<unsigned char>(xml_[pos - 1]))) {
+                size_t eq = after;
+                while (eq < xml_.size() && std::isspace(static_cast<unsigned char>(xml_[eq]))) ++eq;
+                size_t lt = xml_.rfind('<', pos), gt = xml_.rfind('>', pos);
+                bool insideTag = lt != std::string_view::npos && (gt == std::string_view::npos || gt < lt);
+                if (eq < xml_.size() && xml_[eq] == '=' && insideTag) return eq + 1;
+            }
+            pos = after;
+        }
+        return std::string_view::npos;
+    }
+
+    // Element-Inhalt von <qname ...>INHALT</qname>. attrs = Attributtext des Start-Tags
+    bool element(std::string_view qname, size_t afterName, std::string_view& attrs,
+                 std::optional<std::string_view>& content) const {
+        size_t gt = xml_.find('>', afterName);
+        if (gt == std::string_view::npos) return false;
+        bool selfClosing = xml_[gt - 1] == '/';
+        attrs = trim(xml_.substr(afterName, gt - afterName - (selfClosing ? 1 : 0)));
+        if (selfClosing) {
+            content = std::string_view{};
+            return true;
+        }
+        std::string closeTag = "</" + std::string(qname) + ">";
+        size_t end = xml_.find(closeTag, gt + 1);
+        if (end == std::string_view::npos) return false;
+        content = xml_.substr(gt + 1, end - gt - 1);
+        return true;
+    }
+
+    // XML-Entities auflösen; ohne '&' bleibt es eine View ins Paket
+    bool decodeText(std::string_view raw, std::string_view& out) {
+        if (raw.find('\r') != std::string_view::npos) return false;   // Zeilenende-Normalisierung des XML-Parsers
+        if (raw.find('&') == std::string_view::npos) {
+            out = raw;
+            return true;
+        }
+        std::string s;
+        s.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] != '&') {
+                s += raw[i];
+                continue;
+            }
+            size_t semi = raw.find(';', i);
+            if (semi == std::string_view::npos) return false;
+            std::string_view ent = raw.substr(i + 1, semi - i - 1);
+            if (ent == "amp") s += '&';
+            else if (ent == "lt") s += '<';
+            else if (ent == "gt") s += '>';
+            else if (ent == "quot") s += '"';
+            else if (ent == "apos") s += '\'';
+            else if (ent.size() > 1 && ent[0] == '#') {
+                unsigned long cp = 0;
+                try {
+                    cp = (ent[1] == 'x' || ent[1] == 'X')
+                        ? std::stoul(std::string(ent.substr(2)), nullptr, 16)
+                        : std::stoul(std::string(ent.substr(1)), nullptr, 10);
+                } catch (...) {
+                    return false;
+                }
+                appendUtf8(s, cp);
+            } else {
+                return false;
+            }
+            i = semi;
+        }
+        out = out_.storage.emplace_back(std::move(s));
+        return true;
+    }
+
+    static void appendUtf8(std::string& s, unsigned long cp) {
+        if (cp < 0x80) {
+            s += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            s += static_cast<char>(0xC0 | (cp >> 6));
+            s += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            s += static_cast<char>(0xE0 | (cp >> 12));
+            s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            s += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            s += static_cast<char>(0xF0 | (cp >> 18));
+            s += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            s += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // Einfache Text-Property (Element- oder Attribut-Form)
+    bool simple(std::string_view qname, std::string_view& target) {
+        size_t attr = findAttribute(qname);
+        size_t elem = findStartTag(qname);
+        if (attr != std::string_view::npos && elem != std::string_view::npos) return false;
+
+        if (attr != std::string_view::npos) {
+            if (attr >= xml_.size()) return false;
+            char quote = xml_[attr];
+            if (quote != '"' && quote != '\'') return false;
+            size_t close = xml_.find(quote, attr + 1);
+            if (close == std::string_view::npos) return false;
+            std::string_view raw = xml_.substr(attr + 1, close - attr - 1);
+            // Attributwert-Normalisierung (Tab/Newline -> Leerzeichen) nicht nachgebaut
+            if (raw.find_first_of("\t\n") != std::string_view::npos) return false;
+            return decodeText(raw, target);
+        }
+        if (elem != std::string_view::npos) {
+            std::string_view attrs;
+            std::optional<std::string_view> content;
+            if (!element(qname, elem, attrs, content)) return false;
+            if (!attrs.empty() || content->find('<') != std::string_view::npos) return false;
+            return decodeText(*content, target);
+        }
+        return true;
+    }
+
+    // rdf:li-Einträge eines Containers (rdf:Bag / rdf:Seq / rdf:Alt)
+    bool items(std::string_view content, std::string_view container,
+               std::vector<std::pair<std::string_view, std::string_view>>& out) {
+        size_t start = content.find("<" + std::string(container));
+        if (start == std::string_view::npos) return false;
+        size_t pos = start;
+        while ((pos = content.find("<rdf:li", pos)) != std::string_view::npos) {
+            size_t gt = content.find('>', pos);
+            if (gt == std::string_view::npos) return false;
+            bool selfClosing = content[gt - 1] == '/';
+            std::string_view attrs = trim(content.substr(pos + 7, gt - pos - 7 - (selfClosing ? 1 : 0)));
+            if (selfClosing) {
+                out.emplace_back(attrs, std::string_view{});
+                pos = gt + 1;
+                continue;
+            }
+            size_t end = content.find("</rdf:li>", gt + 1);
+            if (end == std::string_view::npos) return false;
+            std::string_view raw = content.substr(gt + 1, end - gt - 1);
+            if (raw.find('<') != std::string_view::npos) return false;   // Struktur statt Text
+            std::string_view text;
+            if (!decodeText(raw, text)) return false;
+            out.emplace_back(attrs, text);
+            pos = end + 9;
+        }
+        return true;
+    }
+
+    // Bag -> Exiv2 XmpArrayValue::toString(): "a, b, c"
+    bool bag(std::string_view qname, std::optional<std::string_view>& target) {
+        if (findAttribute(qname) != std::string_view::npos) return false;
+        size_t elem = findStartTag(qname);
+        if (elem == std::string_view::npos) return true;
+
+        std::string_view attrs;
+        std::optional<std::string_view> content;
+        if (!element(qname, elem, attrs, content) || !attrs.empty()) return false;
+
+        std::vector<std::pair<std::string_view, std::string_view>> li;
+        if (!items(*content, "rdf:Bag", li)) return false;
+
+        std::string joined;
+        for (size_t i = 0; i < li.size(); ++i) {
+            if (!li[i].first.empty()) return false;
+            if (i) joined += ", ";
+            joined += li[i].second;
+        }
+        target = out_.storage.emplace_back(std::move(joined));
+        return true;
+    }
+
+    // LangAlt mit genau einem Eintrag -> Exiv2: lang="x-default" Text
+    bool langAlt(std::string_view qname, std::string_view& target) {
+        if (findAttribute(qname) != std::string_view::npos) return false;
+        size_t elem = findStartTag(qname);
+        if (elem == std::string_view::npos) return true;
+
+        std::string_view attrs;
+        std::optional<std::string_view> content;
+        if (!element(qname, elem, attrs, content) || !attrs.empty()) return false;
+
+        std::vector<std::pair<std::string_view, std::string_view>> li;
+        if (!items(*content, "rdf:Alt", li) || li.size() != 1) return false;
+
+        std::string_view a = li[0].first;
+        constexpr std::string_view LANG = "xml:lang=";
+        if (!a.starts_with(LANG) || a.size() < LANG.size() + 2) return false;
+        char quote = a[LANG.size()];
+        if ((quote != '"' && quote != '\'') || a.back() != quote) return false;
+        std::string_view lang = a.substr(LANG.size() + 1, a.size() - LANG.size() - 2);
+        if (lang.find(quote) != std::string_view::npos) return false;
+
+        target = out_.storage.emplace_back("lang=\"" + std::string(lang) + "\" " + std::string(li[0].second));
+        return true;
+    }
+
+    std::string_view xml_;
+    FastMetadata& out_;
+};
+
+bool isSof(uint8_t marker) {
+    return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+}
+
+} // namespace
+
+FastMetadataReader::Status FastMetadataReader::parse(std::span<const unsigned char> data, FastMetadata& out) {
+    constexpr std::string_view EXIF_ID = std::string_view("Exif\0\0", 6);
+    constexpr std::string_view XMP_ID = std::string_view("http://ns.adobe.com/xap/1.0/\0", 29);
+    constexpr std::string_view PS_ID = std::string_view("Photoshop 3.0\0", 14);
+
+    // Nur JPEG; alles andere (HEIC, TIFF, RAW, PNG ...) macht Exiv2
+    if (data.size() < 4 || data[0] != 0xFF || data[1] != 0xD8 || data[2] != 0xFF) return Status::Unsupported;
+
+    bool exifSeen = false, xmpSeen = false;
+    std::string psBlob;
+    size_t pos = 2;
+
+    while (true) {
+        // Header-Fenster zu Ende, bevor SOS erreicht wurde
+        if (pos >= data.size() || data[pos] != 0xFF) return Status::Unsupported;
+        while (pos < data.size() && data[pos] == 0xFF) ++pos;
+        if (pos >= data.size()) return Status::Unsupported;
+        uint8_t marker = data[pos++];
+
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue;
+        if (marker == 0xDA || marker == 0xD9) break;
+
+        if (pos + 2 > data.size()) return Status::Unsupported;
+        size_t len = be16(data.data() + pos);
+        if (len < 2 || pos + len > data.size()) return Status::Unsupported;
+        Bytes seg = data.subspan(pos + 2, len - 2);
+
+        if (isSof(marker) && out.height == 0 && seg.size() >= 5) {
+            out.height = be16(seg.data() + 1);
+            out.width = be16(seg.data() + 3);
+        } else if (marker == 0xE1 && !exifSeen && startsWith(seg, EXIF_ID)) {
+            exifSeen = true;
+            out.hasExif = true;
+            TiffReader tiff(seg.subspan(EXIF_ID.size()), out);
+            if (!tiff.read()) return Status::Unsupported;
+        } else if (marker == 0xE1 && !xmpSeen && startsWith(seg, XMP_ID)) {
+            xmpSeen = true;
+            out.hasXmp = true;
+            XmpScanner xmp(asText(seg.subspan(XMP_ID.size())), out);
+            if (!xmp.read()) return Status::Unsupported;
+        } else if (marker == 0xED && startsWith(seg, PS_ID)) {
+            psBlob.append(asText(seg.subspan(PS_ID.size())));
+        }
+        pos += len;
+    }
+
+    if (!psBlob.empty()) {
+        // IPTC-Views müssen den Puffer überleben -> Photoshop-Daten in storage
+        const std::string& ps = out.storage.emplace_back(std::move(psBlob));
+        std::vector<Bytes> blocks;
+        collectIptcBlocks(Bytes(reinterpret_cast<const unsigned char*>(ps.data()), ps.size()), blocks);
+
+        Bytes iptc;
+        if (blocks.size() == 1) {
+            iptc = blocks.front();
+        } else if (blocks.size() > 1) {
+            std::string joined;
+            for (auto b : blocks) joined.append(asText(b));
+            const std::string& j = out.storage.emplace_back(std::move(joined));
+            iptc = Bytes(reinterpret_cast<const unsigned char*>(j.data()), j.size());
+        }
+
+        std::vector<IptcDataset> sets;
+        if (!iptc.empty() && decodeIptc(iptc, sets)) applyIptc(sets, out);
+    }
+    return Status::Ok;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Ergebnis des Fast-Path Parsers. Die string_views zeigen direkt in den
+// gemappten Datei-Header (bzw. in 'storage' für dekodierte Werte) und sind
+// nur gültig, solange der Puffer existiert.
+// Die Werte sind so formatiert, wie Exiv2 sie mit toString() liefert.
+struct FastMetadata {
+    int width = 0;
+    int height = 0;
+
+    bool hasExif = false;
+    std::string_view make, model, iso, aperture, exposure, dateTimeOriginal;
+    double gpsLat = 0.0;
+    double gpsLon = 0.0;
+    double gpsAlt = 0.0;
+
+    bool hasIptc = false;
+    std::string_view title, caption, city, province, country, countryCode, copyright;
+    std::vector<std::string_view> keywords;
+
+    bool hasXmp = false;
+    bool hasXmpSubject = false;
+    std::string_view xmpSubject, xmpCity, xmpState, xmpCountry, xmpCountryCode;
+    std::string_view xmpTitle, xmpDescription, xmpRights;
+
+    std::deque<std::string> storage;
+};
+
+// Read-only mmap der ersten Bytes einer Datei (dort liegen bei JPEG alle Metadaten)
+class MappedHeader {
+public:
+    static constexpr size_t DEFAULT_WINDOW = 512 * 1024;
+
+    explicit MappedHeader(const std::filesystem::path& p, size_t window = DEFAULT_WINDOW);
+    ~MappedHeader();
+    MappedHeader(const MappedHeader&) = delete;
+    MappedHeader& operator=(const MappedHeader&) = delete;
+
+    bool isValid() const { return data_ != nullptr; }
+    std::span<const unsigned char> bytes() const { return {data_, size_}; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Spezialisierter Parser für JPEG APP1 (Exif/TIFF + XMP) und APP13 (IPTC).
+// Liest nur die Tags, die PhotoData braucht. Alles, was er nicht sicher
+// genauso wie Exiv2 interpretieren kann, meldet er als Unsupported ->
+// der Aufrufer fällt auf Exiv2 zurück.
+class FastMetadataReader {
+public:
+    enum class Status { Ok, Unsupported };
+
+    static Status parse(std::span<const unsigned char> data, FastMetadata& out);
+};
@@ -0,0 +1,67 @@
+#include "FileHelpers.h"
+#include <algorithm>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+// Helper: String bereinigen
+std::string sanitize(const std::string& input) {
+    if (input.empty()) return "Unknown";
+    std::string out = input;
+    std::replace(out.begin(), out.end(), ' ', '_');
+    return out;
+}
+
+// Helper: C++ Filesystem Time -> QDateTime
+QDateTime getFileLastModified(const fs::path& p) {
+    try {
+        auto ftime = fs::last_write_time(p);
+        auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now()
+        );
+        std::time_t tt = std::chrono::system_clock::to_time_t(sctp);
+        return QDateTime::fromSecsSinceEpoch(tt);
+    } catch (...) {
+        return QDateTime::currentDateTime(); 
+    }
+}
+
+// Beispiele, zur Compile-Zeit geprüft
+static_assert(matchFilenameDate("IMG_20230101_120000.jpg")->pattern == "android");
+static_assert(matchFilenameDate("PXL_20230101_120000123.jpg")->pattern == "pixel");
+static_assert(matchFilenameDate("WhatsApp Image 2023-01-01 at 12.00.00.jpeg")->minute == 0);
+static_assert(matchFilenameDate("alice___2023-02-28_235959.jpg")->day == 28);
+static_assert(matchFilenameDate("DSC_1672574400.JPG")->epochSeconds == 1672574400);
+static_assert(matchFilenameDate("FB_IMG_1672574400123.jpg")->epochSeconds == 1672574400);
+static_assert(!matchFilenameDate("DSC_0042.JPG"));
+static_assert(!matchFilenameDate("2023-02-29_120000.jpg"));   // kein Schaltjahr
+static_assert(!matchFilenameDate("120230101_120000.jpg"));    // mitten in einer Zahl
+
+QDateTime toDateTime(const FilenameDate& d) {
+    if (d.epochSeconds >= 0) return QDateTime::fromSecsSinceEpoch(d.epochSeconds);
+    return QDateTime(QDate(d.year, d.month, d.day), QTime(d.hour, d.minute, d.second));
+}
+
+// Helper: Datum aus Dateinamen extrahieren (Muster siehe FilenameDate.h)
+QDateTime extractDateFromFilename(std::string_view filename) {
+    auto match = matchFilenameDate(filename);
+    return match ? toDateTime(*match) : QDateTime();
+}
+
+// Helper: Filename Parsing
+FileInfo parseFilename(const std::string& rawName) {
+    FileInfo info;
+    info.cleanName = rawName; 
+    
+    size_t firstSep = rawName.find("___");
+    if (firstSep != std::string::npos) {
+        info.user = rawName.substr(0, firstSep);
+        size_t secondSep = rawName.find("___", firstSep + 3);
+        if (secondSep != std::string::npos) {
+            info.cleanName = rawName.substr(secondSep + 3);
+        } else {
+            info.cleanName = rawName.substr(firstSep + 3);
+        }
+    }
+    return info;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <QDateTime>
+#include "FilenameDate.h"
+
+// Helper: Filename Parsing ("user___...___name.jpg")
+struct FileInfo {
+    std::string user = "system";
+    std::string cleanName;
+};
+
+std::string sanitize(const std::string& input);
+QDateTime getFileLastModified(const std::filesystem::path& p);
+QDateTime toDateTime(const FilenameDate& d);
+QDateTime extractDateFromFilename(std::string_view filename);
+FileInfo parseFilename(const std::string& rawName);
@@ -0,0 +1,401 @@
+#include "FileMover.h"
+#include "IoUring.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <optional>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct MoverMetrics {
+    MetricCounter& bytes;
+    MetricCounter& byRename;
+    MetricCounter& byReflink;
+    MetricCounter& byCopyFileRange;
+    MetricCounter& bySendfile;
+    MetricHistogram& commitSeconds;
+};
+
+static MoverMetrics& metrics() {
+    static MoverMetrics m = [] {
+        auto& r = MetricsRegistry::instance();
+        const char* methodHelp = "Files moved into the photo library, by method";
+        MoverMetrics mm{
+            r.counter("worker_moved_bytes_total", "Bytes moved into the photo library (rate() = bytes/s)"),
+            r.counter("worker_moves_total", methodHelp, R"(method="rename")"),
+            r.counter("worker_moves_total", methodHelp, R"(method="reflink")"),
+            r.counter("worker_moves_total", methodHelp, R"(method="copy_file_range")"),
+            r.counter("worker_moves_total", methodHelp, R"(method="sendfile")"),
+            r.histogram("worker_move_commit_seconds", "Batched directory fsync and source cleanup after moves"),
+        };
+        r.gauge("worker_directory_cache_entries", "Target directories known to exist", "",
+                [] { return (double)DirectoryCache::instance().size(); });
+        return mm;
+    }();
+    return m;
+}
+
+static void countMove(MoveMethod method, uint64_t bytes) {
+    MoverMetrics& m = metrics();
+    m.bytes.inc(bytes);
+    switch (method) {
+        case MoveMethod::Rename:        m.byRename.inc(); break;
+        case MoveMethod::Reflink:       m.byReflink.inc(); break;
+        case MoveMethod::CopyFileRange: m.byCopyFileRange.inc(); break;
+        case MoveMethod::Sendfile:      m.bySendfile.inc(); break;
+    }
+}
+
+const char* moveMethodName(MoveMethod m) {
+    switch (m) {
+        case MoveMethod::Rename:        return "rename";
+        case MoveMethod::Reflink:       return "reflink";
+        case MoveMethod::CopyFileRange: return "copy_file_range";
+        case MoveMethod::Sendfile:      return "sendfile";
+    }
+    return "?";
+}
+
+MoveOptions MoveOptions::fromEnvironment() {
+    MoveOptions o;
+    o.fsync = qEnvironmentVariable("WORKER_MOVE_FSYNC", "on") != "off";
+    o.verify = qEnvironmentVariable("WORKER_MOVE_VERIFY", "on") != "off";
+    return o;
+}
+
+// Schließt den Deskriptor beim Verlassen des Scopes
+namespace {
+struct Fd {
+    int fd = -1;
+    explicit Fd(int f) : fd(f) {}
+    ~Fd() { if (fd >= 0) ::close(fd); }
+    Fd(const Fd&) = delete;
+    Fd& operator=(const Fd&) = delete;
+};
+} // namespace
+
+[[noreturn]] static void fail(const char* what, const fs::path& a, const fs::path& b, int err) {
+    throw fs::filesystem_error(what, a, b, std::error_code(err, std::generic_category()));
+}
+
+static bool syncDirectory(const fs::path& dir) {
+    Fd fd(::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.fd < 0 || ::fsync(fd.fd) != 0) {
+        qWarning() << "fsync of directory failed:" << QString::fromStdString(dir.string()) << ":" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+DirectoryCache& DirectoryCache::instance() {
+    static DirectoryCache cache;
+    return cache;
+}
+
+bool DirectoryCache::contains(const fs::path& dir) const {
+    std::shared_lock lock(mutex_);
+    return dirs_.contains(dir.string());
+}
+
+void DirectoryCache::add(const fs::path& dir) {
+    std::unique_lock lock(mutex_);
+    if (dirs_.size() >= 100000) dirs_.clear();   // Obergrenze, danach einfach neu lernen
+    dirs_.insert(dir.string());
+}
+
+void DirectoryCache::forget(const fs::path& dir) {
+    std::unique_lock lock(mutex_);
+    dirs_.erase(dir.string());
+}
+
+size_t DirectoryCache::size() const {
+    std::shared_lock lock(mutex_);
+    return dirs_.size();
+}
+
+FileMover::FileMover(MoveOptions opts) : opts_(opts) {}
+
+FileMover::~FileMover() {
+    commit();
+}
+
+MoveMethod FileMover::move(const fs::path& src, const fs::path& dest, const ContentHash& expected) {
+    struct stat st{};
+    if (::stat(src.c_str(), &st) != 0) fail("stat", src, dest, errno);
+
+    MoveMethod method = MoveMethod::Rename;
+    if (::rename(src.c_str(), dest.c_str()) == 0) {
+        if (opts_.fsync) {
+            destDirs_.insert(dest.parent_path());
+            srcDirs_.insert(src.parent_path());
+        }
+    } else if (errno == EXDEV) {
+        method = copy(src, dest, expected);
+    } else {
+        fail("rename", src, dest, errno);
+    }
+
+    countMove(method, static_cast<uint64_t>(st.st_size));
+    return method;
+}
+
+// Fehlende Zielordner in einem Rutsch anlegen (mkdirat), Ergebnis merkt sich der Cache
+void FileMover::ensureDirectories(std::span<MoveRequest> batch) {
+    DirectoryCache& cache = DirectoryCache::instance();
+    std::vector<fs::path> missing;
+    for (const auto& req : batch) {
+        fs::path dir = req.dest.parent_path();
+        if (!cache.contains(dir) && std::find(missing.begin(), missing.end(), dir) == missing.end()) {
+            missing.push_back(std::move(dir));
+        }
+    }
+    if (missing.empty()) return;
+    TraceSpan span("mkdir", "move");
+    span.setCount(static_cast<int>(missing.size()));
+
+    std::vector<int> res(missing.size(), -ENOENT);
+    if (IoUring* ring = IoUring::forThread()) {
+        for (size_t i = 0; i < missing.size(); ++i) ring->mkdirat(missing[i].c_str(), 0777, &res[i]);
+        // Ring ausgefallen: nicht ausgeführte Einträge (-ECANCELED) legt die Schleife unten synchron an
+        (void)ring->submit();
+    }
+
+    for (size_t i = 0; i < missing.size(); ++i) {
+        const fs::path& dir = missing[i];
+        std::error_code ec;
+        // Ohne Ring oder wenn Elternordner fehlen: synchron und rekursiv
+        if (res[i] != 0 && res[i] != -EEXIST) fs::create_directories(dir, ec);
+        if (ec) {
+            for (auto& req : batch) {
+                if (req.dest.parent_path() == dir) req.error = "create directory " + dir.string() + ": " + ec.message();
+            }
+            continue;
+        }
+        cache.add(dir);
+        // Neuer Ordner ist selbst ein Eintrag im Elternordner
+        if (opts_.fsync && res[i] != -EEXIST) destDirs_.insert(dir.parent_path());
+    }
+}
+
+void FileMover::moveBatch(std::span<MoveRequest> batch) {
+    for (auto& req : batch) {
+        req.ok = false;
+        req.error.clear();
+    }
+    ensureDirectories(batch);
+    IoUring* ring = IoUring::forThread();
+
+    // 1. Quellen prüfen (Typ + Größe) - ein statx pro Datei, als Batch
+    std::vector<struct statx> stx(batch.size());
+    std::vector<int> res(batch.size(), 0);
+    std::optional<TraceSpan> span(std::in_place, "statx", "move");
+    span->setCount(static_cast<int>(batch.size()));
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!batch[i].error.empty()) continue;
+        const char* src = batch[i].src.c_str();
+        if (ring) ring->statx(src, 0, STATX_TYPE | STATX_SIZE, &stx[i], &res[i]);
+        else res[i] = ::statx(AT_FDCWD, src, 0, STATX_TYPE | STATX_SIZE, &stx[i]) == 0 ? 0 : -errno;
+    }
+    if (ring && !ring->submit()) {
+        // Ring ausgefallen: was der Kernel nicht ausgeführt hat, synchron nachholen
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!batch[i].error.empty() || res[i] != -ECANCELED) continue;
+            res[i] = ::statx(AT_FDCWD, batch[i].src.c_str(), 0, STATX_TYPE | STATX_SIZE, &stx[i]) == 0 ? 0 : -errno;
+        }
+        ring = nullptr;
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!batch[i].error.empty()) continue;
+        if (res[i] < 0) batch[i].error = std::string("statx: ") + std::strerror(-res[i]);
+        else if (!S_ISREG(stx[i].stx_mode)) batch[i].error = "not a regular file";
+        else batch[i].size = stx[i].stx_size;
+    }
+
+    // 2. rename (ersetzt ein vorhandenes Ziel atomar)
+    span.emplace("rename", "move");
+    span->setCount(static_cast<int>(batch.size()));
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!batch[i].error.empty()) continue;
+        const char* src = batch[i].src.c_str();
+        const char* dest = batch[i].dest.c_str();
+        if (ring) ring->renameat(src, dest, &res[i]);
+        else res[i] = ::rename(src, dest) == 0 ? 0 : -errno;
+    }
+    if (ring && !ring->submit()) {
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!batch[i].error.empty() || res[i] != -ECANCELED) continue;
+            res[i] = ::rename(batch[i].src.c_str(), batch[i].dest.c_str()) == 0 ? 0 : -errno;
+        }
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].error.empty()) finishRename(batch[i], res[i]);
+    }
+}
+
+void FileMover::finishRename(MoveRequest& req, int rc) {
+    // Zielordner extern gelöscht, obwohl im Cache -> neu anlegen, einmal wiederholen
+    if (rc == -ENOENT && !fs::exists(req.dest.parent_path())) {
+        DirectoryCache::instance().forget(req.dest.parent_path());
+        std::error_code ec;
+        fs::create_directories(req.dest.parent_path(), ec);
+        if (!ec) {
+            DirectoryCache::instance().add(req.dest.parent_path());
+            rc = ::rename(req.src.c_str(), req.dest.c_str()) == 0 ? 0 : -errno;
+        }
+    }
+
+    if (rc == 0) {
+        req.method = MoveMethod::Rename;
+        if (opts_.fsync) {
+            destDirs_.insert(req.dest.parent_path());
+            srcDirs_.insert(req.src.parent_path());
+        }
+    } else if (rc == -EXDEV) {
+        TraceFileScope traceFile(req.src.filename().string(), {}, static_cast<int64_t>(req.size));
+        TraceSpan span("copy", "move");
+        try {
+            req.method = copy(req.src, req.dest, req.expected);
+        } catch (const std::exception& e) {
+            req.error = e.what();
+            return;
+        }
+    } else {
+        req.error = "rename " + req.src.string() + " -> " + req.dest.string() + ": " + std::strerror(-rc);
+        return;
+    }
+    req.ok = true;
+    countMove(req.method, req.size);
+}
+
+// Kopie über Volumes: erst als ".<name>.part" neben dem Ziel, prüfen, dann umbenennen
+MoveMethod FileMover::copy(const fs::path& src, const fs::path& dest, const ContentHash& expected) {
+    Fd in(::open(src.c_str(), O_RDONLY | O_CLOEXEC));
+    if (in.fd < 0) fail("open", src, dest, errno);
+    struct stat st{};
+    if (::fstat(in.fd, &st) != 0) fail("fstat", src, dest, errno);
+
+    fs::path tmp = dest.parent_path() / ("." + dest.filename().string() + ".part");
+    Fd out(::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777));
+    if (out.fd < 0) fail("open", src, tmp, errno);
+
+    MoveMethod method = MoveMethod::Reflink;
+    int err = 0;
+    const char* step = "copy";
+
+    // 1. Reflink (btrfs, XFS, ...): nur Metadaten, keine Daten
+    if (::ioctl(out.fd, FICLONE, in.fd) != 0) {
+        // 2. copy_file_range: Kopie im Kernel (serverseitig bei NFS 4.2 / SMB)
+        method = MoveMethod::CopyFileRange;
+        off_t done = 0;
+        while (done < st.st_size) {
+            ssize_t n = ::copy_file_range(in.fd, nullptr, out.fd, nullptr, static_cast<size_t>(st.st_size - done), 0);
+            if (n > 0) { done += n; continue; }
+            if (n == 0) { err = EIO; step = "copy_file_range (short)"; break; }
+            if (errno == EINTR) continue;
+            // Ältere Kernel / Dateisysteme ohne Unterstützung -> sendfile
+            if (done == 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+                method = MoveMethod::Sendfile;
+                break;
+            }
+            err = errno;
+            step = "copy_file_range";
+            break;
+        }
+
+        // 3. sendfile: ebenfalls ohne Umweg über den Userspace
+        if (!err && method == MoveMethod::Sendfile) {
+            off_t offset = 0;
+            while (offset < st.st_size) {
+                ssize_t n = ::sendfile(out.fd, in.fd, &offset, static_cast<size_t>(st.st_size - offset));
+                if (n > 0) continue;
+                if (n < 0 && errno == EINTR) continue;
+                err = n == 0 ? EIO : errno;
+                step = "sendfile";
+                break;
+            }
+        }
+    }
+
+    // Änderungsdatum übernehmen (Fallback für das Aufnahmedatum)
+    if (!err) {
+        const struct timespec times[2] = {st.st_atim, st.st_mtim};
+        ::futimens(out.fd, times);
+    }
+    if (!err && opts_.fsync && ::fsync(out.fd) != 0) {
+        err = errno;
+        step = "fsync";
+    }
+
+    // Prüfen: Größe immer, Inhalt per Hash (liest die Kopie einmal)
+    if (!err) {
+        struct stat copied{};
+        if (::fstat(out.fd, &copied) != 0 || copied.st_size != st.st_size) {
+            err = EIO;
+            step = "verify size";
+        } else if (opts_.verify) {
+            ContentHash want = expected.valid ? expected : ContentHash::ofFile(src);
+            if (!want.valid || !(ContentHash::ofFile(tmp) == want)) {
+                err = EIO;
+                step = "verify hash";
+            }
+        }
+    }
+
+    if (!err && ::rename(tmp.c_str(), dest.c_str()) != 0) {
+        err = errno;
+        step = "rename";
+    }
+    if (err) {
+        ::unlink(tmp.c_str());
+        fail(step, src, dest, err);
+    }
+
+    destDirs_.insert(dest.parent_path());
+    srcDirs_.insert(src.parent_path());
+    pendingSources_.push_back(src);
+    return method;
+}
+
+bool FileMover::commit() {
+    if (destDirs_.empty() && pendingSources_.empty()) return true;
+    ScopedTimer timer(metrics().commitSeconds);
+    TraceSpan span("commit", "move");
+    span.setCount(static_cast<int>(destDirs_.size()));
+
+    // 1. Neue Einträge in den Zielverzeichnissen dauerhaft machen
+    bool ok = true;
+    if (opts_.fsync) {
+        for (const auto& dir : destDirs_) ok = syncDirectory(dir) && ok;
+    }
+
+    // 2. Erst dann die kopierten Quellen löschen. Sonst bleiben sie liegen und
+    //    werden beim nächsten Durchlauf als Duplikat erkannt.
+    if (ok) {
+        for (const auto& src : pendingSources_) {
+            if (::unlink(src.c_str()) != 0 && errno != ENOENT) {
+                qWarning() << "Could not remove moved source" << QString::fromStdString(src.string()) << ":"
+                           << strerror(errno);
+            }
+        }
+        if (opts_.fsync) {
+            for (const auto& dir : srcDirs_) syncDirectory(dir);
+        }
+    } else {
+        qCritical() << "Directory fsync failed, keeping" << pendingSources_.size() << "copied sources";
+    }
+
+    destDirs_.clear();
+    srcDirs_.clear();
+    pendingSources_.clear();
+    return ok;
+}
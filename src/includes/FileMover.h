@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "ContentHash.h"
+
+// Wie eine Datei ins Ziel kam
+enum class MoveMethod { Rename, Reflink, CopyFileRange, Sendfile };
+
+const char* moveMethodName(MoveMethod m);
+
+struct MoveOptions {
+    bool fsync = true;    // Datei + Verzeichnisse auf Platte bringen, bevor die Quelle verschwindet
+    bool verify = true;   // Kopie per Größe + XXH3 prüfen
+
+    static MoveOptions fromEnvironment();
+};
+
+// Bereits angelegte Zielordner (von allen Move-Threads geteilt), damit nicht
+// jede Datei erneut exists()/create_directories() auslöst.
+class DirectoryCache {
+public:
+    static DirectoryCache& instance();
+
+    bool contains(const std::filesystem::path& dir) const;
+    void add(const std::filesystem::path& dir);
+    void forget(const std::filesystem::path& dir);   // extern gelöscht
+    size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_set<std::string> dirs_;
+};
+
+// Ein Eintrag für moveBatch(); Ergebnisfelder füllt der Mover
+struct MoveRequest {
+    std::filesystem::path src;
+    std::filesystem::path dest;
+    ContentHash expected;
+
+    bool ok = false;
+    MoveMethod method = MoveMethod::Rename;
+    uint64_t size = 0;
+    std::string error;
+};
+
+// Verschieben über Dateisystemgrenzen (uploads/ und Photos/ auf verschiedenen Volumes):
+// rename -> FICLONE (Reflink) -> copy_file_range -> sendfile. Die Daten laufen nie
+// durch Puffer im Userspace.
+//
+// Nach einer Kopie bleibt die Quelle liegen, bis commit() die Verzeichnis-Einträge
+// gesammelt per fsync gesichert hat. Ein Objekt pro Thread (nicht thread-safe).
+class FileMover {
+public:
+    explicit FileMover(MoveOptions opts = {});
+    ~FileMover();
+
+    FileMover(const FileMover&) = delete;
+    FileMover& operator=(const FileMover&) = delete;
+
+    // Wirft std::filesystem::filesystem_error. expected: Hash der Quelle (falls bekannt).
+    MoveMethod move(const std::filesystem::path& src, const std::filesystem::path& dest,
+                    const ContentHash& expected = {});
+
+    // Viele Dateien auf einmal: Zielordner anlegen (Cache), statx, rename. Mit
+    // WORKER_IO_URING=on jeweils als ein Batch über io_uring, sonst synchron.
+    // Kopien über Volumes laufen wie bei move(). Wirft nicht.
+    void moveBatch(std::span<MoveRequest> batch);
+
+    // Alle berührten Verzeichnisse einmal fsyncen, danach kopierte Quellen löschen.
+    // false -> Zielverzeichnisse nicht sicher, Quellen bleiben liegen.
+    bool commit();
+
+    size_t pending() const { return pendingSources_.size() + destDirs_.size(); }
+
+private:
+    void ensureDirectories(std::span<MoveRequest> batch);
+    void finishRename(MoveRequest& req, int renameResult);
+    MoveMethod copy(const std::filesystem::path& src, const std::filesystem::path& dest, const ContentHash& expected);
+
+    MoveOptions opts_;
+    std::set<std::filesystem::path> destDirs_;
+    std::set<std::filesystem::path> srcDirs_;
+    std::vector<std::filesystem::path> pendingSources_;
+};
@@ -0,0 +1,237 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+// Aufnahmedatum aus Dateinamen von Kameras, Handys und Messengern.
+// Jedes Muster wird zur Compile-Zeit in einen eigenen Matcher übersetzt:
+// Feldpositionen sind Konstanten, die Vergleichsschleife wird ausgerollt.
+// Kein Regex, kein QString, keine Allokation.
+//
+// Platzhalter (wie strftime):
+//   %Y Jahr (4)  %m Monat (2)  %d Tag (2)  %H Stunde (2)  %M Minute (2)  %S Sekunde (2)
+//   %# beliebige Ziffer   %s Unix-Zeit in Sekunden (10)   %L Unix-Zeit in ms (13)
+// Alles andere muss wörtlich passen. Beginnt/endet ein Muster mit einer Ziffer,
+// darf davor/dahinter keine weitere stehen (kein Treffer mitten in einer Zahl).
+
+struct FilenameDate {
+    int year = 0, month = 0, day = 0;
+    int hour = 0, minute = 0, second = 0;
+    int64_t epochSeconds = -1;   // >= 0: Unix-Zeit (UTC) statt der lokalen Felder
+    size_t patternIndex = 0;     // in FilenameDatePatterns::names
+    std::string_view pattern;    // z.B. "pixel"
+};
+
+namespace filename_date {
+
+// Muster als Template-Argument
+template <size_t N>
+struct Spec {
+    char text[N]{};
+    constexpr Spec(const char (&s)[N]) {
+        for (size_t i = 0; i < N; ++i) text[i] = s[i];
+    }
+    constexpr std::string_view view() const { return {text, N - 1}; }
+};
+
+enum class Field : uint8_t { Literal, Year, Month, Day, Hour, Minute, Second, AnyDigit, EpochSeconds, EpochMillis };
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Ungültiger Platzhalter -> throw -> Compile-Fehler beim Instanziieren
+constexpr std::pair<Field, size_t> placeholder(char code) {
+    switch (code) {
+        case 'Y': return {Field::Year, 4};
+        case 'm': return {Field::Month, 2};
+        case 'd': return {Field::Day, 2};
+        case 'H': return {Field::Hour, 2};
+        case 'M': return {Field::Minute, 2};
+        case 'S': return {Field::Second, 2};
+        case '#': return {Field::AnyDigit, 1};
+        case 's': return {Field::EpochSeconds, 10};
+        case 'L': return {Field::EpochMillis, 13};
+        default: throw std::logic_error("unknown placeholder in filename date pattern");
+    }
+}
+
+constexpr size_t expandedLength(std::string_view spec) {
+    size_t len = 0;
+    for (size_t i = 0; i < spec.size(); ++i) {
+        if (spec[i] == '%' && i + 1 < spec.size()) len += placeholder(spec[++i]).second;
+        else ++len;
+    }
+    return len;
+}
+
+// Ein Eintrag pro Zeichen im Dateinamen
+template <size_t LEN>
+struct Program {
+    std::array<Field, LEN> fields{};
+    std::array<char, LEN> literals{};
+};
+
+template <size_t LEN>
+constexpr Program<LEN> compile(std::string_view spec) {
+    Program<LEN> p;
+    size_t pos = 0;
+    for (size_t i = 0; i < spec.size(); ++i) {
+        if (spec[i] == '%' && i + 1 < spec.size()) {
+            auto [field, width] = placeholder(spec[++i]);
+            for (size_t k = 0; k < width; ++k) p.fields[pos++] = field;
+        } else {
+            p.fields[pos] = Field::Literal;
+            p.literals[pos++] = spec[i];
+        }
+    }
+    return p;
+}
+
+template <size_t LEN>
+constexpr size_t countOf(const Program<LEN>& p, Field f) {
+    size_t n = 0;
+    for (Field x : p.fields) n += (x == f);
+    return n;
+}
+
+constexpr bool isLeap(int y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+
+constexpr int daysInMonth(int y, int m) {
+    constexpr int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeap(y) ? 29 : DAYS[m - 1];
+}
+
+// Plausibler Bereich für Fotos; schützt vor Zufallstreffern in Zählern/IDs
+constexpr int MIN_YEAR = 1900;
+constexpr int MAX_YEAR = 2099;
+constexpr int64_t MIN_EPOCH = 946684800;    // 2000-01-01
+constexpr int64_t MAX_EPOCH = 4102444800;   // 2100-01-01
+
+template <Spec S>
+struct Matcher {
+    static constexpr size_t LEN = expandedLength(S.view());
+    static constexpr Program<LEN> CODE = compile<LEN>(S.view());
+    static constexpr bool EPOCH = countOf(CODE, Field::EpochSeconds) + countOf(CODE, Field::EpochMillis) > 0;
+
+    // Erstes wörtliches Zeichen: Kandidaten per find() statt an jeder Position
+    static constexpr size_t ANCHOR = [] {
+        for (size_t i = 0; i < LEN; ++i) {
+            if (CODE.fields[i] == Field::Literal) return i;
+        }
+        return LEN;
+    }();
+
+    static_assert(ANCHOR < LEN, "pattern needs at least one literal character");
+    static_assert(EPOCH ? countOf(CODE, Field::Year) + countOf(CODE, Field::Month) + countOf(CODE, Field::Day) == 0
+                        : countOf(CODE, Field::Year) == 4 && countOf(CODE, Field::Month) == 2 &&
+                              countOf(CODE, Field::Day) == 2,
+                  "pattern needs either %Y%m%d or exactly one of %s / %L");
+    static_assert(countOf(CODE, Field::EpochSeconds) % 10 == 0 && countOf(CODE, Field::EpochMillis) % 13 == 0 &&
+                      countOf(CODE, Field::EpochSeconds) + countOf(CODE, Field::EpochMillis) <= 13,
+                  "at most one epoch placeholder");
+
+    static constexpr bool matchAt(std::string_view s, size_t pos, FilenameDate& out) {
+        if (CODE.fields[0] != Field::Literal && pos > 0 && isDigit(s[pos - 1])) return false;
+        if (CODE.fields[LEN - 1] != Field::Literal && pos + LEN < s.size() && isDigit(s[pos + LEN])) return false;
+
+        FilenameDate d;
+        int64_t epoch = 0;
+        // LEN und CODE sind Konstanten -> der Compiler rollt die Schleife aus
+        for (size_t i = 0; i < LEN; ++i) {
+            const char c = s[pos + i];
+            if (CODE.fields[i] == Field::Literal) {
+                if (c != CODE.literals[i]) return false;
+                continue;
+            }
+            if (!isDigit(c)) return false;
+            const int v = c - '0';
+            switch (CODE.fields[i]) {
+                case Field::Year:   d.year = d.year * 10 + v; break;
+                case Field::Month:  d.month = d.month * 10 + v; break;
+                case Field::Day:    d.day = d.day * 10 + v; break;
+                case Field::Hour:   d.hour = d.hour * 10 + v; break;
+                case Field::Minute: d.minute = d.minute * 10 + v; break;
+                case Field::Second: d.second = d.second * 10 + v; break;
+                case Field::EpochSeconds:
+                case Field::EpochMillis: epoch = epoch * 10 + v; break;
+                default: break;
+            }
+        }
+
+        if constexpr (EPOCH) {
+            if (countOf(CODE, Field::EpochMillis) > 0) epoch /= 1000;
+            if (epoch < MIN_EPOCH || epoch >= MAX_EPOCH) return false;
+            d.epochSeconds = epoch;
+        } else {
+            if (d.year < MIN_YEAR || d.year > MAX_YEAR || d.month < 1 || d.month > 12) return false;
+            if (d.day < 1 || d.day > daysInMonth(d.year, d.month)) return false;
+            if (d.hour > 23 || d.minute > 59 || d.second > 59) return false;
+        }
+        out = d;
+        return true;
+    }
+
+    static constexpr std::optional<FilenameDate> find(std::string_view s) {
+        if (s.size() < LEN) return std::nullopt;
+        const char anchor = CODE.literals[ANCHOR];
+        for (size_t at = s.find(anchor, ANCHOR); at != std::string_view::npos && at - ANCHOR + LEN <= s.size();
+             at = s.find(anchor, at + 1)) {
+            FilenameDate d;
+            if (matchAt(s, at - ANCHOR, d)) return d;
+        }
+        return std::nullopt;
+    }
+};
+
+template <Spec Name, Spec Pattern>
+struct Rule {
+    static constexpr std::string_view name = Name.view();
+    using M = Matcher<Pattern>;
+};
+
+template <typename R>
+constexpr bool tryRule(std::string_view s, size_t index, std::optional<FilenameDate>& out) {
+    out = R::M::find(s);
+    if (!out) return false;
+    out->patternIndex = index;
+    out->pattern = R::name;
+    return true;
+}
+
+template <typename... Rules>
+struct RuleSet {
+    static constexpr std::array<std::string_view, sizeof...(Rules)> names{Rules::name...};
+
+    // Das erste passende Muster in Tabellenreihenfolge gewinnt
+    static constexpr std::optional<FilenameDate> match(std::string_view s) {
+        std::optional<FilenameDate> out;
+        size_t index = 0;
+        (tryRule<Rules>(s, index++, out) || ...);
+        return out;
+    }
+};
+
+} // namespace filename_date
+
+// Spezielle Muster vor allgemeinen (IMG_... passt sonst auch auf "compact")
+using FilenameDatePatterns = filename_date::RuleSet<
+    filename_date::Rule<"whatsapp", "WhatsApp Image %Y-%m-%d at %H.%M.%S">,
+    filename_date::Rule<"whatsapp_video", "WhatsApp Video %Y-%m-%d at %H.%M.%S">,
+    filename_date::Rule<"whatsapp_legacy", "IMG-%Y%m%d-WA%#%#%#%#">,
+    filename_date::Rule<"pixel", "PXL_%Y%m%d_%H%M%S%#%#%#">,
+    filename_date::Rule<"android", "IMG_%Y%m%d_%H%M%S">,
+    filename_date::Rule<"android_video", "VID_%Y%m%d_%H%M%S">,
+    filename_date::Rule<"screenshot", "Screenshot_%Y%m%d-%H%M%S">,
+    filename_date::Rule<"signal", "signal-%Y-%m-%d-%H%M%S">,
+    filename_date::Rule<"iso", "%Y-%m-%d_%H%M%S">,
+    filename_date::Rule<"dropbox", "%Y-%m-%d %H.%M.%S">,
+    filename_date::Rule<"compact", "%Y%m%d_%H%M%S">,
+    filename_date::Rule<"facebook", "FB_IMG_%L">,
+    filename_date::Rule<"dsc_epoch", "DSC_%s">>;
+
+constexpr std::optional<FilenameDate> matchFilenameDate(std::string_view filename) {
+    return FilenameDatePatterns::match(filename);
+}
@@ -0,0 +1,437 @@
+#include "HttpIngest.h"
+#include "DbManager.h"
+#include "DuplicateIndex.h"
+#include "FileHelpers.h"
+#include "FileMover.h"
+#include "IngestPipeline.h"
+#include "MetadataExtractor.h"
+#include "PerceptualHash.h"
+#include "Metrics.h"
+#include "ReverseGeocoder.h"
+#include "Tracer.h"
+#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct HttpIngestMetrics {
+    MetricCounter& stored;
+    MetricCounter& duplicates;
+    MetricCounter& rejected;
+    MetricCounter& invalid;
+    MetricCounter& failed;
+    MetricCounter& bytes;
+    MetricHistogram& seconds;
+};
+
+static HttpIngestMetrics& metrics() {
+    static HttpIngestMetrics m = [] {
+        auto& r = MetricsRegistry::instance();
+        const char* help = "Uploads received via POST /ingest, by result";
+        return HttpIngestMetrics{
+            r.counter("worker_http_ingest_total", help, R"(result="stored")"),
+            r.counter("worker_http_ingest_total", help, R"(result="duplicate")"),
+            r.counter("worker_http_ingest_total", help, R"(result="rejected")"),
+            r.counter("worker_http_ingest_total", help, R"(result="invalid")"),
+            r.counter("worker_http_ingest_total", help, R"(result="failed")"),
+            r.counter("worker_http_ingest_bytes_total", "Bytes written by POST /ingest"),
+            r.histogram("worker_http_ingest_seconds", "POST /ingest from first byte written to picture id"),
+        };
+    }();
+    return m;
+}
+
+static int envInt(const char* name, int defaultValue) {
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+HttpIngestConfig HttpIngestConfig::fromEnvironment() {
+    HttpIngestConfig cfg;
+    cfg.maxRequests = static_cast<size_t>(std::max(1, envInt("WORKER_INGEST_MAX_REQUESTS", 16)));
+    cfg.maxBytes    = static_cast<uint64_t>(std::max(1, envInt("WORKER_INGEST_MAX_MB", 512))) << 20;
+    cfg.maxFileBytes = static_cast<uint64_t>(std::max(1, envInt("WORKER_INGEST_MAX_FILE_MB", 256))) << 20;
+    cfg.dbTimeout   = std::chrono::seconds(std::max(1, envInt("WORKER_INGEST_TIMEOUT_S", 60)));
+    cfg.port        = std::clamp(envInt("WORKER_INGEST_PORT", 8082), 0, 65535);
+    return cfg;
+}
+
+// --- AdmissionControl ---
+
+AdmissionControl::AdmissionControl(size_t maxRequests, uint64_t maxBytes)
+    : maxRequests_(maxRequests), maxBytes_(maxBytes) {}
+
+AdmissionControl::Ticket AdmissionControl::tryAdmit(uint64_t bytes) {
+    size_t r = requests_.load();
+    do {
+        if (r >= maxRequests_) return {};
+    } while (!requests_.compare_exchange_weak(r, r + 1));
+
+    uint64_t b = bytes_.load();
+    do {
+        if (b > 0 && b + bytes > maxBytes_) {
+            requests_--;
+            return {};
+        }
+    } while (!bytes_.compare_exchange_weak(b, b + bytes));
+    return Ticket(this, bytes);
+}
+
+void AdmissionControl::release(uint64_t bytes) {
+    bytes_ -= bytes;
+    requests_--;
+}
+
+AdmissionControl::Ticket::Ticket(Ticket&& o) noexcept : owner_(o.owner_), bytes_(o.bytes_) {
+    o.owner_ = nullptr;
+}
+
+AdmissionControl::Ticket& AdmissionControl::Ticket::operator=(Ticket&& o) noexcept {
+    if (this != &o) {
+        if (owner_) owner_->release(bytes_);
+        owner_ = o.owner_;
+        bytes_ = o.bytes_;
+        o.owner_ = nullptr;
+    }
+    return *this;
+}
+
+AdmissionControl::Ticket::~Ticket() {
+    if (owner_) owner_->release(bytes_);
+}
+
+// --- IngestUpload ---
+
+IngestUpload::IngestUpload(fs::path dest, bool fsync) : dest_(std::move(dest)), fsync_(fsync) {
+    // Eindeutig, damit zwei Uploads mit gleichem Namen sich nicht gegenseitig überschreiben
+    static std::atomic<uint64_t> seq{0};
+    part_ = dest_.parent_path() / ("." + dest_.filename().string() + "." + std::to_string(seq++) + ".part");
+}
+
+IngestUpload::~IngestUpload() {
+    if (fd_ >= 0) ::close(fd_);
+    if (!committed_ && !part_.empty()) ::unlink(part_.c_str());
+}
+
+bool IngestUpload::open(std::string& error) {
+    fd_ = ::open(part_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error = "cannot create " + part_.string() + ": " + std::strerror(errno);
+        part_.clear();   // nicht unsere Datei -> nicht löschen
+        return false;
+    }
+    return true;
+}
+
+bool IngestUpload::write(std::span<const unsigned char> chunk, std::string& error) {
+    const unsigned char* p = chunk.data();
+    size_t left = chunk.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd_, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            error = "write failed: " + std::string(std::strerror(errno));
+            return false;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+
+    hasher_.update(chunk.data(), chunk.size());
+    if (header_.size() < HEADER_WINDOW) {
+        size_t take = std::min(HEADER_WINDOW - header_.size(), chunk.size());
+        header_.insert(header_.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(take));
+    }
+    size_ += chunk.size();
+    return true;
+}
+
+bool IngestUpload::finish(std::string& error) {
+    if (fsync_ && ::fsync(fd_) != 0) {
+        error = "fsync failed: " + std::string(std::strerror(errno));
+        return false;
+    }
+    int rc = ::close(fd_);
+    fd_ = -1;
+    if (rc != 0) {
+        error = "close failed: " + std::string(std::strerror(errno));
+        return false;
+    }
+    hash_ = hasher_.digest();
+    return true;
+}
+
+bool IngestUpload::commit(std::string& error, bool& exists) {
+    // rename() würde ein gleichnamiges Foto stillschweigend ersetzen
+    int rc = ::renameat2(AT_FDCWD, part_.c_str(), AT_FDCWD, dest_.c_str(), RENAME_NOREPLACE);
+    if (rc != 0 && errno == EINVAL) {
+        // Dateisystem ohne RENAME_NOREPLACE (z.B. ältere NFS): link() ersetzt auch nie
+        rc = ::link(part_.c_str(), dest_.c_str());
+        if (rc == 0) ::unlink(part_.c_str());
+    }
+    if (rc != 0) {
+        exists = errno == EEXIST;
+        error = exists ? dest_.string() + " already exists"
+                       : "rename to " + dest_.string() + " failed: " + std::strerror(errno);
+        return false;
+    }
+    committed_ = true;
+    if (fsync_) {
+        int dirFd = ::open(dest_.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+    return true;
+}
+
+// --- HttpIngest ---
+
+// Helper: Zielordner nur unterhalb von PHOTOS_ROOT, keine versteckten Komponenten
+static bool safeRelativeDir(const std::string& dir, fs::path& out) {
+    fs::path p(dir);
+    if (p.is_absolute()) return false;
+    out.clear();
+    for (const fs::path& part : p.lexically_normal()) {
+        const std::string s = part.string();
+        if (s.empty() || s == ".") continue;
+        if (s.starts_with(".")) return false;   // auch ".."
+        out /= part;
+    }
+    return true;
+}
+
+HttpIngest::HttpIngest(IngestPipeline& pipeline, HttpIngestConfig cfg)
+    : pipeline_(pipeline), cfg_(cfg), admission_(cfg_.maxRequests, cfg_.maxBytes) {
+    auto& r = MetricsRegistry::instance();
+    const char* help = "Uploads currently being received via POST /ingest";
+    r.gauge("worker_http_ingest_in_flight", help, R"(unit="requests")", [this] { return (double)admission_.requests(); });
+    r.gauge("worker_http_ingest_in_flight", help, R"(unit="bytes")", [this] { return (double)admission_.bytes(); });
+}
+
+// Gleicher Inhalt ist gerade selbst in Arbeit (reserviert, noch ohne ID): bis
+// zum Commit bzw. Fehlschlag des Originals warten (max. dbTimeout) und neu
+// fragen. Danach wie findOrReserve(); false -> Zeit abgelaufen
+bool HttpIngest::awaitSettled(const ContentHash& hash, std::optional<qint64>& existing) {
+    DuplicateIndex& index = DuplicateIndex::instance();
+    const auto deadline = std::chrono::steady_clock::now() + cfg_.dbTimeout;
+    for (;;) {
+        existing = index.findOrReserve(hash);
+        if (!existing || *existing > 0) return true;
+
+        auto settled = std::make_shared<std::promise<void>>();
+        std::future<void> done = settled->get_future();
+        if (!index.whenSettled(hash, settled.get(), [settled] { settled->set_value(); })) continue;
+        if (done.wait_until(deadline) != std::future_status::ready) {
+            index.cancelWaiters(settled.get());
+            return false;
+        }
+    }
+}
+
+IngestResult HttpIngest::ingest(const IngestRequest& req, uint64_t contentLength, const BodyReader& read) {
+    IngestResult res;
+
+    // Vor dem ersten gelesenen Byte: der Body liegt nie ganz im Speicher,
+    // zu große Uploads werden gar nicht erst angenommen
+    if (contentLength > cfg_.maxFileBytes) {
+        metrics().invalid.inc();
+        res.status = 413;
+        res.error = "upload larger than " + std::to_string(cfg_.maxFileBytes >> 20) + " MiB";
+        return res;
+    }
+
+    AdmissionControl::Ticket ticket = admission_.tryAdmit(contentLength);
+    if (!ticket) {
+        metrics().rejected.inc();
+        res.status = 429;
+        res.error = "too many uploads in flight";
+        return res;
+    }
+
+    // 1. Anfrage prüfen
+    FileInfo info = parseFilename(req.name);
+    fs::path relDir;
+    if (contentLength == 0 || info.cleanName.empty() || info.cleanName.starts_with(".") ||
+        info.cleanName.find('/') != std::string::npos || !safeRelativeDir(req.dir, relDir)) {
+        metrics().invalid.inc();
+        res.status = 400;
+        res.error = "need a non-empty body, a plain file name and a relative dir";
+        return res;
+    }
+    const std::string user = req.user.empty() ? info.user : req.user;
+    const PipelineConfig& pc = pipeline_.config();
+    const fs::path dest = pc.photosRoot / relDir / info.cleanName;
+    res.path = (relDir / info.cleanName).string();
+
+    ScopedTimer timer(metrics().seconds);
+    TraceFileScope traceFile(info.cleanName, user, static_cast<int64_t>(contentLength));
+    TraceSpan span("http ingest", "http");
+    auto fail = [&](int status, std::string error) {
+        metrics().failed.inc();
+        qCritical() << "Ingest of" << QString::fromStdString(res.path) << "failed:" << QString::fromStdString(error);
+        res.status = status;
+        res.error = std::move(error);
+        return res;
+    };
+
+    // 2. Zielordner (bekannte aus dem Cache der Move-Stufe)
+    if (!DirectoryCache::instance().contains(dest.parent_path())) {
+        std::error_code ec;
+        fs::create_directories(dest.parent_path(), ec);
+        if (ec) return fail(500, "cannot create directory: " + ec.message());
+        DirectoryCache::instance().add(dest.parent_path());
+    }
+
+    // 3. In Stücken vom Socket direkt neben das Ziel schreiben
+    std::string error;
+    IngestUpload upload(dest, pc.move.fsync);
+    {
+        TraceSpan writeSpan("read + write + hash", "http");
+        if (!upload.open(error)) return fail(500, error);
+        constexpr size_t CHUNK = 1 << 20;
+        std::vector<unsigned char> buf(static_cast<size_t>(std::min<uint64_t>(CHUNK, contentLength)));
+        for (uint64_t left = contentLength; left > 0;) {
+            long n = read(buf.data(), static_cast<size_t>(std::min<uint64_t>(buf.size(), left)));
+            if (n <= 0) return fail(400, "body ended after " + std::to_string(contentLength - left) + " bytes");
+            if (!upload.write({buf.data(), static_cast<size_t>(n)}, error)) return fail(500, error);
+            left -= static_cast<uint64_t>(n);
+        }
+        if (!upload.finish(error)) return fail(500, error);
+    }
+    metrics().bytes.inc(upload.size());
+
+    // 4. Duplikate vor dem rename: ein verworfener Upload taucht nie in Photos/ auf
+    ContentHash reserved;
+    bool replaceExisting = false;
+    if (upload.hash().valid) {
+        std::optional<qint64> existing;
+        {
+            TraceSpan dupSpan("duplicate check", "http");
+            if (!awaitSettled(upload.hash(), existing)) {
+                metrics().rejected.inc();
+                res.status = 503;
+                res.error = "the same content is still being stored, retry later";
+                return res;
+            }
+        }
+        if (!existing) {
+            reserved = upload.hash();
+        } else if (pc.duplicatePolicy == DuplicatePolicy::Replace) {
+            replaceExisting = true;
+        } else {
+            metrics().duplicates.inc();
+            if (pc.duplicatePolicy == DuplicatePolicy::Link) {
+                WorkerPayload link;
+                link.filename    = info.cleanName;
+                link.relPath     = relDir.string();
+                link.user        = user;
+                link.fileSize    = static_cast<long long>(upload.size());
+                link.contentHash = upload.hash().toHex();
+                link.linkOnly    = true;
+                if (!pipeline_.store(std::move(link))) return fail(503, "worker is shutting down");
+            }
+            qDebug() << "Ingest: duplicate of picture" << *existing << ":" << QString::fromStdString(res.path);
+            res.status = 200;
+            res.duplicateOf = *existing;
+            return res;
+        }
+    }
+
+    // 5. Metadaten: Fast Path aus den ersten Bytes, Exiv2 notfalls über die .part-Datei
+    WorkerPayload payload;
+    try {
+        TraceSpan metaSpan("metadata", "http");
+        payload.meta = MetadataExtractor::extract(upload.partPath().string(), upload.header());
+    } catch (const std::exception& e) {
+        DuplicateIndex::instance().release(reserved);
+        return fail(422, std::string("unreadable image: ") + e.what());
+    }
+    const ReverseGeocoder& geo = ReverseGeocoder::instance();
+    if (geo.isLoaded() && (payload.meta.gpsLat != 0.0 || payload.meta.gpsLon != 0.0)) geo.fill(payload.meta);
+
+    if (payload.meta.takenAt.isValid()) {
+        payload.fileDate = payload.meta.takenAt;
+    } else {
+        QDateTime nameDate = extractDateFromFilename(info.cleanName);
+        payload.fileDate = nameDate.isValid() ? nameDate : getFileLastModified(upload.partPath());
+    }
+
+    // Perceptual Hash (Beinahe-Duplikate), Abgleich macht der DB-Writer
+    if (pipeline_.config().phash.enabled) {
+        TraceSpan phashSpan("phash", "http");
+        payload.phash = PerceptualHash::ofFile(upload.partPath());
+    }
+
+    bool committed, exists = false;
+    {
+        TraceSpan commitSpan("commit", "http");
+        committed = upload.commit(error, exists);
+    }
+    if (!committed) {
+        DuplicateIndex::instance().release(reserved);
+        return fail(exists ? 409 : 500, error);
+    }
+
+    // 6. Über den DB-Writer (Group Commit) speichern und auf die ID warten
+    payload.filename        = info.cleanName;
+    payload.relPath         = relDir.string();
+    payload.fullPath        = dest.string();
+    payload.user            = user;
+    payload.fileSize        = static_cast<long long>(upload.size());
+    payload.contentHash     = upload.hash().toHex();
+    payload.replaceExisting = replaceExisting;
+
+    auto done = std::make_shared<std::promise<qint64>>();
+    std::future<qint64> stored = done->get_future();
+    payload.onStored = [done](qint64 id) { done->set_value(id); };
+    // Ohne Zeile darf die Datei nicht in Photos/ bleiben: sie wäre verwaist, und
+    // ein erneuter Upload scheiterte für immer am vorhandenen Ziel (409)
+    auto discard = [&] {
+        std::error_code ec;
+        fs::remove(dest, ec);
+        if (ec) qWarning() << "Ingest: cannot remove" << QString::fromStdString(dest.string()) << ":" << QString::fromStdString(ec.message());
+    };
+    if (!pipeline_.store(std::move(payload))) {
+        discard();
+        DuplicateIndex::instance().release(reserved);
+        return fail(503, "worker is shutting down");
+    }
+
+    std::future_status waited;
+    {
+        TraceSpan waitSpan("wait for db", "http");
+        waited = stored.wait_for(cfg_.dbTimeout);
+    }
+    if (waited != std::future_status::ready) {
+        // Datei liegt am Ziel, die Zeile kommt noch
+        res.status = 202;
+        res.error = "stored on disk, database write still pending";
+        return res;
+    }
+    qint64 id = -1;
+    try {
+        id = stored.get();
+    } catch (const std::future_error&) {
+        // Payload verworfen, ohne dass der DB-Writer ihn gesehen hat
+    }
+    if (id <= 0) {
+        // Der DB-Writer hat aufgegeben (Reservierung schon zurückgegeben)
+        discard();
+        return fail(500, "database write failed");
+    }
+
+    metrics().stored.inc();
+    res.status = 201;
+    res.pictureId = id;
+    return res;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "ContentHash.h"
+
+class IngestPipeline;
+
+// Grenzen für gleichzeitige Uploads (WORKER_INGEST_MAX_REQUESTS, WORKER_INGEST_MAX_MB)
+struct HttpIngestConfig {
+    size_t maxRequests = 16;
+    uint64_t maxBytes = 512ull << 20;
+    uint64_t maxFileBytes = 256ull << 20;   // WORKER_INGEST_MAX_FILE_MB: größere Uploads -> 413
+    std::chrono::seconds dbTimeout{60};   // WORKER_INGEST_TIMEOUT_S: so lange auf die Picture-ID warten
+    int port = 8082;                        // WORKER_INGEST_PORT, 0 = kein Upload-Endpunkt
+
+    static HttpIngestConfig fromEnvironment();
+};
+
+// Zulassungskontrolle: höchstens maxRequests Uploads und maxBytes Nutzdaten
+// gleichzeitig. Ein Ticket hält seinen Anteil, bis es zerstört wird.
+class AdmissionControl {
+public:
+    class Ticket {
+    public:
+        Ticket() = default;
+        Ticket(Ticket&& o) noexcept;
+        Ticket& operator=(Ticket&& o) noexcept;
+        ~Ticket();
+
+        explicit operator bool() const { return owner_ != nullptr; }
+
+    private:
+        friend class AdmissionControl;
+        Ticket(AdmissionControl* owner, uint64_t bytes) : owner_(owner), bytes_(bytes) {}
+
+        AdmissionControl* owner_ = nullptr;
+        uint64_t bytes_ = 0;
+    };
+
+    AdmissionControl(size_t maxRequests, uint64_t maxBytes);
+
+    // Leeres Ticket -> überlastet (429). Ein einzelner Upload über maxBytes
+    // wird trotzdem zugelassen, wenn sonst nichts läuft.
+    Ticket tryAdmit(uint64_t bytes);
+
+    size_t requests() const { return requests_.load(); }
+    uint64_t bytes() const { return bytes_.load(); }
+
+private:
+    void release(uint64_t bytes);
+
+    const size_t maxRequests_;
+    const uint64_t maxBytes_;
+    std::atomic<size_t> requests_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+// Eine laufende Übertragung: Stücke gehen sofort nach "<ziel>/.<name>.part",
+// Hash und die ersten Bytes (Metadaten-Fenster) werden nebenher gesammelt.
+// Ohne commit() wird die .part-Datei im Destruktor gelöscht.
+class IngestUpload {
+public:
+    static constexpr size_t HEADER_WINDOW = 512 * 1024;   // wie MappedHeader::DEFAULT_WINDOW
+
+    IngestUpload(std::filesystem::path dest, bool fsync);
+    ~IngestUpload();
+
+    IngestUpload(const IngestUpload&) = delete;
+    IngestUpload& operator=(const IngestUpload&) = delete;
+
+    bool open(std::string& error);
+    bool write(std::span<const unsigned char> chunk, std::string& error);
+
+    // Daten auf Platte bringen (fsync), Hash abschließen. Datei bleibt .part
+    bool finish(std::string& error);
+
+    // .part -> Ziel umbenennen, Verzeichnis-Eintrag sichern. Ein vorhandenes
+    // Foto wird nie ersetzt: dann false und exists = true
+    bool commit(std::string& error, bool& exists);
+
+    const std::filesystem::path& partPath() const { return part_; }
+    const std::filesystem::path& dest() const { return dest_; }
+    uint64_t size() const { return size_; }
+    const ContentHash& hash() const { return hash_; }
+    std::span<const unsigned char> header() const { return header_; }
+
+private:
+    std::filesystem::path dest_;
+    std::filesystem::path part_;
+    bool fsync_;
+    int fd_ = -1;
+    bool committed_ = false;
+    uint64_t size_ = 0;
+    ContentHasher hasher_;
+    ContentHash hash_;
+    std::vector<unsigned char> header_;
+};
+
+struct IngestRequest {
+    std::string user;   // leer -> aus dem Dateinamen ("user___...___name.jpg") oder "system"
+    std::string name;   // Dateiname
+    std::string dir;    // Zielordner relativ zu PHOTOS_ROOT, z.B. "2023/Sommer"
+};
+
+struct IngestResult {
+    int status = 500;            // HTTP-Status
+    qint64 pictureId = -1;
+    qint64 duplicateOf = -1;     // Duplikat (Policy skip/link): vorhandenes Foto
+    std::string path;            // relativ zu PHOTOS_ROOT
+    std::string error;
+};
+
+// POST /ingest: Upload direkt an den endgültigen Ort schreiben (ohne den Umweg
+// über uploads/ und das Polling), Metadaten aus den ersten Bytes lesen und
+// über den DB-Writer der Pipeline speichern. Unabhängig vom HTTP-Framework.
+class HttpIngest {
+public:
+    HttpIngest(IngestPipeline& pipeline, HttpIngestConfig cfg);
+
+    // Liest bis zu len Bytes des Bodys; 0 = Verbindung zu, < 0 = Fehler
+    using BodyReader = std::function<long(unsigned char* buf, size_t len)>;
+
+    // Größe und Zulassung werden geprüft, bevor das erste Byte gelesen wird;
+    // danach wandert der Body stückweise in die .part-Datei. Blockiert bis
+    // zum DB-Commit (max. dbTimeout)
+    IngestResult ingest(const IngestRequest& req, uint64_t contentLength, const BodyReader& read);
+
+    const AdmissionControl& admission() const { return admission_; }
+
+private:
+    bool awaitSettled(const ContentHash& hash, std::optional<qint64>& existing);
+
+    IngestPipeline& pipeline_;
+    const HttpIngestConfig cfg_;
+    AdmissionControl admission_;
+};
@@ -0,0 +1,117 @@
+#include "ImageResize.h"
+#include <algorithm>
+#include <cmath>
+
+void fitInside(int width, int height, int maxEdge, int& outWidth, int& outHeight) {
+    if (width <= maxEdge && height <= maxEdge) {
+        outWidth = width;
+        outHeight = height;
+        return;
+    }
+    if (width >= height) {
+        outWidth = maxEdge;
+        outHeight = std::max(1, static_cast<int>(std::lround(static_cast<double>(height) * maxEdge / width)));
+    } else {
+        outHeight = maxEdge;
+        outWidth = std::max(1, static_cast<int>(std::lround(static_cast<double>(width) * maxEdge / height)));
+    }
+}
+
+namespace {
+
+// Gewichte pro Zielkoordinate: Quellbereich [first, first + count)
+struct FilterTaps {
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<float> weights;   // dstSize * maxTaps
+    int maxTaps = 0;
+};
+
+FilterTaps computeTaps(int srcSize, int dstSize) {
+    FilterTaps t;
+    const double scale = static_cast<double>(srcSize) / dstSize;
+    const double support = std::max(1.0, scale);   // Verkleinern: Filter auf Quellraster strecken
+    t.maxTaps = static_cast<int>(std::ceil(support * 2)) + 1;
+    t.first.resize(dstSize);
+    t.count.resize(dstSize);
+    t.weights.assign(static_cast<size_t>(dstSize) * t.maxTaps, 0.0f);
+
+    for (int d = 0; d < dstSize; ++d) {
+        double center = (d + 0.5) * scale - 0.5;
+        int lo = std::max(0, static_cast<int>(std::floor(center - support)));
+        int hi = std::min(srcSize - 1, static_cast<int>(std::ceil(center + support)));
+        hi = std::min(hi, lo + t.maxTaps - 1);
+
+        float* w = &t.weights[static_cast<size_t>(d) * t.maxTaps];
+        double sum = 0.0;
+        for (int s = lo; s <= hi; ++s) {
+            double x = std::abs((s - center) / support);
+            double v = x < 1.0 ? 1.0 - x : 0.0;
+            w[s - lo] = static_cast<float>(v);
+            sum += v;
+        }
+        if (sum <= 0.0) {
+            // Kann nur beim Vergrößern am Rand passieren: nächsten Pixel nehmen
+            lo = std::clamp(static_cast<int>(std::lround(center)), 0, srcSize - 1);
+            hi = lo;
+            w[0] = 1.0f;
+            sum = 1.0;
+        }
+        for (int s = 0; s <= hi - lo; ++s) w[s] = static_cast<float>(w[s] / sum);
+        t.first[d] = lo;
+        t.count[d] = hi - lo + 1;
+    }
+    return t;
+}
+
+} // namespace
+
+RgbImage resizeRgb(const RgbImage& src, int width, int height) {
+    RgbImage dst;
+    if (!src.isValid() || width <= 0 || height <= 0) return dst;
+    dst.width = width;
+    dst.height = height;
+    dst.pixels.resize(static_cast<size_t>(width) * height * 3);
+
+    const FilterTaps tx = computeTaps(src.width, width);
+    const FilterTaps ty = computeTaps(src.height, height);
+    const size_t rowLen = static_cast<size_t>(width) * 3;
+
+    // 1. Horizontal: jede Quellzeile auf Zielbreite (float)
+    std::vector<float> horiz(static_cast<size_t>(src.height) * rowLen);
+    for (int y = 0; y < src.height; ++y) {
+        const uint8_t* in = &src.pixels[static_cast<size_t>(y) * src.width * 3];
+        float* out = &horiz[static_cast<size_t>(y) * rowLen];
+        for (int x = 0; x < width; ++x) {
+            const float* w = &tx.weights[static_cast<size_t>(x) * tx.maxTaps];
+            const uint8_t* p = in + static_cast<size_t>(tx.first[x]) * 3;
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int k = 0; k < tx.count[x]; ++k) {
+                r += w[k] * p[k * 3];
+                g += w[k] * p[k * 3 + 1];
+                b += w[k] * p[k * 3 + 2];
+            }
+            out[x * 3] = r;
+            out[x * 3 + 1] = g;
+            out[x * 3 + 2] = b;
+        }
+    }
+
+    // 2. Vertikal: gewichtete Summe ganzer Zeilen -> lange, zusammenhängende Schleifen
+    std::vector<float> acc(rowLen);
+    for (int y = 0; y < height; ++y) {
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        const float* w = &ty.weights[static_cast<size_t>(y) * ty.maxTaps];
+        for (int k = 0; k < ty.count[y]; ++k) {
+            const float* __restrict row = &horiz[static_cast<size_t>(ty.first[y] + k) * rowLen];
+            float* __restrict a = acc.data();
+            const float wk = w[k];
+            for (size_t i = 0; i < rowLen; ++i) a[i] += wk * row[i];
+        }
+        uint8_t* out = &dst.pixels[static_cast<size_t>(y) * rowLen];
+        for (size_t i = 0; i < rowLen; ++i) {
+            out[i] = static_cast<uint8_t>(std::clamp(acc[i] + 0.5f, 0.0f, 255.0f));
+        }
+    }
+    return dst;
+}
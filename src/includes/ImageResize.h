@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// 8-Bit RGB, zeilenweise ohne Padding
+struct RgbImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;   // width * height * 3
+
+    bool isValid() const { return width > 0 && height > 0; }
+};
+
+// Größe, die in maxEdge x maxEdge passt (Seitenverhältnis bleibt, nie größer als das Original)
+void fitInside(int width, int height, int maxEdge, int& outWidth, int& outHeight);
+
+// Separabler Dreiecksfilter (beim Verkleinern mit entsprechend breitem Träger,
+// d.h. ohne Aliasing). Die inneren Schleifen laufen über zusammenhängende
+// float-Zeilen und werden vom Compiler vektorisiert.
+RgbImage resizeRgb(const RgbImage& src, int width, int height);
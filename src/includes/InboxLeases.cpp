@@ -0,0 +1,433 @@
+#include "InboxLeases.h"
+#include "DbPool.h"
+#include "KeywordCache.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSysInfo>
+#include <QtGlobal>
+#include <algorithm>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct LeaseMetrics {
+    MetricCounter& claimsWon;
+    MetricCounter& claimsLost;
+    MetricCounter& takeovers;
+    MetricCounter& lost;
+    MetricHistogram& claimSeconds;
+    MetricHistogram& heartbeatSeconds;
+};
+
+static LeaseMetrics& metrics() {
+    static LeaseMetrics m = [] {
+        auto& r = MetricsRegistry::instance();
+        const char* claimHelp = "Inbox files offered for claiming, by outcome";
+        return LeaseMetrics{
+            r.counter("worker_lease_claims_total", claimHelp, R"(result="won")"),
+            r.counter("worker_lease_claims_total", claimHelp, R"(result="lost")"),
+            r.counter("worker_lease_takeovers_total", "Expired leases of other nodes taken over"),
+            r.counter("worker_lease_lost_total", "Own leases found taken over by another node"),
+            r.histogram("worker_lease_claim_seconds", "Duration of one batched claim statement"),
+            r.histogram("worker_lease_heartbeat_seconds", "Duration of one heartbeat round"),
+        };
+    }();
+    return m;
+}
+
+static int envInt(const char* name, int defaultValue) {
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+LeaseConfig LeaseConfig::fromEnvironment() {
+    LeaseConfig cfg;
+    cfg.enabled = qEnvironmentVariable("WORKER_CLUSTER", "off") == "lease";
+    cfg.node = qEnvironmentVariable("WORKER_NODE_ID");
+    if (cfg.node.isEmpty()) cfg.node = QSysInfo::machineHostName() + ":" + QString::number(::getpid());
+
+    cfg.ttl = std::chrono::seconds(std::max(5, envInt("WORKER_LEASE_TTL_S", 60)));
+    // Mehrere Heartbeats pro TTL, damit ein verpasster nicht gleich die Leases kostet
+    int hb = envInt("WORKER_LEASE_HEARTBEAT_S", static_cast<int>(cfg.ttl.count() / 4));
+    cfg.heartbeat = std::chrono::seconds(std::clamp<int>(hb, 1, static_cast<int>(cfg.ttl.count() / 2)));
+    cfg.claimBatch = static_cast<size_t>(std::max(1, envInt("WORKER_LEASE_BATCH", 256)));
+    return cfg;
+}
+
+InboxLeases::InboxLeases(fs::path inboxDir, LeaseConfig cfg, ClaimedCallback onClaimed)
+    : inboxDir_(std::move(inboxDir)),
+      cfg_(std::move(cfg)),
+      onClaimed_(std::move(onClaimed)),
+      claimQueue_(100000) {}
+
+InboxLeases::~InboxLeases() {
+    stop();
+}
+
+void InboxLeases::start() {
+    if (started_ || !cfg_.enabled) return;
+    started_ = true;
+
+    auto& r = MetricsRegistry::instance();
+    r.gauge("worker_leases_held", "Inbox files this node currently holds a lease for", "",
+            [this] { return (double)held(); });
+    r.gauge("worker_cluster_nodes", "Worker nodes with a heartbeat younger than the lease TTL", "", [this] {
+        std::lock_guard lock(snapshotMutex_);
+        return (double)std::count_if(snapshot_.nodes.begin(), snapshot_.nodes.end(),
+                                     [](const LeaseNodeInfo& n) { return n.alive; });
+    });
+
+    heartbeatThread_ = std::thread(&InboxLeases::heartbeatWorker, this);
+    claimThread_ = std::thread(&InboxLeases::claimWorker, this);
+    qDebug() << "Cluster mode: node" << cfg_.node << "lease ttl:" << cfg_.ttl.count() << "s"
+             << "heartbeat:" << cfg_.heartbeat.count() << "s";
+}
+
+void InboxLeases::stop() {
+    if (!started_) return;
+    started_ = false;
+
+    claimQueue_.close();
+    claimQueue_.clear();
+    {
+        std::lock_guard lock(stopMutex_);
+        stopping_ = true;
+    }
+    stopCv_.notify_all();
+    claimThread_.join();
+    heartbeatThread_.join();
+
+    // Unbearbeitete Dateien nicht bis zum Ablauf der TTL blockieren
+    {
+        DbPool::Lease lease = DbPool::instance().acquire();
+        if (lease.isValid()) {
+            QSqlQuery q(lease.db());
+            q.prepare("DELETE FROM inbox_leases WHERE node = ?");
+            q.addBindValue(cfg_.node);
+            if (!q.exec()) qWarning() << "Dropping leases failed:" << q.lastError().text();
+            q.prepare("DELETE FROM worker_nodes WHERE node = ?");
+            q.addBindValue(cfg_.node);
+            if (!q.exec()) qWarning() << "Unregistering node failed:" << q.lastError().text();
+        }
+    }
+    DbPool::instance().releaseThread();
+
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    released_.clear();
+    owned_ = 0;
+    qDebug() << "Cluster mode stopped, leases released for" << cfg_.node;
+}
+
+// Pfade sind auf allen Knoten gleich, wenn sie relativ zur Inbox gespeichert werden
+std::string InboxLeases::keyFor(const fs::path& path) const {
+    return path.lexically_relative(inboxDir_).generic_string();
+}
+
+void InboxLeases::offer(const fs::path& path) {
+    std::string key = keyFor(path);
+    bool owned = false;
+    {
+        std::lock_guard lock(mutex_);
+        auto [it, inserted] = entries_.try_emplace(key);
+        Entry& e = it->second;
+        if (inserted) {
+            // Fertig gemeldet, aber noch da (z.B. Fehler) -> die Zeile gehört uns noch
+            if (released_.erase(key)) {
+                e = Entry{State::Owned, Clock::now(), {}};
+                owned_++;
+            }
+        } else if (e.state == State::Pending) {
+            return;
+        } else if (e.state == State::Foreign) {
+            if (Clock::now() < e.retryAt) return;
+            e.state = State::Pending;
+        }
+        owned = e.state == State::Owned;
+    }
+    if (owned) {
+        onClaimed_(path);   // Pipeline ignoriert Dateien, die schon in Arbeit sind
+        return;
+    }
+    claimQueue_.push(std::move(key));
+}
+
+void InboxLeases::release(const fs::path& path) {
+    std::string key = keyFor(path);
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.state != State::Owned) return;
+    entries_.erase(it);
+    owned_--;
+    released_.insert(std::move(key));
+}
+
+size_t InboxLeases::held() const {
+    std::lock_guard lock(mutex_);
+    return owned_ + released_.size();
+}
+
+LeaseSnapshot InboxLeases::snapshot() const {
+    std::lock_guard lock(snapshotMutex_);
+    return snapshot_;
+}
+
+// Gewonnene Zeilen übernehmen; nur neu gewonnene gehen an die Pipeline
+void InboxLeases::claimed(const std::vector<std::string>& keys, bool takeover) {
+    std::vector<fs::path> fresh;
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto& key : keys) {
+            Entry& e = entries_[key];
+            if (e.state == State::Owned) continue;
+            e = Entry{State::Owned, Clock::now(), {}};
+            owned_++;
+            released_.erase(key);
+            fresh.push_back(inboxDir_ / key);
+        }
+    }
+    for (const auto& path : fresh) {
+        std::error_code ec;
+        if (takeover && !fs::is_regular_file(path, ec)) {
+            // Toter Knoten hat die Datei noch verschoben, nur die Zeile blieb übrig
+            release(path);
+            continue;
+        }
+        onClaimed_(path);
+    }
+}
+
+// Offene Pfade sammeln und mit EINEM Statement beanspruchen
+void InboxLeases::claimWorker() {
+    std::vector<std::string> batch;
+    while (auto first = claimQueue_.pop()) {
+        batch.push_back(std::move(*first));
+        auto deadline = Clock::now() + cfg_.claimWindow;
+        while (batch.size() < cfg_.claimBatch) {
+            auto left = deadline - Clock::now();
+            if (left <= Clock::duration::zero()) break;
+            auto next = claimQueue_.popFor(left);
+            if (!next) break;
+            batch.push_back(std::move(*next));
+        }
+
+        std::vector<QString> paths;
+        paths.reserve(batch.size());
+        for (const auto& key : batch) paths.push_back(QString::fromStdString(key));
+
+        std::vector<std::string> won;
+        bool ok = false;
+        {
+            std::lock_guard order(dbOrder_);
+            ScopedTimer timer(metrics().claimSeconds);
+            DbPool::Lease lease = DbPool::instance().acquire();
+            if (lease.isValid()) {
+                // Frei, abgelaufen oder schon unsere -> gewonnen. Gleichzeitige Claims
+                // desselben Pfads warten auf den Unique-Index, nur einer bekommt die Zeile.
+                QSqlQuery& q = lease.prepared(
+                    "INSERT INTO inbox_leases (path, node, claimed_at, expires_at) "
+                    "SELECT p, ?, now(), now() + ? * interval '1 second' FROM unnest(?::text[]) AS p "
+                    "ON CONFLICT (path) DO UPDATE SET node = EXCLUDED.node, claimed_at = EXCLUDED.claimed_at, "
+                    "expires_at = EXCLUDED.expires_at "
+                    "WHERE inbox_leases.node = EXCLUDED.node OR inbox_leases.expires_at < now() "
+                    "RETURNING path");
+                q.bindValue(0, cfg_.node);
+                q.bindValue(1, static_cast<int>(cfg_.ttl.count()));
+                q.bindValue(2, KeywordCache::toPgArray(paths));
+                ok = q.exec();
+                if (ok) {
+                    while (q.next()) won.push_back(q.value(0).toString().toStdString());
+                    q.finish();
+                } else {
+                    qCritical() << "Lease claim failed:" << q.lastError().text();
+                    lease.markBroken();
+                }
+            }
+        }
+
+        if (!ok) {
+            // Beim nächsten Fund erneut versuchen
+            std::lock_guard lock(mutex_);
+            for (const auto& key : batch) {
+                auto it = entries_.find(key);
+                if (it != entries_.end() && it->second.state == State::Pending) entries_.erase(it);
+            }
+            batch.clear();
+            continue;
+        }
+
+        metrics().claimsWon.inc(won.size());
+        metrics().claimsLost.inc(batch.size() - won.size());
+        claimed(won, false);
+
+        // Rest hält ein anderer Knoten -> erst nach Ablauf seiner TTL wieder fragen
+        {
+            std::lock_guard lock(mutex_);
+            auto retryAt = Clock::now() + cfg_.ttl;
+            for (const auto& key : batch) {
+                auto it = entries_.find(key);
+                if (it != entries_.end() && it->second.state == State::Pending) {
+                    it->second.state = State::Foreign;
+                    it->second.retryAt = retryAt;
+                }
+            }
+        }
+        batch.clear();
+    }
+    DbPool::instance().releaseThread();
+}
+
+void InboxLeases::heartbeatWorker() {
+    while (true) {
+        {
+            ScopedTimer timer(metrics().heartbeatSeconds);
+            DbPool::Lease lease = DbPool::instance().acquire();
+            if (lease.isValid() && !heartbeat(lease)) lease.markBroken();
+        }
+        std::unique_lock lock(stopMutex_);
+        if (stopCv_.wait_for(lock, cfg_.heartbeat, [&] { return stopping_; })) break;
+    }
+    DbPool::instance().releaseThread();
+}
+
+// Eine Runde: Fertige löschen, eigene verlängern, Knoten melden,
+// Abgelaufene übernehmen, Übersicht für /status auffrischen
+bool InboxLeases::heartbeat(DbPool::Lease& lease) {
+    const int ttl = static_cast<int>(cfg_.ttl.count());
+    const auto roundStart = Clock::now();
+
+    // 1. Fertige Dateien freigeben
+    {
+        std::lock_guard order(dbOrder_);
+        std::vector<QString> done;
+        {
+            std::lock_guard lock(mutex_);
+            for (const auto& key : released_) done.push_back(QString::fromStdString(key));
+            released_.clear();
+        }
+        if (!done.empty()) {
+            QSqlQuery& q = lease.prepared("DELETE FROM inbox_leases WHERE node = ? AND path = ANY(?::text[])");
+            q.bindValue(0, cfg_.node);
+            q.bindValue(1, KeywordCache::toPgArray(done));
+            if (!q.exec()) {
+                qWarning() << "Releasing leases failed:" << q.lastError().text();
+                std::lock_guard lock(mutex_);
+                for (const auto& p : done) {
+                    std::string key = p.toStdString();
+                    if (!entries_.contains(key)) released_.insert(std::move(key));
+                }
+                return false;
+            }
+        }
+    }
+
+    // 2. Eigene Leases verlängern. Was fehlt, hat ein anderer Knoten übernommen
+    //    (wir waren länger als die TTL weg) -> melden, nicht mehr als eigen zählen.
+    QSqlQuery& qExtend = lease.prepared(
+        "UPDATE inbox_leases SET expires_at = now() + ? * interval '1 second' WHERE node = ? RETURNING path");
+    qExtend.bindValue(0, ttl);
+    qExtend.bindValue(1, cfg_.node);
+    if (!qExtend.exec()) {
+        qWarning() << "Lease heartbeat failed:" << qExtend.lastError().text();
+        return false;
+    }
+    std::unordered_set<std::string> extended;
+    while (qExtend.next()) extended.insert(qExtend.value(0).toString().toStdString());
+    qExtend.finish();
+    {
+        std::lock_guard lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            const Entry& e = it->second;
+            if (e.state == State::Owned && e.since < roundStart && !extended.contains(it->first)) {
+                qWarning() << "Lease lost to another node:" << QString::fromStdString(it->first);
+                metrics().lost.inc();
+                owned_--;
+                it = entries_.erase(it);
+            } else if (e.state == State::Foreign && e.retryAt < roundStart) {
+                it = entries_.erase(it);   // nicht mehr gemeldet -> vergessen
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // 3. Knoten melden
+    QSqlQuery& qNode = lease.prepared(
+        "INSERT INTO worker_nodes (node) VALUES (?) ON CONFLICT (node) DO UPDATE SET heartbeat_at = now()");
+    qNode.bindValue(0, cfg_.node);
+    if (!qNode.exec()) {
+        qWarning() << "Node heartbeat failed:" << qNode.lastError().text();
+        return false;
+    }
+
+    // 4. Abgelaufene Leases übernehmen. SKIP LOCKED: mehrere Knoten teilen sich
+    //    die Waisen, statt aufeinander zu warten.
+    QSqlQuery& qTake = lease.prepared(
+        "UPDATE inbox_leases l SET node = ?, claimed_at = now(), expires_at = now() + ? * interval '1 second', "
+        "takeovers = l.takeovers + 1 "
+        "FROM (SELECT path FROM inbox_leases WHERE expires_at < now() ORDER BY expires_at LIMIT ? "
+        "FOR UPDATE SKIP LOCKED) e "
+        "WHERE l.path = e.path RETURNING l.path");
+    qTake.bindValue(0, cfg_.node);
+    qTake.bindValue(1, ttl);
+    qTake.bindValue(2, static_cast<int>(cfg_.claimBatch));
+    if (!qTake.exec()) {
+        qWarning() << "Lease takeover failed:" << qTake.lastError().text();
+        return false;
+    }
+    std::vector<std::string> taken;
+    while (qTake.next()) taken.push_back(qTake.value(0).toString().toStdString());
+    qTake.finish();
+    if (!taken.empty()) {
+        qDebug() << "Took over" << taken.size() << "expired leases";
+        metrics().takeovers.inc(taken.size());
+        claimed(taken, true);
+    }
+
+    // 5. Übersicht; Knoten ohne Heartbeat und ohne Leases nach 10 TTL austragen
+    QSqlQuery& qPrune = lease.prepared(
+        "DELETE FROM worker_nodes n WHERE n.heartbeat_at < now() - ? * interval '1 second' "
+        "AND NOT EXISTS (SELECT 1 FROM inbox_leases l WHERE l.node = n.node)");
+    qPrune.bindValue(0, ttl * 10);
+    if (!qPrune.exec()) qWarning() << "Pruning nodes failed:" << qPrune.lastError().text();
+
+    LeaseSnapshot snap;
+    QSqlQuery& qNodes = lease.prepared(
+        "SELECT n.node, EXTRACT(EPOCH FROM now() - n.heartbeat_at), "
+        "(SELECT count(*) FROM inbox_leases l WHERE l.node = n.node) "
+        "FROM worker_nodes n ORDER BY n.node");
+    if (!qNodes.exec()) {
+        qWarning() << "Reading nodes failed:" << qNodes.lastError().text();
+        return false;
+    }
+    while (qNodes.next()) {
+        LeaseNodeInfo n;
+        n.node = qNodes.value(0).toString().toStdString();
+        n.heartbeatAgeSeconds = qNodes.value(1).toDouble();
+        n.leases = qNodes.value(2).toInt();
+        n.alive = n.heartbeatAgeSeconds < static_cast<double>(ttl);
+        snap.totalLeases += n.leases;
+        snap.nodes.push_back(std::move(n));
+    }
+    qNodes.finish();
+
+    QSqlQuery& qLeases = lease.prepared(
+        "SELECT path, node, EXTRACT(EPOCH FROM expires_at - now()) FROM inbox_leases ORDER BY claimed_at LIMIT ?");
+    qLeases.bindValue(0, static_cast<int>(SNAPSHOT_LEASES));
+    if (!qLeases.exec()) {
+        qWarning() << "Reading leases failed:" << qLeases.lastError().text();
+        return false;
+    }
+    while (qLeases.next()) {
+        snap.leases.push_back({qLeases.value(0).toString().toStdString(), qLeases.value(1).toString().toStdString(),
+                               qLeases.value(2).toDouble()});
+    }
+    qLeases.finish();
+
+    std::lock_guard lock(snapshotMutex_);
+    snapshot_ = std::move(snap);
+    return true;
+}
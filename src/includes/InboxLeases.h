@@ -0,0 +1,128 @@
+#pragma once
+#include <QString>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "BoundedQueue.h"
+#include "DbPool.h"
+
+// Mehrere Worker-Knoten an einer gemeinsamen Inbox (z.B. NFS):
+// WORKER_CLUSTER=lease, WORKER_NODE_ID (Default "<host>:<pid>"),
+// WORKER_LEASE_TTL_S, WORKER_LEASE_HEARTBEAT_S, WORKER_LEASE_BATCH
+struct LeaseConfig {
+    bool enabled = false;
+    QString node;
+    std::chrono::seconds ttl{60};
+    std::chrono::seconds heartbeat{15};       // Default: ttl / 4
+    size_t claimBatch = 256;                  // Pfade pro Claim-Statement
+    std::chrono::milliseconds claimWindow{50};
+
+    static LeaseConfig fromEnvironment();
+};
+
+// Für /status
+struct LeaseNodeInfo {
+    std::string node;
+    int leases = 0;
+    double heartbeatAgeSeconds = 0;
+    bool alive = false;   // letzter Heartbeat jünger als die TTL
+};
+
+struct LeaseInfo {
+    std::string path;     // relativ zur Inbox
+    std::string node;
+    double expiresInSeconds = 0;
+};
+
+struct LeaseSnapshot {
+    std::vector<LeaseNodeInfo> nodes;
+    std::vector<LeaseInfo> leases;   // höchstens SNAPSHOT_LEASES, älteste zuerst
+    int totalLeases = 0;
+};
+
+// Koordination über die Tabelle inbox_leases: ein Knoten bearbeitet eine
+// Inbox-Datei nur, wenn er ihre Zeile hält.
+// - Claim: gesammelt per INSERT ... ON CONFLICT, gewinnt nur, wenn frei oder abgelaufen
+// - Heartbeat: verlängert alle eigenen Leases mit einem UPDATE
+// - Übernahme: abgelaufene Leases toter Knoten per FOR UPDATE SKIP LOCKED
+// - Fertig (verschoben/verworfen/fehlgeschlagen): Zeile wird gelöscht
+class InboxLeases {
+public:
+    static constexpr size_t SNAPSHOT_LEASES = 200;
+
+    using ClaimedCallback = std::function<void(const std::filesystem::path&)>;
+
+    InboxLeases(std::filesystem::path inboxDir, LeaseConfig cfg, ClaimedCallback onClaimed);
+    ~InboxLeases();
+
+    InboxLeases(const InboxLeases&) = delete;
+    InboxLeases& operator=(const InboxLeases&) = delete;
+
+    bool enabled() const { return cfg_.enabled; }
+    const QString& node() const { return cfg_.node; }
+
+    void start();
+
+    // Nach IngestPipeline::stop(): eigene Leases und Knoten-Eintrag löschen,
+    // liegengebliebene Dateien sind damit sofort für andere frei
+    void stop();
+
+    // Discovery: eigene Datei -> sofort weiter, fremde erst nach Ablauf
+    // der TTL wieder versuchen, sonst zum nächsten Claim-Batch
+    void offer(const std::filesystem::path& path);
+
+    // Pipeline ist mit der Datei fertig; gelöscht wird beim nächsten Heartbeat
+    void release(const std::filesystem::path& path);
+
+    size_t held() const;
+    LeaseSnapshot snapshot() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class State { Pending, Owned, Foreign };
+    struct Entry {
+        State state = State::Pending;
+        Clock::time_point since;     // Owned: seit wann (Heartbeat erkennt verlorene Leases)
+        Clock::time_point retryAt;   // Foreign: frühestens dann erneut versuchen
+    };
+
+    std::string keyFor(const std::filesystem::path& path) const;
+    void claimWorker();
+    void heartbeatWorker();
+    bool heartbeat(DbPool::Lease& lease);
+    void claimed(const std::vector<std::string>& keys, bool takeover);
+
+    const std::filesystem::path inboxDir_;
+    const LeaseConfig cfg_;
+    ClaimedCallback onClaimed_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;   // Schlüssel relativ zur Inbox
+    std::unordered_set<std::string> released_;   // fertig, Zeile noch nicht gelöscht
+    size_t owned_ = 0;
+
+    // Claim und Löschen der fertigen Zeilen nie gleichzeitig: sonst könnte ein
+    // DELETE eine gerade neu beanspruchte Zeile treffen
+    std::mutex dbOrder_;
+
+    BoundedQueue<std::string> claimQueue_;
+
+    mutable std::mutex snapshotMutex_;
+    LeaseSnapshot snapshot_;
+
+    std::mutex stopMutex_;
+    std::condition_variable stopCv_;
+    bool stopping_ = false;
+
+    std::thread claimThread_;
+    std::thread heartbeatThread_;
+    bool started_ = false;
+};
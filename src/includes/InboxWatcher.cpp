@@ -0,0 +1,231 @@
+#include "InboxWatcher.h"
+#include "IoUring.h"
+#include <QDebug>
+#include <QString>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Nur "fertige" Dateien interessieren uns, halb hochgeladene Dateien
+// lösen noch kein IN_CLOSE_WRITE aus.
+static constexpr uint32_t WATCH_MASK =
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// So lange müssen Größe und mtime einer vorgefundenen Datei unverändert bleiben
+static constexpr std::chrono::seconds SETTLE_DELAY{2};
+
+InboxWatcher::InboxWatcher(fs::path root, FileCallback onFile)
+    : root_(std::move(root)), onFile_(std::move(onFile)) {}
+
+InboxWatcher::~InboxWatcher() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool InboxWatcher::init() {
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        qWarning() << "inotify_init1 failed:" << std::strerror(errno);
+        return false;
+    }
+    std::error_code ec;
+    fs::create_directories(root_, ec);
+    return true;
+}
+
+void InboxWatcher::addWatch(const fs::path& dir) {
+    int wd = inotify_add_watch(fd_, dir.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        // ENOSPC -> fs.inotify.max_user_watches zu klein
+        qWarning() << "inotify_add_watch failed for" << QString::fromStdString(dir.string())
+                   << ":" << std::strerror(errno);
+        return;
+    }
+    watches_[wd] = dir;
+}
+
+// statx für viele Pfade: mit io_uring als ein Batch, sonst einzeln
+static void statBatch(const std::vector<fs::path>& paths, int flags, std::vector<struct statx>& out,
+                      std::vector<int>& res) {
+    out.assign(paths.size(), {});
+    res.assign(paths.size(), 0);
+    IoUring* ring = IoUring::forThread();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (ring) ring->statx(paths[i].c_str(), flags, STATX_TYPE, &out[i], &res[i]);
+        else res[i] = ::statx(AT_FDCWD, paths[i].c_str(), flags, STATX_TYPE, &out[i]) == 0 ? 0 : -errno;
+    }
+    if (ring && !ring->submit()) {
+        // Ring ausgefallen: was der Kernel nicht ausgeführt hat, synchron nachholen
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (res[i] == -ECANCELED) res[i] = ::statx(AT_FDCWD, paths[i].c_str(), flags, STATX_TYPE, &out[i]) == 0 ? 0 : -errno;
+        }
+    }
+}
+
+// Watches für dir und alle Unterordner setzen und vorhandene Dateien melden.
+// Der Watch wird VOR dem Auflisten gesetzt, damit keine Datei zwischen
+// Scan und Watch verloren geht (Doppelmeldungen sind harmlos).
+// settleFiles: Ordner ist zur Laufzeit entstanden, darin kann gerade noch
+// geschrieben werden (mkdir x && cp big.jpg x/) -> Dateien erst nach settle().
+// Der Typ kommt aus d_type; nur wo das Dateisystem ihn nicht liefert
+// (DT_UNKNOWN, typisch für Netzwerk-Mounts) wird pro Verzeichnis gesammelt gestatet.
+void InboxWatcher::scanDirectory(const fs::path& dir, bool settleFiles) {
+    auto report = [&](const fs::path& p) {
+        if (settleFiles) settle(p);
+        else onFile_(p);
+    };
+    std::vector<fs::path> pending{dir};
+    std::vector<fs::path> unknown, links;
+    std::vector<struct statx> stx;
+    std::vector<int> res;
+
+    while (!pending.empty()) {
+        fs::path current = std::move(pending.back());
+        pending.pop_back();
+        addWatch(current);
+
+        DIR* d = ::opendir(current.c_str());
+        if (!d) continue;   // z.B. keine Berechtigung -> überspringen
+        while (dirent* e = ::readdir(d)) {
+            if (std::strcmp(e->d_name, ".") == 0 || std::strcmp(e->d_name, "..") == 0) continue;
+            fs::path p = current / e->d_name;
+            switch (e->d_type) {
+                case DT_DIR:     pending.push_back(std::move(p)); break;
+                case DT_REG:     report(p); break;
+                case DT_LNK:     links.push_back(std::move(p)); break;
+                case DT_UNKNOWN: unknown.push_back(std::move(p)); break;
+                default:         break;
+            }
+        }
+        ::closedir(d);
+
+        if (!unknown.empty()) {
+            statBatch(unknown, AT_SYMLINK_NOFOLLOW, stx, res);
+            for (size_t i = 0; i < unknown.size(); ++i) {
+                if (res[i] < 0) continue;
+                if (S_ISDIR(stx[i].stx_mode)) pending.push_back(std::move(unknown[i]));
+                else if (S_ISREG(stx[i].stx_mode)) report(unknown[i]);
+                else if (S_ISLNK(stx[i].stx_mode)) links.push_back(std::move(unknown[i]));
+            }
+            unknown.clear();
+        }
+        // Symlinks: nur Dateien melden, verlinkten Ordnern nicht folgen
+        if (!links.empty()) {
+            statBatch(links, 0, stx, res);
+            for (size_t i = 0; i < links.size(); ++i) {
+                if (res[i] == 0 && S_ISREG(stx[i].stx_mode)) report(links[i]);
+            }
+            links.clear();
+        }
+    }
+}
+
+// Größe + mtime merken, reportSettled() meldet die Datei, sobald beides stehen bleibt
+void InboxWatcher::settle(const fs::path& file) {
+    struct stat st{};
+    if (::stat(file.c_str(), &st) != 0) return;
+    const int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+    unsettled_.insert_or_assign(file.string(), Unsettled{st.st_size, mtimeNs, std::chrono::steady_clock::now() + SETTLE_DELAY});
+}
+
+void InboxWatcher::reportSettled() {
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = unsettled_.begin(); it != unsettled_.end();) {
+        Unsettled& u = it->second;
+        if (u.checkAt > now) {
+            ++it;
+            continue;
+        }
+        struct stat st{};
+        if (::stat(it->first.c_str(), &st) != 0) {   // weg (verschoben, gelöscht)
+            it = unsettled_.erase(it);
+            continue;
+        }
+        const int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+        if (st.st_size != u.size || mtimeNs != u.mtimeNs) {
+            // Wird noch geschrieben -> erneut warten
+            u = {st.st_size, mtimeNs, now + SETTLE_DELAY};
+            ++it;
+            continue;
+        }
+        onFile_(it->first);
+        it = unsettled_.erase(it);
+    }
+}
+
+// Vollständiger Abgleich: beim Start und nach einem Queue-Overflow.
+// Meldet sofort (wie das Polling): vor dem Start geschriebene Dateien sind fertig
+void InboxWatcher::reconcile() {
+    for (const auto& [wd, path] : watches_) inotify_rm_watch(fd_, wd);
+    watches_.clear();
+    scanDirectory(root_, false);
+    qDebug() << "Inbox reconciled, watching" << watches_.size() << "directories";
+}
+
+void InboxWatcher::readEvents() {
+    alignas(inotify_event) char buf[64 * 1024];
+
+    while (true) {
+        ssize_t len = ::read(fd_, buf, sizeof(buf));
+        if (len <= 0) return; // EAGAIN -> alles gelesen
+
+        bool overflow = false;
+        for (char* ptr = buf; ptr < buf + len; ) {
+            auto* ev = reinterpret_cast<inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            if (ev->mask & IN_IGNORED) {
+                watches_.erase(ev->wd);
+                continue;
+            }
+
+            auto it = watches_.find(ev->wd);
+            if (it == watches_.end() || ev->len == 0) continue;
+            fs::path p = it->second / ev->name;
+
+            if (ev->mask & IN_ISDIR) {
+                // Neuer (oder hineinverschobener) Ordner: rekursiv aufnehmen,
+                // vorgefundene Dateien erst, wenn sie fertig aussehen
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO)) scanDirectory(p, true);
+            } else if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                unsettled_.erase(p.string());
+                onFile_(p);
+            }
+        }
+
+        if (overflow) {
+            qWarning() << "inotify queue overflow, running full rescan";
+            reconcile();
+        }
+    }
+}
+
+void InboxWatcher::run(const std::atomic<bool>& running) {
+    reconcile();
+
+    pollfd pfd{fd_, POLLIN, 0};
+    while (running) {
+        // Timeout, damit isRunning regelmäßig geprüft wird
+        int rc = ::poll(&pfd, 1, 500);
+        if (rc > 0 && (pfd.revents & POLLIN)) readEvents();
+        if (!unsettled_.empty()) reportSettled();
+
+        // Inbox selbst wurde gelöscht/verschoben -> neu anlegen
+        if (watches_.empty()) {
+            std::error_code ec;
+            fs::create_directories(root_, ec);
+            reconcile();
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// Event-basierte Überwachung des Inbox-Ordners (Linux inotify).
+// Meldet nur fertig geschriebene Dateien (IN_CLOSE_WRITE / IN_MOVED_TO),
+// neue Unterordner werden automatisch mit überwacht.
+class InboxWatcher {
+public:
+    using FileCallback = std::function<void(const std::filesystem::path&)>;
+
+    InboxWatcher(std::filesystem::path root, FileCallback onFile);
+    ~InboxWatcher();
+
+    InboxWatcher(const InboxWatcher&) = delete;
+    InboxWatcher& operator=(const InboxWatcher&) = delete;
+
+    // false -> inotify nicht verfügbar (Aufrufer fällt auf Polling zurück)
+    bool init();
+
+    // Blockiert, bis running == false. Macht zuerst einen vollständigen Abgleich.
+    void run(const std::atomic<bool>& running);
+
+private:
+    struct Unsettled {
+        int64_t size;
+        int64_t mtimeNs;
+        std::chrono::steady_clock::time_point checkAt;
+    };
+
+    void addWatch(const std::filesystem::path& dir);
+    void scanDirectory(const std::filesystem::path& dir, bool settleFiles);
+    void settle(const std::filesystem::path& file);
+    void reportSettled();
+    void reconcile();
+    void readEvents();
+
+    std::filesystem::path root_;
+    FileCallback onFile_;
+    int fd_ = -1;
+    std::unordered_map<int, std::filesystem::path> watches_;
+    // In neu angelegten Ordnern vorgefundene Dateien: erst melden, wenn Größe
+    // und mtime eine Weile gleich bleiben (oder IN_CLOSE_WRITE kommt)
+    std::unordered_map<std::string, Unsettled> unsettled_;
+};
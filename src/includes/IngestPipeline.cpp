@@ -0,0 +1,770 @@
+#include "IngestPipeline.h"
+#include "Metrics.h"
+#include "ReverseGeocoder.h"
+#include "Tracer.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+// Prometheus-Metriken der Pipeline, einmalig registriert
+struct PipelineMetrics {
+    MetricHistogram& hashSeconds;
+    MetricHistogram& extractSeconds;
+    MetricHistogram& moveSeconds;
+    MetricHistogram& dbTransactionSeconds;
+    MetricHistogram& geocodeSeconds;
+    MetricHistogram& phashSeconds;
+    MetricHistogram& phashSearchSeconds;
+    MetricCounter& nearDuplicates;
+    MetricCounter& geocoded;
+    MetricCounter& files;
+    MetricCounter& bytes;
+    MetricCounter& duplicates;
+    MetricCounter& duplicatesDeferred;
+    MetricCounter& failedExtract;
+    MetricCounter& failedMove;
+    MetricCounter& failedDb;
+    MetricCounter& failedLinks;
+    MetricHistogram& derivativeSeconds;
+    MetricCounter& derivatives;
+    MetricCounter& derivativesQueueFull;
+    MetricCounter& derivativesUnsupported;
+    MetricCounter& derivativesFailed;
+    MetricCounter& outboxRetries;
+    MetricCounter& outboxRejected;
+};
+
+static PipelineMetrics& metrics() {
+    static PipelineMetrics m = [] {
+        auto& r = MetricsRegistry::instance();
+        const char* failHelp = "Files that failed, by pipeline stage";
+        const char* skipHelp = "Photos without derivatives, by reason";
+        return PipelineMetrics{
+            r.histogram("worker_hash_seconds", "Content hash time per file"),
+            r.histogram("worker_extract_seconds", "Metadata extraction time per file"),
+            r.histogram("worker_move_seconds", "Time to move a file into the photo library"),
+            r.histogram("worker_db_transaction_seconds", "Duration of one DB batch transaction"),
+            r.histogram("worker_geocode_seconds", "Offline reverse geocoding time per file with GPS",
+                        "", {0.000001, 0.0000025, 0.000005, 0.00001, 0.000025, 0.00005, 0.0001, 0.001}),
+            r.histogram("worker_phash_seconds", "Scaled JPEG decode and perceptual hash per file",
+                        "", {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1}),
+            r.histogram("worker_phash_search_seconds", "Near-duplicate lookup in the perceptual hash index",
+                        "", {0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.005}),
+            r.counter("worker_near_duplicates_total", "Candidate near-duplicate pairs recorded"),
+            r.counter("worker_geocoded_total", "Files whose location fields were filled from GPS"),
+            r.counter("worker_files_stored_total", "Files stored in the database"),
+            r.counter("worker_bytes_stored_total", "Bytes of files stored in the database"),
+            r.counter("worker_duplicates_total", "Uploads detected as exact duplicates"),
+            r.counter("worker_duplicates_deferred_total", "Uploads requeued because the same content was still in flight"),
+            r.counter("worker_failures_total", failHelp, R"(reason="extract")"),
+            r.counter("worker_failures_total", failHelp, R"(reason="move")"),
+            r.counter("worker_failures_total", failHelp, R"(reason="db")"),
+            r.counter("worker_failures_total", failHelp, R"(reason="links")"),
+            r.histogram("worker_derivative_seconds", "Time to decode, resize and write all derivatives of one photo"),
+            r.counter("worker_derivatives_total", "Photos with derivatives written"),
+            r.counter("worker_derivatives_skipped_total", skipHelp, R"(reason="queue_full")"),
+            r.counter("worker_derivatives_skipped_total", skipHelp, R"(reason="unsupported")"),
+            r.counter("worker_derivatives_skipped_total", skipHelp, R"(reason="failed")"),
+            r.counter("worker_outbox_retries_total", "Outbox records returned for another DB attempt"),
+            r.counter("worker_outbox_rejected_total", "Outbox records given up after repeated DB errors"),
+        };
+    }();
+    return m;
+}
+
+// Welches Dateinamen-Muster das Datum geliefert hat (Index wie FilenameDatePatterns::names)
+static MetricCounter& filenameDateCounter(size_t patternIndex) {
+    static const std::vector<MetricCounter*> counters = [] {
+        std::vector<MetricCounter*> c;
+        for (std::string_view name : FilenameDatePatterns::names) {
+            c.push_back(&MetricsRegistry::instance().counter(
+                "worker_filename_dates_total", "Capture dates taken from the file name, by pattern",
+                "pattern=\"" + std::string(name) + "\""));
+        }
+        return c;
+    }();
+    return *counters[patternIndex];
+}
+
+// Helper: Integer aus Umgebungsvariable, sonst Default
+static int envInt(const char* name, int defaultValue) {
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+PipelineConfig PipelineConfig::fromEnvironment(const fs::path& inboxDir, const fs::path& photosRoot) {
+    PipelineConfig cfg;
+    cfg.inboxDir = inboxDir;
+    cfg.photosRoot = photosRoot;
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    cfg.extractThreads = std::max(1, envInt("WORKER_EXTRACT_THREADS", cores > 0 ? cores : 1));
+    cfg.moveThreads    = std::max(1, envInt("WORKER_MOVE_THREADS", 1));
+    cfg.dbThreads      = std::max(1, envInt("WORKER_DB_THREADS", 1));
+    cfg.queueCapacity  = static_cast<size_t>(std::max(1, envInt("WORKER_QUEUE_CAPACITY", 256)));
+
+    cfg.dbBatchSize    = static_cast<size_t>(std::max(1, envInt("WORKER_DB_BATCH_SIZE", 64)));
+    cfg.dbBatchWindow  = std::chrono::milliseconds(std::max(0, envInt("WORKER_DB_BATCH_MS", 200)));
+    // "rollback": ganzer Batch scheitert gemeinsam, "isolate": nur fehlerhafte Zeilen
+    cfg.dbBatchMode    = qEnvironmentVariable("WORKER_DB_BATCH_MODE", "isolate") == "rollback"
+                         ? BatchFailureMode::Rollback : BatchFailureMode::Isolate;
+    cfg.outbox         = OutboxConfig::fromEnvironment();
+
+    cfg.moveBatchSize  = static_cast<size_t>(std::max(1, envInt("WORKER_MOVE_BATCH", 32)));
+    cfg.move           = MoveOptions::fromEnvironment();
+
+    cfg.duplicatePolicy = DuplicateIndex::policyFromEnvironment();
+    cfg.phash = PerceptualHashConfig::fromEnvironment();
+    cfg.scheduler = SchedulerConfig::fromEnvironment();
+
+    cfg.derivativeThreads       = std::max(0, envInt("WORKER_DERIVATIVE_THREADS", 0));
+    cfg.derivativeQueueCapacity = static_cast<size_t>(std::max(1, envInt("WORKER_DERIVATIVE_QUEUE", 4096)));
+    if (cfg.derivativeThreads > 0) cfg.derivatives = DerivativeConfig::fromEnvironment();
+    return cfg;
+}
+
+IngestPipeline::IngestPipeline(PipelineConfig cfg)
+    : cfg_(std::move(cfg)),
+      scheduler_(cfg_.scheduler),
+      moveQueue_(cfg_.queueCapacity),
+      dbQueue_(cfg_.queueCapacity),
+      derivativeQueue_(cfg_.derivativeQueueCapacity),
+      derivatives_(cfg_.derivatives) {}
+
+IngestPipeline::~IngestPipeline() {
+    stop();
+}
+
+void IngestPipeline::start() {
+    if (started_) return;
+    started_ = true;
+
+    // Offene Einträge vom letzten Lauf werden gleich mit abgearbeitet
+    outbox_.reset();
+    if (cfg_.outbox.enabled) {
+        outbox_ = std::make_unique<Outbox>(cfg_.outbox);
+        if (!outbox_->open()) {
+            qCritical() << "Outbox unusable, writing directly to the database.";
+            outbox_.reset();
+        }
+    }
+    auto dbStage = outbox_ ? &IngestPipeline::drainWorker : &IngestPipeline::dbWorker;
+
+    for (int i = 0; i < cfg_.extractThreads; ++i) extractThreads_.emplace_back(&IngestPipeline::extractWorker, this);
+    for (int i = 0; i < cfg_.moveThreads; ++i)    moveThreads_.emplace_back(&IngestPipeline::moveWorker, this);
+    for (int i = 0; i < cfg_.dbThreads; ++i)      dbThreads_.emplace_back(dbStage, this);
+    for (int i = 0; i < cfg_.derivativeThreads; ++i)
+        derivativeThreads_.emplace_back(&IngestPipeline::derivativeWorker, this);
+
+    // Backlog wird erst beim Scrape gelesen
+    auto& r = MetricsRegistry::instance();
+    const char* backlogHelp = "Files waiting in front of a pipeline stage";
+    r.gauge("worker_backlog", backlogHelp, R"(stage="extract")", [this] { return (double)extractBacklog(); });
+    r.gauge("worker_backlog", backlogHelp, R"(stage="move")", [this] { return (double)moveBacklog(); });
+    r.gauge("worker_backlog", backlogHelp, R"(stage="db")", [this] { return (double)dbBacklog(); });
+    r.gauge("worker_backlog", backlogHelp, R"(stage="derivatives")", [this] { return (double)derivativeBacklog(); });
+    r.gauge("worker_scheduler_users", "Users with files waiting in the fair-share scheduler", "",
+            [this] { return (double)scheduler_.activeUsers(); });
+    r.gauge("worker_in_flight", "Files accepted from the inbox and not yet stored", "", [this] {
+        std::lock_guard lock(inFlightMutex_);
+        return (double)inFlight_.size();
+    });
+    if (outbox_) {
+        r.gauge("worker_outbox_records", "Moved files logged in the outbox and not yet stored", "",
+                [this] { return (double)outbox_->backlog(); });
+        r.gauge("worker_outbox_bytes", "Size of the outbox segments on disk", "",
+                [this] { return (double)outbox_->bytesOnDisk(); });
+    }
+
+    qDebug() << "Pipeline started. extract:" << cfg_.extractThreads
+             << "move:" << cfg_.moveThreads << "db:" << cfg_.dbThreads
+             << "queue:" << cfg_.queueCapacity
+             << "db batch:" << cfg_.dbBatchSize << "/" << cfg_.dbBatchWindow.count() << "ms"
+             << "derivatives:" << cfg_.derivativeThreads
+             << "outbox:" << (outbox_ ? QString::fromStdString(cfg_.outbox.dir.string()) : QString("off"));
+}
+
+// Herunterfahren: Noch nicht verschobene Dateien bleiben in der Inbox liegen
+// und werden beim nächsten Start erneut gefunden. Bereits verschobene Dateien
+// müssen dagegen noch in die DB -> die DB-Queue wird vollständig abgearbeitet.
+// Mit Outbox bleibt der Rest im Log und wird beim nächsten Start geschrieben.
+// Offene Derivate werden verworfen (die Fotos sind dann ohne Thumbnails).
+void IngestPipeline::stop() {
+    if (!started_) return;
+    started_ = false;
+
+    scheduler_.close();
+    scheduler_.clear();
+    moveQueue_.close();
+    moveQueue_.clear();
+    for (auto& t : extractThreads_) t.join();
+    for (auto& t : moveThreads_) t.join();
+
+    dbQueue_.close();
+    if (outbox_) outbox_->close();
+    for (auto& t : dbThreads_) t.join();
+    DuplicateIndex::instance().cancelWaiters(this);
+
+    derivativeQueue_.close();
+    derivativeQueue_.clear();
+    for (auto& t : derivativeThreads_) t.join();
+
+    extractThreads_.clear();
+    moveThreads_.clear();
+    dbThreads_.clear();
+    derivativeThreads_.clear();
+    qDebug() << "Pipeline stopped. stored:" << counters_.stored.load();
+}
+
+void IngestPipeline::submit(const fs::path& srcPath) {
+    std::string user = parseFilename(srcPath.filename().string()).user;
+    {
+        std::lock_guard lock(inFlightMutex_);
+        if (!inFlight_.try_emplace(srcPath.string(), user).second) return;
+    }
+    counters_.discovered++;
+    if (!scheduler_.push(user, srcPath)) {
+        std::lock_guard lock(inFlightMutex_);
+        inFlight_.erase(srcPath.string());
+    }
+}
+
+bool IngestPipeline::store(WorkerPayload payload) {
+    counters_.discovered++;
+    return forwardToDb(std::move(payload));
+}
+
+// Über die Outbox (kehrt nach dem fsync zurück) oder direkt in die DB-Queue
+bool IngestPipeline::forwardToDb(WorkerPayload&& payload) {
+    if (!outbox_) return dbQueue_.push(std::move(payload));
+    std::vector<WorkerPayload> one;
+    one.push_back(std::move(payload));
+    return outbox_->append(one);
+}
+
+// Datei ist aus Extraktion/Verschieben raus -> Platz im Benutzer-Limit frei
+void IngestPipeline::release(const fs::path& srcPath) {
+    std::string user;
+    {
+        std::lock_guard lock(inFlightMutex_);
+        auto it = inFlight_.find(srcPath.string());
+        if (it == inFlight_.end()) return;
+        user = std::move(it->second);
+        inFlight_.erase(it);
+    }
+    scheduler_.finished(user);
+    if (releaseHook_) releaseHook_(srcPath);
+}
+
+// Upload-Ordner relativ zur Inbox: "uploads/2023/Sommer/img.jpg" -> "2023/Sommer"
+// Rein lexikalisch: Watcher/Polling liefern Pfade unterhalb von inboxDir, fs::relative()
+// würde jede Pfadkomponente per stat auflösen.
+static fs::path uploadStructure(const fs::path& srcPath, const fs::path& inboxDir) {
+    return srcPath.lexically_relative(inboxDir).parent_path();
+}
+
+// Stufe 2: Hash prüfen, Name parsen, Metadaten lesen, Datum bestimmen
+void IngestPipeline::extractWorker() {
+    Tracer::nameThread("extract");
+    while (auto scheduled = scheduler_.pop()) {
+        const fs::path* srcPath = &scheduled->path;
+        ContentHash reserved;
+        try {
+            // Kann doppelt gemeldet werden (Abgleich + Event) -> schon verschoben?
+            std::string rawName = srcPath->filename().string();
+            TraceFileScope traceFile(rawName, scheduled->user);
+            TraceSpan span("extract", "extract");
+            if (rawName.starts_with(".") || !fs::is_regular_file(*srcPath)) {
+                release(*srcPath);
+                continue;
+            }
+
+            ExtractedItem item;
+            item.srcPath = *srcPath;
+
+            // 1. Name Parsen
+            item.fileInfo = parseFilename(rawName);
+
+            // 2. Exakte Duplikate erkennen, BEVOR Exiv2 die Datei anfasst
+            {
+                ScopedTimer timer(metrics().hashSeconds);
+                TraceSpan hashSpan("hash", "extract");
+                item.hash = ContentHash::ofFile(*srcPath);
+            }
+            if (outbox_) {
+                // Outbox-Eintrag entsteht vor dem Verschieben (statx im Move-Batch kommt zu spät)
+                std::error_code ec;
+                const auto size = fs::file_size(*srcPath, ec);
+                if (!ec) item.size = size;
+            }
+            if (item.hash.valid) {
+                auto existing = DuplicateIndex::instance().findOrReserve(item.hash);
+                if (!existing) {
+                    reserved = item.hash;
+                } else if (*existing == 0) {
+                    deferDuplicate(*scheduled, item.hash);
+                    continue;
+                } else if (handleDuplicate(item, *existing)) {
+                    release(*srcPath);
+                    continue;
+                }
+            }
+
+            // 3. Metadaten lesen
+            {
+                ScopedTimer timer(metrics().extractSeconds);
+                TraceSpan metaSpan("metadata", "extract");
+                item.meta = MetadataExtractor::extract(srcPath->string());
+            }
+
+            // 4. Fehlende Ortsangaben offline aus den GPS-Koordinaten ergänzen
+            const ReverseGeocoder& geo = ReverseGeocoder::instance();
+            if (geo.isLoaded() && (item.meta.gpsLat != 0.0 || item.meta.gpsLon != 0.0)) {
+                ScopedTimer timer(metrics().geocodeSeconds);
+                TraceSpan geoSpan("geocode", "extract");
+                if (geo.fill(item.meta)) metrics().geocoded.inc();
+            }
+
+            // 5. Perceptual Hash aus einer 1/8-Dekodierung (Nicht-JPEG -> ohne)
+            if (cfg_.phash.enabled) {
+                ScopedTimer timer(metrics().phashSeconds);
+                TraceSpan phashSpan("phash", "extract");
+                item.phash = PerceptualHash::ofFile(*srcPath);
+            }
+
+            // 6. Datum ermitteln (Kaskade)
+            if (item.meta.takenAt.isValid()) {
+                item.fileDate = item.meta.takenAt;
+            } else {
+                auto named = matchFilenameDate(item.fileInfo.cleanName);
+                if (named) {
+                    item.fileDate = toDateTime(*named);
+                    filenameDateCounter(named->patternIndex).inc();
+                }
+                if (!item.fileDate.isValid()) item.fileDate = getFileLastModified(*srcPath);
+            }
+
+            counters_.extracted++;
+            if (!moveQueue_.push(std::move(item))) {
+                DuplicateIndex::instance().release(reserved);
+                release(*srcPath);
+            }
+
+        } catch (const std::exception& e) {
+            counters_.failed++;
+            metrics().failedExtract.inc();
+            DuplicateIndex::instance().release(reserved);
+            release(*srcPath);
+            qCritical() << "Error extracting file:" << e.what();
+        }
+    }
+}
+
+// Duplikat gemäß Policy behandeln. true -> Datei ist erledigt,
+// false -> normal weiterverarbeiten (Policy "replace").
+bool IngestPipeline::handleDuplicate(ExtractedItem& item, qint64 existingId) {
+    if (cfg_.duplicatePolicy == DuplicatePolicy::Replace) {
+        item.replaceExisting = true;
+        return false;
+    }
+
+    counters_.duplicates++;
+    metrics().duplicates.inc();
+    qDebug() << "Duplicate of picture" << existingId << ":" << QString::fromStdString(item.srcPath.string());
+
+    if (cfg_.duplicatePolicy == DuplicatePolicy::Link) {
+        WorkerPayload payload;
+        payload.filename    = item.fileInfo.cleanName;
+        payload.relPath     = uploadStructure(item.srcPath, cfg_.inboxDir).string();
+        payload.user        = item.fileInfo.user;
+        payload.fileSize    = static_cast<long long>(fs::file_size(item.srcPath));
+        payload.contentHash = item.hash.toHex();
+        payload.linkOnly    = true;
+        if (!forwardToDb(std::move(payload))) return true;   // Upload bleibt liegen
+    }
+
+    fs::remove(item.srcPath);
+    return true;
+}
+
+// Gleicher Inhalt ist gerade selbst in Arbeit (noch ohne Picture-ID): skip/link
+// würden den Upload verwerfen bzw. auf ein Foto verweisen, das vielleicht nie
+// gespeichert wird. Die Datei bleibt deshalb in der Inbox und in Arbeit (keine
+// Doppelmeldung, Lease bleibt) und wird neu eingereiht, sobald das Original
+// gespeichert oder gescheitert ist. Dann greift die Policy gegen die echte ID,
+// oder der Upload wird selbst zum Original.
+void IngestPipeline::deferDuplicate(const ScheduledFile& file, const ContentHash& hash) {
+    metrics().duplicatesDeferred.inc();
+    auto requeue = [this, file] {
+        // Geschlossen -> Herunterfahren: Datei bleibt liegen, der nächste Start findet sie
+        if (!scheduler_.requeue(file.user, file.path)) release(file.path);
+    };
+    if (!DuplicateIndex::instance().whenSettled(hash, this, requeue)) requeue();
+}
+
+// Stufe 3: In die Photos-Struktur verschieben.
+// Mehrere Dateien pro Durchlauf, damit die Verzeichnis-fsyncs nur einmal anfallen.
+void IngestPipeline::moveWorker() {
+    Tracer::nameThread("move");
+    FileMover mover(cfg_.move);
+    std::vector<ExtractedItem> batch;
+    std::vector<WorkerPayload> moved;
+    std::vector<fs::path> movedSources;
+
+    while (auto first = moveQueue_.pop()) {
+        // Nur nehmen, was schon wartet -> kein zusätzliches Warten pro Datei
+        batch.push_back(std::move(*first));
+        while (batch.size() < cfg_.moveBatchSize) {
+            auto next = moveQueue_.popFor(std::chrono::milliseconds(0));
+            if (!next) break;
+            batch.push_back(std::move(*next));
+        }
+
+        // Ziele bestimmen; Anlegen der Ordner, statx und rename laufen gesammelt
+        std::vector<MoveRequest> requests(batch.size());
+        std::vector<WorkerPayload> payloads(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            ExtractedItem& item = batch[i];
+            // Wir spiegeln die Ordnerstruktur aus "uploads": "Photos/2023/Sommer/<name>"
+            fs::path relPath = uploadStructure(item.srcPath, cfg_.inboxDir);
+            requests[i].src = item.srcPath;
+            requests[i].dest = cfg_.photosRoot / relPath / item.fileInfo.cleanName;
+            requests[i].expected = item.hash;
+
+            WorkerPayload& payload = payloads[i];
+            payload.filename = item.fileInfo.cleanName;
+            // In der DB speichern wir den relativen Pfad (z.B. "2023/Sommer")
+            payload.relPath  = relPath.string();
+            payload.fullPath = requests[i].dest.string();
+            payload.user     = item.fileInfo.user;
+            payload.fileSize = static_cast<long long>(item.size);
+            payload.fileDate = item.fileDate;
+            payload.meta     = std::move(item.meta);
+            payload.contentHash     = item.hash.toHex();
+            payload.phash           = item.phash;
+            payload.replaceExisting = item.replaceExisting;
+        }
+
+        // Outbox: Absicht dauerhaft vormerken, BEVOR eine Datei das Ziel erreicht.
+        // Ein Absturz danach hinterlässt höchstens einen Eintrag ohne Datei
+        // (beim Replay verworfen), nie ein Foto ohne Eintrag.
+        std::vector<uint64_t> intents;
+        const bool logged = outbox_ && outbox_->append(payloads, &intents);
+        if (outbox_ && !logged) qCritical() << "Outbox write failed, storing" << batch.size() << "files directly";
+
+        auto moveStart = std::chrono::steady_clock::now();
+        TraceSpan span("move batch", "move");
+        span.setCount(static_cast<int>(batch.size()));
+        mover.moveBatch(requests);
+        // Histogramm bleibt "pro Datei": Batch-Dauer anteilig
+        auto perFile = (std::chrono::steady_clock::now() - moveStart) / static_cast<int>(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) metrics().moveSeconds.observe(perFile);
+
+        std::vector<uint64_t> done, cancelled;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            ExtractedItem& item = batch[i];
+            const MoveRequest& req = requests[i];
+            if (!req.ok) {
+                counters_.failed++;
+                metrics().failedMove.inc();
+                DuplicateIndex::instance().release(item.hash);
+                release(item.srcPath);
+                if (logged) cancelled.push_back(intents[i]);
+                qCritical() << "Error moving file:" << QString::fromStdString(req.error);
+                continue;
+            }
+            counters_.moved++;
+            if (logged) done.push_back(intents[i]);
+            payloads[i].fileSize = static_cast<long long>(req.size);
+            moved.push_back(std::move(payloads[i]));
+            movedSources.push_back(item.srcPath);
+        }
+        if (logged) outbox_->cancel(cancelled);
+
+        // Zielverzeichnisse sichern, dann kopierte Quellen löschen
+        mover.commit();
+
+        if (logged) {
+            outbox_->publish(done);
+        } else if (outbox_) {
+            // Ohne Log: selbst schreiben, die DB-Threads lesen nur die Outbox
+            storeDirect(moved);
+        }
+        for (size_t i = 0; i < moved.size(); ++i) {
+            release(movedSources[i]);
+            if (outbox_) continue;
+            std::string destPath = moved[i].fullPath;
+            if (!dbQueue_.push(std::move(moved[i]))) {
+                qCritical() << "DB queue closed, not stored:" << QString::fromStdString(destPath);
+            }
+        }
+        batch.clear();
+        moved.clear();
+        movedSources.clear();
+    }
+}
+
+// Stufe 4: DB Insert (Group Commit)
+void IngestPipeline::dbWorker() {
+    Tracer::nameThread("db");
+    std::vector<WorkerPayload> batch, links;
+    std::vector<NearDuplicate> near;
+    batch.reserve(cfg_.dbBatchSize);
+
+    while (auto first = dbQueue_.pop()) {
+        // Batch sammeln: bis dbBatchSize erreicht oder das Zeitfenster abgelaufen ist
+        auto collect = [&](WorkerPayload&& p) {
+            if (p.linkOnly) links.push_back(std::move(p));
+            else batch.push_back(std::move(p));
+        };
+        collect(std::move(*first));
+        auto deadline = std::chrono::steady_clock::now() + cfg_.dbBatchWindow;
+        while (batch.size() + links.size() < cfg_.dbBatchSize) {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero()) break;
+            auto next = dbQueue_.popFor(left);
+            if (!next) break;
+            collect(std::move(*next));
+        }
+
+        TraceSpan span("db batch", "db");
+        span.setCount(static_cast<int>(batch.size() + links.size()));
+        std::vector<qint64> ids;
+        {
+            ScopedTimer timer(metrics().dbTransactionSeconds);
+            ids = DbManager::insertBatch(batch, cfg_.dbBatchMode);
+        }
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (ids[i] > 0) pictureStored(batch[i], ids[i], near);
+            else pictureFailed(batch[i]);
+            if (batch[i].onStored) batch[i].onStored(ids[i]);
+        }
+
+        // Kandidaten gesammelt nach dem Commit; ein Fehler kostet nur die Hinweise
+        if (!near.empty() && DbManager::insertNearDuplicates(near) > 0) {
+            metrics().nearDuplicates.inc(near.size());
+        }
+        near.clear();
+
+        // Verweise erst nach den Originalen (können im selben Batch stecken)
+        if (!links.empty() && DbManager::insertLinks(links) < 0) {
+            counters_.failed += static_cast<int>(links.size());
+            metrics().failedLinks.inc(links.size());
+        }
+        batch.clear();
+        links.clear();
+    }
+    // Persistente Verbindung dieses Threads schließen
+    DbPool::instance().releaseThread();
+}
+
+// Stufe 4 mit Outbox: Log in Batches abarbeiten, erst nach dem Commit bestätigen.
+// Ist die DB weg, geht alles mit wachsender Pause zurück in den Log (zählt nicht
+// als Versuch); lehnt die DB einen Eintrag maxAttempts-mal ab, wird er verworfen.
+void IngestPipeline::drainWorker() {
+    Tracer::nameThread("db");
+    const OutboxConfig& oc = outbox_->config();
+    const std::chrono::milliseconds minDelay(100);
+    std::chrono::milliseconds delay = minDelay;
+    std::vector<NearDuplicate> near;
+    std::vector<uint64_t> acks;
+    std::vector<OutboxRecord> inserts, upserts, links, again;
+
+    // Payloads für DbManager zusammenhängend, danach zurück in die Einträge
+    auto writeGroup = [&](std::vector<OutboxRecord>& group, bool upsert) {
+        std::vector<WorkerPayload> rows;
+        rows.reserve(group.size());
+        for (auto& r : group) rows.push_back(std::move(r.payload));
+        std::vector<qint64> ids;
+        if (group.empty()) return ids;
+        if (upsert) {
+            ScopedTimer timer(metrics().dbTransactionSeconds);
+            ids = DbManager::upsertBatch(rows, cfg_.dbBatchMode);
+        } else if (!rows[0].linkOnly) {
+            ScopedTimer timer(metrics().dbTransactionSeconds);
+            ids = DbManager::insertBatch(rows, cfg_.dbBatchMode);
+        } else {
+            // Verweise: alle gemeinsam
+            ids.assign(rows.size(), DbManager::insertLinks(rows) < 0 ? -1 : 1);
+        }
+        for (size_t i = 0; i < group.size(); ++i) group[i].payload = std::move(rows[i]);
+        return ids;
+    };
+
+    while (true) {
+        std::vector<OutboxRecord> records = outbox_->next(cfg_.dbBatchSize, cfg_.dbBatchWindow);
+        if (records.empty()) break;   // geschlossen
+
+        for (auto& r : records) {
+            // Replay: Datei inzwischen weg (Absturz vor dem Verschieben, gelöscht) -> nichts zu schreiben
+            if (r.replayed && !r.payload.linkOnly && !fs::exists(r.payload.fullPath)) {
+                qWarning() << "Outbox: file gone, dropping" << QString::fromStdString(r.payload.fullPath);
+                acks.push_back(r.seq);
+                continue;
+            }
+            // Evtl. schon committed (Neustart, abgebrochene Verbindung) -> Upsert per full_path
+            if (r.payload.linkOnly) links.push_back(std::move(r));
+            else if (r.replayed) upserts.push_back(std::move(r));
+            else inserts.push_back(std::move(r));
+        }
+
+        TraceSpan span("db batch", "db");
+        span.setCount(static_cast<int>(records.size()));
+        // Verweise erst nach den Originalen (können im selben Batch stecken)
+        std::vector<qint64> insertIds = writeGroup(inserts, false);
+        std::vector<qint64> upsertIds = writeGroup(upserts, true);
+        std::vector<qint64> linkIds = writeGroup(links, false);
+
+        const bool anyFailed = std::ranges::any_of(insertIds, [](qint64 id) { return id <= 0; }) ||
+                               std::ranges::any_of(upsertIds, [](qint64 id) { return id <= 0; }) ||
+                               std::ranges::any_of(linkIds, [](qint64 id) { return id <= 0; });
+        const bool outage = anyFailed && !DbManager::isReachable();
+
+        auto settle = [&](std::vector<OutboxRecord>& group, const std::vector<qint64>& ids) {
+            for (size_t i = 0; i < group.size(); ++i) {
+                OutboxRecord& r = group[i];
+                if (ids[i] > 0) {
+                    if (!r.payload.linkOnly) pictureStored(r.payload, ids[i], near);
+                    if (r.payload.onStored) r.payload.onStored(ids[i]);
+                    acks.push_back(r.seq);
+                    continue;
+                }
+                if (!outage && ++r.attempts >= oc.maxAttempts) {
+                    if (r.payload.linkOnly) {
+                        counters_.failed++;
+                        metrics().failedLinks.inc();
+                    } else {
+                        pictureFailed(r.payload);
+                    }
+                    metrics().outboxRejected.inc();
+                    if (r.payload.onStored) r.payload.onStored(-1);
+                    outbox_->reject(r, "database rejected the record");
+                    continue;
+                }
+                r.replayed = true;
+                again.push_back(std::move(r));
+            }
+            group.clear();
+        };
+        settle(inserts, insertIds);
+        settle(upserts, upsertIds);
+        settle(links, linkIds);
+
+        // Kandidaten gesammelt nach dem Commit; ein Fehler kostet nur die Hinweise
+        if (!near.empty() && DbManager::insertNearDuplicates(near) > 0) {
+            metrics().nearDuplicates.inc(near.size());
+        }
+        near.clear();
+
+        outbox_->acknowledge(acks);
+        acks.clear();
+
+        if (!again.empty()) {
+            metrics().outboxRetries.inc(again.size());
+            outbox_->retry(std::move(again));
+            again.clear();
+        }
+        // Einzelne fehlerhafte Zeilen kommen ohne Pause wieder (bis maxAttempts)
+        if (!outage) {
+            delay = minDelay;
+            continue;
+        }
+        qWarning() << "Database unreachable," << outbox_->backlog() << "records wait in the outbox, retry in"
+                   << delay.count() << "ms";
+        if (!outbox_->sleepFor(delay)) break;
+        delay = std::min(delay * 2, oc.maxRetryDelay);
+    }
+    DbPool::instance().releaseThread();
+}
+
+// Outbox nicht beschreibbar: Batch direkt aus dem Move-Thread schreiben
+void IngestPipeline::storeDirect(std::vector<WorkerPayload>& rows) {
+    if (rows.empty()) return;
+    std::vector<NearDuplicate> near;
+    std::vector<qint64> ids;
+    {
+        ScopedTimer timer(metrics().dbTransactionSeconds);
+        ids = DbManager::insertBatch(rows, cfg_.dbBatchMode);
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (ids[i] > 0) pictureStored(rows[i], ids[i], near);
+        else pictureFailed(rows[i]);
+    }
+    if (!near.empty() && DbManager::insertNearDuplicates(near) > 0) metrics().nearDuplicates.inc(near.size());
+}
+
+// Nach dem Commit: Zähler, Duplikat-Index, Beinahe-Duplikate, Derivate
+void IngestPipeline::pictureStored(const WorkerPayload& p, qint64 id, std::vector<NearDuplicate>& near) {
+    counters_.stored++;
+    metrics().files.inc();
+    metrics().bytes.inc(static_cast<uint64_t>(std::max(0LL, p.fileSize)));
+    ContentHash hash = ContentHash::fromHex(p.contentHash);
+    if (hash.valid) DuplicateIndex::instance().commit(hash, id);
+    if (p.phash) matchNearDuplicates(*p.phash, id, near);
+    // Derivate nie auf Kosten der Aufnahme: volle Queue -> überspringen
+    if (!derivativeThreads_.empty() && !derivativeQueue_.tryPush({id, p.fullPath, p.relPath})) {
+        metrics().derivativesQueueFull.inc();
+    }
+    qDebug() << "Processed:" << QString::fromStdString(p.filename) << "into" << QString::fromStdString(p.relPath);
+}
+
+void IngestPipeline::pictureFailed(const WorkerPayload& p) {
+    counters_.failed++;
+    metrics().failedDb.inc();
+    ContentHash hash = ContentHash::fromHex(p.contentHash);
+    if (hash.valid) DuplicateIndex::instance().release(hash);
+    qWarning() << "DB Insert failed for" << QString::fromStdString(p.filename);
+}
+
+// Ähnliche ältere Fotos suchen und das neue gleich eintragen: so finden sich
+// auch zwei ähnliche Fotos aus demselben Batch
+void IngestPipeline::matchNearDuplicates(uint64_t phash, qint64 pictureId, std::vector<NearDuplicate>& out) {
+    std::vector<NearMatch> matches;
+    {
+        ScopedTimer timer(metrics().phashSearchSeconds);
+        TraceSpan span("phash search", "db");
+        matches = PerceptualIndex::instance().matchAndInsert(phash, pictureId, cfg_.phash.maxDistance,
+                                                             cfg_.phash.maxMatches);
+    }
+    if (matches.empty()) return;
+    counters_.nearDuplicates++;
+    for (const NearMatch& m : matches) out.push_back({pictureId, m.pictureId, m.distance});
+}
+
+// Stufe 5 (optional): Thumbnails/Previews + Blurhash
+void IngestPipeline::derivativeWorker() {
+    Tracer::nameThread("derivatives");
+    while (auto job = derivativeQueue_.pop()) {
+        try {
+            TraceFileScope traceFile(job->fullPath.filename().string(), {});
+            DerivativeResult result;
+            {
+                ScopedTimer timer(metrics().derivativeSeconds);
+                TraceSpan span("derivatives", "derivatives");
+                result = derivatives_.generate(job->fullPath, job->relPath);
+            }
+            if (result.unsupported) {
+                metrics().derivativesUnsupported.inc();
+                continue;
+            }
+            if (!DbManager::insertDerivatives(job->pictureId, result.records, result.blurhash)) {
+                // Foto evtl. inzwischen ersetzt/gelöscht -> keine verwaisten Dateien liegen lassen
+                for (const auto& r : result.records) {
+                    std::error_code ec;
+                    fs::remove(r.path, ec);
+                }
+                metrics().derivativesFailed.inc();
+                continue;
+            }
+            counters_.derivatives++;
+            metrics().derivatives.inc();
+        } catch (const std::exception& e) {
+            metrics().derivativesFailed.inc();
+            qWarning() << "Derivatives failed for" << QString::fromStdString(job->fullPath.string()) << ":" << e.what();
+        }
+    }
+    DbPool::instance().releaseThread();
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "BoundedQueue.h"
+#include "ContentHash.h"
+#include "DbManager.h"
+#include "DerivativeGenerator.h"
+#include "DuplicateIndex.h"
+#include "FileHelpers.h"
+#include "FileMover.h"
+#include "Outbox.h"
+#include "PerceptualHash.h"
+#include "UserScheduler.h"
+
+// Thread-Anzahl pro Stufe und Queue-Größen (aus Umgebungsvariablen)
+struct PipelineConfig {
+    std::filesystem::path inboxDir;
+    std::filesystem::path photosRoot;
+    int extractThreads = 0;   // 0 -> Anzahl Kerne
+    int moveThreads = 1;
+    int dbThreads = 1;
+    size_t queueCapacity = 256;
+
+    // Group Commit: bis zu dbBatchSize Fotos oder dbBatchWindow warten
+    size_t dbBatchSize = 64;
+    std::chrono::milliseconds dbBatchWindow{200};
+    BatchFailureMode dbBatchMode = BatchFailureMode::Isolate;
+
+    // Verschobene Fotos erst dauerhaft lokal vormerken, dann in die DB (WORKER_OUTBOX=on)
+    OutboxConfig outbox;
+
+    // Verschieben: Dateien pro Verzeichnis-fsync, Kopier-Optionen bei anderem Volume
+    size_t moveBatchSize = 32;
+    MoveOptions move;
+
+    DuplicatePolicy duplicatePolicy = DuplicatePolicy::Skip;
+    PerceptualHashConfig phash;   // Beinahe-Duplikate (aus bei WORKER_PHASH=off)
+
+    // Reihenfolge der Extraktion: fair pro Benutzer (statt Verzeichnis-Reihenfolge)
+    SchedulerConfig scheduler;
+
+    // Thumbnails/Previews: eigener Pool, 0 -> Stufe aus
+    int derivativeThreads = 0;
+    size_t derivativeQueueCapacity = 4096;
+    DerivativeConfig derivatives;
+
+    static PipelineConfig fromEnvironment(const std::filesystem::path& inboxDir,
+                                          const std::filesystem::path& photosRoot);
+};
+
+// Zähler pro Stufe (für /status)
+struct StageCounters {
+    std::atomic<int> discovered{0};
+    std::atomic<int> extracted{0};
+    std::atomic<int> moved{0};
+    std::atomic<int> stored{0};
+    std::atomic<int> failed{0};
+    std::atomic<int> duplicates{0};
+    std::atomic<int> nearDuplicates{0};   // Fotos mit mindestens einem ähnlichen älteren Foto
+    std::atomic<int> derivatives{0};
+};
+
+// Discovery -> Benutzer-Scheduler -> Metadaten (Pool) -> Verschieben -> DB-Writer,
+// verbunden über BoundedQueues (Backpressure). Mit Outbox liegt zwischen
+// Verschieben und DB-Writer statt der Queue ein lokaler Log.
+// Optional danach: Derivate (eigener Pool, blockiert die Aufnahme nie).
+class IngestPipeline {
+public:
+    explicit IngestPipeline(PipelineConfig cfg);
+    ~IngestPipeline();
+
+    IngestPipeline(const IngestPipeline&) = delete;
+    IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+    void start();
+    void stop();
+
+    // Discovery: reiht die Datei beim Benutzer aus dem Dateinamen ein, blockiert
+    // erst, wenn der Scheduler voll ist. Dateien in Arbeit werden ignoriert.
+    void submit(const std::filesystem::path& srcPath);
+
+    // HTTP-Ingest: Datei liegt schon am Ziel, Metadaten sind gelesen -> direkt
+    // in den DB-Writer. payload.onStored meldet die ID. false -> Pipeline gestoppt
+    bool store(WorkerPayload payload);
+
+    // Wird aufgerufen, sobald eine Inbox-Datei fertig ist (verschoben, verworfen
+    // oder fehlgeschlagen). Vor start() setzen; für die Lease-Koordination.
+    void setReleaseHook(std::function<void(const std::filesystem::path&)> hook) { releaseHook_ = std::move(hook); }
+
+    const PipelineConfig& config() const { return cfg_; }
+    const StageCounters& counters() const { return counters_; }
+    size_t extractBacklog() const { return scheduler_.size(); }
+    std::vector<UserQueueStats> userQueues() const { return scheduler_.snapshot(); }
+    size_t moveBacklog() const { return moveQueue_.size(); }
+    size_t dbBacklog() const { return outbox_ ? outbox_->backlog() : dbQueue_.size(); }
+    size_t derivativeBacklog() const { return derivativeQueue_.size(); }
+    const Outbox* outbox() const { return outbox_.get(); }   // nullptr -> aus
+
+private:
+    struct ExtractedItem {
+        std::filesystem::path srcPath;
+        FileInfo fileInfo;
+        PhotoData meta;
+        QDateTime fileDate;
+        ContentHash hash;
+        std::optional<uint64_t> phash;
+        bool replaceExisting = false;
+        uint64_t size = 0;   // nur mit Outbox vor dem Verschieben bekannt
+    };
+
+    struct DerivativeJob {
+        qint64 pictureId;
+        std::filesystem::path fullPath;
+        std::string relPath;
+    };
+
+    void extractWorker();
+    bool handleDuplicate(ExtractedItem& item, qint64 existingId);
+    void deferDuplicate(const ScheduledFile& file, const ContentHash& hash);
+    void moveWorker();
+    bool forwardToDb(WorkerPayload&& payload);
+    void dbWorker();
+    void drainWorker();
+    void pictureStored(const WorkerPayload& p, qint64 id, std::vector<NearDuplicate>& near);
+    void pictureFailed(const WorkerPayload& p);
+    void storeDirect(std::vector<WorkerPayload>& rows);
+    void matchNearDuplicates(uint64_t phash, qint64 pictureId, std::vector<NearDuplicate>& out);
+    void derivativeWorker();
+    void release(const std::filesystem::path& srcPath);
+
+    PipelineConfig cfg_;
+    StageCounters counters_;
+
+    UserScheduler scheduler_;
+    BoundedQueue<ExtractedItem> moveQueue_;
+    BoundedQueue<WorkerPayload> dbQueue_;
+    std::unique_ptr<Outbox> outbox_;   // statt dbQueue_, wenn aktiv
+    BoundedQueue<DerivativeJob> derivativeQueue_;
+    DerivativeGenerator derivatives_;
+
+    std::mutex inFlightMutex_;
+    std::unordered_map<std::string, std::string> inFlight_;   // Pfad -> Benutzer
+    std::function<void(const std::filesystem::path&)> releaseHook_;
+
+    std::vector<std::thread> extractThreads_;
+    std::vector<std::thread> moveThreads_;
+    std::vector<std::thread> dbThreads_;
+    std::vector<std::thread> derivativeThreads_;
+    bool started_ = false;
+};
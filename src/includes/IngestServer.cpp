@@ -0,0 +1,373 @@
+#include "IngestServer.h"
+#include "HttpIngest.h"
+#include <QDebug>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static constexpr size_t MAX_HEADER_BYTES = 16 * 1024;
+static constexpr int READ_TIMEOUT_S = 30;   // langsame Clients halten sonst einen Thread fest
+
+static void setReadTimeout(int fd, int seconds) {
+    timeval tv{};
+    tv.tv_sec = seconds;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+static long recvSome(int fd, void* buf, size_t len) {
+    for (;;) {
+        ssize_t n = ::recv(fd, buf, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        return static_cast<long>(n);
+    }
+}
+
+static bool sendAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// Abgelehnte Anfragen: ein Client ohne "Expect: 100-continue" schickt den Body
+// trotzdem. Ein close() mit ungelesenen Daten löst ein RST aus, das die Antwort
+// verschlucken kann -> Schreibseite schließen und kurz (begrenzt) weiterlesen.
+static void lingeringClose(int fd) {
+    ::shutdown(fd, SHUT_WR);
+    setReadTimeout(fd, 1);
+    char sink[16 * 1024];
+    size_t drained = 0;
+    while (drained < (256u << 10)) {
+        long n = recvSome(fd, sink, sizeof(sink));
+        if (n <= 0) break;
+        drained += static_cast<size_t>(n);
+    }
+}
+
+static const char* reason(int status) {
+    switch (status) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 413: return "Content Too Large";
+    case 422: return "Unprocessable Content";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 503: return "Service Unavailable";
+    default:  return "Internal Server Error";
+    }
+}
+
+static void appendJsonString(std::string& out, std::string_view s) {
+    out += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out += esc;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+static void respond(int fd, const IngestResult& r) {
+    std::string body = "{\"path\":";
+    appendJsonString(body, r.path);
+    if (r.pictureId > 0) body += ",\"id\":" + std::to_string(r.pictureId);
+    if (r.duplicateOf >= 0) body += ",\"duplicate_of\":" + std::to_string(r.duplicateOf);
+    if (!r.error.empty()) {
+        body += ",\"error\":";
+        appendJsonString(body, r.error);
+    }
+    body += '}';
+
+    std::string head = "HTTP/1.1 " + std::to_string(r.status) + " " + reason(r.status) + "\r\n";
+    head += "Content-Type: application/json\r\n";
+    head += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    if (r.status == 429 || r.status == 503) head += "Retry-After: 1\r\n";
+    if (r.status == 405) head += "Allow: POST\r\n";
+    head += "Connection: close\r\n\r\n";
+    sendAll(fd, head + body);
+}
+
+static IngestResult error(int status, std::string message) {
+    IngestResult r;
+    r.status = status;
+    r.error = std::move(message);
+    return r;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Query-Parameter dekodieren ("%2F", "+" -> Leerzeichen)
+static std::string urlDecode(std::string_view s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0) {
+            out += static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+IngestServer::IngestServer(HttpIngest& ingest, int port, size_t maxConnections)
+    : ingest_(ingest), port_(port), maxConnections_(std::max<size_t>(1, maxConnections)),
+      pending_(maxConnections_) {}
+
+IngestServer::~IngestServer() {
+    stop();
+}
+
+bool IngestServer::start() {
+    listenFd_ = ::socket(AF_INET6, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        qCritical() << "Ingest endpoint: socket failed:" << std::strerror(errno);
+        return false;
+    }
+    int on = 1, off = 0;
+    ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ::setsockopt(listenFd_, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));   // auch IPv4
+
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(static_cast<uint16_t>(port_));
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listenFd_, 64) != 0) {
+        qCritical() << "Ingest endpoint: cannot listen on port" << port_ << ":" << std::strerror(errno);
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    for (size_t i = 0; i < maxConnections_; ++i) workers_.emplace_back(&IngestServer::connectionWorker, this);
+    acceptThread_ = std::thread(&IngestServer::acceptLoop, this);
+    qDebug() << "Ingest endpoint listening on port" << port_ << "connections:" << maxConnections_;
+    return true;
+}
+
+void IngestServer::stop() {
+    if (!running_.exchange(false)) return;
+
+    // Weckt accept() auf
+    ::shutdown(listenFd_, SHUT_RDWR);
+    if (acceptThread_.joinable()) acceptThread_.join();
+    ::close(listenFd_);
+    listenFd_ = -1;
+
+    {
+        std::lock_guard lock(mutex_);
+        // Lesende Verbindungen brechen ab (Upload wird verworfen), wartende bekommen noch ihre Antwort
+        for (int fd : connections_) ::shutdown(fd, SHUT_RD);
+    }
+    pending_.close();
+    for (auto& t : workers_) t.join();
+    workers_.clear();
+}
+
+void IngestServer::acceptLoop() {
+    while (running_) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (running_) {
+                qWarning() << "Ingest endpoint: accept failed:" << std::strerror(errno);
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+        bool admitted;
+        {
+            std::lock_guard lock(mutex_);
+            admitted = connections_.size() < maxConnections_;
+            if (admitted) connections_.insert(fd);
+        }
+        if (!admitted) {
+            respond(fd, error(503, "too many connections"));
+            lingeringClose(fd);
+            ::close(fd);
+            continue;
+        }
+        // Höchstens maxConnections_ angenommen -> passt immer in die Queue
+        pending_.push(fd);
+    }
+}
+
+void IngestServer::connectionWorker() {
+    while (auto fd = pending_.pop()) {
+        serve(*fd);
+        // Erst austragen, dann schließen: die Nummer kann sofort neu vergeben werden
+        std::lock_guard lock(mutex_);
+        connections_.erase(*fd);
+        ::close(*fd);
+    }
+}
+
+void IngestServer::serve(int fd) {
+    setReadTimeout(fd, READ_TIMEOUT_S);
+
+    // 1. Header lesen (begrenzt); was dahinter schon ankam, ist Body
+    std::string head;
+    size_t end;
+    char buf[4096];
+    while ((end = head.find("\r\n\r\n")) == std::string::npos) {
+        if (head.size() > MAX_HEADER_BYTES) {
+            respond(fd, error(431, "request header too large"));
+            return lingeringClose(fd);
+        }
+        long n = recvSome(fd, buf, sizeof(buf));
+        if (n <= 0) return;
+        head.append(buf, static_cast<size_t>(n));
+    }
+    std::string pending = head.substr(end + 4);
+    head.resize(end);
+
+    // 2. Request-Zeile: "POST /ingest?name=...&dir=... HTTP/1.1"
+    std::string_view headers(head);
+    size_t eol = headers.find("\r\n");
+    std::string_view line = headers.substr(0, eol);
+    headers = eol == std::string_view::npos ? std::string_view{} : headers.substr(eol + 2);
+
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 <= sp1) {
+        respond(fd, error(400, "malformed request line"));
+        return lingeringClose(fd);
+    }
+    std::string_view method = line.substr(0, sp1);
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view query;
+    if (size_t q = target.find('?'); q != std::string_view::npos) {
+        query = target.substr(q + 1);
+        target = target.substr(0, q);
+    }
+    if (target != "/ingest") {
+        respond(fd, error(404, "only POST /ingest is served on this port"));
+        return lingeringClose(fd);
+    }
+    if (method != "POST") {
+        respond(fd, error(405, "use POST"));
+        return lingeringClose(fd);
+    }
+
+    IngestRequest req;
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+        size_t eq = pair.find('=');
+        std::string_view key = pair.substr(0, eq);
+        std::string value = eq == std::string_view::npos ? std::string{} : urlDecode(pair.substr(eq + 1));
+        if (key == "user") req.user = std::move(value);
+        else if (key == "name") req.name = std::move(value);
+        else if (key == "dir") req.dir = std::move(value);
+    }
+
+    // 3. Header: nur Content-Length (Pflicht), Transfer-Encoding und Expect interessieren
+    bool haveLength = false, chunked = false, expectContinue = false;
+    uint64_t contentLength = 0;
+    while (!headers.empty()) {
+        eol = headers.find("\r\n");
+        std::string_view h = headers.substr(0, eol);
+        headers = eol == std::string_view::npos ? std::string_view{} : headers.substr(eol + 2);
+        size_t colon = h.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = trim(h.substr(0, colon));
+        std::string_view value = trim(h.substr(colon + 1));
+        if (equalsIgnoreCase(name, "Content-Length")) {
+            auto [p, ec] = std::from_chars(value.data(), value.data() + value.size(), contentLength);
+            if (ec != std::errc{} || p != value.data() + value.size()) {
+                respond(fd, error(400, "invalid Content-Length"));
+                return lingeringClose(fd);
+            }
+            haveLength = true;
+        } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked = true;
+        } else if (equalsIgnoreCase(name, "Expect")) {
+            expectContinue = equalsIgnoreCase(value, "100-continue");
+        }
+    }
+    if (!haveLength || chunked) {
+        // Ohne Länge ließe sich die Größe erst nach dem Einlesen prüfen
+        respond(fd, error(411, "Content-Length required, chunked uploads are not supported"));
+        return lingeringClose(fd);
+    }
+
+    // 4. Body erst lesen, wenn HttpIngest Größe und Zulassung geprüft hat
+    bool started = false;
+    uint64_t consumed = 0;
+    auto read = [&](unsigned char* out, size_t len) -> long {
+        if (!started) {
+            started = true;
+            if (expectContinue && pending.empty() && !sendAll(fd, "HTTP/1.1 100 Continue\r\n\r\n")) return -1;
+        }
+        if (!pending.empty()) {
+            size_t n = std::min(len, pending.size());
+            std::memcpy(out, pending.data(), n);
+            pending.erase(0, n);
+            consumed += n;
+            return static_cast<long>(n);
+        }
+        long n = recvSome(fd, out, len);
+        if (n > 0) consumed += static_cast<uint64_t>(n);
+        return n;
+    };
+    IngestResult r = ingest_.ingest(req, contentLength, read);
+    respond(fd, r);
+    // Body nicht (vollständig) gelesen -> Rest verwerfen, damit die Antwort ankommt
+    if (consumed < contentLength) lingeringClose(fd);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "BoundedQueue.h"
+
+class HttpIngest;
+
+// Schlanker HTTP/1.1-Endpunkt nur für POST /ingest (WORKER_INGEST_PORT).
+// Crow liest jeden Body vollständig in den Speicher, bevor ein Handler läuft;
+// hier werden nach den Headern erst Content-Length (413/411) und die
+// Zulassung (429) geprüft, danach fließt der Body stückweise in IngestUpload.
+// Eine Anfrage pro Verbindung, feste Anzahl Verbindungs-Threads: pro Thread
+// angelegte Zustände (z.B. Tracer-Puffer) entstehen nicht mit jeder Verbindung neu.
+class IngestServer {
+public:
+    IngestServer(HttpIngest& ingest, int port, size_t maxConnections);
+    ~IngestServer();
+
+    IngestServer(const IngestServer&) = delete;
+    IngestServer& operator=(const IngestServer&) = delete;
+
+    // false -> Port nicht verfügbar
+    bool start();
+
+    // Keine neuen Verbindungen; laufende Übertragungen werden abgebrochen,
+    // Anfragen, die schon auf den DB-Commit warten, noch beantwortet
+    void stop();
+
+private:
+    void acceptLoop();
+    void connectionWorker();
+    void serve(int fd);
+
+    HttpIngest& ingest_;
+    const int port_;
+    const size_t maxConnections_;
+    int listenFd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread acceptThread_;
+    std::vector<std::thread> workers_;
+    BoundedQueue<int> pending_;   // angenommen, wartet auf einen freien Worker
+
+    std::mutex mutex_;
+    std::unordered_set<int> connections_;   // angenommen oder in Arbeit
+};
@@ -0,0 +1,245 @@
+#include "IoUring.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef WORKER_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+bool IoUring::enabled() {
+    static const bool on = qEnvironmentVariable("WORKER_IO_URING", "off") == "on";
+    return on;
+}
+
+#ifndef WORKER_HAVE_IO_URING
+
+// Ohne Kernel-Header: immer der synchrone Pfad
+IoUring* IoUring::forThread() { return nullptr; }
+IoUring::~IoUring() = default;
+bool IoUring::setup(unsigned) { return false; }
+struct io_uring_sqe* IoUring::nextSqe(int*) { return nullptr; }
+void IoUring::statx(const char*, int, unsigned, struct statx*, int* result) { *result = -ENOSYS; }
+void IoUring::mkdirat(const char*, mode_t, int* result) { *result = -ENOSYS; }
+void IoUring::renameat(const char*, const char*, int* result) { *result = -ENOSYS; }
+bool IoUring::submit() { return false; }
+void IoUring::reap() {}
+void IoUring::abandon() {}
+
+#else
+
+static int sysSetup(unsigned entries, io_uring_params* p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int sysRegister(int fd, unsigned op, void* arg, unsigned nr) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, op, arg, nr));
+}
+
+// Head/Tail teilen wir mit dem Kernel -> Acquire/Release
+static unsigned loadAcquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+static void storeRelease(unsigned* p, unsigned v) {
+    std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
+
+IoUring* IoUring::forThread() {
+    if (!enabled()) return nullptr;
+    // Einmal pro Thread versuchen; schlägt es fehl (seccomp, alter Kernel), bleibt es beim synchronen Pfad
+    thread_local std::unique_ptr<IoUring> ring = [] {
+        std::unique_ptr<IoUring> r(new IoUring());
+        if (!r->setup(256)) r.reset();
+        return r;
+    }();
+    return ring && !ring->broken_ ? ring.get() : nullptr;
+}
+
+bool IoUring::setup(unsigned entries) {
+    io_uring_params p{};
+    fd_ = sysSetup(entries, &p);
+    if (fd_ < 0) {
+        qWarning() << "io_uring unavailable:" << std::strerror(errno) << "-> synchronous file operations";
+        return false;
+    }
+
+    // Benötigte Opcodes prüfen (statx ab 5.6, renameat ab 5.11, mkdirat ab 5.15)
+    const size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::vector<unsigned char> probeBuf(probeSize, 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeBuf.data());
+    if (sysRegister(fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        qWarning() << "io_uring probe failed -> synchronous file operations";
+        return false;
+    }
+    for (unsigned op : {IORING_OP_STATX, IORING_OP_MKDIRAT, IORING_OP_RENAMEAT}) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            qWarning() << "io_uring lacks opcode" << op << "-> synchronous file operations";
+            return false;
+        }
+    }
+
+    sqRingSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        return false;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            return false;
+        }
+    }
+    sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        sqes_ = nullptr;
+        return false;
+    }
+
+    auto* sq = static_cast<char*>(sqRing_);
+    auto* cq = static_cast<char*>(cqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sqEntries_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_entries);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    return true;
+}
+
+IoUring::~IoUring() {
+    if (sqes_) ::munmap(sqes_, sqesSize_);
+    if (cqRing_ && cqRing_ != sqRing_) ::munmap(cqRing_, cqRingSize_);
+    if (sqRing_) ::munmap(sqRing_, sqRingSize_);
+    if (fd_ >= 0) ::close(fd_);
+}
+
+// Freien Slot holen; ist der Ring voll, wird vorher abgeschickt
+io_uring_sqe* IoUring::nextSqe(int* result) {
+    if (broken_ || (queued_ + inFlight_ >= sqEntries_ && !submit())) {
+        *result = -ECANCELED;   // Aufrufer holt es synchron nach
+        return nullptr;
+    }
+    unsigned tail = *sqTail_;
+    unsigned idx = tail & sqMask_;
+    auto* sqe = static_cast<io_uring_sqe*>(sqes_) + idx;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = reinterpret_cast<uint64_t>(result);
+    *result = -ECANCELED;   // bis der Kernel antwortet
+    sqArray_[idx] = idx;
+    storeRelease(sqTail_, tail + 1);
+    queued_++;
+    return sqe;
+}
+
+void IoUring::statx(const char* path, int flags, unsigned mask, struct statx* out, int* result) {
+    io_uring_sqe* sqe = nextSqe(result);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<uint64_t>(path);
+    sqe->len = mask;
+    sqe->off = reinterpret_cast<uint64_t>(out);
+    sqe->statx_flags = static_cast<uint32_t>(flags);
+}
+
+void IoUring::mkdirat(const char* path, mode_t mode, int* result) {
+    io_uring_sqe* sqe = nextSqe(result);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_MKDIRAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<uint64_t>(path);
+    sqe->len = mode;
+}
+
+void IoUring::renameat(const char* from, const char* to, int* result) {
+    io_uring_sqe* sqe = nextSqe(result);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RENAMEAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<uint64_t>(from);
+    sqe->len = static_cast<uint32_t>(AT_FDCWD);
+    sqe->addr2 = reinterpret_cast<uint64_t>(to);
+}
+
+bool IoUring::submit() {
+    if (broken_) return false;
+    inFlight_ += queued_;
+    unsigned toSubmit = queued_;
+    queued_ = 0;
+
+    while (inFlight_ > 0) {
+        int rc = sysEnter(fd_, toSubmit, inFlight_, IORING_ENTER_GETEVENTS);
+        if (rc < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+            qCritical() << "io_uring_enter failed:" << std::strerror(errno) << "-> synchronous file operations";
+            abandon();
+            return false;
+        }
+        toSubmit -= std::min(toSubmit, static_cast<unsigned>(rc));
+        reap();
+    }
+    return true;
+}
+
+// Fertige Ergebnisse in die Ergebnis-Slots der Aufrufer schreiben
+void IoUring::reap() {
+    unsigned head = *cqHead_;
+    unsigned tail = loadAcquire(cqTail_);
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        *reinterpret_cast<int*>(cqe.user_data) = cqe.res;
+        inFlight_--;
+    }
+    storeRelease(cqHead_, head);
+}
+
+// Nach einem Fehler von io_uring_enter: Einträge, die der Kernel schon übernommen
+// hat, laufen weiter und schreiben in Puffer der Aufrufer (oft auf deren Stack).
+// Deshalb nicht einfach zurückkehren, sondern nicht übernommene Einträge
+// zurücknehmen und auf alle übrigen warten. Danach wird der Ring nicht mehr benutzt.
+void IoUring::abandon() {
+    broken_ = true;
+
+    // Ohne SQPOLL übernimmt nur io_uring_enter Einträge: alles zwischen Kernel-Head
+    // und unserem Tail ist noch unberührt und bleibt -ECANCELED
+    unsigned head = loadAcquire(sqHead_);
+    unsigned unsubmitted = *sqTail_ - head;
+    storeRelease(sqTail_, head);
+    inFlight_ -= std::min(inFlight_, unsubmitted);
+
+    // Der Kernel trägt Ergebnisse auch ohne io_uring_enter in den CQ-Ring ein
+    while (inFlight_ > 0) {
+        if (sysEnter(fd_, 0, inFlight_, IORING_ENTER_GETEVENTS) < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        reap();
+    }
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// Minimaler io_uring-Ring direkt über die Kernel-ABI (ohne liburing).
+// Viele kleine Dateisystem-Operationen werden vorgemerkt und mit einem
+// einzigen io_uring_enter() abgeschickt -> bei Netzwerk-Mounts zählt die
+// Latenz pro Syscall, nicht der Durchsatz.
+//
+// Ein Ring pro Thread, nicht thread-safe. Ergebnisse: >= 0 oder -errno.
+class IoUring {
+public:
+    // Ring des aktuellen Threads. nullptr, wenn abgeschaltet (WORKER_IO_URING != on)
+    // oder der Kernel statx/mkdirat/renameat per io_uring nicht kann.
+    static IoUring* forThread();
+    static bool enabled();
+
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Pfade und Puffer müssen bis submit() gültig bleiben
+    void statx(const char* path, int flags, unsigned mask, struct statx* out, int* result);
+    void mkdirat(const char* path, mode_t mode, int* result);
+    void renameat(const char* from, const char* to, int* result);
+
+    // Alles Vorgemerkte abschicken und auf sämtliche Ergebnisse warten.
+    // false -> Ring ausgefallen (forThread() liefert danach nullptr); Einträge,
+    // die der Kernel nicht ausgeführt hat, stehen auf -ECANCELED und müssen
+    // synchron nachgeholt werden. Auch dann ist kein Eintrag mehr beim Kernel.
+    [[nodiscard]] bool submit();
+
+private:
+    IoUring() = default;
+    bool setup(unsigned entries);
+    struct io_uring_sqe* nextSqe(int* result);
+    void reap();
+    void abandon();
+
+    int fd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    void* sqes_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    struct io_uring_cqe* cqes_ = nullptr;
+
+    unsigned queued_ = 0;     // vorgemerkt, noch nicht beim Kernel
+    unsigned inFlight_ = 0;   // abgeschickt, Ergebnis fehlt noch
+    bool broken_ = false;     // io_uring_enter dauerhaft fehlgeschlagen
+};
@@ -0,0 +1,121 @@
+#include "KeywordCache.h"
+#include "Tracer.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <mutex>
+
+KeywordCache& KeywordCache::instance() {
+    static KeywordCache cache;
+    return cache;
+}
+
+QString KeywordCache::toPgArray(const std::vector<QString>& values) {
+    QString out = "{";
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i) out += ",";
+        QString v = values[i];
+        v.replace("\\", "\\\\");
+        v.replace("\"", "\\\"");
+        out += "\"" + v + "\"";
+    }
+    out += "}";
+    return out;
+}
+
+bool KeywordCache::warmUp() {
+    size_t loaded = 0;
+    {
+        DbPool::Lease lease = DbPool::instance().acquire();
+        if (!lease.isValid()) return false;
+
+        QSqlQuery q(lease.db());
+        q.setForwardOnly(true);
+        if (!q.exec("SELECT id, tag FROM keywords")) {
+            qCritical() << "Keyword cache warm-up failed:" << q.lastError().text();
+            return false;
+        }
+
+        std::unique_lock lock(mutex_);
+        while (q.next()) ids_.emplace(q.value(1).toString(), q.value(0).toInt());
+        loaded = ids_.size();
+    }
+    DbPool::instance().releaseThread();
+    qDebug() << "Keyword cache warmed up:" << loaded << "keywords";
+    return true;
+}
+
+bool KeywordCache::resolve(DbPool::Lease& lease, const std::vector<QString>& tags,
+                           std::unordered_map<QString, int>& out, Resolved& fresh) {
+    std::vector<QString> missing;
+    {
+        std::shared_lock lock(mutex_);
+        for (const auto& tag : tags) {
+            auto it = ids_.find(tag);
+            if (it != ids_.end()) out.emplace(tag, it->second);
+            else missing.push_back(tag);
+        }
+    }
+    hits_.fetch_add(static_cast<qint64>(tags.size() - missing.size()), std::memory_order_relaxed);
+    misses_.fetch_add(static_cast<qint64>(missing.size()), std::memory_order_relaxed);
+    if (missing.empty()) return true;
+    TraceSpan span("keywords", "db");
+    span.setCount(static_cast<int>(missing.size()));
+
+    // Ein Statement für alle Fehltreffer: neue Tags anlegen, vorhandene mitlesen
+    QSqlQuery& q = lease.prepared(
+        "WITH input AS (SELECT DISTINCT unnest(?::text[]) AS tag), "
+        "ins AS (INSERT INTO keywords (tag) SELECT tag FROM input ON CONFLICT (tag) DO NOTHING RETURNING id, tag) "
+        "SELECT id, tag FROM ins "
+        "UNION ALL "
+        "SELECT k.id, k.tag FROM keywords k JOIN input i ON i.tag = k.tag");
+    q.bindValue(0, toPgArray(missing));
+    if (!q.exec()) {
+        qCritical() << "Keyword upsert failed:" << q.lastError().text();
+        return false;
+    }
+    while (q.next()) {
+        QString tag = q.value(1).toString();
+        int id = q.value(0).toInt();
+        if (out.emplace(tag, id).second) fresh.emplace_back(tag, id);
+    }
+    q.finish();
+
+    // Von paralleler Transaktion gerade angelegt -> im Snapshot des Upserts
+    // noch nicht sichtbar, mit neuem Statement nachlesen
+    std::vector<QString> stillMissing;
+    for (const auto& tag : missing) {
+        if (!out.contains(tag)) stillMissing.push_back(tag);
+    }
+    if (stillMissing.empty()) return true;
+
+    QSqlQuery& qSel = lease.prepared("SELECT id, tag FROM keywords WHERE tag = ANY(?::text[])");
+    qSel.bindValue(0, toPgArray(stillMissing));
+    if (!qSel.exec()) {
+        qCritical() << "Keyword lookup failed:" << qSel.lastError().text();
+        return false;
+    }
+    while (qSel.next()) {
+        QString tag = qSel.value(1).toString();
+        int id = qSel.value(0).toInt();
+        if (out.emplace(tag, id).second) fresh.emplace_back(tag, id);
+    }
+    qSel.finish();
+    return true;
+}
+
+void KeywordCache::publish(const Resolved& fresh) {
+    if (fresh.empty()) return;
+    std::unique_lock lock(mutex_);
+    for (const auto& [tag, id] : fresh) ids_.insert_or_assign(tag, id);
+}
+
+void KeywordCache::forget(const std::vector<QString>& tags) {
+    std::unique_lock lock(mutex_);
+    for (const auto& tag : tags) ids_.erase(tag);
+}
+
+size_t KeywordCache::size() const {
+    std::shared_lock lock(mutex_);
+    return ids_.size();
+}
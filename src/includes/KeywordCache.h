@@ -0,0 +1,49 @@
+#pragma once
+#include <QString>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "DbPool.h"
+
+// Prozessweiter Cache Tag -> keywords.id, geteilt von allen DB-Writern.
+// Wird beim Start aus der Tabelle "keywords" befüllt; Fehltreffer werden
+// gesammelt mit EINEM unnest()-Upsert aufgelöst.
+class KeywordCache {
+public:
+    using Resolved = std::vector<std::pair<QString, int>>;
+
+    static KeywordCache& instance();
+
+    // Alle vorhandenen Keywords laden (eigene Verbindung des aufrufenden Threads)
+    bool warmUp();
+
+    // IDs für tags (bereits getrimmt, eindeutig) nach out schreiben.
+    // Neu aufgelöste Einträge landen in fresh und sind erst nach publish()
+    // für andere Threads sichtbar -> kein Cache-Eintrag aus einer Transaktion,
+    // die später zurückgerollt wird.
+    bool resolve(DbPool::Lease& lease, const std::vector<QString>& tags,
+                 std::unordered_map<QString, int>& out, Resolved& fresh);
+
+    // Nach erfolgreichem COMMIT aufrufen
+    void publish(const Resolved& fresh);
+
+    // Nach fehlgeschlagener Transaktion (z.B. Keyword extern gelöscht)
+    void forget(const std::vector<QString>& tags);
+
+    size_t size() const;
+    qint64 hits() const { return hits_.load(std::memory_order_relaxed); }
+    qint64 misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    // Postgres Array-Literal {"a","b"} für Bindings mit ::text[]
+    static QString toPgArray(const std::vector<QString>& values);
+
+private:
+    KeywordCache() = default;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<QString, int> ids_;
+    std::atomic<qint64> hits_{0};
+    std::atomic<qint64> misses_{0};
+};
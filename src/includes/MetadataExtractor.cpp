@@ -1,13 +1,11 @@
 #include "MetadataExtractor.h"
+#include "FastMetadataReader.h"
 #include <exiv2/exiv2.hpp>
 #include <QDebug>
 #include <iostream>
 #include <cmath> 
-
-// Helper: Exiv2 String zu QString
-static QString toQt(const std::string& s) {
-    return QString::fromStdString(s);
-}
+#include <cstdlib>
+#include <string_view>
 
 // Helper: GPS Koordinaten berechnen
 static double getGpsCoordinate(const Exiv2::ExifData& exifData, const char* key, const char* refKey) {
@@ -66,7 +64,7 @@ static double getGpsAltitude(const Exiv2::ExifData& exifData) {
     }
 }
 
-PhotoData MetadataExtractor::extract(const std::string& filepath) {
+PhotoData MetadataExtractor::extractWithExiv2(const std::string& filepath) {
     PhotoData data;
     try {
         auto image = Exiv2::ImageFactory::open(filepath);
@@ -76,20 +74,6 @@ PhotoData MetadataExtractor::extract(const std::string& filepath) {
         data.width = image->pixelWidth();
         data.height = image->pixelHeight();
 
-        // --- HELPER: Keywords splitten & hinzufügen ---
-        // Löst das Problem: "Beijing, China, CHN" -> ["Beijing", "China", "CHN"]
-        auto addKeywords = [&](const QString& rawValue) {
-            // Qt::SkipEmptyParts verhindert leere Einträge bei ",,"
-            QStringList parts = rawValue.split(',', Qt::SkipEmptyParts);
-            
-            for (const QString& part : parts) {
-                QString clean = part.trimmed(); // Leerzeichen entfernen
-                if (!clean.isEmpty() && !data.keywords.contains(clean)) {
-                    data.keywords.append(clean);
-                }
-            }
-        };
-        
         // --- EXIF (Wie zuvor) ---
         Exiv2::ExifData &exifData = image->exifData();
         if (!exifData.empty()) {
@@ -97,15 +81,18 @@ PhotoData MetadataExtractor::extract(const std::string& filepath) {
             // Kurzform für den Kontext:
             auto getExif = [&](const char* k){ 
                 auto p = exifData.findKey(Exiv2::ExifKey(k)); 
-                return (p != exifData.end()) ? toQt(p->toString()) : QString(); 
+                return (p != exifData.end()) ? data.store(p->toString()) : std::string_view(); 
             };
             data.make = getExif("Exif.Image.Make");
             data.model = getExif("Exif.Image.Model");
             data.iso = getExif("Exif.Photo.ISOSpeedRatings");
             data.aperture = getExif("Exif.Photo.FNumber");
             data.exposure = getExif("Exif.Photo.ExposureTime");
-            std::string d = getExif("Exif.Photo.DateTimeOriginal").toStdString();
-            if(!d.empty()) data.takenAt = QDateTime::fromString(toQt(d), "yyyy:MM:dd HH:mm:ss");
+            auto d = exifData.findKey(Exiv2::ExifKey("Exif.Photo.DateTimeOriginal"));
+            if (d != exifData.end()) {
+                std::string v = d->toString();
+                if (!v.empty()) data.takenAt = QDateTime::fromString(QString::fromStdString(v), "yyyy:MM:dd HH:mm:ss");
+            }
 
             data.gpsLat = getGpsCoordinate(exifData, "Exif.GPSInfo.GPSLatitude", "Exif.GPSInfo.GPSLatitudeRef");
             data.gpsLon = getGpsCoordinate(exifData, "Exif.GPSInfo.GPSLongitude", "Exif.GPSInfo.GPSLongitudeRef");
@@ -117,7 +104,7 @@ PhotoData MetadataExtractor::extract(const std::string& filepath) {
         if (!iptcData.empty()) {
             auto getIptc = [&](const char* k){ 
                 auto p = iptcData.findKey(Exiv2::IptcKey(k)); 
-                return (p != iptcData.end()) ? toQt(p->toString()) : QString(); 
+                return (p != iptcData.end()) ? data.store(p->toString()) : std::string_view(); 
             };
 
             data.title = getIptc("Iptc.Application2.ObjectName");
@@ -131,8 +118,7 @@ PhotoData MetadataExtractor::extract(const std::string& filepath) {
             auto key = Exiv2::IptcKey("Iptc.Application2.Keywords");
             auto pos = iptcData.findKey(key);
             while (pos != iptcData.end() && pos->key() == "Iptc.Application2.Keywords") {
-                QString val = toQt(pos->toString());
-                if (!data.keywords.contains(val)) data.keywords.append(val);
+                data.addKeyword(pos->toString());
                 ++pos;
             }
         }
@@ -143,28 +129,25 @@ PhotoData MetadataExtractor::extract(const std::string& filepath) {
              // 1. Keywords (dc:subject)
              Exiv2::XmpKey key("Xmp.dc.subject");
              for (auto pos = xmpData.begin(); pos != xmpData.end(); ++pos) {
-                 if (pos->key() == "Xmp.dc.subject") {
-                     QString val = toQt(pos->toString());
-                     if (!data.keywords.contains(val)) data.keywords.append(val);
-                 }
+                 if (pos->key() == "Xmp.dc.subject") data.addKeyword(pos->toString());
              }
              
              // Helper für XMP Lookup
              auto getXmp = [&](const char* k) {
                  auto p = xmpData.findKey(Exiv2::XmpKey(k));
-                 return (p != xmpData.end()) ? toQt(p->toString()) : QString();
+                 return (p != xmpData.end()) ? data.store(p->toString()) : std::string_view();
              };
 
              // 2. Location Fallback (Standard Mapping: Photoshop Namespace)
-             if (data.city.isEmpty())        data.city = getXmp("Xmp.photoshop.City");
-             if (data.province.isEmpty())    data.province = getXmp("Xmp.photoshop.State");
-             if (data.country.isEmpty())     data.country = getXmp("Xmp.photoshop.Country");
-             if (data.countryCode.isEmpty()) data.countryCode = getXmp("Xmp.iptcCore.CountryCode");
+             if (data.city.empty())        data.city = getXmp("Xmp.photoshop.City");
+             if (data.province.empty())    data.province = getXmp("Xmp.photoshop.State");
+             if (data.country.empty())     data.country = getXmp("Xmp.photoshop.Country");
+             if (data.countryCode.empty()) data.countryCode = getXmp("Xmp.iptc.CountryCode");
              
              // 3. Info Fallback
-             if (data.title.isEmpty())       data.title = getXmp("Xmp.dc.title");
-             if (data.description.isEmpty()) data.description = getXmp("Xmp.dc.description");
-             if (data.copyright.isEmpty())   data.copyright = getXmp("Xmp.dc.rights");
+             if (data.title.empty())       data.title = getXmp("Xmp.dc.title");
+             if (data.description.empty()) data.description = getXmp("Xmp.dc.description");
+             if (data.copyright.empty())   data.copyright = getXmp("Xmp.dc.rights");
         }
 
     } catch (Exiv2::Error& e) {
@@ -173,4 +156,128 @@ PhotoData MetadataExtractor::extract(const std::string& filepath) {
         qWarning() << "Unknown Exiv2 Exception";
     }
     return data;
-}
\ No newline at end of file
+}
+
+// --- Fast Path ---
+
+enum class FastMode { Off, On, Verify };
+
+// WORKER_FAST_METADATA = on (Standard) | off | verify
+static FastMode fastModeFromEnvironment() {
+    const char* v = std::getenv("WORKER_FAST_METADATA");
+    if (!v) return FastMode::On;
+    std::string_view s(v);
+    if (s == "off" || s == "0") return FastMode::Off;
+    if (s == "verify") return FastMode::Verify;
+    return FastMode::On;
+}
+
+// Gleiche Zuordnung und Fallback-Reihenfolge wie extractWithExiv2().
+// Texte werden einmal in die Arena von PhotoData kopiert, nicht nach UTF-16.
+static PhotoData fromFast(const FastMetadata& m) {
+    PhotoData data;
+    data.width = m.width;
+    data.height = m.height;
+
+    if (m.hasExif) {
+        data.make = data.store(m.make);
+        data.model = data.store(m.model);
+        data.iso = data.store(m.iso);
+        data.aperture = data.store(m.aperture);
+        data.exposure = data.store(m.exposure);
+        if (!m.dateTimeOriginal.empty()) {
+            data.takenAt = QDateTime::fromString(toQString(m.dateTimeOriginal), "yyyy:MM:dd HH:mm:ss");
+        }
+        data.gpsLat = m.gpsLat;
+        data.gpsLon = m.gpsLon;
+        data.gpsAlt = m.gpsAlt;
+    }
+
+    if (m.hasIptc) {
+        data.title = data.store(m.title);
+        data.caption = data.store(m.caption);
+        data.city = data.store(m.city);
+        data.province = data.store(m.province);
+        data.country = data.store(m.country);
+        data.countryCode = data.store(m.countryCode);
+        data.copyright = data.store(m.copyright);
+        data.keywords.reserve(m.keywords.size());
+        for (auto k : m.keywords) data.addKeyword(k);
+    }
+
+    if (m.hasXmp) {
+        if (m.hasXmpSubject) data.addKeyword(m.xmpSubject);
+        if (data.city.empty())        data.city = data.store(m.xmpCity);
+        if (data.province.empty())    data.province = data.store(m.xmpState);
+        if (data.country.empty())     data.country = data.store(m.xmpCountry);
+        if (data.countryCode.empty()) data.countryCode = data.store(m.xmpCountryCode);
+        if (data.title.empty())       data.title = data.store(m.xmpTitle);
+        if (data.description.empty()) data.description = data.store(m.xmpDescription);
+        if (data.copyright.empty())   data.copyright = data.store(m.xmpRights);
+    }
+    return data;
+}
+
+// Namen der Felder, in denen sich a und b unterscheiden
+QStringList MetadataExtractor::differences(const PhotoData& a, const PhotoData& b) {
+    QStringList diffs;
+    auto cmp = [&](const char* name, const auto& x, const auto& y) {
+        if (x != y) diffs << QString::fromLatin1(name);
+    };
+    cmp("width", a.width, b.width);
+    cmp("height", a.height, b.height);
+    cmp("make", a.make, b.make);
+    cmp("model", a.model, b.model);
+    cmp("iso", a.iso, b.iso);
+    cmp("aperture", a.aperture, b.aperture);
+    cmp("exposure", a.exposure, b.exposure);
+    cmp("takenAt", a.takenAt, b.takenAt);
+    cmp("gpsLat", a.gpsLat, b.gpsLat);
+    cmp("gpsLon", a.gpsLon, b.gpsLon);
+    cmp("gpsAlt", a.gpsAlt, b.gpsAlt);
+    cmp("title", a.title, b.title);
+    cmp("description", a.description, b.description);
+    cmp("copyright", a.copyright, b.copyright);
+    cmp("caption", a.caption, b.caption);
+    cmp("country", a.country, b.country);
+    cmp("city", a.city, b.city);
+    cmp("province", a.province, b.province);
+    cmp("countryCode", a.countryCode, b.countryCode);
+    cmp("keywords", a.keywords, b.keywords);
+    return diffs;
+}
+
+std::optional<PhotoData> MetadataExtractor::extractFast(const std::string& filepath) {
+    MappedHeader header(filepath);
+    if (!header.isValid()) return std::nullopt;
+    return extractFast(header.bytes());
+}
+
+std::optional<PhotoData> MetadataExtractor::extractFast(std::span<const unsigned char> header) {
+    FastMetadata meta;
+    if (FastMetadataReader::parse(header, meta) != FastMetadataReader::Status::Ok) return std::nullopt;
+    return fromFast(meta);
+}
+
+PhotoData MetadataExtractor::extract(const std::string& filepath) {
+    return extract(filepath, {});
+}
+
+PhotoData MetadataExtractor::extract(const std::string& filepath, std::span<const unsigned char> header) {
+    static const FastMode mode = fastModeFromEnvironment();
+    if (mode == FastMode::Off) return extractWithExiv2(filepath);
+
+    std::optional<PhotoData> data = header.empty() ? extractFast(filepath) : extractFast(header);
+    if (!data) return extractWithExiv2(filepath);
+
+    if (mode == FastMode::Verify) {
+        // Abweichungen protokollieren, Exiv2 gilt als Referenz
+        PhotoData ref = extractWithExiv2(filepath);
+        QStringList diffs = differences(*data, ref);
+        if (!diffs.isEmpty()) {
+            qWarning() << "Fast metadata mismatch for" << QString::fromStdString(filepath) << ":" << diffs.join(", ");
+        }
+        return ref;
+    }
+    return *data;
+}
@@ -1,30 +1,24 @@
 #pragma once
+#include <optional>
+#include <span>
 #include <string>
 #include <QString>
 #include <QStringList>
 #include <QDateTime>
-
-struct PhotoData {
-    // Basis
-    int width = 0;
-    int height = 0;
-    
-    // Exif
-    QString make, model, iso, aperture, exposure;
-    double gpsLat = 0.0;
-    double gpsLon = 0.0;
-    double gpsAlt = 0.0;
-    QDateTime takenAt;
-
-    // IPTC / XMP / Location Logic
-    QString title, description, copyright, caption;
-    QString country, city, province, countryCode;
-    
-    // Keywords (gesammelt aus IPTC und XMP)
-    QStringList keywords;
-};
+#include "PhotoData.h"
 
 class MetadataExtractor {
 public:
+    // Fast Path, bei Bedarf Exiv2 (WORKER_FAST_METADATA)
     static PhotoData extract(const std::string& filepath);
+
+    // Wie oben, der Fast Path liest aber die schon vorliegenden ersten Bytes
+    // (HTTP-Ingest); Exiv2 als Fallback weiterhin über filepath
+    static PhotoData extract(const std::string& filepath, std::span<const unsigned char> header);
+
+    // Einzelne Pfade, z.B. für Benchmarks und den Vergleich beider Parser
+    static PhotoData extractWithExiv2(const std::string& filepath);
+    static std::optional<PhotoData> extractFast(const std::string& filepath);   // nullopt -> nicht unterstützt
+    static std::optional<PhotoData> extractFast(std::span<const unsigned char> header);
+    static QStringList differences(const PhotoData& a, const PhotoData& b);
 };
\ No newline at end of file
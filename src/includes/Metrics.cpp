@@ -0,0 +1,178 @@
+#include "Metrics.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+size_t metrics_detail::shardIndex() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+}
+
+// --- MetricCounter ---
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (const auto& s : shards_) total += s.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+// --- MetricHistogram ---
+
+MetricHistogram::MetricHistogram(std::vector<double> bounds) : bounds_(std::move(bounds)) {
+    std::sort(bounds_.begin(), bounds_.end());
+    if (bounds_.size() > MAX_BUCKETS) {
+        qWarning() << "Histogram with" << bounds_.size() << "buckets, keeping" << MAX_BUCKETS;
+        bounds_.resize(MAX_BUCKETS);
+    }
+}
+
+void MetricHistogram::observe(double seconds) {
+    // Wenige Grenzen -> lineare Suche ist schneller als upper_bound
+    size_t i = 0;
+    while (i < bounds_.size() && seconds > bounds_[i]) ++i;
+
+    Shard& s = shards_[metrics_detail::shardIndex()];
+    s.buckets[i].fetch_add(1, std::memory_order_relaxed);
+    s.sumNanos.fetch_add(static_cast<uint64_t>(std::max(0.0, seconds) * 1e9), std::memory_order_relaxed);
+}
+
+MetricHistogram::Snapshot MetricHistogram::snapshot() const {
+    Snapshot snap;
+    snap.cumulative.assign(bounds_.size() + 1, 0);
+    uint64_t sumNanos = 0;
+    for (const auto& s : shards_) {
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            snap.cumulative[i] += s.buckets[i].load(std::memory_order_relaxed);
+        }
+        sumNanos += s.sumNanos.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 1; i < snap.cumulative.size(); ++i) snap.cumulative[i] += snap.cumulative[i - 1];
+    snap.count = snap.cumulative.back();
+    snap.sum = static_cast<double>(sumNanos) / 1e9;
+    return snap;
+}
+
+// --- MetricsRegistry ---
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+std::vector<double> MetricsRegistry::defaultLatencyBuckets() {
+    return {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help, Type type) {
+    for (auto& f : families_) {
+        if (f->name == name) return *f;
+    }
+    families_.push_back(std::make_unique<Family>(Family{name, help, type, {}}));
+    return *families_.back();
+}
+
+MetricsRegistry::Series* MetricsRegistry::findSeries(Family& f, const std::string& labels) {
+    for (auto& s : f.series) {
+        if (s.labels == labels) return &s;
+    }
+    return nullptr;
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard lock(mutex_);
+    Family& f = family(name, help, Type::Counter);
+    if (Series* s = findSeries(f, labels); s && s->counter) return *s->counter;
+
+    Series s;
+    s.labels = labels;
+    s.counter = std::make_unique<MetricCounter>();
+    f.series.push_back(std::move(s));
+    return *f.series.back().counter;
+}
+
+MetricHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                            const std::string& labels, std::vector<double> bounds) {
+    std::lock_guard lock(mutex_);
+    Family& f = family(name, help, Type::Histogram);
+    if (Series* s = findSeries(f, labels); s && s->histogram) return *s->histogram;
+
+    Series s;
+    s.labels = labels;
+    s.histogram = std::make_unique<MetricHistogram>(std::move(bounds));
+    f.series.push_back(std::move(s));
+    return *f.series.back().histogram;
+}
+
+void MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                            const std::string& labels, std::function<double()> read) {
+    std::lock_guard lock(mutex_);
+    Family& f = family(name, help, Type::Gauge);
+    if (Series* s = findSeries(f, labels)) {
+        s->read = std::move(read);
+        return;
+    }
+    f.series.push_back(Series{labels, nullptr, nullptr, std::move(read)});
+}
+
+void MetricsRegistry::counterFunction(const std::string& name, const std::string& help,
+                                      const std::string& labels, std::function<double()> read) {
+    std::lock_guard lock(mutex_);
+    Family& f = family(name, help, Type::Counter);
+    if (Series* s = findSeries(f, labels)) {
+        s->read = std::move(read);
+        return;
+    }
+    f.series.push_back(Series{labels, nullptr, nullptr, std::move(read)});
+}
+
+// Zahl im Prometheus-Format (+Inf/-Inf/NaN ausgeschrieben)
+static void writeValue(std::ostringstream& out, double v) {
+    if (std::isnan(v)) out << "NaN";
+    else if (std::isinf(v)) out << (v > 0 ? "+Inf" : "-Inf");
+    else out << v;
+}
+
+static std::string withLabels(const std::string& name, const std::string& labels, const std::string& extra = {}) {
+    std::string joined = labels;
+    if (!extra.empty()) joined += (joined.empty() ? "" : ",") + extra;
+    return joined.empty() ? name : name + "{" + joined + "}";
+}
+
+std::string MetricsRegistry::render() const {
+    std::ostringstream out;
+    out.precision(10);
+
+    std::lock_guard lock(mutex_);
+    for (const auto& f : families_) {
+        const char* type = f->type == Type::Counter ? "counter" : f->type == Type::Gauge ? "gauge" : "histogram";
+        out << "# HELP " << f->name << ' ' << f->help << '\n';
+        out << "# TYPE " << f->name << ' ' << type << '\n';
+
+        for (const auto& s : f->series) {
+            if (s.histogram) {
+                auto snap = s.histogram->snapshot();
+                const auto& bounds = s.histogram->bounds();
+                for (size_t i = 0; i < bounds.size(); ++i) {
+                    std::ostringstream le;
+                    le.precision(10);
+                    le << "le=\"" << bounds[i] << '"';
+                    out << withLabels(f->name + "_bucket", s.labels, le.str()) << ' ' << snap.cumulative[i] << '\n';
+                }
+                out << withLabels(f->name + "_bucket", s.labels, "le=\"+Inf\"") << ' ' << snap.count << '\n';
+                out << withLabels(f->name + "_sum", s.labels) << ' ';
+                writeValue(out, snap.sum);
+                out << '\n';
+                out << withLabels(f->name + "_count", s.labels) << ' ' << snap.count << '\n';
+            } else if (s.counter) {
+                out << withLabels(f->name, s.labels) << ' ' << s.counter->value() << '\n';
+            } else if (s.read) {
+                out << withLabels(f->name, s.labels) << ' ';
+                writeValue(out, s.read());
+                out << '\n';
+            }
+        }
+    }
+    return out.str();
+}
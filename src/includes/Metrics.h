@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Prometheus-Metriken für /metrics.
+// Zähler und Histogramme sind pro Thread-Shard aufgeteilt: ein Aufruf im
+// Hot Path ist ein relaxed fetch_add auf eine eigene Cache-Line, ohne Lock
+// und ohne geteilte Cache-Line zwischen den Worker-Threads.
+// Summiert wird erst beim Scrape.
+
+namespace metrics_detail {
+inline constexpr size_t SHARDS = 16;
+
+// Jeder Thread bekommt beim ersten Aufruf fest einen Shard zugeteilt
+size_t shardIndex();
+}
+
+class MetricCounter {
+public:
+    void inc(uint64_t n = 1) {
+        shards_[metrics_detail::shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, metrics_detail::SHARDS> shards_;
+};
+
+// Histogramm für Dauern in Sekunden (feste Bucket-Grenzen)
+class MetricHistogram {
+public:
+    static constexpr size_t MAX_BUCKETS = 24;
+
+    explicit MetricHistogram(std::vector<double> bounds);
+
+    void observe(double seconds);
+    void observe(std::chrono::steady_clock::duration d) {
+        observe(std::chrono::duration<double>(d).count());
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> cumulative;   // pro Grenze, letzter Eintrag = +Inf
+        double sum = 0.0;
+        uint64_t count = 0;
+    };
+    Snapshot snapshot() const;
+    const std::vector<double>& bounds() const { return bounds_; }
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, MAX_BUCKETS + 1> buckets{};
+        std::atomic<uint64_t> sumNanos{0};
+    };
+    std::vector<double> bounds_;
+    std::array<Shard, metrics_detail::SHARDS> shards_;
+};
+
+// Misst die Lebensdauer des Objekts
+class ScopedTimer {
+public:
+    explicit ScopedTimer(MetricHistogram& h) : hist_(h), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { hist_.observe(std::chrono::steady_clock::now() - start_); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    MetricHistogram& hist_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Registrierung (selten, mit Lock) und Ausgabe im Prometheus-Textformat.
+// Zurückgegebene Referenzen bleiben bis Prozessende gültig -> im Hot Path
+// einmal holen und z.B. in einer static-Variable merken.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    // labels im Prometheus-Format ohne Klammern, z.B. R"(reason="move")"
+    MetricCounter& counter(const std::string& name, const std::string& help,
+                           const std::string& labels = {});
+    MetricHistogram& histogram(const std::string& name, const std::string& help,
+                               const std::string& labels = {},
+                               std::vector<double> bounds = defaultLatencyBuckets());
+
+    // Wert wird erst beim Scrape abgefragt (Queue-Längen, Pool-Zustand, ...)
+    void gauge(const std::string& name, const std::string& help,
+               const std::string& labels, std::function<double()> read);
+    // Wie gauge(), aber für monoton steigende Werte, die woanders gezählt werden
+    void counterFunction(const std::string& name, const std::string& help,
+                         const std::string& labels, std::function<double()> read);
+
+    std::string render() const;
+
+    static std::vector<double> defaultLatencyBuckets();
+
+private:
+    MetricsRegistry() = default;
+
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        std::string labels;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricHistogram> histogram;
+        std::function<double()> read;
+    };
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<Series> series;
+    };
+
+    Family& family(const std::string& name, const std::string& help, Type type);
+    static Series* findSeries(Family& f, const std::string& labels);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_;
+};
@@ -0,0 +1,681 @@
+#include "Outbox.h"
+#include "ContentHash.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Eintrag: [u32 len][u8 type][u64 seq][Daten][u64 Prüfsumme über type..Daten]
+// len zählt type + seq + Daten. Ganzzahlen in Host-Byte-Reihenfolge (der Log
+// verlässt die Maschine nicht).
+static constexpr uint8_t RECORD_PAYLOAD = 1;
+static constexpr uint8_t RECORD_ACK = 2;       // Daten: n x u64 seq
+static constexpr size_t HEADER = 4;
+static constexpr size_t TRAILER = 8;
+static constexpr size_t MIN_BODY = 1 + 8;
+static constexpr uint32_t MAX_BODY = 64u << 20;
+static constexpr uint32_t NULL_TEXT = 0xFFFFFFFF;
+
+static constexpr uint8_t FLAG_LINK_ONLY = 1;
+static constexpr uint8_t FLAG_REPLACE = 2;
+static constexpr uint8_t FLAG_PHASH = 4;
+
+// Helper: Integer aus Umgebungsvariable, sonst Default
+static int envInt(const char* name, int defaultValue) {
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+OutboxConfig OutboxConfig::fromEnvironment() {
+    OutboxConfig cfg;
+    QString mode = qEnvironmentVariable("WORKER_OUTBOX", "off");
+    cfg.enabled = mode == "on" || mode == "1";
+    cfg.dir = qEnvironmentVariable("WORKER_OUTBOX_DIR", "outbox").toStdString();
+    cfg.segmentBytes = static_cast<size_t>(std::clamp(envInt("WORKER_OUTBOX_SEGMENT_MB", 64), 1, 1024)) << 20;
+    cfg.maxAttempts = std::max(1, envInt("WORKER_OUTBOX_MAX_ATTEMPTS", 10));
+    cfg.maxRetryDelay = std::chrono::seconds(std::max(1, envInt("WORKER_OUTBOX_RETRY_MAX_S", 30)));
+    return cfg;
+}
+
+// --- Serialisierung ---
+
+template <typename T>
+static void put(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+// null (PhotoData: Feld nicht vorhanden) bleibt null
+static void putText(std::string& out, std::string_view s) {
+    if (!s.data()) {
+        put<uint32_t>(out, NULL_TEXT);
+        return;
+    }
+    put<uint32_t>(out, static_cast<uint32_t>(s.size()));
+    out.append(s);
+}
+
+static void putDate(std::string& out, const QDateTime& d) {
+    put<int64_t>(out, d.isValid() ? d.toMSecsSinceEpoch() : INT64_MIN);
+}
+
+struct Reader {
+    std::string_view in;
+    size_t pos = 0;
+    bool ok = true;
+
+    template <typename T>
+    T get() {
+        T v{};
+        if (pos + sizeof(T) > in.size()) {
+            ok = false;
+            return v;
+        }
+        std::memcpy(&v, in.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+
+    std::string_view text() {
+        const uint32_t len = get<uint32_t>();
+        if (!ok || len == NULL_TEXT) return {};
+        if (pos + len > in.size()) {
+            ok = false;
+            return {};
+        }
+        std::string_view s(in.data() + pos, len);
+        pos += len;
+        return s;
+    }
+
+    QDateTime date() {
+        const int64_t ms = get<int64_t>();
+        return ms == INT64_MIN ? QDateTime() : QDateTime::fromMSecsSinceEpoch(ms);
+    }
+};
+
+// onStored bleibt außen vor (Callback im Speicher)
+static void encodePayload(std::string& out, const WorkerPayload& p) {
+    putText(out, p.filename);
+    putText(out, p.relPath);
+    putText(out, p.fullPath);
+    putText(out, p.user);
+    put<int64_t>(out, p.fileSize);
+    putDate(out, p.fileDate);
+    putText(out, p.contentHash);
+    put<uint8_t>(out, (p.linkOnly ? FLAG_LINK_ONLY : 0) | (p.replaceExisting ? FLAG_REPLACE : 0) |
+                          (p.phash ? FLAG_PHASH : 0));
+    put<uint64_t>(out, p.phash.value_or(0));
+
+    const PhotoData& m = p.meta;
+    put<int32_t>(out, m.width);
+    put<int32_t>(out, m.height);
+    for (std::string_view s : {m.make, m.model, m.iso, m.aperture, m.exposure}) putText(out, s);
+    put<double>(out, m.gpsLat);
+    put<double>(out, m.gpsLon);
+    put<double>(out, m.gpsAlt);
+    putDate(out, m.takenAt);
+    for (std::string_view s : {m.title, m.description, m.copyright, m.caption, m.country, m.city, m.province,
+                               m.countryCode, m.continent}) {
+        putText(out, s);
+    }
+    put<uint32_t>(out, static_cast<uint32_t>(m.keywords.size()));
+    for (std::string_view k : m.keywords) putText(out, k);
+}
+
+static bool decodePayload(std::string_view data, WorkerPayload& p) {
+    Reader r{data};
+    p.filename = r.text();
+    p.relPath = r.text();
+    p.fullPath = r.text();
+    p.user = r.text();
+    p.fileSize = r.get<int64_t>();
+    p.fileDate = r.date();
+    p.contentHash = r.text();
+    const auto flags = r.get<uint8_t>();
+    const auto phash = r.get<uint64_t>();
+    p.linkOnly = flags & FLAG_LINK_ONLY;
+    p.replaceExisting = flags & FLAG_REPLACE;
+    if (flags & FLAG_PHASH) p.phash = phash;
+
+    PhotoData& m = p.meta;
+    m.width = r.get<int32_t>();
+    m.height = r.get<int32_t>();
+    for (std::string_view* s : {&m.make, &m.model, &m.iso, &m.aperture, &m.exposure}) *s = m.store(r.text());
+    m.gpsLat = r.get<double>();
+    m.gpsLon = r.get<double>();
+    m.gpsAlt = r.get<double>();
+    m.takenAt = r.date();
+    for (std::string_view* s : {&m.title, &m.description, &m.copyright, &m.caption, &m.country, &m.city,
+                                &m.province, &m.countryCode, &m.continent}) {
+        *s = m.store(r.text());
+    }
+    const auto keywords = r.get<uint32_t>();
+    for (uint32_t i = 0; r.ok && i < keywords; ++i) m.addKeyword(r.text());
+    return r.ok && r.pos == data.size();
+}
+
+static uint64_t checksum(std::string_view body) {
+    return ContentHash::ofBuffer(body.data(), body.size()).low;
+}
+
+static void appendFrame(std::string& out, uint8_t type, uint64_t seq, std::string_view data) {
+    const size_t start = out.size();
+    put<uint32_t>(out, static_cast<uint32_t>(MIN_BODY + data.size()));
+    put<uint8_t>(out, type);
+    put<uint64_t>(out, seq);
+    out.append(data);
+    put<uint64_t>(out, checksum(std::string_view(out).substr(start + HEADER)));
+}
+
+// --- Dateien ---
+
+Outbox::File::~File() {
+    if (fd >= 0) ::close(fd);
+}
+
+static bool writeAll(int fd, const char* data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+static bool readAll(int fd, char* data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pread(fd, data, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+// Neue/gelöschte Segmente überleben einen Absturz erst nach fsync des Verzeichnisses
+static void syncDirectory(const fs::path& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    if (::fsync(fd) != 0) qWarning() << "Outbox: fsync of directory failed:" << std::strerror(errno);
+    ::close(fd);
+}
+
+static fs::path segmentPath(const fs::path& dir, uint64_t id) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llu.wal", static_cast<unsigned long long>(id));
+    return dir / name;
+}
+
+// --- Outbox ---
+
+Outbox::Outbox(OutboxConfig cfg) : cfg_(std::move(cfg)) {}
+
+Outbox::~Outbox() {
+    close();
+}
+
+bool Outbox::open() {
+    std::error_code ec;
+    fs::create_directories(cfg_.dir, ec);
+    if (ec) {
+        qCritical() << "Outbox: cannot create" << QString::fromStdString(cfg_.dir.string()) << ":"
+                    << QString::fromStdString(ec.message());
+        return false;
+    }
+
+    std::vector<uint64_t> ids;
+    for (const auto& entry : fs::directory_iterator(cfg_.dir, ec)) {
+        if (entry.path().extension() != ".wal") continue;
+        const std::string stem = entry.path().stem().string();
+        if (stem.empty() || !std::all_of(stem.begin(), stem.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            continue;
+        ids.push_back(std::stoull(stem));
+    }
+    std::sort(ids.begin(), ids.end());
+
+    std::lock_guard writeLock(writeMutex_);
+    {
+        std::lock_guard lock(mutex_);
+        uint64_t maxSeq = 0;
+        for (uint64_t id : ids) {
+            Segment& seg = segments_[id];
+            seg.path = segmentPath(cfg_.dir, id);
+            if (!scanSegment(id, seg, maxSeq)) return false;
+            nextSegment_ = id + 1;
+        }
+        nextSeq_ = maxSeq + 1;
+        sessionStart_ = nextSeq_;
+        cursorSegment_ = segments_.empty() ? nextSegment_ : segments_.begin()->first;
+        cursorOffset_ = 0;
+
+        if (!pending_.empty()) {
+            qDebug() << "Outbox: replaying" << pending_.size() << "records from" << segments_.size() << "segments";
+        }
+        dropFinishedSegments();
+    }
+    return startSegment();
+}
+
+// Ein vorhandenes Segment lesen: Einträge prüfen, offene Fotos merken,
+// Bestätigungen anwenden. Ab dem ersten kaputten Eintrag wird abgeschnitten
+// (Absturz mitten im Schreiben).
+bool Outbox::scanSegment(uint64_t id, Segment& seg, uint64_t& maxSeq) {
+    auto file = std::make_shared<File>();
+    file->fd = ::open(seg.path.c_str(), O_RDWR | O_CLOEXEC);
+    if (file->fd < 0) {
+        qCritical() << "Outbox: cannot open" << QString::fromStdString(seg.path.string()) << ":"
+                    << std::strerror(errno);
+        return false;
+    }
+    std::error_code ec;
+    const uint64_t fileSize = fs::file_size(seg.path, ec);
+    std::string data(ec ? 0 : fileSize, '\0');
+    if (!readAll(file->fd, data.data(), data.size(), 0)) {
+        qCritical() << "Outbox: cannot read" << QString::fromStdString(seg.path.string());
+        return false;
+    }
+
+    uint64_t pos = 0;
+    while (pos + HEADER <= data.size()) {
+        uint32_t len = 0;
+        std::memcpy(&len, data.data() + pos, sizeof(len));
+        if (len < MIN_BODY || len > MAX_BODY || pos + HEADER + len + TRAILER > data.size()) break;
+        std::string_view body(data.data() + pos + HEADER, len);
+        uint64_t sum = 0;
+        std::memcpy(&sum, body.data() + len, sizeof(sum));
+        if (sum != checksum(body)) break;
+
+        const auto type = static_cast<uint8_t>(body[0]);
+        uint64_t seq = 0;
+        std::memcpy(&seq, body.data() + 1, sizeof(seq));
+        if (type == RECORD_PAYLOAD) {
+            pending_[seq] = id;
+            seg.outstanding++;
+            maxSeq = std::max(maxSeq, seq);
+        } else if (type == RECORD_ACK) {
+            std::string_view seqs = body.substr(MIN_BODY);
+            for (size_t i = 0; i + 8 <= seqs.size(); i += 8) {
+                uint64_t acked = 0;
+                std::memcpy(&acked, seqs.data() + i, sizeof(acked));
+                maxSeq = std::max(maxSeq, acked);
+            }
+            applyAcks(seqs);
+        }
+        pos += HEADER + len + TRAILER;
+    }
+
+    if (pos < data.size()) {
+        qWarning() << "Outbox: truncating" << QString::fromStdString(seg.path.string()) << "from" << data.size()
+                   << "to" << pos << "bytes (incomplete record)";
+        if (::ftruncate(file->fd, static_cast<off_t>(pos)) != 0 || ::fdatasync(file->fd) != 0) {
+            qCritical() << "Outbox: truncate failed:" << std::strerror(errno);
+            return false;
+        }
+    }
+    seg.file = std::move(file);
+    seg.size = pos;
+    seg.durable = pos;
+    seg.sealed = true;
+    return true;
+}
+
+// Aktuelles Segment sichern und abschließen, ein neues beginnen
+bool Outbox::startSegment() {
+    if (active_) {
+        if (::fdatasync(active_->fd) != 0) {
+            qCritical() << "Outbox: fdatasync failed:" << std::strerror(errno);
+            return false;
+        }
+        std::lock_guard lock(mutex_);
+        auto it = segments_.find(activeId_);
+        if (it != segments_.end()) {
+            it->second.durable = it->second.size;
+            it->second.sealed = true;
+        }
+        dropFinishedSegments();
+        cv_.notify_all();
+    }
+
+    const uint64_t id = nextSegment_++;
+    Segment seg;
+    seg.path = segmentPath(cfg_.dir, id);
+    seg.file = std::make_shared<File>();
+    seg.file->fd = ::open(seg.path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (seg.file->fd < 0) {
+        qCritical() << "Outbox: cannot create" << QString::fromStdString(seg.path.string()) << ":"
+                    << std::strerror(errno);
+        active_.reset();
+        return false;
+    }
+    syncDirectory(cfg_.dir);
+
+    active_ = seg.file;
+    activeId_ = id;
+    activeSize_ = 0;
+    std::lock_guard lock(mutex_);
+    segments_.emplace(id, std::move(seg));
+    return true;
+}
+
+void Outbox::close() {
+    {
+        std::lock_guard lock(mutex_);
+        if (closed_) return;
+        closed_ = true;
+    }
+    cv_.notify_all();
+}
+
+// Frames ans aktive Segment hängen; registered läuft unter mutex_, bevor ein
+// anderer Thread die Einträge per fsync für next() freigeben kann
+bool Outbox::writeFrames(const std::string& frames, uint64_t& segment, uint64_t& end,
+                         const std::function<void(uint64_t segment)>& registered) {
+    if (!active_) return false;
+    if (activeSize_ > 0 && activeSize_ + frames.size() > cfg_.segmentBytes && !startSegment()) return false;
+    if (!writeAll(active_->fd, frames.data(), frames.size(), activeSize_)) {
+        qCritical() << "Outbox: write failed:" << std::strerror(errno);
+        // Halben Eintrag nicht stehen lassen
+        if (::ftruncate(active_->fd, static_cast<off_t>(activeSize_)) != 0) active_.reset();
+        return false;
+    }
+    activeSize_ += frames.size();
+    segment = activeId_;
+    end = activeSize_;
+
+    std::lock_guard lock(mutex_);
+    segments_[activeId_].size = activeSize_;
+    registered(activeId_);
+    return true;
+}
+
+// Group Commit: wer den syncMutex_ bekommt, sichert alles bisher Geschriebene.
+// Die anderen finden ihre Einträge danach schon gesichert vor.
+bool Outbox::sync(const std::shared_ptr<File>& file, uint64_t segment, uint64_t end) {
+    std::lock_guard syncLock(syncMutex_);
+    {
+        std::lock_guard lock(mutex_);
+        auto it = segments_.find(segment);
+        if (it == segments_.end() || it->second.durable >= end) return true;
+    }
+    uint64_t target = end;
+    {
+        std::lock_guard writeLock(writeMutex_);
+        if (activeId_ == segment) target = activeSize_;
+    }
+    if (::fdatasync(file->fd) != 0) {
+        qCritical() << "Outbox: fdatasync failed:" << std::strerror(errno);
+        return false;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        auto it = segments_.find(segment);
+        if (it != segments_.end()) it->second.durable = std::max(it->second.durable, target);
+    }
+    cv_.notify_all();
+    return true;
+}
+
+bool Outbox::append(std::vector<WorkerPayload>& payloads, std::vector<uint64_t>* held) {
+    if (payloads.empty()) return true;
+    {
+        std::lock_guard lock(mutex_);
+        if (closed_) return false;
+    }
+
+    // Serialisieren ohne Lock, seq erst beim Schreiben
+    std::vector<std::string> bodies(payloads.size());
+    size_t total = 0;
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        encodePayload(bodies[i], payloads[i]);
+        total += HEADER + MIN_BODY + bodies[i].size() + TRAILER;
+    }
+
+    std::shared_ptr<File> file;
+    uint64_t segment = 0, end = 0;
+    {
+        std::lock_guard writeLock(writeMutex_);
+        const uint64_t first = nextSeq_;
+        std::string frames;
+        frames.reserve(total);
+        for (size_t i = 0; i < bodies.size(); ++i) appendFrame(frames, RECORD_PAYLOAD, first + i, bodies[i]);
+
+        bool ok = writeFrames(frames, segment, end, [&](uint64_t id) {
+            Segment& seg = segments_[id];
+            for (size_t i = 0; i < payloads.size(); ++i) {
+                pending_[first + i] = id;
+                if (held) held_.insert(first + i);
+                if (payloads[i].onStored) callbacks_[first + i] = std::move(payloads[i].onStored);
+            }
+            seg.outstanding += payloads.size();
+        });
+        if (!ok) return false;
+        nextSeq_ = first + payloads.size();
+        if (held) {
+            held->clear();
+            for (size_t i = 0; i < payloads.size(); ++i) held->push_back(first + i);
+        }
+        file = active_;
+    }
+    // Schlägt der fsync fehl, bleiben die Einträge trotzdem im Log
+    return sync(file, segment, end);
+}
+
+void Outbox::publish(const std::vector<uint64_t>& seqs) {
+    {
+        std::lock_guard lock(mutex_);
+        for (uint64_t seq : seqs) {
+            held_.erase(seq);
+            auto it = heldRecords_.find(seq);
+            if (it == heldRecords_.end()) continue;   // noch nicht gelesen -> kommt regulär
+            retry_.push_back(std::move(it->second));
+            heldRecords_.erase(it);
+        }
+    }
+    cv_.notify_all();
+}
+
+void Outbox::cancel(const std::vector<uint64_t>& seqs) {
+    {
+        std::lock_guard lock(mutex_);
+        for (uint64_t seq : seqs) {
+            held_.erase(seq);
+            heldRecords_.erase(seq);
+        }
+    }
+    acknowledge(seqs);
+}
+
+void Outbox::applyAcks(std::string_view seqs) {
+    for (size_t i = 0; i + 8 <= seqs.size(); i += 8) {
+        uint64_t seq = 0;
+        std::memcpy(&seq, seqs.data() + i, sizeof(seq));
+        auto it = pending_.find(seq);
+        if (it == pending_.end()) continue;
+        auto seg = segments_.find(it->second);
+        if (seg != segments_.end() && seg->second.outstanding > 0) seg->second.outstanding--;
+        pending_.erase(it);
+        callbacks_.erase(seq);
+    }
+}
+
+void Outbox::acknowledge(const std::vector<uint64_t>& seqs) {
+    if (seqs.empty()) return;
+    std::string data(seqs.size() * sizeof(uint64_t), '\0');
+    std::memcpy(data.data(), seqs.data(), data.size());
+    std::string frame;
+    appendFrame(frame, RECORD_ACK, 0, data);
+
+    std::lock_guard writeLock(writeMutex_);
+    uint64_t segment = 0, end = 0;
+    bool written = writeFrames(frame, segment, end, [&](uint64_t) {
+        applyAcks(data);
+        dropFinishedSegments();
+    });
+    if (!written) {
+        // Nur im Speicher bestätigen: nach einem Neustart kommt das Foto per Upsert noch einmal
+        std::lock_guard lock(mutex_);
+        applyAcks(data);
+    }
+}
+
+void Outbox::retry(std::vector<OutboxRecord> records) {
+    {
+        std::lock_guard lock(mutex_);
+        for (auto& r : records) retry_.push_back(std::move(r));
+    }
+    cv_.notify_all();
+}
+
+void Outbox::reject(const OutboxRecord& record, const std::string& reason) {
+    const WorkerPayload& p = record.payload;
+    std::ofstream log(cfg_.dir / "rejected.log", std::ios::app);
+    log << QDateTime::currentDateTime().toString(Qt::ISODate).toStdString() << '\t' << record.seq << '\t'
+        << (p.linkOnly ? "link" : "picture") << '\t' << p.user << '\t' << p.relPath << '\t' << p.filename << '\t'
+        << reason << '\n';
+    qCritical() << "Outbox: giving up on" << QString::fromStdString(p.filename) << "after"
+                << record.attempts << "attempts:" << QString::fromStdString(reason);
+    acknowledge({record.seq});
+}
+
+bool Outbox::sleepFor(std::chrono::milliseconds delay) {
+    std::unique_lock lock(mutex_);
+    return !cv_.wait_for(lock, delay, [&] { return closed_; });
+}
+
+// Nächsten gesicherten, unbestätigten Eintrag ab dem Lesezeiger
+bool Outbox::readNext(OutboxRecord& out) {
+    std::string frame;
+    while (true) {
+        auto it = segments_.lower_bound(cursorSegment_);
+        if (it == segments_.end()) return false;
+        if (it->first != cursorSegment_) {
+            cursorSegment_ = it->first;
+            cursorOffset_ = 0;
+        }
+        const Segment& seg = it->second;
+        if (cursorOffset_ + HEADER + MIN_BODY + TRAILER > seg.durable) {
+            if (!seg.sealed) return false;
+            cursorSegment_++;
+            cursorOffset_ = 0;
+            continue;
+        }
+
+        uint32_t len = 0;
+        if (!readAll(seg.file->fd, reinterpret_cast<char*>(&len), sizeof(len), cursorOffset_) || len < MIN_BODY ||
+            cursorOffset_ + HEADER + len + TRAILER > seg.durable) {
+            qCritical() << "Outbox: unreadable record in" << QString::fromStdString(seg.path.string()) << "at"
+                        << cursorOffset_;
+            cursorSegment_++;
+            cursorOffset_ = 0;
+            continue;
+        }
+        frame.resize(len + TRAILER);
+        if (!readAll(seg.file->fd, frame.data(), frame.size(), cursorOffset_ + HEADER)) return false;
+        cursorOffset_ += HEADER + len + TRAILER;
+
+        std::string_view body(frame.data(), len);
+        uint64_t sum = 0, seq = 0;
+        std::memcpy(&sum, frame.data() + len, sizeof(sum));
+        std::memcpy(&seq, body.data() + 1, sizeof(seq));
+        if (static_cast<uint8_t>(body[0]) != RECORD_PAYLOAD || !pending_.contains(seq)) continue;
+        if (sum != checksum(body)) {
+            qCritical() << "Outbox: checksum mismatch for record" << seq;
+            continue;
+        }
+
+        out = OutboxRecord{};
+        out.seq = seq;
+        out.replayed = seq < sessionStart_;
+        if (!decodePayload(body.substr(MIN_BODY), out.payload)) {
+            qCritical() << "Outbox: cannot decode record" << seq;
+            continue;
+        }
+        auto cb = callbacks_.find(seq);
+        if (cb != callbacks_.end()) {
+            out.payload.onStored = std::move(cb->second);
+            callbacks_.erase(cb);
+        }
+        if (held_.contains(seq)) {
+            // Verschieben läuft noch: beiseitelegen bis publish()
+            heldRecords_.emplace(seq, std::move(out));
+            continue;
+        }
+        return true;
+    }
+}
+
+std::vector<OutboxRecord> Outbox::next(size_t max, std::chrono::milliseconds window) {
+    std::vector<OutboxRecord> out;
+    auto take = [&] {
+        while (out.size() < max) {
+            if (!retry_.empty()) {
+                out.push_back(std::move(retry_.front()));
+                retry_.pop_front();
+                continue;
+            }
+            OutboxRecord r;
+            if (!readNext(r)) break;
+            out.push_back(std::move(r));
+        }
+        return closed_ || out.size() >= max;
+    };
+
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [&] { return take() || !out.empty(); });
+    if (!closed_ && out.size() < max && window.count() > 0) {
+        cv_.wait_for(lock, window, take);
+    }
+    if (closed_) {
+        // Nicht geschrieben: Callbacks zurück, Einträge bleiben für den nächsten Start
+        for (auto& r : out) {
+            if (r.payload.onStored) callbacks_[r.seq] = std::move(r.payload.onStored);
+        }
+        out.clear();
+    }
+    return out;
+}
+
+// Vorne liegende, abgeschlossene Segmente ohne offene Fotos löschen.
+// Nur von vorne: eine Bestätigung liegt immer im selben oder einem späteren
+// Segment als ihr Foto.
+void Outbox::dropFinishedSegments() {
+    bool removed = false;
+    while (!segments_.empty()) {
+        auto it = segments_.begin();
+        if (!it->second.sealed || it->second.outstanding > 0) break;
+        std::error_code ec;
+        fs::remove(it->second.path, ec);
+        if (ec) {
+            qWarning() << "Outbox: cannot remove" << QString::fromStdString(it->second.path.string());
+            break;
+        }
+        segments_.erase(it);
+        removed = true;
+    }
+    if (removed) syncDirectory(cfg_.dir);
+}
+
+size_t Outbox::backlog() const {
+    std::lock_guard lock(mutex_);
+    return pending_.size();
+}
+
+uint64_t Outbox::bytesOnDisk() const {
+    std::lock_guard lock(mutex_);
+    uint64_t total = 0;
+    for (const auto& [id, seg] : segments_) total += seg.size;
+    return total;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "DbManager.h"
+
+// Lokaler Write-Ahead-Log zwischen Verschieben und DB (WORKER_OUTBOX=on).
+// Verschobene Fotos werden erst hier dauerhaft vorgemerkt (fdatasync, gleichzeitige
+// Schreiber teilen sich einen), der DB-Writer arbeitet den Log ab und bestätigt
+// nach dem Commit. Ist die DB weg, läuft die Aufnahme weiter, der Log wächst.
+// Nach einem Neustart werden unbestätigte Einträge erneut geschrieben.
+//
+// WORKER_OUTBOX_DIR (outbox), WORKER_OUTBOX_SEGMENT_MB (64),
+// WORKER_OUTBOX_MAX_ATTEMPTS (10, nur bei erreichbarer DB), WORKER_OUTBOX_RETRY_MAX_S (30)
+struct OutboxConfig {
+    bool enabled = false;
+    std::filesystem::path dir = "outbox";
+    size_t segmentBytes = size_t{64} << 20;
+    int maxAttempts = 10;
+    std::chrono::milliseconds maxRetryDelay{30000};
+
+    static OutboxConfig fromEnvironment();
+};
+
+struct OutboxRecord {
+    uint64_t seq = 0;
+    WorkerPayload payload;
+    bool replayed = false;   // aus einem früheren Lauf: evtl. schon committed
+    int attempts = 0;        // fehlgeschlagene Versuche bei erreichbarer DB
+};
+
+// Segmente "<Nummer>.wal", Einträge: Länge, Typ, seq, Daten, Prüfsumme.
+// Bestätigungen sind eigene Einträge (ohne fsync: geht eine verloren, wird das
+// Foto nach dem Neustart per Upsert noch einmal geschrieben). Segmente werden nur
+// von vorne gelöscht, sobald alle ihre Fotos bestätigt sind.
+class Outbox {
+public:
+    explicit Outbox(OutboxConfig cfg);
+    ~Outbox();
+
+    Outbox(const Outbox&) = delete;
+    Outbox& operator=(const Outbox&) = delete;
+
+    // Segmente einlesen, abgerissenes Ende abschneiden, neues Segment beginnen
+    bool open();
+
+    // next() liefert danach nichts mehr; offene Einträge bleiben für den nächsten Start
+    void close();
+
+    // Dauerhaft anhängen. Kehrt erst nach dem fdatasync zurück.
+    // onStored bleibt im Speicher und hängt später am gelesenen Eintrag.
+    // Mit held: Absicht vor dem Verschieben. next() liefert die Einträge erst nach
+    // publish(); cancel() verwirft sie. Nach einem Absturz kommen sie per Replay
+    // (ohne Datei am Ziel -> verworfen).
+    bool append(std::vector<WorkerPayload>& payloads, std::vector<uint64_t>* held = nullptr);
+    void publish(const std::vector<uint64_t>& seqs);
+    void cancel(const std::vector<uint64_t>& seqs);
+
+    // Bis zu max Einträge (Wiederholungen zuerst). Blockiert, bis einer da ist,
+    // und wartet dann höchstens window auf weitere. Leer -> geschlossen.
+    std::vector<OutboxRecord> next(size_t max, std::chrono::milliseconds window);
+
+    void acknowledge(const std::vector<uint64_t>& seqs);
+
+    // Später erneut liefern (vor neuen Einträgen)
+    void retry(std::vector<OutboxRecord> records);
+
+    // Aufgeben: Zeile nach rejected.log, dann bestätigen
+    void reject(const OutboxRecord& record, const std::string& reason);
+
+    // Pause zwischen zwei Versuchen; false -> geschlossen
+    bool sleepFor(std::chrono::milliseconds delay);
+
+    const OutboxConfig& config() const { return cfg_; }
+    size_t backlog() const;   // vorgemerkt, nicht bestätigt
+    uint64_t bytesOnDisk() const;
+
+private:
+    struct File {
+        int fd = -1;
+        ~File();
+    };
+
+    struct Segment {
+        std::filesystem::path path;
+        std::shared_ptr<File> file;
+        uint64_t size = 0;         // geschrieben
+        uint64_t durable = 0;      // gesichert und für next() lesbar
+        size_t outstanding = 0;    // Fotos ohne Bestätigung
+        bool sealed = false;       // es kommt nichts mehr dazu
+    };
+
+    bool scanSegment(uint64_t id, Segment& seg, uint64_t& maxSeq);
+    bool startSegment();                                                       // writeMutex_
+    bool writeFrames(const std::string& frames, uint64_t& segment, uint64_t& end,
+                     const std::function<void(uint64_t segment)>& registered);  // writeMutex_ -> mutex_
+    bool sync(const std::shared_ptr<File>& file, uint64_t segment, uint64_t end);
+    void applyAcks(std::string_view seqs);                                     // mutex_
+    bool readNext(OutboxRecord& out);                                          // mutex_
+    void dropFinishedSegments();                                               // mutex_
+
+    OutboxConfig cfg_;
+
+    // Schreiben: aktives Segment
+    std::mutex writeMutex_;
+    std::shared_ptr<File> active_;
+    uint64_t activeId_ = 0;
+    uint64_t activeSize_ = 0;
+    uint64_t nextSegment_ = 1;
+    uint64_t nextSeq_ = 1;
+    std::mutex syncMutex_;   // ein fdatasync für alle, die gerade warten
+
+    // Lesen, Bestätigungen, Segmentliste
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<uint64_t, Segment> segments_;                 // Nummer -> Segment
+    std::unordered_map<uint64_t, uint64_t> pending_;      // seq -> Segment, unbestätigt
+    std::unordered_map<uint64_t, std::function<void(qint64)>> callbacks_;
+    std::deque<OutboxRecord> retry_;                       // Wiederholungen und freigegebene Absichten
+    std::unordered_set<uint64_t> held_;                    // Absichten vor dem Verschieben
+    std::unordered_map<uint64_t, OutboxRecord> heldRecords_;   // schon gelesen, noch nicht freigegeben
+    uint64_t cursorSegment_ = 0;
+    uint64_t cursorOffset_ = 0;
+    uint64_t sessionStart_ = 1;   // kleinere seq -> aus einem früheren Lauf
+    bool closed_ = false;
+};
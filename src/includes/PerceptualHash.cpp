@@ -0,0 +1,238 @@
+#include "PerceptualHash.h"
+#include "DbPool.h"
+#include "DerivativeGenerator.h"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
+#include <numbers>
+
+namespace fs = std::filesystem;
+
+static int envInt(const char* name, int defaultValue) {
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+PerceptualHashConfig PerceptualHashConfig::fromEnvironment() {
+    PerceptualHashConfig cfg;
+    QString mode = qEnvironmentVariable("WORKER_PHASH", "off");
+    cfg.enabled = (mode == "on" || mode == "1");
+    cfg.maxDistance = std::clamp(envInt("WORKER_PHASH_DISTANCE", 8), 0, PerceptualIndex::MAX_DISTANCE);
+    cfg.maxMatches = static_cast<size_t>(std::max(1, envInt("WORKER_PHASH_MAX_MATCHES", 20)));
+    return cfg;
+}
+
+// --- Hash ---
+
+// Zeilen 0..LOW-1 der orthonormalen DCT-II Matrix (SIZE Punkte)
+static const std::array<float, PerceptualHash::LOW * PerceptualHash::SIZE>& dctTable() {
+    static const auto table = [] {
+        constexpr int N = PerceptualHash::SIZE;
+        std::array<float, PerceptualHash::LOW * N> t{};
+        for (int u = 0; u < PerceptualHash::LOW; ++u) {
+            const double scale = std::sqrt((u == 0 ? 1.0 : 2.0) / N);
+            for (int x = 0; x < N; ++x) {
+                t[u * N + x] = static_cast<float>(scale * std::cos((2 * x + 1) * u * std::numbers::pi / (2 * N)));
+            }
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint64_t PerceptualHash::compute(const RgbImage& img) {
+    constexpr int N = SIZE;
+    const RgbImage small = (img.width == N && img.height == N) ? img : resizeRgb(img, N, N);
+
+    // Graustufen (BT.601). Wie in ImageResize: flache float-Zeilen, die der
+    // Compiler vektorisiert, statt handgeschriebener Intrinsics.
+    float gray[N * N];
+    const uint8_t* px = small.pixels.data();
+    for (int i = 0; i < N * N; ++i) {
+        gray[i] = 0.299f * px[3 * i] + 0.587f * px[3 * i + 1] + 0.114f * px[3 * i + 2];
+    }
+
+    // Separable DCT, nur die LOW niedrigsten Frequenzen je Richtung:
+    // rows = C[LOW x N] * gray, coeffs = rows * C^T
+    const auto& c = dctTable();
+    float rows[LOW * N] = {};
+    for (int u = 0; u < LOW; ++u) {
+        float* r = &rows[u * N];
+        for (int y = 0; y < N; ++y) {
+            const float k = c[u * N + y];
+            const float* g = &gray[y * N];
+            for (int x = 0; x < N; ++x) r[x] += k * g[x];
+        }
+    }
+    float coeffs[LOW * LOW];
+    for (int u = 0; u < LOW; ++u) {
+        for (int v = 0; v < LOW; ++v) {
+            float sum = 0.0f;
+            for (int x = 0; x < N; ++x) sum += rows[u * N + x] * c[v * N + x];
+            coeffs[u * LOW + v] = sum;
+        }
+    }
+
+    float sorted[LOW * LOW];
+    std::copy(std::begin(coeffs), std::end(coeffs), sorted);
+    std::sort(std::begin(sorted), std::end(sorted));
+    const float median = (sorted[LOW * LOW / 2 - 1] + sorted[LOW * LOW / 2]) / 2.0f;
+
+    uint64_t hash = 0;
+    for (int i = 0; i < LOW * LOW; ++i) {
+        if (coeffs[i] > median) hash |= uint64_t{1} << i;
+    }
+    return hash;
+}
+
+std::optional<uint64_t> PerceptualHash::ofFile(const fs::path& file) {
+    // 64 px reichen für 32x32; libjpeg dekodiert dann fast immer mit 1/8
+    RgbImage decoded;
+    std::string error;
+    if (!DerivativeGenerator::decodeJpegScaled(file, 2 * SIZE, decoded, error)) return std::nullopt;
+    return compute(decoded);
+}
+
+// --- Index ---
+
+PerceptualIndex& PerceptualIndex::instance() {
+    static PerceptualIndex index;
+    return index;
+}
+
+PerceptualIndex::PerceptualIndex() {
+    for (auto& table : buckets_) table.resize(size_t{1} << CHUNK_BITS);
+}
+
+bool PerceptualIndex::load() {
+    size_t loaded = 0;
+    {
+        DbPool::Lease lease = DbPool::instance().acquire();
+        if (!lease.isValid()) return false;
+
+        QSqlQuery q(lease.db());
+        q.setForwardOnly(true);
+        if (!q.exec("SELECT phash, id FROM pictures WHERE phash IS NOT NULL")) {
+            qCritical() << "Loading perceptual hashes failed:" << q.lastError().text();
+            return false;
+        }
+
+        std::unique_lock lock(mutex_);
+        while (q.next()) {
+            insertLocked(static_cast<uint64_t>(q.value(0).toLongLong()), q.value(1).toLongLong());
+        }
+        loaded = hashOf_.size();
+    }
+    DbPool::instance().releaseThread();
+    qDebug() << "Perceptual index loaded:" << loaded << "hashes";
+    return true;
+}
+
+void PerceptualIndex::insertLocked(uint64_t hash, qint64 pictureId) {
+    eraseLocked(pictureId);
+    uint32_t idx;
+    if (!freeSlots_.empty()) {
+        idx = freeSlots_.back();
+        freeSlots_.pop_back();
+        ids_[idx] = pictureId;
+    } else {
+        idx = static_cast<uint32_t>(ids_.size());
+        ids_.push_back(pictureId);
+    }
+    hashOf_[pictureId] = hash;
+    for (int c = 0; c < CHUNKS; ++c) buckets_[c][chunk(hash, c)].push_back({hash, idx});
+}
+
+void PerceptualIndex::eraseLocked(qint64 pictureId) {
+    auto it = hashOf_.find(pictureId);
+    if (it == hashOf_.end()) return;
+    const uint64_t hash = it->second;
+    hashOf_.erase(it);
+
+    uint32_t idx = 0;
+    for (int c = 0; c < CHUNKS; ++c) {
+        auto& bucket = buckets_[c][chunk(hash, c)];
+        auto slot = std::find_if(bucket.begin(), bucket.end(), [&](const Slot& s) { return ids_[s.index] == pictureId; });
+        if (slot == bucket.end()) continue;
+        idx = slot->index;
+        // Reihenfolge im Bucket egal (searchLocked sortiert)
+        *slot = bucket.back();
+        bucket.pop_back();
+    }
+    ids_[idx] = 0;
+    freeSlots_.push_back(idx);
+}
+
+std::vector<NearMatch> PerceptualIndex::searchLocked(uint64_t hash, int maxDistance, size_t limit) const {
+    std::vector<NearMatch> out;
+    if (hashOf_.empty() || limit == 0) return out;
+    maxDistance = std::clamp(maxDistance, 0, MAX_DISTANCE);
+    const int radius = maxDistance / CHUNKS;
+
+    for (int c = 0; c < CHUNKS; ++c) {
+        const auto& table = buckets_[c];
+        auto visit = [&](uint32_t key) {
+            for (const Slot& slot : table[key]) {
+                const uint64_t other = slot.hash;
+                // Schon über ein früheres Stück gefunden -> nicht doppelt melden
+                bool seen = false;
+                for (int p = 0; p < c && !seen; ++p) seen = std::popcount(chunk(other, p) ^ chunk(hash, p)) <= radius;
+                if (seen) continue;
+                int d = PerceptualHash::distance(hash, other);
+                if (d <= maxDistance) out.push_back({ids_[slot.index], d});
+            }
+        };
+
+        // Alle Stückwerte mit höchstens radius (<= 3) gekippten Bits
+        const uint32_t key = chunk(hash, c);
+        visit(key);
+        for (int i = 0; radius >= 1 && i < CHUNK_BITS; ++i) {
+            const uint32_t k1 = key ^ (1u << i);
+            visit(k1);
+            for (int j = i + 1; radius >= 2 && j < CHUNK_BITS; ++j) {
+                const uint32_t k2 = k1 ^ (1u << j);
+                visit(k2);
+                for (int l = j + 1; radius >= 3 && l < CHUNK_BITS; ++l) visit(k2 ^ (1u << l));
+            }
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const NearMatch& a, const NearMatch& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.pictureId < b.pictureId;
+    });
+    if (out.size() > limit) out.resize(limit);
+    return out;
+}
+
+std::vector<NearMatch> PerceptualIndex::search(uint64_t hash, int maxDistance, size_t limit) const {
+    std::shared_lock lock(mutex_);
+    return searchLocked(hash, maxDistance, limit);
+}
+
+std::vector<NearMatch> PerceptualIndex::matchAndInsert(uint64_t hash, qint64 pictureId, int maxDistance, size_t limit) {
+    std::unique_lock lock(mutex_);
+    eraseLocked(pictureId);
+    auto matches = searchLocked(hash, maxDistance, limit);
+    insertLocked(hash, pictureId);
+    return matches;
+}
+
+void PerceptualIndex::insert(uint64_t hash, qint64 pictureId) {
+    std::unique_lock lock(mutex_);
+    insertLocked(hash, pictureId);
+}
+
+void PerceptualIndex::erase(qint64 pictureId) {
+    std::unique_lock lock(mutex_);
+    eraseLocked(pictureId);
+}
+
+size_t PerceptualIndex::size() const {
+    std::shared_lock lock(mutex_);
+    return hashOf_.size();
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <QtGlobal>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include "ImageResize.h"
+
+// Beinahe-Duplikate (gleiches Foto, andere Größe/Qualität):
+// WORKER_PHASH=on, WORKER_PHASH_DISTANCE (Hamming, 0..15), WORKER_PHASH_MAX_MATCHES
+struct PerceptualHashConfig {
+    bool enabled = false;
+    int maxDistance = 8;
+    size_t maxMatches = 20;   // pro Foto höchstens so viele Kandidaten speichern
+
+    static PerceptualHashConfig fromEnvironment();
+};
+
+// 64-Bit pHash: 32x32 Graustufen, DCT, die 8x8 niedrigsten Frequenzen
+// gegen ihren Median. Robust gegen Skalieren und JPEG-Neukompression.
+class PerceptualHash {
+public:
+    static constexpr int SIZE = 32;
+    static constexpr int LOW = 8;
+
+    static uint64_t compute(const RgbImage& img);
+
+    // Nur JPEG; dekodiert per skalierter IDCT (meist 1/8). nullopt -> nicht lesbar
+    static std::optional<uint64_t> ofFile(const std::filesystem::path& file);
+
+    static int distance(uint64_t a, uint64_t b) { return std::popcount(a ^ b); }
+};
+
+struct NearMatch {
+    qint64 pictureId = 0;
+    int distance = 0;
+};
+
+// In-Memory Index aller pictures.phash (Multi-Index Hashing): der Hash wird in
+// 4 Stücke à 16 Bit geteilt, jedes Stück hat eine eigene Bucket-Tabelle.
+// Liegen zwei Hashes höchstens r auseinander, stimmt mindestens ein Stück bis
+// auf r/4 Bits überein -> pro Suche nur wenige hundert Buckets statt aller Hashes.
+class PerceptualIndex {
+public:
+    static constexpr int CHUNKS = 4;
+    static constexpr int CHUNK_BITS = 16;
+    static constexpr int MAX_DISTANCE = CHUNKS * 4 - 1;   // Stück-Radius höchstens 3
+
+    static PerceptualIndex& instance();
+
+    bool load();
+
+    // Treffer aufsteigend nach Abstand, höchstens limit
+    std::vector<NearMatch> search(uint64_t hash, int maxDistance, size_t limit) const;
+
+    // Suchen und danach eintragen, atomar (zwei ähnliche Fotos im selben
+    // Batch finden sich so gegenseitig). Ein schon eingetragenes pictureId
+    // (Upsert, Outbox-Replay) wird vorher entfernt und findet sich nicht selbst.
+    std::vector<NearMatch> matchAndInsert(uint64_t hash, qint64 pictureId, int maxDistance, size_t limit);
+
+    // Eintragen bzw. alten Hash dieses Fotos ersetzen
+    void insert(uint64_t hash, qint64 pictureId);
+
+    // Nach dem Commit für gelöschte Fotos (Policy "replace"), damit sie keine
+    // Plätze im limit belegen
+    void erase(qint64 pictureId);
+    size_t size() const;
+
+private:
+    PerceptualIndex();
+
+    void insertLocked(uint64_t hash, qint64 pictureId);
+    void eraseLocked(qint64 pictureId);
+    std::vector<NearMatch> searchLocked(uint64_t hash, int maxDistance, size_t limit) const;
+
+    static uint32_t chunk(uint64_t hash, int c) {
+        return static_cast<uint32_t>(hash >> (c * CHUNK_BITS)) & 0xFFFF;
+    }
+
+    // Hash liegt mit im Bucket: Vergleiche laufen über zusammenhängenden
+    // Speicher, ids_ wird nur für echte Treffer gelesen
+    struct Slot {
+        uint64_t hash;
+        uint32_t index;   // in ids_
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::vector<qint64> ids_;
+    std::vector<uint32_t> freeSlots_;                  // Lücken in ids_ nach erase
+    std::unordered_map<qint64, uint64_t> hashOf_;      // pictureId -> Hash, zum Austragen
+    std::vector<std::vector<Slot>> buckets_[CHUNKS];   // Stückwert -> Einträge
+};
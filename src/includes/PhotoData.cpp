@@ -0,0 +1,94 @@
+#include "PhotoData.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+// Quelle bleibt leer zurück und darf weiter benutzt werden
+TextArena& TextArena::operator=(TextArena&& o) noexcept {
+    if (this != &o) {
+        blocks_ = std::exchange(o.blocks_, {});
+        cur_ = std::exchange(o.cur_, nullptr);
+        left_ = std::exchange(o.left_, 0);
+        lastBlock_ = std::exchange(o.lastBlock_, 0);
+    }
+    return *this;
+}
+
+std::string_view TextArena::store(std::string_view s) {
+    if (!s.data()) return {};
+    if (s.empty()) return std::string_view("", 0);
+
+    if (s.size() > left_) {
+        // Blöcke wachsen mit (Stock-Fotos mit Hunderten Tags), Einzelstücke passen immer
+        size_t size = std::max(s.size(), lastBlock_ ? lastBlock_ * 2 : FIRST_BLOCK);
+        blocks_.push_back(std::make_unique_for_overwrite<char[]>(size));
+        cur_ = blocks_.back().get();
+        left_ = size;
+        lastBlock_ = size;
+    }
+    std::memcpy(cur_, s.data(), s.size());
+    std::string_view out(cur_, s.size());
+    cur_ += s.size();
+    left_ -= s.size();
+    return out;
+}
+
+// Kopie: Views zeigen danach in die eigene Arena
+PhotoData::PhotoData(const PhotoData& o) {
+    *this = o;
+}
+
+PhotoData& PhotoData::operator=(const PhotoData& o) {
+    if (this == &o) return *this;
+    arena_ = TextArena();
+    width = o.width;
+    height = o.height;
+    gpsLat = o.gpsLat;
+    gpsLon = o.gpsLon;
+    gpsAlt = o.gpsAlt;
+    takenAt = o.takenAt;
+
+    for (auto field : {&PhotoData::make, &PhotoData::model, &PhotoData::iso, &PhotoData::aperture,
+                       &PhotoData::exposure, &PhotoData::title, &PhotoData::description, &PhotoData::copyright,
+                       &PhotoData::caption, &PhotoData::country, &PhotoData::city, &PhotoData::province,
+                       &PhotoData::countryCode, &PhotoData::continent}) {
+        this->*field = store(o.*field);
+    }
+
+    keywords.clear();
+    keywords.reserve(o.keywords.size());
+    for (std::string_view k : o.keywords) keywords.push_back(store(k));
+    slots_ = o.slots_;   // gleiche Indizes
+    return *this;
+}
+
+std::string_view PhotoData::store(std::string_view s) {
+    return arena_.store(s);
+}
+
+void PhotoData::insertSlot(uint32_t index) {
+    const size_t mask = slots_.size() - 1;
+    size_t i = std::hash<std::string_view>{}(keywords[index]) & mask;
+    while (slots_[i] != 0) i = (i + 1) & mask;
+    slots_[i] = index + 1;
+}
+
+void PhotoData::rehash(size_t slots) {
+    slots_.assign(slots, 0);
+    for (uint32_t i = 0; i < keywords.size(); ++i) insertSlot(i);
+}
+
+bool PhotoData::addKeyword(std::string_view k) {
+    // Höchstens halb voll -> kurze Sondierketten
+    if ((keywords.size() + 1) * 2 > slots_.size()) rehash(std::max<size_t>(16, slots_.size() * 2));
+
+    const size_t mask = slots_.size() - 1;
+    size_t i = std::hash<std::string_view>{}(k) & mask;
+    while (slots_[i] != 0) {
+        if (keywords[slots_[i] - 1] == k) return false;
+        i = (i + 1) & mask;
+    }
+    keywords.push_back(arena_.store(k.data() ? k : std::string_view("", 0)));
+    slots_[i] = static_cast<uint32_t>(keywords.size());
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <QDateTime>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Bump-Allocator für die Texte eines Fotos: wenige Blöcke statt einer
+// Allokation pro Feld. Views bleiben gültig, solange die Arena lebt
+// (auch nach einem Move).
+class TextArena {
+public:
+    TextArena() = default;
+    TextArena(TextArena&& o) noexcept { *this = std::move(o); }
+    TextArena& operator=(TextArena&& o) noexcept;
+
+    std::string_view store(std::string_view s);
+
+private:
+    static constexpr size_t FIRST_BLOCK = 512;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cur_ = nullptr;
+    size_t left_ = 0;
+    size_t lastBlock_ = 0;
+};
+
+// Metadaten eines Fotos. Alle Texte sind UTF-8-Views in die eigene Arena;
+// in QString umgewandelt wird erst dort, wo eine Qt-API es verlangt (DB-Binding).
+// Ein nicht gefundenes Feld ist eine leere View mit data() == nullptr (-> NULL in der DB).
+struct PhotoData {
+    // Basis
+    int width = 0;
+    int height = 0;
+
+    // Exif
+    std::string_view make, model, iso, aperture, exposure;
+    double gpsLat = 0.0;
+    double gpsLon = 0.0;
+    double gpsAlt = 0.0;
+    QDateTime takenAt;
+
+    // IPTC / XMP / Location Logic
+    std::string_view title, description, copyright, caption;
+    std::string_view country, city, province, countryCode;
+    std::string_view continent;   // nur aus dem Reverse-Geocoding
+
+    // Keywords (gesammelt aus IPTC und XMP), ohne Duplikate, in Fundreihenfolge
+    std::vector<std::string_view> keywords;
+
+    PhotoData() = default;
+    PhotoData(const PhotoData& o);
+    PhotoData& operator=(const PhotoData& o);
+    PhotoData(PhotoData&&) noexcept = default;
+    PhotoData& operator=(PhotoData&&) noexcept = default;
+
+    // Text in die Arena kopieren; null bleibt null
+    std::string_view store(std::string_view s);
+
+    // Keyword übernehmen, falls noch nicht vorhanden. true -> neu
+    bool addKeyword(std::string_view k);
+
+private:
+    void insertSlot(uint32_t index);
+    void rehash(size_t slots);
+
+    TextArena arena_;
+    // Offene Adressierung über keywords: Index + 1, 0 = frei (statt QStringList::contains, O(n²))
+    std::vector<uint32_t> slots_;
+};
+
+// Nur an der Grenze zu Qt: null -> QString(), sonst UTF-8 -> UTF-16
+inline QString toQString(std::string_view s) {
+    return s.data() ? QString::fromUtf8(s.data(), static_cast<qsizetype>(s.size())) : QString();
+}
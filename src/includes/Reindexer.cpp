@@ -0,0 +1,522 @@
+#include "Reindexer.h"
+#include "ContentHash.h"
+#include "DbPool.h"
+#include "FileHelpers.h"
+#include "MetadataExtractor.h"
+#include "PerceptualHash.h"
+#include "ReverseGeocoder.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static int envInt(const char* name, int defaultValue) {
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+// --- ParallelWalker ---
+
+ParallelWalker::ParallelWalker(int threads) {
+    for (int i = 0; i < std::max(1, threads); ++i) queues_.push_back(std::make_unique<WorkQueue>());
+}
+
+void ParallelWalker::push(size_t self, fs::path dir) {
+    pending_++;
+    WorkQueue& own = *queues_[self];
+    std::lock_guard lock(own.mutex);
+    own.dirs.push_back(std::move(dir));
+}
+
+// Eigene Deque von hinten, sonst reihum bei den Nachbarn von vorne stehlen
+bool ParallelWalker::take(size_t self, fs::path& out) {
+    {
+        WorkQueue& own = *queues_[self];
+        std::lock_guard lock(own.mutex);
+        if (!own.dirs.empty()) {
+            out = std::move(own.dirs.back());
+            own.dirs.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues_.size(); ++k) {
+        WorkQueue& victim = *queues_[(self + k) % queues_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.dirs.empty()) {
+            out = std::move(victim.dirs.front());
+            victim.dirs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ParallelWalker::scan(size_t self, const fs::path& dir, const std::function<void(WalkedFile&&)>& onFile) {
+    DIR* d = ::opendir(dir.c_str());
+    if (!d) {
+        qWarning() << "Reindex: cannot open" << QString::fromStdString(dir.string()) << ":" << std::strerror(errno);
+        return;
+    }
+    directories_++;
+    const int fd = ::dirfd(d);
+    while (const dirent* e = ::readdir(d)) {
+        const char* name = e->d_name;
+        if (name[0] == '.') continue;   // ".", ".." und versteckte/temporäre Dateien
+        if (e->d_type == DT_DIR) {
+            push(self, dir / name);
+            continue;
+        }
+        if (e->d_type != DT_REG && e->d_type != DT_UNKNOWN) continue;   // Symlinks, Sockets, ...
+
+        // Relativ zum offenen Verzeichnis: kein erneutes Auflösen des ganzen Pfads
+        struct statx st {};
+        if (::statx(fd, name, AT_SYMLINK_NOFOLLOW, STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO, &st) != 0) {
+            qWarning() << "Reindex: cannot stat" << QString::fromStdString((dir / name).string()) << ":"
+                       << std::strerror(errno);
+            continue;
+        }
+        if (S_ISDIR(st.stx_mode)) {
+            push(self, dir / name);
+            continue;
+        }
+        if (!S_ISREG(st.stx_mode)) continue;
+
+        WalkedFile f;
+        f.path = dir / name;
+        f.stamp.size = st.stx_size;
+        f.stamp.mtimeNs = static_cast<int64_t>(st.stx_mtime.tv_sec) * 1'000'000'000 + st.stx_mtime.tv_nsec;
+        f.stamp.inode = st.stx_ino;
+        onFile(std::move(f));
+    }
+    ::closedir(d);
+}
+
+void ParallelWalker::run(size_t self, const std::function<void(WalkedFile&&)>& onFile,
+                         const std::atomic<bool>& running) {
+    fs::path dir;
+    while (running) {
+        if (take(self, dir)) {
+            scan(self, dir, onFile);
+            pending_--;   // erst nach dem Scan: Unterordner sind dann schon gezählt
+            continue;
+        }
+        if (pending_.load() == 0) return;
+        // Andere Threads lesen noch Verzeichnisse, die neue Arbeit liefern können
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void ParallelWalker::walk(const fs::path& root, const std::function<void(WalkedFile&&)>& onFile,
+                          const std::atomic<bool>& running) {
+    pending_ = 0;
+    directories_ = 0;
+    push(0, root);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        threads.emplace_back(&ParallelWalker::run, this, i, std::cref(onFile), std::cref(running));
+    }
+    run(0, onFile, running);
+    for (auto& t : threads) t.join();
+
+    // Abgebrochen: Rest verwerfen
+    for (auto& q : queues_) q->dirs.clear();
+}
+
+// --- ReindexManifest ---
+
+ReindexManifest::ReindexManifest(fs::path file) : file_(std::move(file)) {
+    journal_ = file_;
+    journal_ += ".journal";
+}
+
+ReindexManifest::~ReindexManifest() {
+    if (journalFd_ >= 0) ::close(journalFd_);
+}
+
+static void appendLine(std::string& out, const std::string& key, const FileStamp& s) {
+    out += std::to_string(s.inode);
+    out += ' ';
+    out += std::to_string(s.size);
+    out += ' ';
+    out += std::to_string(s.mtimeNs);
+    out += ' ';
+    out += key;
+    out += '\n';
+}
+
+// Helper: "inode size mtime_ns pfad" (Pfad darf Leerzeichen enthalten)
+static bool parseLine(std::string_view line, std::string_view& key, FileStamp& s) {
+    const char* p = line.data();
+    const char* end = p + line.size();
+    auto field = [&](auto& value) {
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc() || next == end || *next != ' ') return false;
+        p = next + 1;
+        return true;
+    };
+    if (!field(s.inode) || !field(s.size) || !field(s.mtimeNs) || p == end) return false;
+    key = std::string_view(p, static_cast<size_t>(end - p));
+    return true;
+}
+
+bool ReindexManifest::readFile(const fs::path& file, bool repairTail) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return !fs::exists(file);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (in.bad()) {
+        qCritical() << "Reindex: cannot read" << QString::fromStdString(file.string());
+        return false;
+    }
+
+    // Abbruch mitten im Schreiben: halbe Zeile abschneiden, sonst klebt der nächste Eintrag daran
+    size_t lastNewline = data.rfind('\n');
+    size_t complete = lastNewline == std::string::npos ? 0 : lastNewline + 1;
+    if (complete < data.size()) {
+        qWarning() << "Reindex: dropping incomplete last line of" << QString::fromStdString(file.string());
+        data.resize(complete);
+        if (repairTail) {
+            std::error_code ec;
+            fs::resize_file(file, complete, ec);
+            if (ec) {
+                qCritical() << "Reindex: cannot repair" << QString::fromStdString(file.string()) << ":" << ec.message().c_str();
+                return false;
+            }
+        }
+    }
+
+    size_t bad = 0;
+    std::string_view rest(data);
+    while (!rest.empty()) {
+        size_t nl = rest.find('\n');
+        std::string_view line = rest.substr(0, nl);
+        rest.remove_prefix(nl + 1);
+
+        std::string_view key;
+        FileStamp stamp;
+        if (!parseLine(line, key, stamp)) {
+            bad++;
+            continue;
+        }
+        entries_[std::string(key)].stamp = stamp;
+    }
+    if (bad) qWarning() << "Reindex:" << bad << "unreadable lines in" << QString::fromStdString(file.string());
+    return true;
+}
+
+bool ReindexManifest::openJournal() {
+    journalFd_ = ::open(journal_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (journalFd_ < 0) {
+        qCritical() << "Reindex: cannot open" << QString::fromStdString(journal_.string()) << ":" << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool ReindexManifest::load() {
+    std::unique_lock lock(mutex_);
+    entries_.clear();
+    if (!readFile(file_, false) || !readFile(journal_, true)) return false;
+    std::lock_guard journalLock(journalMutex_);
+    return journalFd_ >= 0 || openJournal();
+}
+
+void ReindexManifest::discard() {
+    std::unique_lock lock(mutex_);
+    std::lock_guard journalLock(journalMutex_);
+    entries_.clear();
+    if (journalFd_ >= 0) {
+        ::close(journalFd_);
+        journalFd_ = -1;
+    }
+    std::error_code ec;
+    fs::remove(file_, ec);
+    fs::remove(journal_, ec);
+}
+
+bool ReindexManifest::unchanged(const std::string& key, const FileStamp& stamp) {
+    std::shared_lock lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+    it->second.seen.store(true, std::memory_order_relaxed);
+    return it->second.stamp == stamp;
+}
+
+bool ReindexManifest::record(std::span<const std::pair<std::string, FileStamp>> entries) {
+    if (entries.empty()) return true;
+
+    std::string buf;
+    for (const auto& [key, stamp] : entries) appendLine(buf, key, stamp);
+    {
+        std::lock_guard journalLock(journalMutex_);
+        if (journalFd_ < 0 && !openJournal()) return false;
+        const char* p = buf.data();
+        size_t left = buf.size();
+        while (left > 0) {
+            ssize_t n = ::write(journalFd_, p, left);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                qCritical() << "Reindex: journal write failed:" << std::strerror(errno);
+                return false;
+            }
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        if (::fdatasync(journalFd_) != 0) {
+            qCritical() << "Reindex: journal fdatasync failed:" << std::strerror(errno);
+            return false;
+        }
+    }
+
+    // Erst wenn der Checkpoint auf Platte ist, gilt die Datei als erledigt
+    std::unique_lock lock(mutex_);
+    for (const auto& [key, stamp] : entries) {
+        Entry& e = entries_[key];
+        e.stamp = stamp;
+        e.seen.store(true, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool ReindexManifest::compact() {
+    fs::path tmp = file_;
+    tmp += ".tmp";
+
+    size_t kept = 0, gone = 0;
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        std::shared_lock lock(mutex_);
+        std::string buf;
+        for (const auto& [key, e] : entries_) {
+            // Nicht mehr auf Platte: aus dem Manifest, die DB-Zeile bleibt
+            if (!e.seen.load(std::memory_order_relaxed)) {
+                gone++;
+                continue;
+            }
+            appendLine(buf, key, e.stamp);
+            kept++;
+            if (buf.size() >= (1 << 20)) {
+                out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                buf.clear();
+            }
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        out.close();
+        if (!out) {
+            qCritical() << "Reindex: cannot write" << QString::fromStdString(tmp.string());
+            return false;
+        }
+    }
+
+    // tmp auf Platte, rename, dann der Verzeichnis-Eintrag
+    int fd = ::open(tmp.c_str(), O_RDONLY | O_CLOEXEC);
+    bool synced = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    std::error_code ec;
+    if (synced) fs::rename(tmp, file_, ec);
+    if (!synced || ec) {
+        qCritical() << "Reindex: cannot replace manifest" << QString::fromStdString(file_.string());
+        fs::remove(tmp, ec);
+        return false;
+    }
+    fs::path dir = file_.parent_path().empty() ? fs::path(".") : file_.parent_path();
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+
+    {
+        std::lock_guard journalLock(journalMutex_);
+        if (journalFd_ >= 0) {
+            ::close(journalFd_);
+            journalFd_ = -1;
+        }
+        fs::remove(journal_, ec);
+    }
+    qDebug() << "Reindex manifest written:" << kept << "files," << gone << "no longer on disk";
+    return true;
+}
+
+size_t ReindexManifest::size() const {
+    std::shared_lock lock(mutex_);
+    return entries_.size();
+}
+
+// --- Reindexer ---
+
+ReindexConfig ReindexConfig::fromEnvironment(const fs::path& photosRoot, bool full) {
+    ReindexConfig cfg;
+    cfg.photosRoot = photosRoot;
+    cfg.manifest = qEnvironmentVariable("WORKER_REINDEX_MANIFEST", "reindex.manifest").toStdString();
+    cfg.full = full;
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores <= 0) cores = 1;
+    cfg.walkThreads    = std::max(1, envInt("WORKER_REINDEX_WALK_THREADS", cores));
+    cfg.extractThreads = std::max(1, envInt("WORKER_EXTRACT_THREADS", cores));
+    cfg.dbThreads      = std::max(1, envInt("WORKER_DB_THREADS", 1));
+    cfg.queueCapacity  = static_cast<size_t>(std::max(1, envInt("WORKER_QUEUE_CAPACITY", 256)));
+    cfg.dbBatchSize    = static_cast<size_t>(std::max(1, envInt("WORKER_DB_BATCH_SIZE", 64)));
+    cfg.dbBatchMode    = qEnvironmentVariable("WORKER_DB_BATCH_MODE", "isolate") == "rollback"
+                         ? BatchFailureMode::Rollback : BatchFailureMode::Isolate;
+    cfg.phash          = PerceptualHashConfig::fromEnvironment().enabled;
+    return cfg;
+}
+
+Reindexer::Reindexer(ReindexConfig cfg)
+    : cfg_(std::move(cfg)),
+      manifest_(cfg_.manifest),
+      extractQueue_(cfg_.queueCapacity),
+      dbQueue_(cfg_.queueCapacity) {}
+
+void Reindexer::logProgress(const char* prefix) const {
+    qDebug() << prefix << "scanned:" << stats_.scanned.load() << "unchanged:" << stats_.unchanged.load()
+             << "extracted:" << stats_.extracted.load() << "stored:" << stats_.stored.load()
+             << "failed:" << stats_.failed.load();
+}
+
+bool Reindexer::run(const std::atomic<bool>& running) {
+    running_ = &running;
+    if (cfg_.full) {
+        manifest_.discard();
+    } else if (!manifest_.load()) {
+        return false;
+    }
+    qDebug() << "Reindex of" << QString::fromStdString(cfg_.photosRoot.string())
+             << (cfg_.full ? "started (full rebuild)." : "started.") << "known files:" << manifest_.size()
+             << "walk:" << cfg_.walkThreads << "extract:" << cfg_.extractThreads << "db:" << cfg_.dbThreads;
+
+    std::vector<std::thread> extractThreads, dbThreads;
+    for (int i = 0; i < cfg_.extractThreads; ++i) extractThreads.emplace_back(&Reindexer::extractWorker, this);
+    for (int i = 0; i < cfg_.dbThreads; ++i) dbThreads.emplace_back(&Reindexer::dbWorker, this);
+
+    ParallelWalker walker(cfg_.walkThreads);
+    walker.walk(cfg_.photosRoot, [this](WalkedFile&& f) {
+        stats_.scanned++;
+        std::string key = f.path.lexically_relative(cfg_.photosRoot).string();
+        if (key.find('\n') != std::string::npos) {
+            qWarning() << "Reindex: skipping file name with newline:" << QString::fromStdString(f.path.string());
+            return;
+        }
+        if (manifest_.unchanged(key, f.stamp)) {
+            stats_.unchanged++;
+            return;
+        }
+        extractQueue_.push({std::move(f), std::move(key)});
+    }, running);
+    const bool complete = running.load();
+
+    // Abbruch: was schon extrahiert ist, kommt noch in die DB (und ins Journal)
+    extractQueue_.close();
+    if (!complete) extractQueue_.clear();
+    for (auto& t : extractThreads) t.join();
+    dbQueue_.close();
+    for (auto& t : dbThreads) t.join();
+
+    qDebug() << "Reindex walked" << walker.directories() << "directories";
+    if (!complete) {
+        logProgress("Reindex interrupted, run --reindex again to resume.");
+        return false;
+    }
+    logProgress("Reindex finished.");
+    return manifest_.compact() && stats_.failed.load() == 0;
+}
+
+// Wie die Extraktion der Pipeline, nur ohne Duplikat-Policy und ohne Verschieben
+void Reindexer::extractWorker() {
+    while (auto c = extractQueue_.pop()) {
+        if (!running_->load()) continue;   // Queue leeren, damit der Walker nicht hängt
+        const fs::path& path = c->file.path;
+        try {
+            Extracted item;
+            item.key = std::move(c->key);
+            item.stamp = c->file.stamp;
+
+            WorkerPayload& p = item.payload;
+            p.filename = path.filename().string();
+            p.relPath  = fs::path(item.key).parent_path().string();
+            p.fullPath = path.string();
+            p.user     = "system";   // nur für neue Zeilen, vorhandene behalten ihren Benutzer
+            p.fileSize = static_cast<long long>(item.stamp.size);
+
+            ContentHash hash = ContentHash::ofFile(path);
+            if (hash.valid) p.contentHash = hash.toHex();
+
+            p.meta = MetadataExtractor::extract(path.string());
+            if (cfg_.phash) p.phash = PerceptualHash::ofFile(path);
+
+            const ReverseGeocoder& geo = ReverseGeocoder::instance();
+            if (geo.isLoaded() && (p.meta.gpsLat != 0.0 || p.meta.gpsLon != 0.0)) geo.fill(p.meta);
+
+            // Datum: EXIF -> Dateiname -> mtime
+            if (p.meta.takenAt.isValid()) {
+                p.fileDate = p.meta.takenAt;
+            } else {
+                QDateTime nameDate = extractDateFromFilename(p.filename);
+                p.fileDate = nameDate.isValid() ? nameDate : getFileLastModified(path);
+            }
+
+            stats_.extracted++;
+            dbQueue_.push(std::move(item));
+        } catch (const std::exception& e) {
+            stats_.failed++;
+            qCritical() << "Reindex: error extracting" << QString::fromStdString(path.string()) << ":" << e.what();
+        }
+    }
+}
+
+void Reindexer::dbWorker() {
+    std::vector<WorkerPayload> batch;
+    std::vector<std::pair<std::string, FileStamp>> stamps, done;
+    auto lastLog = std::chrono::steady_clock::now();
+
+    while (auto first = dbQueue_.pop()) {
+        auto collect = [&](Extracted&& e) {
+            batch.push_back(std::move(e.payload));
+            stamps.emplace_back(std::move(e.key), e.stamp);
+        };
+        collect(std::move(*first));
+        while (batch.size() < cfg_.dbBatchSize) {
+            auto next = dbQueue_.popFor(std::chrono::milliseconds(200));
+            if (!next) break;
+            collect(std::move(*next));
+        }
+
+        std::vector<qint64> ids = DbManager::upsertBatch(batch, cfg_.dbBatchMode);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (ids[i] > 0) {
+                stats_.stored++;
+                done.push_back(std::move(stamps[i]));
+            } else {
+                // Nicht ins Journal -> wird beim nächsten Lauf erneut versucht
+                stats_.failed++;
+                qWarning() << "Reindex: DB upsert failed for" << QString::fromStdString(batch[i].fullPath);
+            }
+        }
+        manifest_.record(done);   // Fehlschlag: gespeichert, aber ohne Checkpoint -> nächster Lauf wiederholt
+        batch.clear();
+        stamps.clear();
+        done.clear();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastLog >= std::chrono::seconds(10)) {
+            lastLog = now;
+            logProgress("Reindex progress:");
+        }
+    }
+    DbPool::instance().releaseThread();
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "BoundedQueue.h"
+#include "DbManager.h"
+
+// Was vom Dateisystem reicht, um "unverändert" zu erkennen
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    uint64_t inode = 0;
+
+    bool operator==(const FileStamp&) const = default;
+};
+
+struct WalkedFile {
+    std::filesystem::path path;
+    FileStamp stamp;
+};
+
+// Paralleler Verzeichnis-Walker mit Work Stealing: jeder Thread arbeitet seine
+// eigene Deque von hinten ab (zuletzt gefundene Unterordner zuerst), wer leer
+// läuft, nimmt sich vorne bei einem anderen Thread die ältesten (meist größten)
+// Teilbäume. Versteckte Einträge (".*", z.B. ".part"-Dateien) werden übersprungen,
+// Symlinks nicht verfolgt.
+class ParallelWalker {
+public:
+    explicit ParallelWalker(int threads);
+
+    // onFile läuft parallel auf den Walker-Threads. Bricht ab, sobald running false ist.
+    void walk(const std::filesystem::path& root, const std::function<void(WalkedFile&&)>& onFile,
+              const std::atomic<bool>& running);
+
+    uint64_t directories() const { return directories_.load(); }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::filesystem::path> dirs;
+    };
+
+    void run(size_t self, const std::function<void(WalkedFile&&)>& onFile, const std::atomic<bool>& running);
+    void scan(size_t self, const std::filesystem::path& dir, const std::function<void(WalkedFile&&)>& onFile);
+    void push(size_t self, std::filesystem::path dir);
+    bool take(size_t self, std::filesystem::path& out);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::atomic<uint64_t> pending_{0};   // gefundene, noch nicht fertig gelesene Verzeichnisse
+    std::atomic<uint64_t> directories_{0};
+};
+
+// Stand der letzten Indizierung: Pfad relativ zu PHOTOS_ROOT -> Größe/mtime/Inode.
+// Textdatei "inode size mtime_ns pfad\n". Daneben liegt ein Journal (".journal"),
+// an das nach jedem DB-Commit angehängt wird -> Checkpoint. Beim Laden gewinnt
+// das Journal; nach einem vollständigen Lauf wird beides zum Manifest verdichtet.
+class ReindexManifest {
+public:
+    explicit ReindexManifest(std::filesystem::path file);
+    ~ReindexManifest();
+
+    ReindexManifest(const ReindexManifest&) = delete;
+    ReindexManifest& operator=(const ReindexManifest&) = delete;
+
+    bool load();      // Manifest + Journal; false nur bei Lesefehlern
+    void discard();   // --full: alles vergessen (auch auf Platte)
+
+    // Thread-safe. Merkt sich zugleich, dass der Pfad noch existiert.
+    bool unchanged(const std::string& key, const FileStamp& stamp);
+
+    // Erfolgreich gespeicherte Dateien ans Journal hängen (ein fdatasync)
+    bool record(std::span<const std::pair<std::string, FileStamp>> entries);
+
+    // Manifest aus allen noch vorhandenen Einträgen neu schreiben, Journal löschen
+    bool compact();
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        FileStamp stamp;
+        std::atomic<bool> seen{false};
+    };
+
+    bool readFile(const std::filesystem::path& file, bool repairTail);
+    bool openJournal();
+
+    std::filesystem::path file_;
+    std::filesystem::path journal_;
+    mutable std::shared_mutex mutex_;   // entries_
+    std::unordered_map<std::string, Entry> entries_;
+    std::mutex journalMutex_;           // Schreiben + fdatasync, ohne die Walker zu blockieren
+    int journalFd_ = -1;
+};
+
+struct ReindexConfig {
+    std::filesystem::path photosRoot;
+    std::filesystem::path manifest;   // WORKER_REINDEX_MANIFEST, Default "reindex.manifest"
+    bool full = false;                // Manifest ignorieren, alles neu einlesen
+    int walkThreads = 0;              // WORKER_REINDEX_WALK_THREADS, 0 -> Anzahl Kerne
+    int extractThreads = 0;           // WORKER_EXTRACT_THREADS
+    int dbThreads = 1;                // WORKER_DB_THREADS
+    size_t queueCapacity = 256;
+    size_t dbBatchSize = 64;
+    BatchFailureMode dbBatchMode = BatchFailureMode::Isolate;
+    bool phash = false;               // WORKER_PHASH=on: pictures.phash nachtragen
+
+    static ReindexConfig fromEnvironment(const std::filesystem::path& photosRoot, bool full);
+};
+
+struct ReindexStats {
+    std::atomic<uint64_t> scanned{0};
+    std::atomic<uint64_t> unchanged{0};
+    std::atomic<uint64_t> extracted{0};
+    std::atomic<uint64_t> stored{0};
+    std::atomic<uint64_t> failed{0};
+};
+
+// --reindex: vorhandene Dateien unter PHOTOS_ROOT erneut einlesen, ohne sie
+// anzufassen. Walker -> Extraktion (Hash, Exiv2, Geocoding, Datum) -> Upsert.
+// Nur neue/geänderte Dateien laufen durch Extraktion und DB.
+class Reindexer {
+public:
+    explicit Reindexer(ReindexConfig cfg);
+
+    // Blockiert bis fertig oder running == false.
+    // true -> kompletter Durchlauf, Manifest verdichtet.
+    bool run(const std::atomic<bool>& running);
+
+    const ReindexStats& stats() const { return stats_; }
+
+private:
+    struct Candidate {
+        WalkedFile file;
+        std::string key;
+    };
+
+    struct Extracted {
+        WorkerPayload payload;
+        std::string key;
+        FileStamp stamp;
+    };
+
+    void extractWorker();
+    void dbWorker();
+    void logProgress(const char* prefix) const;
+
+    const ReindexConfig cfg_;
+    const std::atomic<bool>* running_ = nullptr;
+    ReindexManifest manifest_;
+    ReindexStats stats_;
+    BoundedQueue<Candidate> extractQueue_;
+    BoundedQueue<Extracted> dbQueue_;
+};
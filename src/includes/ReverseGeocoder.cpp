@@ -0,0 +1,403 @@
+#include "ReverseGeocoder.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static constexpr double EARTH_RADIUS_KM = 6371.0088;
+static constexpr uint32_t NO_COUNTRY = 0xFFFFFFFF;
+
+// Snapshot-Layout: Header | Node[nodeCount] | Country[countryCount] | Strings
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t countryCount;
+    uint32_t stringBytes;
+    int64_t sourceMtime;   // mtime des Städte-Dumps beim Bauen
+};
+
+static constexpr char SNAPSHOT_MAGIC[8] = {'W', 'G', 'G', 'E', 'O', 'K', 'D', '1'};
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+// Knoten des impliziten k-d-Baums: Median von [lo,hi) liegt bei (lo+hi)/2
+struct ReverseGeocoder::Node {
+    float v[3];          // Einheitsvektor
+    uint32_t name;       // Offset in der String-Tabelle
+    uint32_t admin1;
+    uint32_t country;    // Index in Country[], NO_COUNTRY wenn unbekannt
+};
+
+struct ReverseGeocoder::Country {
+    uint32_t name;
+    uint32_t code;
+    uint32_t continent;
+};
+
+static void toUnitVector(double lat, double lon, float out[3]) {
+    double la = lat * M_PI / 180.0, lo = lon * M_PI / 180.0;
+    out[0] = static_cast<float>(std::cos(la) * std::cos(lo));
+    out[1] = static_cast<float>(std::cos(la) * std::sin(lo));
+    out[2] = static_cast<float>(std::sin(la));
+}
+
+static float dist2(const float a[3], const float b[3]) {
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+static int64_t mtimeOf(const fs::path& p) {
+    std::error_code ec;
+    auto t = fs::last_write_time(p, ec);
+    return ec ? 0 : static_cast<int64_t>(t.time_since_epoch().count());
+}
+
+static std::vector<std::string_view> splitTabs(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string_view::npos ? std::string_view::npos : tab - start));
+        if (tab == std::string_view::npos) break;
+        start = tab + 1;
+    }
+    return fields;
+}
+
+static std::string_view continentName(std::string_view code) {
+    if (code == "AF") return "Africa";
+    if (code == "AN") return "Antarctica";
+    if (code == "AS") return "Asia";
+    if (code == "EU") return "Europe";
+    if (code == "NA") return "North America";
+    if (code == "OC") return "Oceania";
+    if (code == "SA") return "South America";
+    return code;
+}
+
+ReverseGeocoder& ReverseGeocoder::instance() {
+    static ReverseGeocoder geocoder;
+    return geocoder;
+}
+
+ReverseGeocoder::~ReverseGeocoder() {
+    if (map_) ::munmap(map_, mapSize_);
+}
+
+bool ReverseGeocoder::load() {
+    QString dirEnv = qEnvironmentVariable("WORKER_GEONAMES_DIR");
+    if (dirEnv.isEmpty()) {
+        qDebug() << "Reverse geocoding disabled (WORKER_GEONAMES_DIR not set)";
+        return false;
+    }
+    fs::path dir = dirEnv.toStdString();
+
+    // Erster vorhandener Städte-Dump (feinere Dumps zuerst)
+    fs::path cities;
+    QString citiesEnv = qEnvironmentVariable("WORKER_GEONAMES_CITIES");
+    if (!citiesEnv.isEmpty()) {
+        cities = dir / citiesEnv.toStdString();
+    } else {
+        for (const char* name : {"cities500.txt", "cities1000.txt", "cities5000.txt", "cities15000.txt"}) {
+            if (fs::exists(dir / name)) {
+                cities = dir / name;
+                break;
+            }
+        }
+    }
+
+    bool ok = false;
+    double maxKm = qEnvironmentVariableIntValue("WORKER_GEOCODER_MAX_KM", &ok);
+    if (!ok || maxKm <= 0) maxKm = 50.0;
+    double chord = 2.0 * std::sin(std::min(maxKm, M_PI * EARTH_RADIUS_KM) / (2.0 * EARTH_RADIUS_KM));
+    maxChord2_ = static_cast<float>(chord * chord);
+
+    // Ohne Dump wird jeder vorhandene Snapshot akzeptiert (vorkompiliert ausgeliefert)
+    fs::path snapshot = dir / "geonames.snapshot";
+    int64_t sourceMtime = cities.empty() ? 0 : mtimeOf(cities);
+    if (mapSnapshot(snapshot, sourceMtime)) return true;
+
+    if (cities.empty()) {
+        qWarning() << "Reverse geocoding: no snapshot and no cities*.txt in" << dirEnv;
+        return false;
+    }
+    qDebug() << "Reverse geocoding: building snapshot from" << QString::fromStdString(cities.string());
+    if (!buildSnapshot(dir, cities, snapshot)) return false;
+    return mapSnapshot(snapshot, sourceMtime);
+}
+
+bool ReverseGeocoder::mapSnapshot(const fs::path& p, int64_t expectedSourceMtime) {
+    int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const auto* h = static_cast<const SnapshotHeader*>(map);
+    size_t expected = sizeof(SnapshotHeader) + static_cast<size_t>(h->nodeCount) * sizeof(Node) +
+                      static_cast<size_t>(h->countryCount) * sizeof(Country) + h->stringBytes;
+    bool valid = std::memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+                 h->version == SNAPSHOT_VERSION && expected == size && h->nodeCount > 0 && h->stringBytes > 0;
+    if (valid && expectedSourceMtime != 0 && h->sourceMtime != expectedSourceMtime) {
+        qDebug() << "Reverse geocoding: snapshot is older than the dump, rebuilding";
+        valid = false;
+    }
+    if (!valid) {
+        ::munmap(map, size);
+        return false;
+    }
+
+    // Zufällige Zugriffe beim Abstieg im Baum
+    ::madvise(map, size, MADV_RANDOM);
+
+    if (map_) ::munmap(map_, mapSize_);
+    map_ = map;
+    mapSize_ = size;
+    const char* base = static_cast<const char*>(map);
+    nodes_ = reinterpret_cast<const Node*>(base + sizeof(SnapshotHeader));
+    nodeCount_ = h->nodeCount;
+    countries_ = reinterpret_cast<const Country*>(nodes_ + nodeCount_);
+    countryCount_ = h->countryCount;
+    strings_ = reinterpret_cast<const char*>(countries_ + countryCount_);
+    stringBytes_ = h->stringBytes;
+
+    qDebug() << "Reverse geocoding: loaded" << nodeCount_ << "places from" << QString::fromStdString(p.string());
+    return true;
+}
+
+std::string_view ReverseGeocoder::str(uint32_t offset) const {
+    if (offset >= stringBytes_) return {};
+    return std::string_view(strings_ + offset);
+}
+
+void ReverseGeocoder::nearest(size_t lo, size_t hi, int depth, const float q[3], size_t& best, float& bestDist) const {
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const Node& n = nodes_[mid];
+        float d = dist2(n.v, q);
+        if (d < bestDist) {
+            bestDist = d;
+            best = mid;
+        }
+
+        int axis = depth % 3;
+        float diff = q[axis] - n.v[axis];
+        ++depth;
+        // Nähere Hälfte zuerst, die andere nur, wenn die Split-Ebene näher liegt
+        if (diff < 0) {
+            nearest(lo, mid, depth, q, best, bestDist);
+            if (diff * diff >= bestDist) return;
+            lo = mid + 1;
+        } else {
+            nearest(mid + 1, hi, depth, q, best, bestDist);
+            if (diff * diff >= bestDist) return;
+            hi = mid;
+        }
+    }
+}
+
+std::optional<GeoPlace> ReverseGeocoder::lookup(double lat, double lon) const {
+    if (!nodes_) return std::nullopt;
+
+    float q[3];
+    toUnitVector(lat, lon, q);
+    size_t best = nodeCount_;
+    float bestDist = maxChord2_;
+    nearest(0, nodeCount_, 0, q, best, bestDist);
+    if (best == nodeCount_) return std::nullopt;
+
+    const Node& n = nodes_[best];
+    GeoPlace place;
+    place.city = str(n.name);
+    place.province = str(n.admin1);
+    if (n.country < countryCount_) {
+        const Country& c = countries_[n.country];
+        place.country = str(c.name);
+        place.countryCode = str(c.code);
+        place.continent = str(c.continent);
+    }
+    place.distanceKm = 2.0 * EARTH_RADIUS_KM * std::asin(std::min(1.0, std::sqrt(bestDist) / 2.0));
+    return place;
+}
+
+bool ReverseGeocoder::fill(PhotoData& data) const {
+    // (0,0) heißt bei uns "kein GPS"
+    if (!nodes_ || (data.gpsLat == 0.0 && data.gpsLon == 0.0)) return false;
+    if (!data.city.empty() && !data.province.empty() && !data.country.empty() &&
+        !data.countryCode.empty() && !data.continent.empty()) {
+        return false;
+    }
+
+    auto place = lookup(data.gpsLat, data.gpsLon);
+    if (!place) return false;
+
+    // Snapshot-Texte in die Arena des Fotos kopieren (Snapshot kann ersetzt werden)
+    auto set = [&data](std::string_view& field, std::string_view value) {
+        if (field.empty() && !value.empty()) field = data.store(value);
+    };
+    set(data.city, place->city);
+    set(data.province, place->province);
+    set(data.country, place->country);
+    set(data.countryCode, place->countryCode);
+    set(data.continent, place->continent);
+    return true;
+}
+
+// --- Snapshot bauen ---
+
+namespace {
+
+class StringTable {
+public:
+    StringTable() { bytes_.push_back('\0'); }   // Offset 0 = ""
+
+    uint32_t add(std::string_view s) {
+        if (s.empty()) return 0;
+        auto it = offsets_.find(std::string(s));
+        if (it != offsets_.end()) return it->second;
+        uint32_t off = static_cast<uint32_t>(bytes_.size());
+        bytes_.insert(bytes_.end(), s.begin(), s.end());
+        bytes_.push_back('\0');
+        offsets_.emplace(std::string(s), off);
+        return off;
+    }
+    const std::vector<char>& bytes() const { return bytes_; }
+
+private:
+    std::vector<char> bytes_;
+    std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+template <typename Node>
+void buildKdTree(std::vector<Node>& nodes, size_t lo, size_t hi, int depth) {
+    if (hi - lo <= 1) return;
+    size_t mid = lo + (hi - lo) / 2;
+    int axis = depth % 3;
+    std::nth_element(nodes.begin() + lo, nodes.begin() + mid, nodes.begin() + hi,
+                     [axis](const Node& a, const Node& b) { return a.v[axis] < b.v[axis]; });
+    buildKdTree(nodes, lo, mid, depth + 1);
+    buildKdTree(nodes, mid + 1, hi, depth + 1);
+}
+
+} // namespace
+
+bool ReverseGeocoder::buildSnapshot(const fs::path& dir, const fs::path& citiesFile, const fs::path& out) {
+    StringTable strings;
+    std::vector<Country> countries;
+    std::unordered_map<std::string, uint32_t> countryIndex;   // ISO2 -> Index
+    std::unordered_map<std::string, uint32_t> admin1;         // "DE.02" -> Name
+    std::string line;
+
+    // countryInfo.txt: ISO, ISO3, ISO-Numeric, fips, Country, Capital, Area, Population, Continent, ...
+    if (std::ifstream in(dir / "countryInfo.txt"); in) {
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            auto f = splitTabs(line);
+            if (f.size() < 9) continue;
+            countryIndex.emplace(std::string(f[0]), static_cast<uint32_t>(countries.size()));
+            countries.push_back({strings.add(f[4]), strings.add(f[1].empty() ? f[0] : f[1]),
+                                 strings.add(continentName(f[8]))});
+        }
+    } else {
+        qWarning() << "Reverse geocoding: countryInfo.txt missing, country names stay empty";
+    }
+
+    // admin1CodesASCII.txt: "DE.02", Name, ASCII-Name, geonameid
+    if (std::ifstream in(dir / "admin1CodesASCII.txt"); in) {
+        while (std::getline(in, line)) {
+            auto f = splitTabs(line);
+            if (f.size() < 2) continue;
+            admin1.emplace(std::string(f[0]), strings.add(f[1]));
+        }
+    }
+
+    // cities*.txt: geonameid, name, asciiname, alternatenames, lat, lon, class, code, country, cc2, admin1, ...
+    std::ifstream in(citiesFile);
+    if (!in) {
+        qWarning() << "Reverse geocoding: cannot read" << QString::fromStdString(citiesFile.string());
+        return false;
+    }
+    std::vector<Node> nodes;
+    while (std::getline(in, line)) {
+        auto f = splitTabs(line);
+        if (f.size() < 11) continue;
+
+        double lat = std::strtod(std::string(f[4]).c_str(), nullptr);
+        double lon = std::strtod(std::string(f[5]).c_str(), nullptr);
+
+        Node n{};
+        toUnitVector(lat, lon, n.v);
+        n.name = strings.add(f[1]);
+        std::string cc(f[8]);
+        auto a = admin1.find(cc + "." + std::string(f[10]));
+        n.admin1 = a != admin1.end() ? a->second : 0;
+        auto c = countryIndex.find(cc);
+        if (c != countryIndex.end()) {
+            n.country = c->second;
+        } else if (!cc.empty()) {
+            // Land ohne countryInfo-Eintrag: wenigstens den ISO2-Code liefern
+            countryIndex.emplace(cc, static_cast<uint32_t>(countries.size()));
+            n.country = static_cast<uint32_t>(countries.size());
+            countries.push_back({0, strings.add(cc), 0});
+        } else {
+            n.country = NO_COUNTRY;
+        }
+        nodes.push_back(n);
+    }
+    if (nodes.empty()) {
+        qWarning() << "Reverse geocoding: no places in" << QString::fromStdString(citiesFile.string());
+        return false;
+    }
+
+    buildKdTree(nodes, 0, nodes.size(), 0);
+
+    SnapshotHeader h{};
+    std::memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.nodeCount = static_cast<uint32_t>(nodes.size());
+    h.countryCount = static_cast<uint32_t>(countries.size());
+    h.stringBytes = static_cast<uint32_t>(strings.bytes().size());
+    h.sourceMtime = mtimeOf(citiesFile);
+
+    // Erst vollständig schreiben, dann umbenennen -> nie ein halber Snapshot
+    fs::path tmp = out;
+    tmp += ".tmp";
+    {
+        std::ofstream o(tmp, std::ios::binary | std::ios::trunc);
+        o.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        o.write(reinterpret_cast<const char*>(nodes.data()), static_cast<std::streamsize>(nodes.size() * sizeof(Node)));
+        o.write(reinterpret_cast<const char*>(countries.data()),
+                static_cast<std::streamsize>(countries.size() * sizeof(Country)));
+        o.write(strings.bytes().data(), static_cast<std::streamsize>(strings.bytes().size()));
+        if (!o) {
+            qWarning() << "Reverse geocoding: writing snapshot failed";
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, out, ec);
+    if (ec) {
+        qWarning() << "Reverse geocoding: cannot rename snapshot:" << QString::fromStdString(ec.message());
+        return false;
+    }
+    qDebug() << "Reverse geocoding: snapshot with" << nodes.size() << "places written";
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include "MetadataExtractor.h"
+
+// Ergebnis einer Abfrage. Die Views zeigen in den gemappten Snapshot.
+struct GeoPlace {
+    std::string_view city;
+    std::string_view province;
+    std::string_view country;
+    std::string_view countryCode;   // ISO 3166 alpha-3 (wie IPTC), sonst alpha-2
+    std::string_view continent;
+    double distanceKm = 0.0;
+};
+
+// Offline Reverse-Geocoding aus einem GeoNames-Dump (WORKER_GEONAMES_DIR):
+//   cities1000.txt (oder cities500/5000/15000), admin1CodesASCII.txt, countryInfo.txt
+//
+// Beim ersten Start wird daraus ein Binär-Snapshot (geonames.snapshot) mit
+// einem impliziten k-d-Baum über 3D-Einheitsvektoren gebaut. Danach wird nur
+// noch der Snapshot per mmap geladen -> kein Parsen beim Start, und die
+// Seiten werden vom Page Cache zwischen Neustarts geteilt.
+class ReverseGeocoder {
+public:
+    static ReverseGeocoder& instance();
+
+    // Snapshot laden (bei Bedarf aus dem Dump bauen). false -> Geocoding aus
+    bool load();
+    bool isLoaded() const { return nodes_ != nullptr; }
+
+    // Nächster Ort innerhalb von WORKER_GEOCODER_MAX_KM (Default 50 km)
+    std::optional<GeoPlace> lookup(double lat, double lon) const;
+
+    // Leere Ortsfelder aus den GPS-Koordinaten ergänzen. true -> etwas ergänzt
+    bool fill(PhotoData& data) const;
+
+    // Snapshot aus den GeoNames-Dateien in dir bauen
+    static bool buildSnapshot(const std::filesystem::path& dir, const std::filesystem::path& citiesFile,
+                              const std::filesystem::path& out);
+
+    size_t size() const { return nodeCount_; }
+
+private:
+    ReverseGeocoder() = default;
+    ~ReverseGeocoder();
+
+    struct Node;
+    struct Country;
+
+    bool mapSnapshot(const std::filesystem::path& p, int64_t expectedSourceMtime);
+    void nearest(size_t lo, size_t hi, int depth, const float q[3], size_t& best, float& bestDist) const;
+    std::string_view str(uint32_t offset) const;
+
+    void* map_ = nullptr;
+    size_t mapSize_ = 0;
+    const Node* nodes_ = nullptr;
+    size_t nodeCount_ = 0;
+    const Country* countries_ = nullptr;
+    size_t countryCount_ = 0;
+    const char* strings_ = nullptr;
+    size_t stringBytes_ = 0;
+    float maxChord2_ = 0.0f;
+};
@@ -0,0 +1,231 @@
+#include "Tracer.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+static int envInt(const char* name, int defaultValue) {
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+static int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Auf Puffergröße kürzen, ohne ein UTF-8 Zeichen zu zerschneiden
+template <size_t N>
+static void copyTruncated(char (&dst)[N], std::string_view src) {
+    size_t len = std::min(src.size(), N - 1);
+    if (len < src.size()) {
+        while (len > 0 && (static_cast<unsigned char>(src[len]) & 0xC0) == 0x80) --len;
+    }
+    std::memcpy(dst, src.data(), len);
+    dst[len] = '\0';
+}
+
+// Datei des aktuellen Threads (siehe TraceFileScope)
+struct TraceContext {
+    char file[64] = {};
+    char user[32] = {};
+    int64_t size = -1;
+};
+
+static thread_local TraceContext tlsContext;
+static thread_local std::shared_ptr<void> tlsBuffer;   // hält den Puffer des Threads
+static thread_local const char* tlsThreadName = nullptr;
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer() : epochNs_(steadyNs()) {
+    capacity_ = static_cast<size_t>(std::clamp(envInt("WORKER_TRACE_EVENTS", 16384), 256, 1 << 20));
+    QString mode = qEnvironmentVariable("WORKER_TRACE", "off");
+    if (mode == "on" || mode == "1") setEnabled(true);
+}
+
+void Tracer::setEnabled(bool on) {
+    if (enabled_.exchange(on) == on) return;
+    if (on) qDebug() << "Tracing enabled," << capacity_ << "spans per thread";
+    else qDebug() << "Tracing disabled.";
+}
+
+void Tracer::clear() {
+    std::lock_guard lock(mutex_);
+    for (auto& b : buffers_) {
+        std::lock_guard bufferLock(b->mutex);
+        b->written = 0;
+    }
+}
+
+void Tracer::nameThread(const char* name) {
+    tlsThreadName = name;
+    if (tlsBuffer) {
+        auto* b = static_cast<ThreadBuffer*>(tlsBuffer.get());
+        std::lock_guard lock(b->mutex);
+        b->name = name;
+    }
+}
+
+int64_t Tracer::now() const {
+    return steadyNs() - epochNs_;
+}
+
+// Erst beim ersten Span eines Threads angelegt -> ohne Tracing kein Speicher
+Tracer::ThreadBuffer& Tracer::buffer() {
+    if (!tlsBuffer) {
+        auto b = std::make_shared<ThreadBuffer>();
+        b->events.resize(capacity_);
+        if (tlsThreadName) b->name = tlsThreadName;
+        std::lock_guard lock(mutex_);
+        b->tid = static_cast<uint32_t>(buffers_.size() + 1);
+        buffers_.push_back(b);
+        tlsBuffer = b;
+    }
+    return *static_cast<ThreadBuffer*>(tlsBuffer.get());
+}
+
+void Tracer::record(const TraceEvent& e) {
+    ThreadBuffer& b = buffer();
+    std::lock_guard lock(b.mutex);
+    b.events[b.written % b.events.size()] = e;
+    ++b.written;
+}
+
+static void appendEscaped(std::string& out, const char* s) {
+    for (; *s; ++s) {
+        const auto c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+}
+
+// Chrome "Trace Event Format" (chrome://tracing, ui.perfetto.dev).
+// "X" = vollständiger Span mit Dauer, Zeiten in Mikrosekunden
+std::string Tracer::chromeJson() const {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard lock(mutex_);
+        buffers = buffers_;
+    }
+
+    std::string out = R"({"displayTimeUnit":"ms","traceEvents":[)";
+    bool first = true;
+    char buf[160];
+    std::vector<TraceEvent> events;
+    for (const auto& b : buffers) {
+        std::string name;
+        {
+            std::lock_guard lock(b->mutex);
+            const uint64_t cap = b->events.size();
+            const uint64_t n = std::min<uint64_t>(b->written, cap);
+            events.clear();
+            for (uint64_t i = b->written - n; i < b->written; ++i) events.push_back(b->events[i % cap]);
+            name = b->name.empty() ? "thread " + std::to_string(b->tid) : b->name;
+        }
+
+        if (!first) out += ',';
+        first = false;
+        out += R"({"ph":"M","pid":1,"name":"thread_name","tid":)";
+        out += std::to_string(b->tid);
+        out += R"(,"args":{"name":")";
+        appendEscaped(out, name.c_str());
+        out += "\"}}";
+
+        for (const TraceEvent& e : events) {
+            std::snprintf(buf, sizeof(buf), R"(,{"ph":"X","pid":1,"tid":%u,"ts":%.3f,"dur":%.3f,"name":")",
+                          b->tid, e.startNs / 1000.0, e.durNs / 1000.0);
+            out += buf;
+            appendEscaped(out, e.name);
+            out += R"(","cat":")";
+            appendEscaped(out, e.category);
+            out += R"(","args":{)";
+            bool firstArg = true;
+            auto sep = [&] {
+                if (!firstArg) out += ',';
+                firstArg = false;
+            };
+            if (e.file[0]) {
+                sep();
+                out += R"("file":")";
+                appendEscaped(out, e.file);
+                out += '"';
+            }
+            if (e.user[0]) {
+                sep();
+                out += R"("user":")";
+                appendEscaped(out, e.user);
+                out += '"';
+            }
+            if (e.size >= 0) {
+                sep();
+                out += R"("size":)" + std::to_string(e.size);
+            }
+            if (e.count > 0) {
+                sep();
+                out += R"("count":)" + std::to_string(e.count);
+            }
+            out += "}}";
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+// --- TraceFileScope ---
+
+TraceFileScope::TraceFileScope(std::string_view file, std::string_view user, int64_t size) {
+    if (!Tracer::instance().enabled()) return;
+    active_ = true;
+    std::memcpy(file_, tlsContext.file, sizeof(file_));
+    std::memcpy(user_, tlsContext.user, sizeof(user_));
+    size_ = tlsContext.size;
+    copyTruncated(tlsContext.file, file);
+    copyTruncated(tlsContext.user, user);
+    tlsContext.size = size;
+}
+
+TraceFileScope::~TraceFileScope() {
+    if (!active_) return;
+    std::memcpy(tlsContext.file, file_, sizeof(file_));
+    std::memcpy(tlsContext.user, user_, sizeof(user_));
+    tlsContext.size = size_;
+}
+
+void TraceFileScope::setSize(int64_t size) {
+    tlsContext.size = size;
+}
+
+// --- TraceSpan ---
+
+TraceSpan::~TraceSpan() {
+    // Auch wenn zwischendurch ausgeschaltet wurde: begonnene Spans noch schreiben
+    if (start_ < 0) return;
+    Tracer& tracer = Tracer::instance();
+    TraceEvent e;
+    e.name = name_;
+    e.category = category_;
+    e.startNs = start_;
+    e.durNs = tracer.now() - start_;
+    e.count = count_;
+    if (count_ == 0) {
+        std::memcpy(e.file, tlsContext.file, sizeof(e.file));
+        std::memcpy(e.user, tlsContext.user, sizeof(e.user));
+        e.size = tlsContext.size;
+    }
+    tracer.record(e);
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Span-Tracing für einzelne Dateien (Chrome Trace / Perfetto).
+// Jeder Thread schreibt in einen eigenen Ringpuffer fester Größe; die ältesten
+// Spans werden überschrieben. Ausgeschaltet kostet ein Span nur ein relaxed load.
+// WORKER_TRACE=on schaltet beim Start ein, WORKER_TRACE_EVENTS = Spans pro Thread.
+// Zur Laufzeit: /trace/on, /trace/off, /trace (JSON für ui.perfetto.dev).
+
+struct TraceEvent {
+    const char* name = nullptr;       // String-Literal
+    const char* category = nullptr;   // String-Literal
+    int64_t startNs = 0;              // seit Start des Tracers
+    int64_t durNs = 0;
+    int64_t size = -1;                // Dateigröße, -1 = unbekannt
+    int count = 0;                    // Batch-Größe, 0 = kein Batch
+    char file[64] = {};
+    char user[32] = {};
+};
+
+class Tracer {
+public:
+    static Tracer& instance();
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    void setEnabled(bool on);
+
+    // Puffer leeren (z.B. vor einem neuen Mitschnitt)
+    void clear();
+
+    // Name des aktuellen Threads in der Trace-Ansicht ("extract", "db", ...)
+    static void nameThread(const char* name);
+
+    // Alle Puffer als Chrome Trace Event JSON
+    std::string chromeJson() const;
+
+    size_t eventsPerThread() const { return capacity_; }
+
+    // Für TraceSpan
+    int64_t now() const;
+    void record(const TraceEvent& e);
+
+private:
+    Tracer();
+
+    struct ThreadBuffer {
+        std::mutex mutex;   // praktisch unbestritten: nur der Besitzer schreibt
+        std::vector<TraceEvent> events;
+        uint64_t written = 0;
+        uint32_t tid = 0;
+        std::string name;
+    };
+
+    ThreadBuffer& buffer();
+
+    std::atomic<bool> enabled_{false};
+    size_t capacity_ = 16384;
+    int64_t epochNs_ = 0;
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;   // auch von beendeten Threads
+};
+
+// Datei, an der der aktuelle Thread gerade arbeitet. Spans darunter (auch in
+// DbManager, FileMover, ...) werden damit markiert. Verschachtelbar.
+class TraceFileScope {
+public:
+    TraceFileScope(std::string_view file, std::string_view user, int64_t size = -1);
+    ~TraceFileScope();
+    TraceFileScope(const TraceFileScope&) = delete;
+    TraceFileScope& operator=(const TraceFileScope&) = delete;
+
+    // Größe erst nach dem Hashen bekannt
+    static void setSize(int64_t size);
+
+private:
+    bool active_ = false;
+    char file_[64];
+    char user_[32];
+    int64_t size_ = -1;
+};
+
+// Misst die Lebensdauer des Objekts als Span "name"
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* category = "worker") noexcept
+        : name_(name), category_(category),
+          start_(Tracer::instance().enabled() ? Tracer::instance().now() : -1) {}
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // Batch-Spans: Anzahl Dateien statt eines Dateinamens
+    void setCount(int count) { count_ = count; }
+
+private:
+    const char* name_;
+    const char* category_;
+    int64_t start_;
+    int count_ = 0;
+};
@@ -0,0 +1,236 @@
+#include "UserScheduler.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <QString>
+#include <QtGlobal>
+#include <algorithm>
+
+static MetricHistogram& waitHistogram() {
+    static MetricHistogram& h = MetricsRegistry::instance().histogram(
+        "worker_schedule_wait_seconds", "Time a discovered file waited for its user's turn", "",
+        {0.01, 0.1, 1, 10, 60, 300, 900, 3600, 14400});
+    return h;
+}
+
+const char* priorityName(PriorityClass p) {
+    switch (p) {
+        case PriorityClass::High:   return "high";
+        case PriorityClass::Normal: return "normal";
+        case PriorityClass::Low:    return "low";
+    }
+    return "normal";
+}
+
+// Helper: "alice=3,bob=1" -> fn("alice", "3") pro Eintrag
+template <typename Fn>
+static void parseUserList(const char* envName, Fn fn) {
+    const QString spec = qEnvironmentVariable(envName);
+    for (const QString& part : spec.split(',', Qt::SkipEmptyParts)) {
+        const auto kv = part.split('=');
+        if (kv.size() != 2 || kv[0].trimmed().isEmpty()) {
+            qWarning() << envName << ": ignoring" << part;
+            continue;
+        }
+        fn(kv[0].trimmed().toStdString(), kv[1].trimmed());
+    }
+}
+
+SchedulerConfig SchedulerConfig::fromEnvironment() {
+    SchedulerConfig cfg;
+    bool ok = false;
+    int capacity = qEnvironmentVariableIntValue("WORKER_SCHED_CAPACITY", &ok);
+    if (ok && capacity > 0) cfg.capacity = static_cast<size_t>(capacity);
+    int cap = qEnvironmentVariableIntValue("WORKER_USER_CAP", &ok);
+    if (ok && cap >= 0) cfg.defaults.maxConcurrent = cap;
+
+    // Erst alle Benutzer mit den Defaults anlegen, dann einzelne Felder überschreiben
+    auto policy = [&](const std::string& user) -> UserPolicy& {
+        return cfg.users.try_emplace(user, cfg.defaults).first->second;
+    };
+    parseUserList("WORKER_USER_WEIGHTS", [&](const std::string& user, const QString& v) {
+        int w = v.toInt(&ok);
+        if (ok && w > 0) policy(user).weight = w;
+        else qWarning() << "WORKER_USER_WEIGHTS: invalid weight for" << QString::fromStdString(user);
+    });
+    parseUserList("WORKER_USER_CAPS", [&](const std::string& user, const QString& v) {
+        int c = v.toInt(&ok);
+        if (ok && c >= 0) policy(user).maxConcurrent = c;
+        else qWarning() << "WORKER_USER_CAPS: invalid cap for" << QString::fromStdString(user);
+    });
+    parseUserList("WORKER_USER_PRIORITY", [&](const std::string& user, const QString& v) {
+        QString p = v.toLower();
+        if (p == "high") policy(user).priority = PriorityClass::High;
+        else if (p == "low") policy(user).priority = PriorityClass::Low;
+        else if (p == "normal") policy(user).priority = PriorityClass::Normal;
+        else qWarning() << "WORKER_USER_PRIORITY: unknown class" << v;
+    });
+    return cfg;
+}
+
+const UserPolicy& SchedulerConfig::policyFor(const std::string& user) const {
+    auto it = users.find(user);
+    return it != users.end() ? it->second : defaults;
+}
+
+UserScheduler::UserScheduler(SchedulerConfig cfg) : cfg_(std::move(cfg)) {}
+
+UserScheduler::UserState& UserScheduler::stateFor(const std::string& user) {
+    auto [it, inserted] = users_.try_emplace(user);
+    if (inserted) {
+        it->second.name = user;
+        it->second.policy = cfg_.policyFor(user);
+    }
+    return it->second;
+}
+
+bool UserScheduler::capped(const UserState& u) const {
+    return u.policy.maxConcurrent > 0 && u.inFlight >= u.policy.maxConcurrent;
+}
+
+bool UserScheduler::push(const std::string& user, std::filesystem::path path) {
+    std::unique_lock lock(mutex_);
+    notFull_.wait(lock, [&] { return closed_ || queued_ < cfg_.capacity; });
+    if (closed_) return false;
+
+    UserState& u = stateFor(user);
+    u.queue.push_back({std::move(path), Clock::now()});
+    queued_++;
+    if (!u.active) {
+        u.active = true;
+        u.deficit = 0;
+        rounds_[static_cast<int>(u.policy.priority)].push_back(&u);
+    }
+    notEmpty_.notify_one();
+    return true;
+}
+
+// Deficit Round Robin pro Klasse: wer vorne steht, bekommt "weight" Dateien,
+// dann ist der Nächste dran. Benutzer am Limit werden übersprungen.
+std::optional<ScheduledFile> UserScheduler::takeNext() {
+    for (auto& round : rounds_) {
+        for (size_t tries = round.size(); tries > 0; --tries) {
+            UserState* u = round.front();
+            if (capped(*u)) {
+                round.pop_front();
+                round.push_back(u);
+                continue;
+            }
+            if (u->deficit <= 0) u->deficit += u->policy.weight;
+
+            Entry e = std::move(u->queue.front());
+            u->queue.pop_front();
+            queued_--;
+            u->deficit--;
+            u->inFlight++;
+            u->served++;
+
+            double waited = std::chrono::duration<double>(Clock::now() - e.enqueued).count();
+            u->waitSum += waited;
+            u->waitMax = std::max(u->waitMax, waited);
+            waitHistogram().observe(waited);
+
+            if (u->queue.empty()) {
+                round.pop_front();
+                u->active = false;
+                u->deficit = 0;
+            } else if (u->deficit <= 0) {
+                round.pop_front();
+                round.push_back(u);
+            }
+            return ScheduledFile{u->name, std::move(e.path)};
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<ScheduledFile> UserScheduler::pop() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        if (auto next = takeNext()) {
+            notFull_.notify_one();
+            return next;
+        }
+        if (closed_ && queued_ == 0) return std::nullopt;
+        // Leer oder alle Wartenden am Limit -> auf push()/finished() warten
+        notEmpty_.wait(lock);
+    }
+}
+
+void UserScheduler::finished(const std::string& user) {
+    std::lock_guard lock(mutex_);
+    auto it = users_.find(user);
+    if (it == users_.end() || it->second.inFlight <= 0) return;
+    it->second.inFlight--;
+    if (it->second.active) notEmpty_.notify_one();
+}
+
+bool UserScheduler::requeue(const std::string& user, std::filesystem::path path) {
+    std::lock_guard lock(mutex_);
+    if (closed_) return false;
+
+    UserState& u = stateFor(user);
+    if (u.inFlight > 0) u.inFlight--;
+    u.queue.push_back({std::move(path), Clock::now()});
+    queued_++;
+    if (!u.active) {
+        u.active = true;
+        u.deficit = 0;
+        rounds_[static_cast<int>(u.policy.priority)].push_back(&u);
+    }
+    notEmpty_.notify_one();
+    return true;
+}
+
+void UserScheduler::close() {
+    std::lock_guard lock(mutex_);
+    closed_ = true;
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+}
+
+void UserScheduler::clear() {
+    std::lock_guard lock(mutex_);
+    for (auto& [name, u] : users_) {
+        u.queue.clear();
+        u.active = false;
+        u.deficit = 0;
+    }
+    for (auto& round : rounds_) round.clear();
+    queued_ = 0;
+    notFull_.notify_all();
+    notEmpty_.notify_all();
+}
+
+size_t UserScheduler::size() const {
+    std::lock_guard lock(mutex_);
+    return queued_;
+}
+
+size_t UserScheduler::activeUsers() const {
+    std::lock_guard lock(mutex_);
+    size_t n = 0;
+    for (const auto& round : rounds_) n += round.size();
+    return n;
+}
+
+std::vector<UserQueueStats> UserScheduler::snapshot() const {
+    std::lock_guard lock(mutex_);
+    const auto now = Clock::now();
+    std::vector<UserQueueStats> out;
+    out.reserve(users_.size());
+    for (const auto& [name, u] : users_) {
+        UserQueueStats s;
+        s.user = name;
+        s.priority = u.policy.priority;
+        s.weight = u.policy.weight;
+        s.depth = u.queue.size();
+        s.inFlight = u.inFlight;
+        s.served = u.served;
+        if (!u.queue.empty()) s.oldestWaitSeconds = std::chrono::duration<double>(now - u.queue.front().enqueued).count();
+        s.avgWaitSeconds = u.served ? u.waitSum / static_cast<double>(u.served) : 0.0;
+        s.maxWaitSeconds = u.waitMax;
+        out.push_back(std::move(s));
+    }
+    std::sort(out.begin(), out.end(), [](const UserQueueStats& a, const UserQueueStats& b) { return a.user < b.user; });
+    return out;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Prioritätsklassen: höhere Klasse wird strikt zuerst bedient
+enum class PriorityClass { High = 0, Normal = 1, Low = 2 };
+
+const char* priorityName(PriorityClass p);
+
+struct UserPolicy {
+    int weight = 1;          // Dateien pro Runde (Deficit Round Robin)
+    int maxConcurrent = 0;   // gleichzeitig in Extraktion/Verschieben, 0 -> unbegrenzt
+    PriorityClass priority = PriorityClass::Normal;
+};
+
+struct SchedulerConfig {
+    size_t capacity = 100000;   // nur Pfade -> großzügig, Backpressure erst ganz am Ende
+    UserPolicy defaults;
+    std::unordered_map<std::string, UserPolicy> users;
+
+    // WORKER_SCHED_CAPACITY, WORKER_USER_WEIGHTS="alice=3,bob=1",
+    // WORKER_USER_CAP (Default) / WORKER_USER_CAPS="bob=2",
+    // WORKER_USER_PRIORITY="admin=high,bulk=low"
+    static SchedulerConfig fromEnvironment();
+    const UserPolicy& policyFor(const std::string& user) const;
+};
+
+struct ScheduledFile {
+    std::string user;
+    std::filesystem::path path;
+};
+
+// Für /status
+struct UserQueueStats {
+    std::string user;
+    PriorityClass priority = PriorityClass::Normal;
+    int weight = 1;
+    size_t depth = 0;
+    int inFlight = 0;
+    uint64_t served = 0;
+    double oldestWaitSeconds = 0;   // ältester noch wartender Eintrag
+    double avgWaitSeconds = 0;      // bis zur Zuteilung, über alle bedienten Dateien
+    double maxWaitSeconds = 0;
+};
+
+// Zwischen Discovery und Extraktion: eine Queue pro Benutzer, Zuteilung per
+// Deficit Round Robin (Gewicht = Dateien pro Runde), optional mit Obergrenze
+// gleichzeitig bearbeiteter Dateien pro Benutzer. So warten drei Fotos nicht
+// hinter 20.000 Dateien eines anderen Benutzers.
+class UserScheduler {
+public:
+    explicit UserScheduler(SchedulerConfig cfg);
+
+    // Blockiert nur, wenn insgesamt capacity Dateien warten. false -> geschlossen
+    bool push(const std::string& user, std::filesystem::path path);
+
+    // nullopt erst, wenn geschlossen UND nichts mehr zuteilbar ist
+    std::optional<ScheduledFile> pop();
+
+    // Zugeteilte Datei ist fertig (gibt den Platz im Benutzer-Limit frei)
+    void finished(const std::string& user);
+
+    // Zugeteilte Datei später noch einmal: wie finished() + push(), blockiert
+    // aber nie (auch nicht bei voller Queue). false -> geschlossen, nichts geändert
+    bool requeue(const std::string& user, std::filesystem::path path);
+
+    void close();
+    void clear();   // Wartende verwerfen (Herunterfahren)
+    size_t size() const;
+    size_t activeUsers() const;
+    std::vector<UserQueueStats> snapshot() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::filesystem::path path;
+        Clock::time_point enqueued;
+    };
+
+    struct UserState {
+        std::string name;
+        UserPolicy policy;
+        std::deque<Entry> queue;
+        int deficit = 0;
+        int inFlight = 0;
+        bool active = false;   // steht in der Runde seiner Klasse
+        uint64_t served = 0;
+        double waitSum = 0;
+        double waitMax = 0;
+    };
+
+    UserState& stateFor(const std::string& user);
+    std::optional<ScheduledFile> takeNext();
+    bool capped(const UserState& u) const;
+
+    static constexpr int CLASSES = 3;
+
+    const SchedulerConfig cfg_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::unordered_map<std::string, UserState> users_;
+    std::deque<UserState*> rounds_[CLASSES];   // aktive Benutzer pro Klasse, vorne ist dran
+    size_t queued_ = 0;
+    bool closed_ = false;
+};
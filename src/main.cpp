@@ -2,93 +2,62 @@
 #include <filesystem>
 #include <thread>
 #include <atomic>
-#include <algorithm>
 #include <iostream>
 #include <chrono> 
+#include <csignal>
+#include <string_view>
 #include <QCoreApplication>
 #include <QDir>
-#include <QDateTime>
-#include <QRegularExpression> // Wichtig für Regex
 
-#include "DbManager.h"
-#include "MetadataExtractor.h"
+#include "DbPool.h"
+#include "DuplicateIndex.h"
+#include "HttpIngest.h"
+#include "InboxLeases.h"
+#include "InboxWatcher.h"
+#include "KeywordCache.h"
+#include "PerceptualHash.h"
+#include "IngestPipeline.h"
+#include "IngestServer.h"
+#include "Metrics.h"
+#include "Reindexer.h"
+#include "ReverseGeocoder.h"
+#include "Tracer.h"
 
 namespace fs = std::filesystem;
 
 // Globals
 std::atomic<bool> isRunning{true};
-std::atomic<int> processedCount{0};
 
 // Paths
 const fs::path INBOX_DIR = "uploads";
 const fs::path PHOTOS_ROOT = "Photos";
 
-// Helper: String bereinigen
-std::string sanitize(const std::string& input) {
-    if (input.empty()) return "Unknown";
-    std::string out = input;
-    std::replace(out.begin(), out.end(), ' ', '_');
-    return out;
-}
+IngestPipeline pipeline(PipelineConfig::fromEnvironment(INBOX_DIR, PHOTOS_ROOT));
 
-// Helper: C++ Filesystem Time -> QDateTime
-QDateTime getFileLastModified(const fs::path& p) {
-    try {
-        auto ftime = fs::last_write_time(p);
-        auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-            ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now()
-        );
-        std::time_t tt = std::chrono::system_clock::to_time_t(sctp);
-        return QDateTime::fromSecsSinceEpoch(tt);
-    } catch (...) {
-        return QDateTime::currentDateTime(); 
-    }
-}
+// WORKER_CLUSTER=lease: Inbox mit anderen Knoten teilen, nur beanspruchte Dateien bearbeiten.
+// Auf NFS sieht inotify die Dateien anderer Clients nicht -> dort WORKER_WATCH_MODE=poll.
+InboxLeases leases(INBOX_DIR, LeaseConfig::fromEnvironment(), [](const fs::path& p) { pipeline.submit(p); });
 
-// Helper: Datum aus Dateinamen extrahieren
-// Muster: YYYY-MM-DD_HHMMSS
-QDateTime extractDateFromFilename(const std::string& filename) {
-    static QRegularExpression re(R"((\d{4})-(\d{2})-(\d{2})_(\d{2})(\d{2})(\d{2}))");
-    auto match = re.match(QString::fromStdString(filename));
-    
-    if (match.hasMatch()) {
-        int year  = match.captured(1).toInt();
-        int month = match.captured(2).toInt();
-        int day   = match.captured(3).toInt();
-        int hour  = match.captured(4).toInt();
-        int min   = match.captured(5).toInt();
-        int sec   = match.captured(6).toInt();
-        
-        QDate date(year, month, day);
-        QTime time(hour, min, sec);
-        if (date.isValid() && time.isValid()) {
-            return QDateTime(date, time);
-        }
-    }
-    return QDateTime();
+// Gefundene Inbox-Datei: direkt in die Pipeline oder erst beanspruchen
+void discovered(const fs::path& p) {
+    if (leases.enabled()) leases.offer(p);
+    else pipeline.submit(p);
 }
 
-// Helper: Filename Parsing
-struct FileInfo {
-    std::string user = "system";
-    std::string cleanName;
-};
-
-FileInfo parseFilename(const std::string& rawName) {
-    FileInfo info;
-    info.cleanName = rawName; 
-    
-    size_t firstSep = rawName.find("___");
-    if (firstSep != std::string::npos) {
-        info.user = rawName.substr(0, firstSep);
-        size_t secondSep = rawName.find("___", firstSep + 3);
-        if (secondSep != std::string::npos) {
-            info.cleanName = rawName.substr(secondSep + 3);
-        } else {
-            info.cleanName = rawName.substr(firstSep + 3);
+// Fallback: Inbox alle 2 Sekunden komplett durchsuchen
+void pollLoop() {
+    while(isRunning) {
+        if (fs::exists(INBOX_DIR)) {
+            auto opts = fs::directory_options::skip_permission_denied;
+            
+            for (const auto& entry : fs::recursive_directory_iterator(INBOX_DIR, opts)) {
+                if (!isRunning) break;
+                if (!entry.is_regular_file()) continue;
+                discovered(entry.path());
+            }
         }
+        std::this_thread::sleep_for(std::chrono::seconds(2));
     }
-    return info;
 }
 
 void workerLoop() {
@@ -96,96 +65,107 @@ void workerLoop() {
     if (!fs::exists(PHOTOS_ROOT)) fs::create_directories(PHOTOS_ROOT);
     
     qDebug() << "Worker Loop started. Watching:" << QString::fromStdString(INBOX_DIR.string());
+    KeywordCache::instance().warmUp();
+    DuplicateIndex::instance().load();
+    if (pipeline.config().phash.enabled) PerceptualIndex::instance().load();
+    ReverseGeocoder::instance().load();
+    // Hook vor start(): die Pipeline-Threads lesen ihn ohne Lock
+    if (leases.enabled()) pipeline.setReleaseHook([](const fs::path& p) { leases.release(p); });
+    pipeline.start();
+    if (leases.enabled()) leases.start();
 
-    while(isRunning) {
-        if (fs::exists(INBOX_DIR)) {
-            auto opts = fs::directory_options::skip_permission_denied;
-            
-            for (const auto& entry : fs::recursive_directory_iterator(INBOX_DIR, opts)) {
-                if (!entry.is_regular_file()) continue;
-
-                try {
-                    fs::path srcPath = entry.path();
-                    std::string rawName = srcPath.filename().string();
-                    if (rawName.starts_with(".")) continue;
-
-                    // 1. Name Parsen
-                    FileInfo fInfo = parseFilename(rawName);
-                    
-                    // 2. Metadaten lesen
-                    PhotoData meta = MetadataExtractor::extract(srcPath.string());
-
-                    // 3. Datum ermitteln (Kaskade)
-                    QDateTime finalDateTime;
-                    if (meta.takenAt.isValid()) {
-                        finalDateTime = meta.takenAt;
-                    } else {
-                        QDateTime nameDate = extractDateFromFilename(fInfo.cleanName);
-                        if (nameDate.isValid()) finalDateTime = nameDate;
-                        else finalDateTime = getFileLastModified(srcPath);
-                    }
-
-                    // --- ÄNDERUNG: PFAD BERECHNUNG ---
-                    // Wir spiegeln die Ordnerstruktur aus "uploads"
-                    
-                    // Pfad relativ zu "uploads/" berechnen
-                    // Bsp: srcPath = "uploads/2023/Sommer/img.jpg" -> relObj = "2023/Sommer/img.jpg"
-                    fs::path relObj = fs::relative(srcPath, INBOX_DIR);
-                    
-                    // Wir wollen nur den Ordner-Teil: "2023/Sommer"
-                    fs::path relPathStructure = relObj.parent_path();
-                    
-                    // Zielordner zusammenbauen: "Photos/2023/Sommer"
-                    fs::path targetDir = PHOTOS_ROOT / relPathStructure;
-                    
-                    if (!fs::exists(targetDir)) fs::create_directories(targetDir);
-                    
-                    fs::path destPath = targetDir / fInfo.cleanName;
-                    // ---------------------------------
-
-                    if (fs::exists(destPath)) {
-                        fs::remove(destPath);
-                    }
-
-                    // 5. Verschieben
-                    fs::rename(srcPath, destPath);
-                    
-                    // Optional: Leere Quell-Ordner löschen? 
-                    // Das ist tricky bei recursive_iterator. Wir lassen sie erstmal stehen.
-
-                    // 6. DB Insert
-                    WorkerPayload payload;
-                    payload.filename = fInfo.cleanName;
-                    
-                    // In der DB speichern wir den relativen Pfad (z.B. "2023/Sommer")
-                    payload.relPath  = relPathStructure.string(); 
-                    
-                    payload.fullPath = destPath.string();
-                    payload.user     = fInfo.user;
-                    payload.fileSize = fs::file_size(destPath);
-                    payload.fileDate = finalDateTime;
-                    payload.meta     = meta;
-
-                    if (DbManager::insertPhoto(payload)) {
-                        processedCount++;
-                        qDebug() << "Processed:" << QString::fromStdString(fInfo.cleanName) 
-                                 << "into" << QString::fromStdString(payload.relPath);
-                    } else {
-                        qWarning() << "DB Insert failed for" << QString::fromStdString(fInfo.cleanName);
-                    }
-
-                } catch (const std::exception& e) {
-                    qCritical() << "Error processing file:" << e.what();
-                }
-            }
+    // WORKER_WATCH_MODE: "inotify" (Default) oder "poll"
+    QString mode = qEnvironmentVariable("WORKER_WATCH_MODE", "inotify");
+    if (mode == "inotify") {
+        InboxWatcher watcher(INBOX_DIR, discovered);
+        if (watcher.init()) {
+            qDebug() << "Watch mode: inotify";
+            watcher.run(isRunning);
+            pipeline.stop();
+            leases.stop();
+            return;
         }
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+        qWarning() << "inotify not available, falling back to polling";
+    }
+
+    qDebug() << "Watch mode: poll";
+    pollLoop();
+    pipeline.stop();
+    leases.stop();
+}
+
+// --reindex [--full]: Photos/ neu einlesen statt die Inbox zu beobachten.
+// Ctrl+C bricht sauber ab, der nächste Aufruf macht beim letzten Checkpoint weiter.
+int runReindex(bool full) {
+    std::signal(SIGINT, [](int) { isRunning = false; });
+    std::signal(SIGTERM, [](int) { isRunning = false; });
+
+    if (!fs::exists(PHOTOS_ROOT)) {
+        qCritical() << "Nothing to reindex:" << QString::fromStdString(PHOTOS_ROOT.string()) << "does not exist";
+        return 1;
+    }
+    KeywordCache::instance().warmUp();
+    ReverseGeocoder::instance().load();
+
+    // DB-Writer halten ihre Verbindung bis zum Ende, dazu eine für Kurzzugriffe
+    ReindexConfig cfg = ReindexConfig::fromEnvironment(PHOTOS_ROOT, full);
+    if (!DbPool::instance().reserveFor(cfg.dbThreads + 1, QString("db writers %1, +1 short-lived").arg(cfg.dbThreads))) {
+        return 1;
+    }
+    Reindexer reindexer(std::move(cfg));
+    return reindexer.run(isRunning) ? 0 : 1;
+}
+
+// Zustand, der nur beim Scrape von /metrics gelesen wird
+void registerMetrics() {
+    auto& r = MetricsRegistry::instance();
+    const char* connHelp = "DB connection pool state";
+    r.gauge("worker_db_connections", connHelp, R"(state="max")", [] { return (double)DbPool::instance().stats().maxSize; });
+    r.gauge("worker_db_connections", connHelp, R"(state="open")", [] { return (double)DbPool::instance().stats().openConnections; });
+    r.gauge("worker_db_connections", connHelp, R"(state="in_use")", [] { return (double)DbPool::instance().stats().inUse; });
+    r.counterFunction("worker_db_reconnects_total", "DB connections re-opened after a failed health check", "",
+                      [] { return (double)DbPool::instance().stats().reconnects; });
+    r.gauge("worker_keyword_cache_entries", "Keywords held in the in-process cache", "",
+            [] { return (double)KeywordCache::instance().size(); });
+    r.counterFunction("worker_keyword_cache_hits_total", "Keyword lookups served from the cache", "",
+                      [] { return (double)KeywordCache::instance().hits(); });
+    r.counterFunction("worker_keyword_cache_misses_total", "Keyword lookups resolved in the database", "",
+                      [] { return (double)KeywordCache::instance().misses(); });
+    r.gauge("worker_geocoder_places", "Places in the reverse geocoding index", "",
+            [] { return (double)ReverseGeocoder::instance().size(); });
+    r.gauge("worker_duplicate_index_entries", "Content hashes held in the duplicate index", "",
+            [] { return (double)DuplicateIndex::instance().size(); });
+    if (pipeline.config().phash.enabled) {
+        r.gauge("worker_phash_index_entries", "Perceptual hashes held in the near-duplicate index", "",
+                [] { return (double)PerceptualIndex::instance().size(); });
     }
 }
 
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
 
+    bool reindex = false, full = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--reindex") reindex = true;
+        else if (arg == "--full") full = true;
+        else qWarning() << "Unknown argument:" << argv[i];
+    }
+    if (reindex) return runReindex(full);
+
+    // Threads, die ihre DB-Verbindung bis zum Ende halten: DB-Writer bzw. Outbox-Drain,
+    // Derivate, Lease-Claim + Heartbeat, mit Outbox auch die Move-Threads (schreiben
+    // direkt, wenn der Log ausfällt). Dazu eine für Kurzzugriffe (Caches laden, Leases abmelden).
+    // Zu wenige Plätze -> diese Threads warten in acquire() für immer.
+    const PipelineConfig& pc = pipeline.config();
+    const int leaseThreads = leases.enabled() ? 2 : 0;
+    const int moveDbThreads = pc.outbox.enabled ? pc.moveThreads : 0;
+    const int longLived = pc.dbThreads + pc.derivativeThreads + leaseThreads + moveDbThreads;
+    const QString poolDetail = QString("db %1, derivatives %2, leases %3, move %4, +1 short-lived")
+                                   .arg(pc.dbThreads).arg(pc.derivativeThreads).arg(leaseThreads).arg(moveDbThreads);
+    if (!DbPool::instance().reserveFor(longLived + 1, poolDetail)) return 1;
+
+    registerMetrics();
     std::thread t(workerLoop);
 
     crow::SimpleApp monitor;
@@ -194,11 +174,117 @@ int main(int argc, char *argv[]) {
     ([](){
         crow::json::wvalue x;
         x["service"] = "CrowWorker";
-        x["processed"] = (int)processedCount;
+        const StageCounters& c = pipeline.counters();
+        x["processed"] = c.stored.load();
+        x["stages"]["discovered"] = c.discovered.load();
+        x["stages"]["extracted"] = c.extracted.load();
+        x["stages"]["moved"] = c.moved.load();
+        x["stages"]["stored"] = c.stored.load();
+        x["stages"]["failed"] = c.failed.load();
+        x["stages"]["duplicates"] = c.duplicates.load();
+        x["stages"]["near_duplicates"] = c.nearDuplicates.load();
+        x["stages"]["derivatives"] = c.derivatives.load();
+        x["backlog"]["extract"] = (int)pipeline.extractBacklog();
+        x["backlog"]["move"] = (int)pipeline.moveBacklog();
+        x["backlog"]["db"] = (int)pipeline.dbBacklog();
+        x["backlog"]["derivatives"] = (int)pipeline.derivativeBacklog();
+        // Fair-Share: Warteschlange pro Benutzer
+        for (const UserQueueStats& u : pipeline.userQueues()) {
+            auto& j = x["users"][u.user];
+            j["priority"] = priorityName(u.priority);
+            j["weight"] = u.weight;
+            j["queued"] = (int)u.depth;
+            j["in_flight"] = u.inFlight;
+            j["served"] = static_cast<qint64>(u.served);
+            j["oldest_wait_s"] = u.oldestWaitSeconds;
+            j["avg_wait_s"] = u.avgWaitSeconds;
+            j["max_wait_s"] = u.maxWaitSeconds;
+        }
+        DbPoolStats db = DbPool::instance().stats();
+        x["db"]["max"] = db.maxSize;
+        x["db"]["open"] = db.openConnections;
+        x["db"]["in_use"] = db.inUse;
+        x["db"]["acquisitions"] = db.acquisitions;
+        x["db"]["reconnects"] = db.reconnects;
+        x["db"]["wait_avg_ms"] = db.avgWaitMs;
+        x["db"]["wait_max_ms"] = db.maxWaitMs;
+        KeywordCache& kc = KeywordCache::instance();
+        x["keywords"]["cached"] = (int)kc.size();
+        x["keywords"]["hits"] = kc.hits();
+        x["keywords"]["misses"] = kc.misses();
+        // Mehrere Knoten: wer hält welche Inbox-Dateien (Stand des letzten Heartbeats)
+        if (leases.enabled()) {
+            LeaseSnapshot ls = leases.snapshot();
+            x["cluster"]["node"] = leases.node().toStdString();
+            x["cluster"]["held"] = (int)leases.held();
+            x["cluster"]["total_leases"] = ls.totalLeases;
+            for (const LeaseNodeInfo& n : ls.nodes) {
+                auto& j = x["cluster"]["nodes"][n.node];
+                j["leases"] = n.leases;
+                j["alive"] = n.alive;
+                j["heartbeat_age_s"] = n.heartbeatAgeSeconds;
+            }
+            for (size_t i = 0; i < ls.leases.size(); ++i) {
+                auto& j = x["cluster"]["leases"][static_cast<unsigned>(i)];
+                j["path"] = ls.leases[i].path;
+                j["node"] = ls.leases[i].node;
+                j["expires_in_s"] = ls.leases[i].expiresInSeconds;
+            }
+        }
+        // Outbox: verschobene Fotos ohne DB-Zeile (überstehen Neustart und DB-Ausfall)
+        if (const Outbox* ob = pipeline.outbox()) {
+            x["outbox"]["dir"] = ob->config().dir.string();
+            x["outbox"]["records"] = (int)ob->backlog();
+            x["outbox"]["bytes"] = static_cast<qint64>(ob->bytesOnDisk());
+        }
+        x["trace"]["enabled"] = Tracer::instance().enabled();
+        x["trace"]["events_per_thread"] = (int)Tracer::instance().eventsPerThread();
         x["status"] = "running";
         return x;
     });
 
+    // Upload direkt in Photos/ (ohne uploads/ + Polling), eigener Port (WORKER_INGEST_PORT):
+    // POST /ingest?name=IMG_1234.jpg&dir=2023/Sommer&user=alice, Body = Bilddatei.
+    // Nicht über Crow: Crow liest den Body vollständig in den Speicher, bevor der
+    // Handler läuft, und das ließe sich erst danach ablehnen. IngestServer prüft
+    // Content-Length (WORKER_INGEST_MAX_FILE_MB) und Zulassung vor dem ersten
+    // Body-Byte und schreibt den Body stückweise auf Platte.
+    const HttpIngestConfig ingestCfg = HttpIngestConfig::fromEnvironment();
+    HttpIngest ingest(pipeline, ingestCfg);
+    IngestServer ingestServer(ingest, ingestCfg.port, ingestCfg.maxRequests * 2);
+    if (ingestCfg.port > 0 && !ingestServer.start()) qWarning() << "POST /ingest disabled";
+
+    // Prometheus Text-Format
+    CROW_ROUTE(monitor, "/metrics")
+    ([](){
+        crow::response res(MetricsRegistry::instance().render());
+        res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        return res;
+    });
+
+    // Span-Tracing: /trace/on (leert die Puffer), /trace/off, /trace -> JSON
+    // für chrome://tracing bzw. ui.perfetto.dev
+    CROW_ROUTE(monitor, "/trace/on")
+    ([](){
+        Tracer::instance().clear();
+        Tracer::instance().setEnabled(true);
+        return "Tracing enabled";
+    });
+
+    CROW_ROUTE(monitor, "/trace/off")
+    ([](){
+        Tracer::instance().setEnabled(false);
+        return "Tracing disabled";
+    });
+
+    CROW_ROUTE(monitor, "/trace")
+    ([](){
+        crow::response res(Tracer::instance().chromeJson());
+        res.set_header("Content-Type", "application/json");
+        res.set_header("Content-Disposition", "attachment; filename=\"worker-trace.json\"");
+        return res;
+    });
+
     CROW_ROUTE(monitor, "/stop")
     ([&monitor](){
         isRunning = false;
@@ -206,8 +292,13 @@ int main(int argc, char *argv[]) {
         return "Stopping worker...";
     });
 
-    monitor.port(8081).run();
+    // Mehrere Threads: /trace und /metrics dürfen /status nicht blockieren
+    monitor.port(8081).multithreaded().run();
 
+    // Auch bei SIGINT/SIGTERM (Crow beendet run()) sauber herunterfahren;
+    // laufende Uploads zuerst, sie brauchen noch die Pipeline
+    ingestServer.stop();
+    isRunning = false;
     if (t.joinable()) t.join();
     return 0;
 }
\ No newline at end of file